@@ -0,0 +1,1522 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+#include "veb.hpp"
+#include "vebt.hpp"
+#include "vebflat.hpp"
+#include "vebmap.hpp"
+#include "vebconc.hpp"
+#include "vebshard.hpp"
+#include "vebpool.hpp"
+#include "vebfile.hpp"
+#include "vebwal.hpp"
+#include "vebsnap.hpp"
+#include "vebstats.hpp"
+#include "vebpq.hpp"
+#include "vebmulti.hpp"
+
+double secondsSince ( clock_t start )
+{
+  return ( double ) ( clock() - start ) / CLOCKS_PER_SEC;
+}
+
+double wallNow()
+{
+  timespec ts;
+  clock_gettime ( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+void report ( const char * name, int opCnt, double seconds )
+{
+  std::cout << name << ": " << opCnt << " ops in " << seconds << " s, "
+            << ( long ) ( opCnt / seconds ) << " ops/s" << std::endl;
+}
+
+void benchLookups ( int universe = 16777216, int queryCnt = 4194304 )
+{
+  TvEB * tree = new TvEB ( universe );
+
+  srand ( 42 );
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % 8 == 0 ) vEB_insert ( tree, i );
+  }
+
+  int * queries = new int [queryCnt];
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    queries[i] = rand() % universe;
+  }
+
+  std::cout << "universe " << universe << ", " << queryCnt << " queries" << std::endl;
+
+  int hits = 0;
+  clock_t start = clock();
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    hits += vEB_find ( tree, queries[i] );
+  }
+  report ( "find", queryCnt, secondsSince ( start ) );
+
+  int res;
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    hits += vEB_succ ( tree, queries[i], res );
+  }
+  report ( "succ", queryCnt, secondsSince ( start ) );
+
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    hits += vEB_pred ( tree, queries[i], res );
+  }
+  report ( "pred", queryCnt, secondsSince ( start ) );
+
+  std::cout << "(" << hits << " hits)" << std::endl;
+
+  delete [] queries;
+  delete tree;
+}
+
+void benchChurn ( int universe, int opCnt, TvEBArena * arena )
+{
+  TvEB * tree = arena ? arena->alloc ( universe ) : new TvEB ( universe );
+
+  srand ( 42 );
+  int * keys = new int [opCnt];
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    keys[i] = rand() % universe;
+  }
+
+  std::cout << "universe " << universe << ", " << opCnt
+            << ( arena ? " arena" : " heap" ) << " inserts and deletes" << std::endl;
+
+  // every key is deleted again a quarter of the operations later, so the
+  // subtrees keep emptying and filling up
+  int window = opCnt / 4;
+  clock_t start = clock();
+  for ( int i = 0; i < opCnt + window; ++i )
+  {
+    if ( i < opCnt ) vEB_insert ( tree, keys[i], universe, arena );
+    if ( i >= window ) vEB_delete ( tree, keys[i - window] );
+  }
+  report ( "churn", 2 * opCnt, secondsSince ( start ) );
+
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    vEB_insert ( tree, keys[i], universe, arena );
+  }
+  start = clock();
+  if ( arena ) arena->clear();
+  else delete tree;
+  std::cout << "release: " << secondsSince ( start ) << " s" << std::endl;
+
+  delete [] keys;
+}
+
+void benchFlat ( int universe, int density, int queryCnt )
+{
+  TvEB * tree = new TvEB ( universe );
+  TvEBFlat * flat = new TvEBFlat ( universe );
+
+  srand ( 42 );
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 )
+    {
+      vEB_insert ( tree, i );
+      vEB_insert ( flat, i );
+    }
+  }
+
+  int * queries = new int [queryCnt];
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    queries[i] = rand() % universe;
+  }
+
+  std::cout << "universe " << universe << ", density 1/" << density << ", "
+            << queryCnt << " queries, pointer vs flat" << std::endl;
+
+  int res, hits = 0;
+  clock_t start = clock();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_succ ( tree, queries[i], res );
+  report ( "succ pointer", queryCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_succ ( flat, queries[i], res );
+  report ( "succ flat", queryCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_pred ( tree, queries[i], res );
+  report ( "pred pointer", queryCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_pred ( flat, queries[i], res );
+  report ( "pred flat", queryCnt, secondsSince ( start ) );
+
+  std::cout << "(" << hits << " hits)" << std::endl;
+
+  delete [] queries;
+  delete flat;
+  delete tree;
+}
+
+void benchSparse ( int universe, int keyCnt, int queryCnt, int flags )
+{
+  TvEB * tree = new TvEB ( universe, NULL, flags );
+
+  srand ( 42 );
+  clock_t start = clock();
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    vEB_insert ( tree, ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe ) );
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt << " keys, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << std::endl;
+  report ( "insert", keyCnt, secondsSince ( start ) );
+
+  int res, hits = 0;
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    hits += vEB_succ ( tree, ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe ), res );
+  }
+  report ( "succ", queryCnt, secondsSince ( start ) );
+  std::cout << "(" << hits << " hits)" << std::endl;
+
+  delete tree;
+}
+
+void benchMap ( int universe, int keyCnt, int queryCnt )
+{
+  TvEB * tree = new TvEB ( universe );
+  std::unordered_map<int, long> values;
+  TvEBMap<long> * map = new TvEBMap<long> ( universe );
+
+  srand ( 42 );
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    int key = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+    vEB_insert ( tree, key );
+    values[key] = i;
+    vEB_insert ( map, key, ( long ) i );
+  }
+
+  int * queries = new int [queryCnt];
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    queries[i] = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt << " keys, "
+            << queryCnt << " queries, tree + hash map vs vEB map" << std::endl;
+
+  int res;
+  long value, sum = 0;
+  clock_t start = clock();
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    if ( vEB_succ ( tree, queries[i], res ) ) sum += values[res];
+  }
+  report ( "succ tree + hash map", queryCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    if ( vEB_succ ( map, queries[i], res, value ) ) sum += value;
+  }
+  report ( "succ vEB map", queryCnt, secondsSince ( start ) );
+
+  std::cout << "(checksum " << sum << ")" << std::endl;
+
+  delete [] queries;
+  delete map;
+  delete tree;
+}
+
+void benchBatch ( int universe, int keyCnt, bool sorted )
+{
+  srand ( 42 );
+  int * keys = new int [keyCnt];
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    keys[i] = sorted ? ( int ) ( ( long long ) i * universe / keyCnt )
+              : ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt
+            << ( sorted ? " sorted" : " random" ) << " keys, one by one vs batch" << std::endl;
+
+  TvEB * tree = new TvEB ( universe );
+  clock_t start = clock();
+  for ( int i = 0; i < keyCnt; ++i ) vEB_insert ( tree, keys[i] );
+  report ( "insert", keyCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < keyCnt; ++i ) vEB_delete ( tree, keys[i] );
+  report ( "delete", keyCnt, secondsSince ( start ) );
+  delete tree;
+
+  tree = new TvEB ( universe );
+  start = clock();
+  vEB_insert_batch ( tree, keys, keyCnt );
+  report ( "insert batch", keyCnt, secondsSince ( start ) );
+  start = clock();
+  vEB_delete_batch ( tree, keys, keyCnt );
+  report ( "delete batch", keyCnt, secondsSince ( start ) );
+  delete tree;
+
+  delete [] keys;
+}
+
+void benchBuild ( int universe, int density, int flags )
+{
+  srand ( 42 );
+  int * keys = new int [universe / density + 1];
+  int keyCnt = 0;
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 && keyCnt < universe / density + 1 ) keys[keyCnt++] = i;
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt << " sorted keys, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << " build" << std::endl;
+
+  TvEB * tree = new TvEB ( universe, NULL, flags );
+  clock_t start = clock();
+  for ( int i = 0; i < keyCnt; ++i ) vEB_insert ( tree, keys[i] );
+  report ( "insert", keyCnt, secondsSince ( start ) );
+  delete tree;
+
+  tree = new TvEB ( universe, NULL, flags );
+  start = clock();
+  vEB_insert_batch ( tree, keys, keyCnt );
+  report ( "insert batch", keyCnt, secondsSince ( start ) );
+  delete tree;
+
+  start = clock();
+  tree = vEB_build_from_sorted ( keys, keyCnt, universe, NULL, flags );
+  report ( "build from sorted", keyCnt, secondsSince ( start ) );
+  delete tree;
+
+  delete [] keys;
+}
+
+void benchQueryBatch ( int universe, int keyCnt, int queryCnt, int flags )
+{
+  TvEB * tree = new TvEB ( universe, NULL, flags );
+
+  srand ( 42 );
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    vEB_insert ( tree, ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe ) );
+  }
+
+  int * queries = new int [queryCnt];
+  int * res = new int [queryCnt];
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    queries[i] = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt << " keys, " << queryCnt << " queries, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << ", one by one vs batch" << std::endl;
+
+  int hits = 0;
+  clock_t start = clock();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_succ ( tree, queries[i], res[i] );
+  report ( "succ", queryCnt, secondsSince ( start ) );
+  start = clock();
+  hits += vEB_succ_batch ( tree, queries, queryCnt, res );
+  report ( "succ batch", queryCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_pred ( tree, queries[i], res[i] );
+  report ( "pred", queryCnt, secondsSince ( start ) );
+  start = clock();
+  hits += vEB_pred_batch ( tree, queries, queryCnt, res );
+  report ( "pred batch", queryCnt, secondsSince ( start ) );
+  std::cout << "(" << hits << " hits)" << std::endl;
+
+  delete [] res;
+  delete [] queries;
+  delete tree;
+}
+
+bool countKey ( int val, void * ctx )
+{
+  ( * ( long * ) ctx ) += val;
+  return true;
+}
+
+void benchScan ( int universe, int density, int flags )
+{
+  TvEB * tree = new TvEB ( universe, NULL, flags );
+
+  srand ( 42 );
+  int keyCnt = 0;
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 ) keyCnt += vEB_insert ( tree, i );
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt << " keys, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << " full scan" << std::endl;
+
+  long sum = 0;
+  int val = -1;
+  clock_t start = clock();
+  while ( vEB_succ ( tree, val, val ) ) sum += val;
+  report ( "succ loop", keyCnt, secondsSince ( start ) );
+
+  TvEBIterator it;
+  start = clock();
+  for ( bool valid = vEB_iter_succ ( tree, it, -1 ); valid; valid = vEB_iter_next ( it ) ) sum += it.val;
+  report ( "iterator", keyCnt, secondsSince ( start ) );
+
+  start = clock();
+  vEB_range ( tree, 0, universe - 1, countKey, &sum );
+  report ( "range", keyCnt, secondsSince ( start ) );
+  std::cout << "(checksum " << sum << ")" << std::endl;
+
+  delete tree;
+}
+
+bool countOne ( int val, void * ctx )
+{
+  ( * ( int * ) ctx )++;
+  return true;
+}
+
+void benchCount ( int universe, int keyCnt, int queryCnt, int window )
+{
+  srand ( 42 );
+  int * keys = new int [keyCnt];
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    keys[i] = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+  }
+  int * queries = new int [queryCnt];
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    queries[i] = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt << " keys, " << queryCnt
+            << " counts of windows of " << window << std::endl;
+
+  TvEB * tree = new TvEB ( universe );
+  clock_t start = clock();
+  for ( int i = 0; i < keyCnt; ++i ) vEB_insert ( tree, keys[i] );
+  report ( "insert", keyCnt, secondsSince ( start ) );
+  TvEB * counted = new TvEB ( universe, NULL, VEB_COUNTED );
+  start = clock();
+  for ( int i = 0; i < keyCnt; ++i ) vEB_insert ( counted, keys[i] );
+  report ( "insert counted", keyCnt, secondsSince ( start ) );
+
+  // the scans are slow, only a hundredth of the queries is timed
+  int sum = 0;
+  start = clock();
+  for ( int i = 0; i < queryCnt / 100; ++i ) vEB_range ( tree, queries[i], queries[i] + window - 1, countOne, &sum );
+  report ( "count by range scan", queryCnt / 100, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i ) sum += vEB_count ( counted, queries[i], queries[i] + window - 1 );
+  report ( "count counted", queryCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < queryCnt; ++i ) sum -= vEB_select ( counted, i % keyCnt, keys[0] );
+  report ( "select counted", queryCnt, secondsSince ( start ) );
+  std::cout << "(checksum " << sum << ")" << std::endl;
+
+  delete counted;
+  delete tree;
+  delete [] queries;
+  delete [] keys;
+}
+
+void benchSetAlgebra ( int universe, int keyCnt, int flags )
+{
+  TvEB * a = new TvEB ( universe, NULL, flags );
+  TvEB * b = new TvEB ( universe, NULL, flags );
+
+  srand ( 42 );
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    vEB_insert ( a, ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe ) );
+    vEB_insert ( b, ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe ) );
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt << " keys in each tree, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << std::endl;
+
+  int cnt = 0;
+  int val = -1;
+  clock_t start = clock();
+  TvEB * res = new TvEB ( universe, NULL, flags );
+  while ( vEB_succ ( a, val, val ) )
+  {
+    if ( vEB_find ( b, val ) ) cnt += vEB_insert ( res, val );
+  }
+  report ( "intersect by succ and find", keyCnt, secondsSince ( start ) );
+  delete res;
+
+  start = clock();
+  res = vEB_intersect ( a, b, NULL, flags );
+  report ( "intersect", keyCnt, secondsSince ( start ) );
+  delete res;
+  start = clock();
+  res = vEB_union ( a, b, NULL, flags );
+  report ( "union", keyCnt, secondsSince ( start ) );
+  delete res;
+  start = clock();
+  res = vEB_difference ( a, b, NULL, flags );
+  report ( "difference", keyCnt, secondsSince ( start ) );
+  delete res;
+  std::cout << "(" << cnt << " common)" << std::endl;
+
+  delete b;
+  delete a;
+}
+
+struct TScalingArgs
+{
+  TvEBConcurrent * conc;
+  TvEBRcu * rcu;
+  TvEBSharded * sharded;
+  TvEB * tree;
+  pthread_mutex_t * mutex;
+  int universe;
+  int opCnt;
+  int writePct;
+  unsigned seed;
+  int hits;
+};
+
+void * scalingWorker ( void * arg )
+{
+  TScalingArgs * a = ( TScalingArgs * ) arg;
+  int reader = vEB_rcu_register ( a->rcu );
+  int res;
+  for ( int i = 0; i < a->opCnt; ++i )
+  {
+    int val = ( int ) ( ( ( ( unsigned ) rand_r ( &a->seed ) << 15 ) ^ rand_r ( &a->seed ) ) % a->universe );
+    int op = rand_r ( &a->seed ) % 100;
+    bool write = op < a->writePct;
+    if ( a->rcu )
+    {
+      if ( write ) a->hits += op & 1 ? vEB_delete ( a->rcu, val ) : vEB_insert ( a->rcu, val );
+      else a->hits += op & 1 ? vEB_find ( a->rcu, reader, val ) : vEB_succ ( a->rcu, reader, val, res );
+      continue;
+    }
+    if ( a->sharded )
+    {
+      if ( write ) a->hits += op & 1 ? vEB_delete ( a->sharded, val ) : vEB_insert ( a->sharded, val );
+      else a->hits += op & 1 ? vEB_find ( a->sharded, val ) : vEB_succ ( a->sharded, val, res );
+      continue;
+    }
+    if ( a->conc )
+    {
+      if ( write ) a->hits += op & 1 ? vEB_delete ( a->conc, val ) : vEB_insert ( a->conc, val );
+      else a->hits += op & 1 ? vEB_find ( a->conc, val ) : vEB_succ ( a->conc, val, res );
+      continue;
+    }
+    pthread_mutex_lock ( a->mutex );
+    if ( write ) a->hits += op & 1 ? vEB_delete ( a->tree, val ) : vEB_insert ( a->tree, val );
+    else a->hits += op & 1 ? vEB_find ( a->tree, val ) : vEB_succ ( a->tree, val, res );
+    pthread_mutex_unlock ( a->mutex );
+  }
+  vEB_rcu_unregister ( a->rcu, reader );
+  return NULL;
+}
+
+void benchConcurrent ( int universe, int keyCnt, int opCnt, int maxThreads, int writePct )
+{
+  TvEBConcurrent * conc = new TvEBConcurrent ( universe );
+  TvEBRcu * rcu = new TvEBRcu ( universe );
+  TvEBSharded * sharded = new TvEBSharded ( 256, universe / 256 );
+  TvEB * tree = new TvEB ( universe );
+  pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+
+  srand ( 42 );
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    int val = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+    vEB_insert ( conc, val );
+    vEB_insert ( rcu, val );
+    vEB_insert ( sharded, val );
+    vEB_insert ( tree, val );
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt << " keys, "
+            << 100 - writePct << " % reads and " << writePct << " % writes" << std::endl;
+
+  const char * names[4] = { "global mutex", "cluster locks", "lock-free reads", "256 shards" };
+  TScalingArgs args[64];
+  pthread_t threads[64];
+  for ( int threadCnt = 1; threadCnt <= maxThreads && threadCnt <= 64; threadCnt *= 2 )
+  {
+    for ( int kind = 0; kind < 4; ++kind )
+    {
+      double start = wallNow();
+      for ( int i = 0; i < threadCnt; ++i )
+      {
+        args[i].conc = kind == 1 ? conc : NULL;
+        args[i].rcu = kind == 2 ? rcu : NULL;
+        args[i].sharded = kind == 3 ? sharded : NULL;
+        args[i].tree = tree;
+        args[i].mutex = &mutex;
+        args[i].universe = universe;
+        args[i].opCnt = opCnt / threadCnt;
+        args[i].writePct = writePct;
+        args[i].seed = i + 1;
+        args[i].hits = 0;
+        pthread_create ( &threads[i], NULL, scalingWorker, &args[i] );
+      }
+      for ( int i = 0; i < threadCnt; ++i )
+      {
+        pthread_join ( threads[i], NULL );
+      }
+      std::cout << threadCnt << " threads, ";
+      report ( names[kind], opCnt, wallNow() - start );
+    }
+  }
+
+  pthread_mutex_destroy ( &mutex );
+  delete tree;
+  delete sharded;
+  delete rcu;
+  delete conc;
+}
+
+void benchParallel ( int universe, int density, int maxThreads, int flags )
+{
+  srand ( 42 );
+  std::vector<int> keys;
+  for ( int i = 0; i < universe; i += 1 + rand() % ( 2 * density - 1 ) ) keys.push_back ( i );
+
+  std::cout << "universe " << universe << ", " << keys.size() << " keys, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << std::endl;
+
+  double start = wallNow();
+  TvEB * tree = vEB_build_from_sorted ( &keys[0], keys.size(), universe, NULL, flags );
+  report ( "sequential build", keys.size(), wallNow() - start );
+  start = wallNow();
+  delete tree;
+  report ( "sequential destruction", keys.size(), wallNow() - start );
+
+  for ( int threadCnt = 1; threadCnt <= maxThreads; threadCnt *= 2 )
+  {
+    TvEBPool pool ( threadCnt );
+    start = wallNow();
+    tree = vEB_build_parallel ( &keys[0], keys.size(), universe, &pool, flags );
+    std::cout << threadCnt << " threads, ";
+    report ( "parallel build", keys.size(), wallNow() - start );
+    start = wallNow();
+    vEB_destroy_parallel ( tree, &pool );
+    std::cout << threadCnt << " threads, ";
+    report ( "parallel destruction", keys.size(), wallNow() - start );
+  }
+}
+
+void benchImage ( int universe, int keyCnt, int queryCnt, int flags )
+{
+  TvEB * tree = new TvEB ( universe, NULL, flags );
+  srand ( 42 );
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    vEB_insert ( tree, ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe ) );
+  }
+  int * queries = new int [queryCnt];
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    queries[i] = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+  }
+
+  std::cout << "universe " << universe << ", " << keyCnt << " keys, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << std::endl;
+
+  const char * path = "/tmp/veb_bench.img";
+  double start = wallNow();
+  vEB_save ( tree, path );
+  report ( "save", keyCnt, wallNow() - start );
+  start = wallNow();
+  TvEBImage * image = vEB_image_open ( path );
+  std::cout << "open: " << ( wallNow() - start ) * 1000 << " ms for "
+            << image->bytes << " bytes" << std::endl;
+
+  int hits = 0;
+  int res;
+  start = wallNow();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_succ ( tree, queries[i], res );
+  report ( "tree succ", queryCnt, wallNow() - start );
+  start = wallNow();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_succ ( image, queries[i], res );
+  report ( "image succ", queryCnt, wallNow() - start );
+  vEB_image_close ( image );
+
+  start = wallNow();
+  TvEB * loaded = vEB_load ( path, NULL, flags );
+  report ( "load", keyCnt, wallNow() - start );
+  std::cout << "(" << hits << " hits)" << std::endl;
+  remove ( path );
+
+  delete loaded;
+  delete [] queries;
+  delete tree;
+}
+
+void benchDurable ( int universe, int segCnt, int opCnt, int flags )
+{
+  std::cout << "durable universe " << universe << ", " << segCnt << " segments, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << std::endl;
+
+  char dir[] = "/tmp/veb_bench_XXXXXX";
+  if ( !mkdtemp ( dir ) ) return;
+  TvEBDurable * tree = NULL;
+  srand ( 42 );
+  for ( int groupSize = 1; groupSize <= 1024; groupSize *= 32 )
+  {
+    tree = vEB_durable_open ( dir, universe, segCnt, groupSize, flags );
+    int cnt = groupSize == 1 ? opCnt / 64 : opCnt;
+    double start = wallNow();
+    for ( int i = 0; i < cnt; ++i )
+    {
+      vEB_insert ( tree, ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe ) );
+    }
+    vEB_durable_commit ( tree );
+    std::cout << "group " << groupSize << ", " << tree->syncCnt << " flushes, ";
+    report ( "durable insert", cnt, wallNow() - start );
+    if ( groupSize < 1024 ) vEB_durable_close ( tree );
+  }
+
+  double start = wallNow();
+  vEB_durable_close ( tree );
+  tree = vEB_durable_open ( dir, universe, segCnt, 1024, flags );
+  std::cout << "recovery from the log: " << ( wallNow() - start ) * 1000 << " ms" << std::endl;
+  start = wallNow();
+  int written = vEB_durable_checkpoint ( tree );
+  std::cout << "full checkpoint: " << written << " segments in "
+            << ( wallNow() - start ) * 1000 << " ms" << std::endl;
+
+  for ( int i = 0; i < opCnt / 16; ++i ) vEB_insert ( tree, rand() % ( universe / segCnt ) );
+  start = wallNow();
+  written = vEB_durable_checkpoint ( tree );
+  std::cout << "incremental checkpoint: " << written << " segments in "
+            << ( wallNow() - start ) * 1000 << " ms" << std::endl;
+  vEB_durable_close ( tree );
+  start = wallNow();
+  tree = vEB_durable_open ( dir, universe, segCnt, 1024, flags );
+  std::cout << "recovery from the images: " << ( wallNow() - start ) * 1000 << " ms" << std::endl;
+
+  for ( int i = 0; i < tree->segCnt; ++i )
+  {
+    char name[32];
+    snprintf ( name, sizeof ( name ), "/seg-%d.img", i );
+    remove ( ( std::string ( dir ) + name ).c_str() );
+  }
+  vEB_durable_close ( tree );
+  remove ( ( std::string ( dir ) + "/wal" ).c_str() );
+  remove ( ( std::string ( dir ) + "/manifest" ).c_str() );
+  rmdir ( dir );
+}
+
+void benchSnapshot ( int universe, int keyCnt, int opCnt, int flags )
+{
+  std::cout << "snapshots universe " << universe << ", " << keyCnt << " keys, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << std::endl;
+
+  srand ( 42 );
+  TvEBPersistent * tree = new TvEBPersistent ( universe, flags );
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    vEB_insert ( tree, ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe ) );
+  }
+  int * ops = new int [opCnt];
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    ops[i] = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+  }
+
+  std::vector<int> keys;
+  double start = wallNow();
+  TvEBIterator it;
+  for ( bool valid = vEB_iter_succ ( tree->root, it, -1 ); valid; valid = vEB_iter_next ( it ) ) keys.push_back ( it.val );
+  TvEB * copy = vEB_build_from_sorted ( &keys[0], keys.size(), universe, NULL, flags );
+  std::cout << "deep copy: " << ( wallNow() - start ) * 1000 << " ms" << std::endl;
+  delete copy;
+
+  for ( int every = 0; every <= 4096; every = every ? every * 64 : 1 )
+  {
+    // the analytics keep the last snapshot, a snapshot on every update
+    // copies the root each time and runs fewer updates
+    int cnt = every == 1 ? opCnt / 64 : opCnt;
+    TvEBSnapshot * snap = NULL;
+    start = wallNow();
+    for ( int i = 0; i < cnt; ++i )
+    {
+      if ( every && i % every == 0 )
+      {
+        vEB_snapshot_release ( snap );
+        snap = vEB_snapshot ( tree );
+      }
+      if ( !vEB_insert ( tree, ops[i] ) ) vEB_delete ( tree, ops[i] );
+    }
+    double time = wallNow() - start;
+    if ( every ) std::cout << "snapshot every " << every << " updates, ";
+    else std::cout << "no snapshots, ";
+    report ( "update", cnt, time );
+    vEB_snapshot_release ( snap );
+  }
+
+  delete [] ops;
+  delete tree;
+}
+
+void printUsage ( const char * name, const TvEBMemoryUsage & usage )
+{
+  size_t kinds[VEB_NODE_TYPES] = { 0 };
+  for ( int l = 0; l < VEB_MEMORY_LEVELS; ++l )
+  {
+    for ( int k = 0; k < VEB_NODE_TYPES; ++k ) kinds[k] += usage.nodes[l][k];
+  }
+  std::cout << name << ": " << usage.total / 1024 << " KiB, " << kinds[VEB_NODE_LEAF] << " leaves, "
+            << kinds[VEB_NODE_DENSE] << " dense and " << kinds[VEB_NODE_SPARSE] << " sparse nodes, "
+            << usage.usedSlots << " of " << usage.slots << " cluster slots used" << std::endl;
+}
+
+void benchCompact ( int universe, int keyCnt, int queryCnt, int flags )
+{
+  std::cout << "universe " << universe << ", " << keyCnt << " keys, 7/8 deleted, "
+            << ( flags & VEB_SPARSE ? "sparse" : "dense" ) << std::endl;
+
+  srand ( 42 );
+  TvEB * tree = NULL;
+  std::vector<int> keys ( keyCnt );
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    keys[i] = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+    vEB_insert ( tree, keys[i], universe, NULL, flags );
+  }
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    if ( i % 8 ) vEB_delete ( tree, keys[i] );
+  }
+  int * queries = new int [queryCnt];
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    queries[i] = ( int ) ( ( ( ( unsigned ) rand() << 15 ) ^ rand() ) % universe );
+  }
+
+  TvEBMemoryUsage usage;
+  vEB_memory_usage ( tree, usage );
+  printUsage ( "after churn", usage );
+  TvEBArena * arena = new TvEBArena();
+  double start = wallNow();
+  TvEB * packed = vEB_compact ( tree, arena );
+  std::cout << "compact: " << ( wallNow() - start ) * 1000 << " ms" << std::endl;
+  vEB_memory_usage ( packed, usage );
+  printUsage ( "compacted", usage );
+
+  int hits = 0, res;
+  clock_t begin = clock();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_succ ( tree, queries[i], res );
+  report ( "succ after churn", queryCnt, secondsSince ( begin ) );
+  begin = clock();
+  for ( int i = 0; i < queryCnt; ++i ) hits += vEB_succ ( packed, queries[i], res );
+  report ( "succ compacted", queryCnt, secondsSince ( begin ) );
+  std::cout << "(" << hits << " hits)" << std::endl;
+
+  delete [] queries;
+  delete arena;
+  delete tree;
+}
+
+// The suite below writes CSV to stdout. Everything it draws comes from
+// splitmix64 seeded by the case, so two runs, on any platform, time the
+// same keys and queries in the same order and the result column matches.
+uint64_t suiteNext ( uint64_t & state )
+{
+  uint64_t z = ( state += 0x9E3779B97F4A7C15ull );
+  z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+  z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+  return z ^ ( z >> 31 );
+}
+
+uint64_t nowNs()
+{
+  timespec ts;
+  clock_gettime ( CLOCK_MONOTONIC, &ts );
+  return ( uint64_t ) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+enum { DIST_UNIFORM, DIST_CLUSTERED, DIST_SEQUENTIAL, DIST_ZIPF, DIST_CNT };
+
+const char * distNames[DIST_CNT] = { "uniform", "clustered", "sequential", "zipf" };
+
+// the keys in insertion order, duplicates included, the universe is a power
+// of two so the masks and the odd multiplier keep every key inside it
+void suiteKeys ( int dist, uint64_t universe, int keyCnt, uint64_t seed, std::vector<uint32_t> & keys )
+{
+  uint64_t mask = universe - 1;
+  keys.resize ( keyCnt );
+  if ( dist == DIST_UNIFORM )
+  {
+    for ( int i = 0; i < keyCnt; ++i ) keys[i] = suiteNext ( seed ) & mask;
+  }
+  else if ( dist == DIST_CLUSTERED )
+  {
+    // runs of 64 keys within 4096 of a random center
+    uint64_t center = 0;
+    for ( int i = 0; i < keyCnt; ++i )
+    {
+      if ( i % 64 == 0 ) center = suiteNext ( seed );
+      keys[i] = ( center + suiteNext ( seed ) % 4096 ) & mask;
+    }
+  }
+  else if ( dist == DIST_SEQUENTIAL )
+  {
+    uint64_t stride = std::max ( ( uint64_t ) 1, universe / keyCnt );
+    for ( int i = 0; i < keyCnt; ++i ) keys[i] = ( i * stride ) & mask;
+  }
+  else
+  {
+    // rank r drawn with probability proportional to 1 / r, the ranks are
+    // scattered over the universe
+    std::vector<double> cdf ( keyCnt );
+    double sum = 0;
+    for ( int r = 0; r < keyCnt; ++r ) cdf[r] = ( sum += 1.0 / ( r + 1 ) );
+    for ( int i = 0; i < keyCnt; ++i )
+    {
+      double u = ( suiteNext ( seed ) >> 11 ) * ( 1.0 / 9007199254740992.0 ) * sum;
+      uint64_t rank = std::lower_bound ( cdf.begin(), cdf.end(), u ) - cdf.begin();
+      keys[i] = ( ( rank + 1 ) * 0x9E3779B97F4A7C15ull ) & mask;
+    }
+  }
+}
+
+struct SuiteVeb
+{
+  SuiteVeb ( uint64_t universe, int flags ) : tree ( NULL ), uni ( ( int ) universe ), flags ( flags ) { }
+  ~SuiteVeb() { if ( tree ) delete tree; }
+  void build ( const std::vector<uint32_t> & keys ) { for ( size_t i = 0; i < keys.size(); ++i ) insert ( keys[i] ); }
+  bool insert ( uint32_t key ) { return vEB_insert ( tree, ( int ) key, uni, NULL, flags ); }
+  bool erase ( uint32_t key ) { return vEB_delete ( tree, ( int ) key ); }
+  bool find ( uint32_t key ) { return vEB_find ( tree, ( int ) key ); }
+  bool succ ( uint32_t key, uint32_t & res )
+  {
+    int val;
+    if ( !vEB_succ ( tree, ( int ) key, val ) ) return false;
+    res = val;
+    return true;
+  }
+  bool pred ( uint32_t key, uint32_t & res )
+  {
+    int val;
+    if ( !vEB_pred ( tree, ( int ) key, val ) ) return false;
+    res = val;
+    return true;
+  }
+  uint64_t scan()
+  {
+    uint64_t sum = 0;
+    TvEBIterator it;
+    for ( bool valid = vEB_iter_succ ( tree, it, -1 ); valid; valid = vEB_iter_next ( it ) ) sum += it.val;
+    return sum;
+  }
+  TvEB * tree;
+  int uni;
+  int flags;
+};
+
+// the universe of 2^32 does not fit the int keys of TvEB
+struct SuiteVebT
+{
+  SuiteVebT() : tree ( NULL ) { }
+  ~SuiteVebT() { if ( tree ) delete tree; }
+  void build ( const std::vector<uint32_t> & keys ) { for ( size_t i = 0; i < keys.size(); ++i ) insert ( keys[i] ); }
+  bool insert ( uint32_t key ) { return vEB_insert ( tree, key ); }
+  bool erase ( uint32_t key ) { return vEB_delete ( tree, key ); }
+  bool find ( uint32_t key ) { return vEB_find ( tree, key ); }
+  bool succ ( uint32_t key, uint32_t & res ) { return vEB_succ ( tree, key, res ); }
+  bool pred ( uint32_t key, uint32_t & res ) { return vEB_pred ( tree, key, res ); }
+  uint64_t scan()
+  {
+    uint64_t sum = 0;
+    uint32_t val;
+    for ( bool valid = vEB_min ( tree, val ); valid; valid = vEB_succ ( tree, val, val ) ) sum += val;
+    return sum;
+  }
+  TvEBT<32> * tree;
+};
+
+struct SuiteSet
+{
+  void build ( const std::vector<uint32_t> & keys ) { for ( size_t i = 0; i < keys.size(); ++i ) insert ( keys[i] ); }
+  bool insert ( uint32_t key ) { return set.insert ( key ).second; }
+  bool erase ( uint32_t key ) { return set.erase ( key ); }
+  bool find ( uint32_t key ) { return set.count ( key ); }
+  bool succ ( uint32_t key, uint32_t & res )
+  {
+    std::set<uint32_t>::iterator it = set.upper_bound ( key );
+    if ( it == set.end() ) return false;
+    res = *it;
+    return true;
+  }
+  bool pred ( uint32_t key, uint32_t & res )
+  {
+    std::set<uint32_t>::iterator it = set.lower_bound ( key );
+    if ( it == set.begin() ) return false;
+    res = *--it;
+    return true;
+  }
+  uint64_t scan()
+  {
+    uint64_t sum = 0;
+    for ( std::set<uint32_t>::iterator it = set.begin(); it != set.end(); ++it ) sum += *it;
+    return sum;
+  }
+  std::set<uint32_t> set;
+};
+
+struct SuiteSorted
+{
+  void build ( const std::vector<uint32_t> & keys )
+  {
+    vals = keys;
+    std::sort ( vals.begin(), vals.end() );
+    vals.erase ( std::unique ( vals.begin(), vals.end() ), vals.end() );
+  }
+  bool insert ( uint32_t key )
+  {
+    std::vector<uint32_t>::iterator it = std::lower_bound ( vals.begin(), vals.end(), key );
+    if ( it != vals.end() && *it == key ) return false;
+    vals.insert ( it, key );
+    return true;
+  }
+  bool erase ( uint32_t key )
+  {
+    std::vector<uint32_t>::iterator it = std::lower_bound ( vals.begin(), vals.end(), key );
+    if ( it == vals.end() || *it != key ) return false;
+    vals.erase ( it );
+    return true;
+  }
+  bool find ( uint32_t key ) { return std::binary_search ( vals.begin(), vals.end(), key ); }
+  bool succ ( uint32_t key, uint32_t & res )
+  {
+    std::vector<uint32_t>::iterator it = std::upper_bound ( vals.begin(), vals.end(), key );
+    if ( it == vals.end() ) return false;
+    res = *it;
+    return true;
+  }
+  bool pred ( uint32_t key, uint32_t & res )
+  {
+    std::vector<uint32_t>::iterator it = std::lower_bound ( vals.begin(), vals.end(), key );
+    if ( it == vals.begin() ) return false;
+    res = *--it;
+    return true;
+  }
+  uint64_t scan()
+  {
+    uint64_t sum = 0;
+    for ( size_t i = 0; i < vals.size(); ++i ) sum += vals[i];
+    return sum;
+  }
+  std::vector<uint32_t> vals;
+};
+
+struct SuiteBitset
+{
+  SuiteBitset ( uint64_t universe ) : words ( universe / 64 + 1, 0 ) { }
+  void build ( const std::vector<uint32_t> & keys ) { for ( size_t i = 0; i < keys.size(); ++i ) insert ( keys[i] ); }
+  bool insert ( uint32_t key )
+  {
+    uint64_t bit = ( uint64_t ) 1 << ( key & 63 );
+    if ( words[key >> 6] & bit ) return false;
+    words[key >> 6] |= bit;
+    return true;
+  }
+  bool erase ( uint32_t key )
+  {
+    uint64_t bit = ( uint64_t ) 1 << ( key & 63 );
+    if ( !( words[key >> 6] & bit ) ) return false;
+    words[key >> 6] &= ~bit;
+    return true;
+  }
+  bool find ( uint32_t key ) { return words[key >> 6] >> ( key & 63 ) & 1; }
+  bool succ ( uint32_t key, uint32_t & res )
+  {
+    size_t w = key >> 6;
+    uint64_t word = ( key & 63 ) == 63 ? 0 : words[w] & ( ~ ( uint64_t ) 0 << ( ( key & 63 ) + 1 ) );
+    while ( !word )
+    {
+      if ( ++w == words.size() ) return false;
+      word = words[w];
+    }
+    res = w * 64 + __builtin_ctzll ( word );
+    return true;
+  }
+  bool pred ( uint32_t key, uint32_t & res )
+  {
+    size_t w = key >> 6;
+    uint64_t word = words[w] & ( ( ( uint64_t ) 1 << ( key & 63 ) ) - 1 );
+    while ( !word )
+    {
+      if ( !w-- ) return false;
+      word = words[w];
+    }
+    res = w * 64 + 63 - __builtin_clzll ( word );
+    return true;
+  }
+  uint64_t scan()
+  {
+    uint64_t sum = 0;
+    for ( size_t w = 0; w < words.size(); ++w )
+    {
+      for ( uint64_t word = words[w]; word; word &= word - 1 ) sum += w * 64 + __builtin_ctzll ( word );
+    }
+    return sum;
+  }
+  std::vector<uint64_t> words;
+};
+
+struct SuiteCase
+{
+  int uniBits;
+  int keyCnt;
+  int dist;
+  int distinct;
+};
+
+// the cost of reading the clock, taken off every timed operation
+uint64_t timerOverhead()
+{
+  std::vector<uint64_t> samples ( 1001 );
+  for ( size_t i = 0; i < samples.size(); ++i )
+  {
+    uint64_t start = nowNs();
+    samples[i] = nowNs() - start;
+  }
+  std::nth_element ( samples.begin(), samples.begin() + 500, samples.end() );
+  return samples[500];
+}
+
+void suiteRow ( const SuiteCase & c, const char * name, const char * op, size_t opCnt,
+                double seconds, std::vector<uint64_t> * lat, uint64_t result )
+{
+  std::cout << name << "," << c.uniBits << "," << c.keyCnt << "," << c.distinct << ","
+            << distNames[c.dist] << "," << op << "," << opCnt << ","
+            << ( uint64_t ) ( opCnt / seconds );
+  if ( lat && !lat->empty() )
+  {
+    std::sort ( lat->begin(), lat->end() );
+    const double pcts[] = { 0.5, 0.9, 0.99, 0.999 };
+    for ( int i = 0; i < 4; ++i ) std::cout << "," << ( *lat )[( size_t ) ( pcts[i] * ( lat->size() - 1 ) )];
+  }
+  else std::cout << ",,,,";
+  std::cout << "," << result << std::endl;
+}
+
+enum { SUITE_FIND, SUITE_SUCC, SUITE_PRED };
+
+template <typename TSet>
+uint64_t suiteQuery ( TSet & set, int op, uint32_t key )
+{
+  uint32_t res = 0;
+  if ( op == SUITE_FIND ) return set.find ( key );
+  if ( op == SUITE_SUCC ) return set.succ ( key, res ) ? res + 1 : 0;
+  return set.pred ( key, res ) ? res + 1 : 0;
+}
+
+// the throughput of every operation is taken over a run without the clock,
+// then the latency over a second run timing each operation
+template <typename TSet>
+void suiteRun ( const SuiteCase & c, const char * name, TSet & set, bool updates,
+                const std::vector<uint32_t> & keys, const std::vector<uint32_t> & queries,
+                uint64_t overhead )
+{
+  std::vector<uint64_t> lat;
+  lat.reserve ( std::max ( keys.size(), queries.size() ) );
+  uint64_t inserted = 0;
+  double insertTime = 0;
+  if ( updates )
+  {
+    double start = wallNow();
+    for ( size_t i = 0; i < keys.size(); ++i ) inserted += set.insert ( keys[i] );
+    insertTime = wallNow() - start;
+  }
+  else set.build ( keys );
+
+  const char * opNames[] = { "find", "succ", "pred" };
+  for ( int op = SUITE_FIND; op <= SUITE_PRED; ++op )
+  {
+    uint64_t sum = 0;
+    double start = wallNow();
+    for ( size_t i = 0; i < queries.size(); ++i ) sum += suiteQuery ( set, op, queries[i] );
+    double time = wallNow() - start;
+    lat.clear();
+    for ( size_t i = 0; i < queries.size(); ++i )
+    {
+      uint64_t begin = nowNs();
+      sum += suiteQuery ( set, op, queries[i] );
+      uint64_t ns = nowNs() - begin;
+      lat.push_back ( ns > overhead ? ns - overhead : 0 );
+    }
+    suiteRow ( c, name, opNames[op], queries.size(), time, &lat, sum / 2 );
+  }
+
+  double start = wallNow();
+  uint64_t sum = set.scan();
+  suiteRow ( c, name, "scan", c.distinct, wallNow() - start, NULL, sum );
+
+  if ( !updates ) return;
+
+  uint64_t deleted = 0;
+  start = wallNow();
+  for ( size_t i = 0; i < keys.size(); ++i ) deleted += set.erase ( keys[i] );
+  double deleteTime = wallNow() - start;
+
+  lat.clear();
+  for ( size_t i = 0; i < keys.size(); ++i )
+  {
+    uint64_t begin = nowNs();
+    set.insert ( keys[i] );
+    uint64_t ns = nowNs() - begin;
+    lat.push_back ( ns > overhead ? ns - overhead : 0 );
+  }
+  suiteRow ( c, name, "insert", keys.size(), insertTime, &lat, inserted );
+  lat.clear();
+  for ( size_t i = 0; i < keys.size(); ++i )
+  {
+    uint64_t begin = nowNs();
+    set.erase ( keys[i] );
+    uint64_t ns = nowNs() - begin;
+    lat.push_back ( ns > overhead ? ns - overhead : 0 );
+  }
+  suiteRow ( c, name, "delete", keys.size(), deleteTime, &lat, deleted );
+}
+
+void benchSuite ( int maxKeys )
+{
+  const int uniBits[] = { 16, 20, 24, 28, 30, 32 };
+  uint64_t overhead = timerOverhead();
+  std::cout << "structure,universe_bits,keys,distinct,distribution,op,ops,ops_per_s,"
+            << "p50_ns,p90_ns,p99_ns,p999_ns,result" << std::endl;
+
+  for ( int u = 0; u < 6; ++u )
+  {
+    uint64_t universe = ( uint64_t ) 1 << uniBits[u];
+    int prevCnt = 0;
+    for ( int shift = 8; shift >= 0; shift -= 4 )
+    {
+      int keyCnt = ( int ) std::min ( ( uint64_t ) ( maxKeys >> shift ), universe / 2 );
+      if ( keyCnt == prevCnt || keyCnt < 16 ) continue;
+      prevCnt = keyCnt;
+
+      for ( int dist = 0; dist < DIST_CNT; ++dist )
+      {
+        uint64_t seed = 42 + ( ( uint64_t ) uniBits[u] << 40 ) + ( ( uint64_t ) keyCnt << 8 ) + dist;
+        std::vector<uint32_t> keys;
+        suiteKeys ( dist, universe, keyCnt, seed, keys );
+        // half of the queries are keys, the other half is uniform
+        std::vector<uint32_t> queries ( keyCnt );
+        for ( int i = 0; i < keyCnt; ++i )
+        {
+          uint64_t r = suiteNext ( seed );
+          queries[i] = r & 1 ? keys[( r >> 1 ) % keyCnt] : ( r >> 1 ) & ( universe - 1 );
+        }
+        std::vector<uint32_t> sorted ( keys );
+        std::sort ( sorted.begin(), sorted.end() );
+        SuiteCase c = { uniBits[u], keyCnt, dist,
+                         ( int ) ( std::unique ( sorted.begin(), sorted.end() ) - sorted.begin() ) };
+
+        if ( uniBits[u] <= 30 )
+        {
+          SuiteVeb veb ( universe, 0 );
+          suiteRun ( c, "veb", veb, true, keys, queries, overhead );
+          SuiteVeb sparse ( universe, VEB_SPARSE );
+          suiteRun ( c, "veb_sparse", sparse, true, keys, queries, overhead );
+        }
+        else
+        {
+          SuiteVebT vebt;
+          suiteRun ( c, "vebt32", vebt, true, keys, queries, overhead );
+        }
+        SuiteSet set;
+        suiteRun ( c, "std_set", set, true, keys, queries, overhead );
+        // the updates of a sorted vector move half of it
+        SuiteSorted sortedVec;
+        suiteRun ( c, "sorted_vector", sortedVec, keyCnt <= 65536, keys, queries, overhead );
+        // a bitset scans the gaps, it is left out of the sparse cases
+        if ( uniBits[u] <= 30 && universe / c.distinct <= 65536 )
+        {
+          SuiteBitset bitset ( universe );
+          suiteRun ( c, "bitset", bitset, true, keys, queries, overhead );
+        }
+      }
+    }
+  }
+}
+
+// a random graph in compressed rows, degree edges out of every vertex
+void dijkstraGraph ( int vertexCnt, int degree, int maxWeight,
+                     std::vector<int> & first, std::vector<int> & to, std::vector<int> & weight )
+{
+  uint64_t state = 42;
+  first.resize ( vertexCnt + 1 );
+  to.resize ( ( size_t ) vertexCnt * degree );
+  weight.resize ( to.size() );
+  for ( int v = 0; v <= vertexCnt; ++v ) first[v] = v * degree;
+  for ( size_t e = 0; e < to.size(); ++e )
+  {
+    to[e] = ( int ) ( suiteNext ( state ) % vertexCnt );
+    weight[e] = 1 + ( int ) ( suiteNext ( state ) % maxWeight );
+  }
+}
+
+// each returns the number of the settled vertices, here the frontier is a
+// TvEBPQ popped by the fused vEB_pop_min or, as before it, by vEB_min and a
+// removal of the found item
+long dijkstraVeb ( const std::vector<int> & first, const std::vector<int> & to,
+                   const std::vector<int> & weight, std::vector<int> & dist, bool fused )
+{
+  int vertexCnt = first.size() - 1;
+  TvEBPQ pq ( 1 << 30, vertexCnt );
+  dist.assign ( vertexCnt, INT_MAX );
+  dist[0] = 0;
+  vEB_push ( &pq, 0, 0 );
+  long settled = 0;
+  int v, d;
+  while ( fused ? vEB_pop_min ( &pq, v, d ) : vEB_min ( &pq, v, d ) && vEB_delete ( &pq, v ) )
+  {
+    settled++;
+    for ( int e = first[v]; e < first[v + 1]; ++e )
+    {
+      int u = to[e], nd = d + weight[e];
+      if ( nd >= dist[u] ) continue;
+      if ( dist[u] == INT_MAX ) vEB_push ( &pq, u, nd );
+      else vEB_decrease_key ( &pq, u, nd );
+      dist[u] = nd;
+    }
+  }
+  return settled;
+}
+
+// a binary heap cannot decrease a key, it takes duplicates and skips the
+// stale ones
+long dijkstraHeap ( const std::vector<int> & first, const std::vector<int> & to,
+                    const std::vector<int> & weight, std::vector<int> & dist )
+{
+  int vertexCnt = first.size() - 1;
+  std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int> >,
+                      std::greater<std::pair<int, int> > > heap;
+  dist.assign ( vertexCnt, INT_MAX );
+  dist[0] = 0;
+  heap.push ( std::make_pair ( 0, 0 ) );
+  long settled = 0;
+  while ( !heap.empty() )
+  {
+    int d = heap.top().first, v = heap.top().second;
+    heap.pop();
+    if ( d > dist[v] ) continue;
+    settled++;
+    for ( int e = first[v]; e < first[v + 1]; ++e )
+    {
+      int u = to[e], nd = d + weight[e];
+      if ( nd >= dist[u] ) continue;
+      dist[u] = nd;
+      heap.push ( std::make_pair ( nd, u ) );
+    }
+  }
+  return settled;
+}
+
+long dijkstraSet ( const std::vector<int> & first, const std::vector<int> & to,
+                   const std::vector<int> & weight, std::vector<int> & dist )
+{
+  int vertexCnt = first.size() - 1;
+  std::set<std::pair<int, int> > frontier;
+  dist.assign ( vertexCnt, INT_MAX );
+  dist[0] = 0;
+  frontier.insert ( std::make_pair ( 0, 0 ) );
+  long settled = 0;
+  while ( !frontier.empty() )
+  {
+    int d = frontier.begin()->first, v = frontier.begin()->second;
+    frontier.erase ( frontier.begin() );
+    settled++;
+    for ( int e = first[v]; e < first[v + 1]; ++e )
+    {
+      int u = to[e], nd = d + weight[e];
+      if ( nd >= dist[u] ) continue;
+      if ( dist[u] != INT_MAX ) frontier.erase ( std::make_pair ( dist[u], u ) );
+      dist[u] = nd;
+      frontier.insert ( std::make_pair ( nd, u ) );
+    }
+  }
+  return settled;
+}
+
+void benchDijkstra ( int vertexCnt, int degree, int maxWeight )
+{
+  std::vector<int> first, to, weight;
+  dijkstraGraph ( vertexCnt, degree, maxWeight, first, to, weight );
+  std::cout << "dijkstra, " << vertexCnt << " vertices, " << to.size()
+            << " edges, weights 1 to " << maxWeight << std::endl;
+
+  const char * names[] = { "vEB queue, fused pop", "vEB queue, min + delete", "binary heap", "std::set" };
+  std::vector<int> dist[4];
+  long sums[4];
+  for ( int i = 0; i < 4; ++i )
+  {
+    clock_t start = clock();
+    long settled = i < 2 ? dijkstraVeb ( first, to, weight, dist[i], i == 0 )
+                : i == 2 ? dijkstraHeap ( first, to, weight, dist[i] )
+                : dijkstraSet ( first, to, weight, dist[i] );
+    report ( names[i], settled, secondsSince ( start ) );
+    sums[i] = 0;
+    for ( int v = 0; v < vertexCnt; ++v ) if ( dist[i][v] != INT_MAX ) sums[i] += dist[i][v];
+  }
+  std::cout << "(distance sum " << sums[0]
+            << ( dist[1] == dist[0] && dist[2] == dist[0] && dist[3] == dist[0] ? "" : ", MISMATCH" )
+            << ")" << std::endl;
+}
+
+// equal timestamps: opCnt updates of valueCnt values, 3 in 4 adding an
+// occurrence, then succ queries that want the counts too
+void benchMultiset ( int universe, int valueCnt, int opCnt )
+{
+  uint64_t state = 42;
+  std::vector<int> values ( valueCnt ), ops ( opCnt ), queries ( opCnt );
+  for ( int i = 0; i < valueCnt; ++i ) values[i] = ( int ) ( suiteNext ( state ) % universe );
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    ops[i] = values[suiteNext ( state ) % valueCnt];
+    queries[i] = ( int ) ( suiteNext ( state ) % universe );
+  }
+  std::cout << "multiset, universe " << universe << ", " << valueCnt << " values, "
+            << opCnt << " updates and queries" << std::endl;
+
+  // the tree and a side hash map of the counts, the way it was done before
+  TvEB * tree = NULL;
+  std::unordered_map<int, int> counts;
+  long sums[3] = { 0, 0, 0 };
+  int res, cnt;
+  clock_t start = clock();
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    if ( i % 4 )
+    {
+      if ( !counts[ops[i]]++ ) vEB_insert ( tree, ops[i], universe );
+    }
+    else
+    {
+      std::unordered_map<int, int>::iterator it = counts.find ( ops[i] );
+      if ( it != counts.end() && !--it->second ) { counts.erase ( it ); vEB_delete ( tree, ops[i] ); }
+    }
+  }
+  report ( "update tree + hash map", opCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    if ( vEB_succ ( tree, queries[i], res ) ) sums[0] += counts[res];
+  }
+  report ( "succ tree + hash map", opCnt, secondsSince ( start ) );
+
+  TvEBMultiset set ( universe );
+  start = clock();
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    if ( i % 4 ) vEB_insert ( &set, ops[i] );
+    else vEB_delete ( &set, ops[i] );
+  }
+  report ( "update vEB multiset", opCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    if ( vEB_succ ( &set, queries[i], res, cnt ) ) sums[1] += cnt;
+  }
+  report ( "succ vEB multiset", opCnt, secondsSince ( start ) );
+
+  std::map<int, int> ordered;
+  start = clock();
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    if ( i % 4 ) ordered[ops[i]]++;
+    else
+    {
+      std::map<int, int>::iterator it = ordered.find ( ops[i] );
+      if ( it != ordered.end() && !--it->second ) ordered.erase ( it );
+    }
+  }
+  report ( "update std::map", opCnt, secondsSince ( start ) );
+  start = clock();
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    std::map<int, int>::iterator it = ordered.upper_bound ( queries[i] );
+    if ( it != ordered.end() ) sums[2] += it->second;
+  }
+  report ( "succ std::map", opCnt, secondsSince ( start ) );
+
+  std::cout << "(" << set.distinct << " distinct, " << set.size << " occurrences"
+            << ( sums[0] != sums[1] || sums[0] != sums[2] || ( size_t ) set.distinct != ordered.size() ? ", MISMATCH" : "" )
+            << ")" << std::endl;
+  if ( tree ) delete tree;
+}
+
+int main ( int argc, char ** argv )
+{
+  // "bench suite [max keys]" runs the CSV suite only
+  if ( argc > 1 && !strcmp ( argv[1], "suite" ) )
+  {
+    benchSuite ( argc > 2 ? atoi ( argv[2] ) : 1 << 18 );
+    return 0;
+  }
+
+  benchLookups();
+  benchChurn ( 16777216, 4194304, NULL );
+  TvEBArena arena;
+  benchChurn ( 16777216, 4194304, &arena );
+  benchFlat ( 16777216, 8, 4194304 );
+  benchFlat ( 16777216, 2, 4194304 );
+  benchFlat ( 67108864, 2, 4194304 );
+  benchSparse ( 1 << 30, 1 << 20, 1 << 20, 0 );
+  benchSparse ( 1 << 30, 1 << 20, 1 << 20, VEB_SPARSE );
+  benchMap ( 16777216, 1 << 20, 4194304 );
+  benchBatch ( 16777216, 4194304, true );
+  benchBatch ( 16777216, 4194304, false );
+  benchBuild ( 16777216, 2, 0 );
+  benchBuild ( 1 << 30, 1024, VEB_SPARSE );
+  benchQueryBatch ( 1 << 26, 1 << 22, 4194304, 0 );
+  benchQueryBatch ( 1 << 30, 1 << 22, 4194304, VEB_SPARSE );
+  benchScan ( 16777216, 4, 0 );
+  benchScan ( 1 << 28, 64, VEB_SPARSE );
+  benchCount ( 16777216, 4194304, 100000, 65536 );
+  benchSetAlgebra ( 16777216, 4194304, 0 );
+  benchSetAlgebra ( 1 << 30, 1 << 20, VEB_SPARSE );
+  benchConcurrent ( 16777216, 1 << 20, 4194304, 8, 10 );
+  benchConcurrent ( 16777216, 1 << 20, 4194304, 8, 1 );
+  benchParallel ( 1 << 28, 64, 8, 0 );
+  benchParallel ( 1 << 30, 256, 8, VEB_SPARSE );
+  benchImage ( 1 << 26, 1 << 22, 4194304, 0 );
+  benchImage ( 1 << 30, 1 << 20, 4194304, VEB_SPARSE );
+  benchDurable ( 1 << 24, 64, 1 << 20, 0 );
+  benchDurable ( 1 << 30, 256, 1 << 20, VEB_SPARSE );
+  benchSnapshot ( 1 << 24, 1 << 22, 1 << 20, 0 );
+  benchSnapshot ( 1 << 30, 1 << 20, 1 << 20, VEB_SPARSE );
+  benchCompact ( 1 << 26, 1 << 23, 1 << 22, 0 );
+  benchCompact ( 1 << 30, 1 << 22, 1 << 22, VEB_SPARSE );
+  benchDijkstra ( 1 << 21, 8, 1 << 10 );
+  benchDijkstra ( 1 << 21, 8, 1 << 20 );
+  benchMultiset ( 1 << 30, 1 << 16, 1 << 22 );
+  benchMultiset ( 1 << 30, 1 << 20, 1 << 22 );
+
+  // built with VEB_STATS, the statistics of the whole run
+  TvEBStats stats;
+  if ( vEB_stats_snapshot ( stats ) ) vEB_stats_print ( stats, std::cout );
+  return 0;
+}
@@ -1,6 +1,25 @@
 #include <cstdlib>
 #include <cmath>
+#include <set>
+#include <map>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <unistd.h>
+#include <fcntl.h>
 #include "veb.hpp"
+#include "vebt.hpp"
+#include "vebflat.hpp"
+#include "vebmap.hpp"
+#include "vebconc.hpp"
+#include "vebshard.hpp"
+#include "vebpool.hpp"
+#include "vebfile.hpp"
+#include "vebwal.hpp"
+#include "vebsnap.hpp"
+#include "vebstats.hpp"
+#include "vebpq.hpp"
+#include "vebmulti.hpp"
 
 void testSuite1()
 {
@@ -190,7 +209,7 @@ void testSuite1()
   if ( tree ) delete tree;
 }
 
-void testSuite2 ( int universe = 65536 )
+void testSuite2 ( int universe = 65536, TvEBArena * arena = NULL, int flags = 0 )
 {
   if ( universe < 64 )
   {
@@ -202,7 +221,7 @@ void testSuite2 ( int universe = 65536 )
   int testCnt = 0;
   int failedTestsCnt = 0;
 
-  TvEB * tree = new TvEB ( universe );
+  TvEB * tree = arena ? arena->alloc ( universe, flags ) : new TvEB ( universe, NULL, flags );
 
   int timer = time ( NULL );
   // std::cout << timer << std::endl;
@@ -355,16 +374,2142 @@ void testSuite2 ( int universe = 65536 )
 
   std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
 
+  delete [] numbers;
+  if ( arena ) arena->clear();
+  else if ( tree ) delete tree;
+}
+
+template <unsigned Bits>
+void testSuite3 ( int keyCnt, int queryCnt )
+{
+  typedef typename TvEBT<Bits>::key_type key_type;
+
+  int res;
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  TvEBT<Bits> * tree = new TvEBT<Bits>();
+  std::set<key_type> numbers;
+
+  srand ( time ( NULL ) );
+  key_type mask = TvEBT<Bits>::MAX_KEY;
+  // keys are drawn around a few random centers so that clusters get shared
+  key_type centers[4];
+  for ( int i = 0; i < 4; ++i )
+  {
+    centers[i] = ( ( ( uint64_t ) rand() << 42 ) ^ ( ( uint64_t ) rand() << 21 ) ^ rand() ) & mask;
+  }
+
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    key_type key = ( centers[rand() % 4] + rand() % ( keyCnt * 4 ) ) & mask;
+    bool isNew = numbers.insert ( key ).second;
+    res = vEB_insert ( tree, key );
+    testCnt++;
+    if ( res != isNew )
+    {
+      std::cout << "insert of " << key << " returned " << res << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+  }
+
+  for ( int i = 0; i < keyCnt / 2; ++i )
+  {
+    key_type key = ( centers[rand() % 4] + rand() % ( keyCnt * 4 ) ) & mask;
+    bool isIn = numbers.erase ( key );
+    res = vEB_delete ( tree, key );
+    testCnt++;
+    if ( res != isIn )
+    {
+      std::cout << "delete of " << key << " returned " << res << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+  }
+
+  key_type extreme;
+  testCnt++;
+  if ( !vEB_min ( tree, extreme ) || extreme != *numbers.begin() )
+  {
+    std::cout << "failed to find minimum, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+  testCnt++;
+  if ( !vEB_max ( tree, extreme ) || extreme != *numbers.rbegin() )
+  {
+    std::cout << "failed to find maximum, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    key_type key = ( centers[rand() % 4] + rand() % ( keyCnt * 4 ) ) & mask;
+    res = vEB_find ( tree, key );
+    testCnt++;
+    if ( res != ( numbers.count ( key ) > 0 ) )
+    {
+      std::cout << "find of " << key << " returned " << res << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+
+    key_type found;
+    typename std::set<key_type>::iterator it = numbers.upper_bound ( key );
+    res = vEB_succ ( tree, key, found );
+    testCnt++;
+    if ( res != ( it != numbers.end() ) || ( res && found != *it ) )
+    {
+      std::cout << "failed to find successor of number " << key << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+
+    it = numbers.lower_bound ( key );
+    res = vEB_pred ( tree, key, found );
+    testCnt++;
+    if ( res != ( it != numbers.begin() ) || ( res && found != *--it ) )
+    {
+      std::cout << "failed to find predecessor of number " << key << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+  }
+
+  for ( typename std::set<key_type>::iterator it = numbers.begin(); it != numbers.end(); ++it )
+  {
+    res = vEB_delete ( tree, *it );
+    testCnt++;
+    if ( !res ) { std::cout << "failed to delete " << *it << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+  testCnt++;
+  if ( tree ) { std::cout << "emptied tree was not released, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
   if ( tree ) delete tree;
 }
 
+void testSuite4 ( int universe = 1 << 20, int flags = 0 )
+{
+  int res;
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  TvEBArena arena;
+  TvEB * tree = arena.alloc ( universe, flags );
+  char * pos = NULL;
+
+  for ( int round = 0; round < 3; ++round )
+  {
+    for ( int i = round; i < universe; i += 3 )
+    {
+      res = vEB_insert ( tree, i, universe, &arena, flags );
+      testCnt++;
+      if ( !res ) { std::cout << "failed to insert " << i << " in round " << round << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+    }
+
+    if ( round == 0 )
+    {
+      pos = arena.pos;
+    }
+    else
+    {
+      // the nodes emptied in the previous round are reused
+      testCnt++;
+      if ( arena.pos != pos ) { std::cout << "arena grew in round " << round << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+    }
+
+    for ( int i = round; i < universe; i += 3 )
+    {
+      res = vEB_delete ( tree, i );
+      testCnt++;
+      if ( !res ) { std::cout << "failed to delete " << i << " in round " << round << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+    }
+    testCnt++;
+    if ( tree ) { std::cout << "emptied tree was not released in round " << round << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+}
+
+void testSuite5 ( int universe, int queryCnt )
+{
+  int res;
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  TvEBFlat * tree = new TvEBFlat ( universe );
+  char * numbers = new char [universe]();
+
+  srand ( time ( NULL ) );
+  for ( int i = 0; i < universe; ++i )
+  {
+    int idx = rand() % universe;
+    res = vEB_insert ( tree, idx );
+    testCnt++;
+    if ( res == numbers[idx] ) { std::cout << "insert of " << idx << " returned " << res << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+    numbers[idx] = 1;
+  }
+
+  for ( int i = 0; i < universe / 2; ++i )
+  {
+    int idx = rand() % universe;
+    res = vEB_delete ( tree, idx );
+    testCnt++;
+    if ( res != numbers[idx] ) { std::cout << "delete of " << idx << " returned " << res << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+    numbers[idx] = 0;
+  }
+
+  int realMin = 0, realMax = universe - 1, extreme;
+  while ( realMin < universe && !numbers[realMin] ) ++realMin;
+  while ( realMax >= 0 && !numbers[realMax] ) --realMax;
+  testCnt++;
+  if ( !vEB_min ( tree, extreme ) || extreme != realMin ) { std::cout << "failed to find minimum, test number " << testCnt << std::endl; failedTestsCnt++; }
+  testCnt++;
+  if ( !vEB_max ( tree, extreme ) || extreme != realMax ) { std::cout << "failed to find maximum, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    int idx = queryCnt >= universe ? i % ( universe + 1 ) : rand() % ( universe + 1 );
+
+    if ( idx < universe )
+    {
+      res = vEB_find ( tree, idx );
+      testCnt++;
+      if ( res != numbers[idx] ) { std::cout << "find of " << idx << " returned " << res << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+    }
+
+    int found;
+    int realSucc = idx;
+    while ( realSucc < universe && !numbers[realSucc] ) ++realSucc;
+    res = vEB_succ ( tree, idx - 1, found );
+    testCnt++;
+    if ( res != ( realSucc < universe ) || ( res && found != realSucc ) )
+    {
+      std::cout << "failed to find successor of number " << idx - 1 << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+
+    int realPred = idx - 1;
+    while ( realPred >= 0 && !numbers[realPred] ) --realPred;
+    res = vEB_pred ( tree, idx, found );
+    testCnt++;
+    if ( res != ( realPred >= 0 ) || ( res && found != realPred ) )
+    {
+      std::cout << "failed to find predecessor of number " << idx << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+  }
+
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( numbers[i] && !vEB_delete ( tree, i ) ) { std::cout << "failed to delete " << i << std::endl; failedTestsCnt++; }
+  }
+  testCnt++;
+  if ( vEB_min ( tree, extreme ) ) { std::cout << "emptied tree has minimum " << extreme << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete [] numbers;
+  delete tree;
+}
+
+void testSuite6 ( int universe, int keyCnt, int queryCnt )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  TvEBMap<long> * tree = new TvEBMap<long> ( universe );
+  std::map<int, long> reference;
+
+  srand ( time ( NULL ) );
+  for ( int i = 0; i < keyCnt; ++i )
+  {
+    int key = rand() % universe;
+    long value = rand();
+    bool res = vEB_insert ( tree, key, value );
+    testCnt++;
+    if ( res != reference.insert ( std::make_pair ( key, value ) ).second ) { std::cout << "insert of " << key << " returned " << res << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+
+  for ( int i = 0; i < keyCnt / 2; ++i )
+  {
+    int key = rand() % universe;
+    bool res = vEB_delete ( tree, key );
+    testCnt++;
+    if ( res != ( bool ) reference.erase ( key ) ) { std::cout << "delete of " << key << " returned " << res << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+
+  int key;
+  long value;
+  testCnt++;
+  if ( !vEB_min ( tree, key, value ) || key != reference.begin()->first || value != reference.begin()->second ) { std::cout << "failed to find minimum, test number " << testCnt << std::endl; failedTestsCnt++; }
+  testCnt++;
+  if ( !vEB_max ( tree, key, value ) || key != reference.rbegin()->first || value != reference.rbegin()->second ) { std::cout << "failed to find maximum, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    int idx = queryCnt >= universe ? i % ( universe + 1 ) : rand() % ( universe + 1 );
+
+    std::map<int, long>::iterator it = reference.find ( idx );
+    bool res = vEB_find ( tree, idx, value );
+    testCnt++;
+    if ( res != ( it != reference.end() ) || ( res && value != it->second ) ) { std::cout << "find of " << idx << " returned " << res << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+
+    it = reference.lower_bound ( idx );
+    res = vEB_succ ( tree, idx - 1, key, value );
+    testCnt++;
+    if ( res != ( it != reference.end() ) || ( res && ( key != it->first || value != it->second ) ) )
+    {
+      std::cout << "failed to find successor of number " << idx - 1 << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+
+    res = vEB_pred ( tree, idx, key, value );
+    testCnt++;
+    if ( res != ( it != reference.begin() ) || ( res && ( key != ( --it )->first || value != it->second ) ) )
+    {
+      std::cout << "failed to find predecessor of number " << idx << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+  }
+
+  for ( std::map<int, long>::iterator it = reference.begin(); it != reference.end(); ++it )
+  {
+    long * found = vEB_find_value ( tree, it->first );
+    if ( found ) *found += 1;
+  }
+  for ( std::map<int, long>::iterator it = reference.begin(); it != reference.end(); ++it )
+  {
+    testCnt++;
+    if ( !vEB_find ( tree, it->first, value ) || value != it->second + 1 ) { std::cout << "value of " << it->first << " was not updated in place, test number " << testCnt << std::endl; failedTestsCnt++; }
+    if ( !vEB_delete ( tree, it->first ) ) { std::cout << "failed to delete " << it->first << std::endl; failedTestsCnt++; }
+  }
+  testCnt++;
+  if ( tree ) { std::cout << "emptied map was not released, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete tree;
+}
+
+void testSuite7 ( int universe, int batchCnt, TvEBArena * arena = NULL, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  TvEB * tree = NULL;
+  char * numbers = new char [universe]();
+  int * batch = new int [universe];
+
+  srand ( time ( NULL ) );
+  for ( int round = 0; round < batchCnt; ++round )
+  {
+    // a random batch with duplicates and negative values, or a
+    // sorted run of consecutive values
+    int n = rand() % ( universe / 4 + 1 );
+    bool sorted = rand() % 3 == 0;
+    int start = rand() % universe;
+    for ( int i = 0; i < n; ++i )
+    {
+      batch[i] = sorted ? ( start + i ) % universe : rand() % ( universe + 1 ) - 1;
+    }
+
+    bool insert = rand() % 3 != 0;
+    size_t expected = 0;
+    for ( int i = 0; i < n; ++i )
+    {
+      if ( batch[i] < 0 || batch[i] >= universe ) continue;
+      if ( numbers[batch[i]] != insert )
+      {
+        numbers[batch[i]] = insert;
+        expected++;
+      }
+    }
+
+    size_t res = insert ? vEB_insert_batch ( tree, batch, n, universe, arena, flags )
+                 : vEB_delete_batch ( tree, batch, n );
+    testCnt++;
+    if ( res != expected )
+    {
+      std::cout << ( insert ? "insert" : "delete" ) << " of a batch of " << n << " returned " << res
+                << " instead of " << expected << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+
+    int found = -1;
+    int real = -1;
+    for ( ;; )
+    {
+      do ++real; while ( real < universe && !numbers[real] );
+      bool res = vEB_succ ( tree, found, found );
+      testCnt++;
+      if ( res != ( real < universe ) || ( res && found != real ) )
+      {
+        std::cout << "successor walk went to " << found << " instead of " << real << ", test number " << testCnt << std::endl;
+        failedTestsCnt++;
+        break;
+      }
+      if ( !res ) break;
+    }
+
+    int extreme;
+    real = universe;
+    do --real; while ( real >= 0 && !numbers[real] );
+    testCnt++;
+    if ( real >= 0 && ( !vEB_max ( tree, extreme ) || extreme != real ) ) { std::cout << "failed to find maximum, test number " << testCnt << std::endl; failedTestsCnt++; }
+    testCnt++;
+    if ( real < 0 && tree ) { std::cout << "emptied tree was not released, test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+
+  int cnt = 0;
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( numbers[i] ) batch[cnt++] = i;
+  }
+  testCnt++;
+  if ( vEB_delete_batch ( tree, batch, cnt ) != ( size_t ) cnt || tree ) { std::cout << "failed to empty the tree, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete [] batch;
+  delete [] numbers;
+  if ( arena ) arena->clear();
+  else delete tree;
+}
+
+void testSuite8 ( int universe, int density, TvEBArena * arena = NULL, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  char * numbers = new char [universe]();
+  int * keys = new int [universe];
+  int keyCnt = 0;
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 )
+    {
+      numbers[i] = 1;
+      keys[keyCnt++] = i;
+    }
+  }
+
+  TvEB * tree = vEB_build_from_sorted ( keys, keyCnt, universe, arena, flags );
+  testCnt++;
+  if ( !tree ) { std::cout << "failed to build the tree, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  int found = -1;
+  for ( int i = 0; i <= keyCnt; ++i )
+  {
+    bool res = vEB_succ ( tree, found, found );
+    testCnt++;
+    if ( res != ( i < keyCnt ) || ( res && found != keys[i] ) )
+    {
+      std::cout << "successor walk went to " << found << " instead of " << keys[i] << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+      break;
+    }
+  }
+
+  for ( int i = 0; i < universe / 8; ++i )
+  {
+    int idx = rand() % universe;
+    testCnt++;
+    if ( vEB_find ( tree, idx ) != numbers[idx] ) { std::cout << "find of " << idx << " failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+    int realPred = idx - 1;
+    while ( realPred >= 0 && !numbers[realPred] ) --realPred;
+    bool res = vEB_pred ( tree, idx, found );
+    testCnt++;
+    if ( res != ( realPred >= 0 ) || ( res && found != realPred ) )
+    {
+      std::cout << "failed to find predecessor of number " << idx << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+  }
+
+  // the built tree has to stay consistent under the ordinary updates
+  for ( int i = 0; i < universe / 4; ++i )
+  {
+    int idx = rand() % universe;
+    bool res = numbers[idx] ? vEB_delete ( tree, idx ) : vEB_insert ( tree, idx );
+    numbers[idx] = !numbers[idx];
+    testCnt++;
+    if ( !res ) { std::cout << "failed to toggle " << idx << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( numbers[i] && !vEB_delete ( tree, i ) ) { std::cout << "failed to delete " << i << std::endl; failedTestsCnt++; }
+  }
+  testCnt++;
+  if ( tree && tree->min != UNDEFINED ) { std::cout << "emptied tree has minimum " << tree->min << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  int unsorted[] = { 5, 3 };
+  testCnt++;
+  if ( vEB_build_from_sorted ( unsorted, 2, universe ) ) { std::cout << "built a tree from unsorted values, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete [] keys;
+  delete [] numbers;
+  if ( arena ) arena->clear();
+  else delete tree;
+}
+
+void testSuite9 ( int universe, int density, int queryCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEB * tree = new TvEB ( universe, NULL, flags );
+  char * numbers = new char [universe]();
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 )
+    {
+      numbers[i] = 1;
+      vEB_insert ( tree, i );
+    }
+  }
+
+  // the queries cover both ends and the values out of the universe
+  int * queries = new int [queryCnt];
+  int * succs = new int [queryCnt];
+  int * preds = new int [queryCnt];
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    queries[i] = i < 4 ? i - 2 + ( i / 2 ) * universe : rand() % ( universe + 2 ) - 1;
+  }
+
+  size_t succCnt = vEB_succ_batch ( tree, queries, queryCnt, succs );
+  size_t predCnt = vEB_pred_batch ( tree, queries, queryCnt, preds );
+
+  size_t realSuccCnt = 0, realPredCnt = 0;
+  for ( int i = 0; i < queryCnt; ++i )
+  {
+    int val = queries[i];
+    int realSucc = UNDEFINED;
+    if ( val >= -1 && val < universe )
+    {
+      realSucc = val + 1;
+      while ( realSucc < universe && !numbers[realSucc] ) ++realSucc;
+      if ( realSucc == universe ) realSucc = UNDEFINED;
+    }
+    realSuccCnt += realSucc != UNDEFINED;
+    testCnt++;
+    if ( succs[i] != realSucc )
+    {
+      std::cout << "successor of " << val << " found as " << succs[i] << " instead of " << realSucc << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+
+    int realPred = UNDEFINED;
+    if ( val >= 0 && val <= universe )
+    {
+      realPred = val - 1;
+      while ( realPred >= 0 && !numbers[realPred] ) --realPred;
+      if ( realPred < 0 ) realPred = UNDEFINED;
+    }
+    realPredCnt += realPred != UNDEFINED;
+    testCnt++;
+    if ( preds[i] != realPred )
+    {
+      std::cout << "predecessor of " << val << " found as " << preds[i] << " instead of " << realPred << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+  }
+  testCnt++;
+  if ( succCnt != realSuccCnt || predCnt != realPredCnt ) { std::cout << "wrong number of found elements, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete [] preds;
+  delete [] succs;
+  delete [] queries;
+  delete [] numbers;
+  delete tree;
+}
+
+bool collect ( int val, void * ctx )
+{
+  std::vector<int> * vals = ( std::vector<int> * ) ctx;
+  vals->push_back ( val );
+  return vals->size() < vals->capacity();
+}
+
+void testSuite10 ( int universe, int density, TvEBArena * arena = NULL, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEB * tree = arena ? arena->alloc ( universe, flags ) : new TvEB ( universe, NULL, flags );
+  std::vector<int> keys;
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 )
+    {
+      keys.push_back ( i );
+      vEB_insert ( tree, i );
+    }
+  }
+  int keyCnt = keys.size();
+
+  TvEBIterator it;
+  bool valid = vEB_iter_succ ( tree, it, -1 );
+  for ( int i = 0; i <= keyCnt; ++i, valid = vEB_iter_next ( it ) )
+  {
+    testCnt++;
+    if ( valid != ( i < keyCnt ) || ( valid && it.val != keys[i] ) )
+    {
+      std::cout << "forward iteration went to " << it.val << " instead of " << ( i < keyCnt ? keys[i] : UNDEFINED ) << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+      break;
+    }
+  }
+
+  valid = vEB_iter_pred ( tree, it, universe );
+  for ( int i = keyCnt - 1; i >= -1; --i, valid = vEB_iter_prev ( it ) )
+  {
+    testCnt++;
+    if ( valid != ( i >= 0 ) || ( valid && it.val != keys[i] ) )
+    {
+      std::cout << "reverse iteration went to " << it.val << " instead of " << ( i >= 0 ? keys[i] : UNDEFINED ) << ", test number " << testCnt << std::endl;
+      failedTestsCnt++;
+      break;
+    }
+  }
+
+  // a random walk in both directions from random starting points
+  for ( int walk = 0; walk < 100 && keyCnt; ++walk )
+  {
+    int val = rand() % universe;
+    int i = std::upper_bound ( keys.begin(), keys.end(), val ) - keys.begin();
+    valid = vEB_iter_succ ( tree, it, val );
+    for ( int step = 0; step < 200; ++step )
+    {
+      testCnt++;
+      if ( valid != ( i < keyCnt ) || ( valid && it.val != keys[i] ) )
+      {
+        std::cout << "random walk went to " << it.val << " instead of " << ( i < keyCnt ? keys[i] : UNDEFINED ) << ", test number " << testCnt << std::endl;
+        failedTestsCnt++;
+        break;
+      }
+      if ( !valid ) break;
+      if ( rand() % 3 ) { valid = vEB_iter_next ( it ); ++i; }
+      else { valid = vEB_iter_prev ( it ); --i; }
+      if ( i < 0 ) break;
+    }
+  }
+
+  for ( int scan = 0; scan < 100; ++scan )
+  {
+    int lo = rand() % universe - 1;
+    int hi = lo + rand() % ( universe / 4 + 1 );
+    size_t limit = rand() % 4 ? keyCnt + 1 : rand() % 20 + 1;
+    std::vector<int> vals;
+    vals.reserve ( limit );
+    size_t cnt = vEB_range ( tree, lo, hi, collect, &vals );
+
+    std::vector<int>::iterator first = std::lower_bound ( keys.begin(), keys.end(), lo );
+    std::vector<int>::iterator last = std::upper_bound ( keys.begin(), keys.end(), hi );
+    if ( ( size_t ) ( last - first ) > vals.capacity() ) last = first + vals.capacity();
+    testCnt++;
+    if ( cnt != vals.size() || !std::equal ( first, last, vals.begin() ) || ( size_t ) ( last - first ) != vals.size() )
+    {
+      std::cout << "range scan from " << lo << " to " << hi << " returned " << cnt << " elements, test number " << testCnt << std::endl;
+      failedTestsCnt++;
+    }
+  }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  if ( arena ) arena->clear();
+  else delete tree;
+}
+
+void testSuite11 ( int universe, int opCnt, TvEBArena * arena = NULL, int flags = VEB_COUNTED )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEB * tree = arena ? arena->alloc ( universe, flags ) : new TvEB ( universe, NULL, flags );
+  std::set<int> reference;
+  std::vector<int> batch;
+
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    int val = rand() % universe;
+    switch ( rand() % 8 )
+    {
+      case 0:
+        reference.erase ( val );
+        vEB_delete ( tree, val );
+        break;
+      case 1:
+        // batches keep the counts too
+        batch.clear();
+        for ( int j = rand() % 100; j > 0; --j ) batch.push_back ( ( val + rand() % 1000 ) % universe );
+        if ( rand() % 2 )
+        {
+          reference.insert ( batch.begin(), batch.end() );
+          vEB_insert_batch ( tree, batch.data(), batch.size(), universe, arena, flags );
+        }
+        else
+        {
+          for ( size_t j = 0; j < batch.size(); ++j ) reference.erase ( batch[j] );
+          vEB_delete_batch ( tree, batch.data(), batch.size() );
+        }
+        break;
+      default:
+        reference.insert ( val );
+        vEB_insert ( tree, val, universe, arena, flags );
+    }
+  }
+
+  std::vector<int> keys ( reference.begin(), reference.end() );
+  int keyCnt = keys.size();
+  for ( int i = 0; i < 10000; ++i )
+  {
+    int val = rand() % ( universe + 2 ) - 1;
+    int realRank = std::lower_bound ( keys.begin(), keys.end(), val ) - keys.begin();
+    testCnt++;
+    if ( vEB_rank ( tree, val ) != realRank ) { std::cout << "rank of " << val << " is " << vEB_rank ( tree, val ) << " instead of " << realRank << ", test number " << testCnt << std::endl; failedTestsCnt++; }
+
+    int k = rand() % ( keyCnt + 2 ) - 1;
+    int res;
+    bool found = vEB_select ( tree, k, res );
+    testCnt++;
+    if ( found != ( k >= 0 && k < keyCnt ) || ( found && res != keys[k] ) ) { std::cout << "select of " << k << " failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+    int lo = rand() % universe;
+    int hi = lo + rand() % ( universe / 8 + 1 );
+    int realCount = std::upper_bound ( keys.begin(), keys.end(), hi ) - std::lower_bound ( keys.begin(), keys.end(), lo );
+    testCnt++;
+    if ( vEB_count ( tree, lo, hi ) != realCount ) { std::cout << "count from " << lo << " to " << hi << " failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+
+  TvEB * built = vEB_build_from_sorted ( keys.data(), keyCnt, universe, NULL, flags );
+  for ( int i = 0; i < 1000; ++i )
+  {
+    int val = rand() % universe;
+    testCnt++;
+    if ( vEB_rank ( built, val ) != vEB_rank ( tree, val ) ) { std::cout << "rank of " << val << " in the built tree failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+  delete built;
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  if ( arena ) arena->clear();
+  else delete tree;
+}
+
+std::vector<int> elements ( TvEB * tree )
+{
+  std::vector<int> res;
+  TvEBIterator it;
+  for ( bool valid = vEB_iter_succ ( tree, it, -1 ); valid; valid = vEB_iter_next ( it ) ) res.push_back ( it.val );
+  return res;
+}
+
+void testSuite12 ( int universe, int densityA, int densityB, int flagsA = 0, int flagsB = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEB * a = new TvEB ( universe, NULL, flagsA );
+  TvEB * b = new TvEB ( universe, NULL, flagsB );
+  std::vector<int> keysA, keysB;
+  for ( int i = 0; i < universe; ++i )
+  {
+    // b shares runs with a so that both whole and partial clusters match
+    bool inA = rand() % densityA == 0;
+    bool inB = ( i / 100 ) % 3 == 0 ? inA : rand() % densityB == 0;
+    if ( inA ) { keysA.push_back ( i ); vEB_insert ( a, i ); }
+    if ( inB ) { keysB.push_back ( i ); vEB_insert ( b, i ); }
+  }
+
+  std::vector<int> expected[3];
+  std::set_union ( keysA.begin(), keysA.end(), keysB.begin(), keysB.end(), std::back_inserter ( expected[0] ) );
+  std::set_intersection ( keysA.begin(), keysA.end(), keysB.begin(), keysB.end(), std::back_inserter ( expected[1] ) );
+  std::set_difference ( keysA.begin(), keysA.end(), keysB.begin(), keysB.end(), std::back_inserter ( expected[2] ) );
+  const char * names[3] = { "union", "intersection", "difference" };
+
+  TvEB * res[3] = { vEB_union ( a, b ), vEB_intersect ( a, b, NULL, VEB_SPARSE ), vEB_difference ( a, b ) };
+  for ( int i = 0; i < 3; ++i )
+  {
+    testCnt++;
+    if ( elements ( res[i] ) != expected[i] ) { std::cout << names[i] << " of the trees failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+    delete res[i];
+  }
+
+  TvEB * empty = new TvEB ( universe );
+  res[0] = vEB_union ( a, NULL );
+  res[1] = vEB_intersect ( a, empty );
+  res[2] = vEB_difference ( a, empty );
+  testCnt++;
+  if ( elements ( res[0] ) != keysA || elements ( res[1] ).size() || elements ( res[2] ) != keysA ) { std::cout << "operation with an empty tree failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+  for ( int i = 0; i < 3; ++i ) delete res[i];
+  delete empty;
+
+  size_t sizes[3] = { expected[0].size() - keysA.size(), keysA.size() - expected[1].size(), expected[1].size() };
+  for ( int i = 0; i < 3; ++i )
+  {
+    TvEB * copy = vEB_union ( a, NULL, NULL, flagsA );
+    size_t changed = i == 0 ? vEB_union_into ( copy, b ) : i == 1 ? vEB_intersect_into ( copy, b ) : vEB_difference_into ( copy, b );
+    testCnt++;
+    if ( changed != sizes[i] || elements ( copy ) != expected[i] ) { std::cout << names[i] << " in place failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+    delete copy;
+  }
+
+  // a union into an empty tree owns its nodes, they outlive the arena of b
+  TvEBArena * arena = new TvEBArena();
+  TvEB * inArena = vEB_union ( b, NULL, arena, flagsB );
+  TvEB * merged = NULL;
+  vEB_union_into ( merged, inArena, NULL, flagsA );
+  delete arena;
+  testCnt++;
+  if ( elements ( merged ) != keysB || ( merged && ( merged->arena || merged->flags != flagsA ) ) ) { std::cout << "union into an empty tree took the arena of the other, test number " << testCnt << std::endl; failedTestsCnt++; }
+  if ( merged ) delete merged;
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete b;
+  delete a;
+}
+
+template <typename T>
+struct TStressArgs
+{
+  T * tree;
+  int id;
+  int threadCnt;
+  int stride;
+  int opCnt;
+  std::set<int> keys;
+  int failed;
+};
+
+template <typename T>
+void * stressWorker ( void * arg )
+{
+  TStressArgs<T> * a = ( TStressArgs<T> * ) arg;
+  unsigned seed = a->id * 7919 + 1;
+  int uni = a->tree->uni;
+  int res;
+  for ( int i = 0; i < a->opCnt; ++i )
+  {
+    int val = rand_r ( &seed ) % uni;
+    int key = val - val % a->threadCnt + a->id;
+    switch ( rand_r ( &seed ) % 4 )
+    {
+      case 0:
+        // the thread owns the keys congruent to its id, except the stable ones
+        if ( key >= uni || key % a->stride == 0 ) break;
+        if ( vEB_insert ( a->tree, key ) != a->keys.insert ( key ).second ) a->failed++;
+        break;
+      case 1:
+        if ( key >= uni || key % a->stride == 0 ) break;
+        if ( vEB_delete ( a->tree, key ) != ( a->keys.erase ( key ) == 1 ) ) a->failed++;
+        break;
+      case 2:
+        // the successor lies between the value and the next stable key
+        if ( !vEB_succ ( a->tree, val, res ) )
+        {
+          if ( val + a->stride - val % a->stride < uni ) a->failed++;
+        }
+        else if ( res <= val || res > val + a->stride - val % a->stride ) a->failed++;
+        break;
+      case 3:
+        if ( !vEB_pred ( a->tree, val, res ) )
+        {
+          if ( val > 0 ) a->failed++;
+        }
+        else if ( res >= val || res < ( val - 1 ) - ( val - 1 ) % a->stride ) a->failed++;
+        if ( !vEB_find ( a->tree, val - val % a->stride ) ) a->failed++;
+        break;
+    }
+  }
+  return NULL;
+}
+
+template <typename T>
+void stressTest ( T * tree, int threadCnt, int opCnt, int & testCnt, int & failedTestsCnt )
+{
+  int stride = 97;
+  std::set<int> expected;
+  for ( int i = 0; i < tree->uni; i += stride )
+  {
+    vEB_insert ( tree, i );
+    expected.insert ( i );
+  }
+
+  std::vector<TStressArgs<T> > args ( threadCnt );
+  std::vector<pthread_t> threads ( threadCnt );
+  for ( int i = 0; i < threadCnt; ++i )
+  {
+    args[i].tree = tree;
+    args[i].id = i;
+    args[i].threadCnt = threadCnt;
+    args[i].stride = stride;
+    args[i].opCnt = opCnt;
+    args[i].failed = 0;
+    pthread_create ( &threads[i], NULL, stressWorker<T>, &args[i] );
+  }
+  for ( int i = 0; i < threadCnt; ++i )
+  {
+    pthread_join ( threads[i], NULL );
+    testCnt++;
+    if ( args[i].failed ) { std::cout << "thread " << i << " saw " << args[i].failed << " wrong results, test number " << testCnt << std::endl; failedTestsCnt++; }
+    expected.insert ( args[i].keys.begin(), args[i].keys.end() );
+  }
+
+  std::vector<int> found;
+  int res = -1;
+  while ( vEB_succ ( tree, res, res ) ) found.push_back ( res );
+  testCnt++;
+  if ( found != std::vector<int> ( expected.begin(), expected.end() ) ) { std::cout << "final contents of the concurrent tree differ, test number " << testCnt << std::endl; failedTestsCnt++; }
+  int lo, hi;
+  testCnt++;
+  if ( !vEB_min ( tree, lo ) || !vEB_max ( tree, hi ) || lo != *expected.begin() || hi != *expected.rbegin() ) { std::cout << "minimum or maximum of the concurrent tree is wrong, test number " << testCnt << std::endl; failedTestsCnt++; }
+  std::vector<int> back;
+  res = tree->uni;
+  while ( vEB_pred ( tree, res, res ) ) back.push_back ( res );
+  testCnt++;
+  if ( back != std::vector<int> ( expected.rbegin(), expected.rend() ) ) { std::cout << "backward walk of the concurrent tree failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+}
+
+void testSuite13 ( int universe, int threadCnt, int opCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  TvEBConcurrent * tree = new TvEBConcurrent ( universe, flags );
+  stressTest ( tree, threadCnt, opCnt, testCnt, failedTestsCnt );
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete tree;
+}
+
+struct TRcuArgs
+{
+  TvEBRcu * tree;
+  int id;
+  int stride;
+  int * stop;
+  int failed;
+};
+
+void * rcuReader ( void * arg )
+{
+  TRcuArgs * a = ( TRcuArgs * ) arg;
+  unsigned seed = a->id * 7919 + 1;
+  int uni = a->tree->uni;
+  int reader = vEB_rcu_register ( a->tree );
+  int res;
+  while ( !__atomic_load_n ( a->stop, __ATOMIC_RELAXED ) )
+  {
+    // every answer must lie between the value and the closest stable keys
+    int val = rand_r ( &seed ) % uni;
+    if ( !vEB_succ ( a->tree, reader, val, res ) )
+    {
+      if ( val + a->stride - val % a->stride < uni ) a->failed++;
+    }
+    else if ( res <= val || res > val + a->stride - val % a->stride ) a->failed++;
+    if ( !vEB_pred ( a->tree, reader, val, res ) )
+    {
+      if ( val > 0 ) a->failed++;
+    }
+    else if ( res >= val || res < ( val - 1 ) - ( val - 1 ) % a->stride ) a->failed++;
+    if ( !vEB_find ( a->tree, reader, val - val % a->stride ) ) a->failed++;
+    if ( !vEB_min ( a->tree, reader, res ) || res != 0 ) a->failed++;
+  }
+  vEB_rcu_unregister ( a->tree, reader );
+  return NULL;
+}
+
+void testSuite14 ( int universe, int readerCnt, int opCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  int stride = 97;
+  TvEBRcu * tree = new TvEBRcu ( universe, flags );
+  std::set<int> expected;
+  for ( int i = 0; i < tree->uni; i += stride )
+  {
+    vEB_insert ( tree, i );
+    expected.insert ( i );
+  }
+
+  int stop = 0;
+  std::vector<TRcuArgs> args ( readerCnt );
+  std::vector<pthread_t> threads ( readerCnt );
+  for ( int i = 0; i < readerCnt; ++i )
+  {
+    args[i].tree = tree;
+    args[i].id = i;
+    args[i].stride = stride;
+    args[i].stop = &stop;
+    args[i].failed = 0;
+    pthread_create ( &threads[i], NULL, rcuReader, &args[i] );
+  }
+
+  int wrong = 0;
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    int val = rand() % tree->uni;
+    if ( val % stride == 0 ) continue;
+    if ( rand() % 2 )
+    {
+      if ( vEB_insert ( tree, val ) != expected.insert ( val ).second ) wrong++;
+    }
+    else if ( vEB_delete ( tree, val ) != ( expected.erase ( val ) == 1 ) ) wrong++;
+  }
+  __atomic_store_n ( &stop, 1, __ATOMIC_RELAXED );
+  testCnt++;
+  if ( wrong ) { std::cout << "writer saw " << wrong << " wrong results, test number " << testCnt << std::endl; failedTestsCnt++; }
+  for ( int i = 0; i < readerCnt; ++i )
+  {
+    pthread_join ( threads[i], NULL );
+    testCnt++;
+    if ( args[i].failed ) { std::cout << "reader " << i << " saw " << args[i].failed << " wrong results, test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+
+  std::vector<int> found;
+  int reader = vEB_rcu_register ( tree );
+  int res = -1;
+  while ( vEB_succ ( tree, reader, res, res ) ) found.push_back ( res );
+  testCnt++;
+  if ( found != std::vector<int> ( expected.begin(), expected.end() ) ) { std::cout << "final contents of the read-mostly tree differ, test number " << testCnt << std::endl; failedTestsCnt++; }
+  std::vector<int> back;
+  res = tree->uni;
+  while ( vEB_pred ( tree, -1, res, res ) ) back.push_back ( res );
+  testCnt++;
+  if ( back != std::vector<int> ( expected.rbegin(), expected.rend() ) ) { std::cout << "backward walk without a reader slot failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+  vEB_rcu_unregister ( tree, reader );
+
+  int slots[VEB_RCU_READERS];
+  for ( int i = 0; i < VEB_RCU_READERS; ++i ) slots[i] = vEB_rcu_register ( tree );
+  testCnt++;
+  if ( slots[VEB_RCU_READERS - 1] < 0 || vEB_rcu_register ( tree ) != -1 ) { std::cout << "registering the readers failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+  for ( int i = 0; i < VEB_RCU_READERS; ++i ) vEB_rcu_unregister ( tree, slots[i] );
+
+  for ( std::set<int>::iterator it = expected.begin(); it != expected.end(); ++it ) vEB_delete ( tree, *it );
+  testCnt++;
+  if ( vEB_min ( tree, -1, res ) || tree->retiredCnt ) { std::cout << "emptying the read-mostly tree failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete tree;
+}
+
+void testSuite15 ( int shardCnt, int shardUni, int threadCnt, int opCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEBSharded * tree = new TvEBSharded ( shardCnt, shardUni, flags );
+  std::set<int> keys;
+  int res;
+  testCnt++;
+  if ( vEB_min ( tree, res ) || vEB_succ ( tree, -1, res ) || vEB_pred ( tree, tree->uni, res ) ) { std::cout << "empty sharded tree is not empty, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  int wrong = 0;
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    int val = rand() % tree->uni;
+    switch ( rand() % 4 )
+    {
+      case 0:
+      case 1:
+        if ( vEB_insert ( tree, val ) != keys.insert ( val ).second ) wrong++;
+        break;
+      case 2:
+        if ( vEB_delete ( tree, val ) != ( keys.erase ( val ) == 1 ) ) wrong++;
+        break;
+      case 3:
+      {
+        std::set<int>::iterator it = keys.upper_bound ( val );
+        bool found = vEB_succ ( tree, val, res );
+        if ( found != ( it != keys.end() ) || ( found && res != *it ) ) wrong++;
+        it = keys.lower_bound ( val );
+        found = vEB_pred ( tree, val, res );
+        if ( found != ( it != keys.begin() ) || ( found && res != * -- it ) ) wrong++;
+        if ( vEB_find ( tree, val ) != ( keys.count ( val ) == 1 ) ) wrong++;
+        break;
+      }
+    }
+  }
+  testCnt++;
+  if ( wrong ) { std::cout << wrong << " operations of the sharded tree failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+  for ( std::set<int>::iterator it = keys.begin(); it != keys.end(); ++it ) vEB_delete ( tree, *it );
+  testCnt++;
+  if ( vEB_max ( tree, res ) ) { std::cout << "emptied sharded tree is not empty, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  // a universe of 2^31 values would overflow, the tree takes none
+  TvEBSharded * tooBig = new TvEBSharded ( shardCnt << 1, ( 1 << 30 ) / powTwoRoundUp ( shardCnt ), flags );
+  testCnt++;
+  if ( tooBig->uni || vEB_insert ( tooBig, 0 ) || vEB_min ( tooBig, res ) || vEB_pred ( tooBig, 1, res ) ) { std::cout << "sharded tree over 2^30 values is not rejected, test number " << testCnt << std::endl; failedTestsCnt++; }
+  delete tooBig;
+
+  stressTest ( tree, threadCnt, opCnt, testCnt, failedTestsCnt );
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete tree;
+}
+
+void countVisits ( int lo, int hi, void * ctx )
+{
+  int * visits = ( int * ) ctx;
+  for ( int i = lo; i < hi; ++i ) __atomic_fetch_add ( &visits[i], 1, __ATOMIC_RELAXED );
+}
+
+void testSuite16 ( int universe, int density, int threadCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEBPool pool ( threadCnt );
+  for ( int grain = 1; grain <= 1000; grain *= 10 )
+  {
+    std::vector<int> visits ( 10007, 0 );
+    vEB_pool_for ( &pool, 3, 10007, grain, countVisits, &visits[0] );
+    testCnt++;
+    if ( visits[0] || std::count ( visits.begin() + 3, visits.end(), 1 ) != 10004 ) { std::cout << "parallel loop with grain " << grain << " missed or repeated indices, test number " << testCnt << std::endl; failedTestsCnt++; }
+  }
+
+  std::vector<int> keys;
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 ) keys.push_back ( i );
+  }
+  TvEB * built = vEB_build_parallel ( keys.size() ? &keys[0] : NULL, keys.size(), universe, &pool, flags );
+  testCnt++;
+  if ( !built || elements ( built ) != keys ) { std::cout << "parallel build differs from the values, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  int wrong = 0;
+  for ( int i = 0; i < 10000 && built; ++i )
+  {
+    int val = rand() % universe;
+    bool present = std::binary_search ( keys.begin(), keys.end(), val );
+    if ( vEB_find ( built, val ) != present ) wrong++;
+    if ( present ? !vEB_delete ( built, val ) || !vEB_insert ( built, val ) : !vEB_insert ( built, val ) || !vEB_delete ( built, val ) ) wrong++;
+    if ( ( flags & VEB_COUNTED ) && vEB_rank ( built, val ) != std::lower_bound ( keys.begin(), keys.end(), val ) - keys.begin() ) wrong++;
+  }
+  testCnt++;
+  if ( wrong ) { std::cout << wrong << " operations on the parallel built tree failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+  vEB_destroy_parallel ( built, &pool );
+
+  int unsorted[3] = { 1, 3, 2 };
+  testCnt++;
+  if ( vEB_build_parallel ( unsorted, 3, 1 << 20, &pool ) ) { std::cout << "parallel build accepted unsorted values, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+}
+
+void testSuite17 ( int universe, int density, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  char path[64];
+  snprintf ( path, sizeof ( path ), "/tmp/veb_test_%d.img", ( int ) getpid() );
+  TvEB * tree = new TvEB ( universe, NULL, flags );
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 ) vEB_insert ( tree, i );
+  }
+  std::vector<int> keys = elements ( tree );
+
+  testCnt++;
+  if ( !vEB_save ( tree, path ) ) { std::cout << "failed to save the tree, test number " << testCnt << std::endl; failedTestsCnt++; }
+  TvEBImage * image = vEB_image_open ( path );
+  testCnt++;
+  if ( !image ) { std::cout << "failed to open the image, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  int wrong = 0;
+  int a, b;
+  if ( vEB_min ( image, a ) != ( keys.size() > 0 ) || ( keys.size() && a != keys.front() ) ) wrong++;
+  if ( vEB_max ( image, a ) != ( keys.size() > 0 ) || ( keys.size() && a != keys.back() ) ) wrong++;
+  for ( int i = 0; i < 20000; ++i )
+  {
+    int val = i < 2 ? ( i ? tree->uni : -1 ) : rand() % tree->uni;
+    bool found = vEB_succ ( image, val, a );
+    if ( found != vEB_succ ( tree, val, b ) || ( found && a != b ) ) wrong++;
+    found = vEB_pred ( image, val, a );
+    if ( ( found != vEB_pred ( tree, val, b ) || ( found && a != b ) ) && keys.size() ) wrong++;
+    if ( val >= 0 && val < tree->uni && vEB_find ( image, val ) != vEB_find ( tree, val ) ) wrong++;
+  }
+  testCnt++;
+  if ( wrong ) { std::cout << wrong << " queries of the image differ from the tree, test number " << testCnt << std::endl; failedTestsCnt++; }
+  vEB_image_close ( image );
+
+  TvEB * loaded = vEB_load ( path, NULL, flags );
+  testCnt++;
+  if ( !loaded || loaded->uni != tree->uni || elements ( loaded ) != keys ) { std::cout << "loaded tree differs from the saved one, test number " << testCnt << std::endl; failedTestsCnt++; }
+  delete loaded;
+
+  // damaged offsets are rejected when opening, an accepted image stays in its bounds
+  TvEBImageHeader header;
+  FILE * f = fopen ( path, "r+b" );
+  if ( fread ( &header, sizeof ( header ), 1, f ) != 1 ) header.bytes = 0;
+  if ( header.root >= header.leaves + 8 * header.leafCnt )
+  {
+    uint64_t bad = header.bytes + 8, old;
+    fseek ( f, header.root + 24, SEEK_SET );
+    if ( fread ( &old, 8, 1, f ) != 1 ) old = 0;
+    fseek ( f, header.root + 24, SEEK_SET );
+    fwrite ( &bad, 8, 1, f );
+    fflush ( f );
+    testCnt++;
+    if ( vEB_image_open ( path ) ) { std::cout << "image with a summary out of the file was accepted, test number " << testCnt << std::endl; failedTestsCnt++; }
+    fseek ( f, header.root + 24, SEEK_SET );
+    fwrite ( &old, 8, 1, f );
+  }
+  wrong = 0;
+  for ( int i = 0; i < 100 && header.bytes > header.leaves && header.bytes < ( 1 << 20 ); ++i )
+  {
+    uint64_t pos = header.leaves + 8 * ( rand() % ( ( header.bytes - header.leaves ) / 8 ) ), old;
+    uint64_t bad = rand() % 2 ? 8 * ( uint64_t ) ( rand() % ( header.bytes / 4 ) ) : ( uint64_t ) rand() << 33 | rand();
+    fseek ( f, pos, SEEK_SET );
+    if ( fread ( &old, 8, 1, f ) != 1 ) old = 0;
+    fseek ( f, pos, SEEK_SET );
+    fwrite ( &bad, 8, 1, f );
+    fflush ( f );
+    image = vEB_image_open ( path );
+    for ( int j = 0; image && j < 100; ++j )
+    {
+      int val = rand() % tree->uni;
+      if ( vEB_min ( image, a ) && ( a < 0 || a >= tree->uni ) ) wrong++;
+      if ( vEB_succ ( image, val, a ) && ( a <= val || a >= tree->uni ) ) wrong++;
+      if ( vEB_pred ( image, val, a ) && ( a >= val || a < 0 ) ) wrong++;
+      vEB_find ( image, val );
+    }
+    vEB_image_close ( image );
+    fseek ( f, pos, SEEK_SET );
+    fwrite ( &old, 8, 1, f );
+  }
+  testCnt++;
+  if ( wrong ) { std::cout << wrong << " queries of damaged images left the universe, test number " << testCnt << std::endl; failedTestsCnt++; }
+  fclose ( f );
+  image = vEB_image_open ( path );
+  testCnt++;
+  if ( !image ) { std::cout << "restored image was rejected, test number " << testCnt << std::endl; failedTestsCnt++; }
+  vEB_image_close ( image );
+
+  f = fopen ( path, "r+b" );
+  fseek ( f, 8, SEEK_SET );
+  fputc ( 99, f );
+  fclose ( f );
+  testCnt++;
+  if ( vEB_image_open ( path ) || vEB_load ( path ) ) { std::cout << "image of a wrong version was accepted, test number " << testCnt << std::endl; failedTestsCnt++; }
+  remove ( path );
+  testCnt++;
+  if ( vEB_image_open ( path ) ) { std::cout << "missing image was opened, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete tree;
+}
+
+/***************************************************************************//**
+ * @brief      Applies random changes to the given durable tree and its mirror,
+ *             returning the number of the successful ones.
+ ******************************************************************************/
+int durableChanges ( TvEBDurable * tree, std::set<int> & mirror, int cnt, int lo, int hi )
+{
+  int changed = 0;
+  for ( int i = 0; i < cnt; ++i )
+  {
+    int val = lo + rand() % ( hi - lo );
+    bool ok = rand() % 3 ? vEB_insert ( tree, val ) : vEB_delete ( tree, val );
+    if ( ok && !mirror.erase ( val ) ) mirror.insert ( val );
+    changed += ok;
+  }
+  return changed;
+}
+
+void testSuite18 ( int universe, int segCnt, int groupSize, int opCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  char dir[] = "/tmp/veb_wal_XXXXXX";
+  if ( !mkdtemp ( dir ) ) { std::cout << "failed to create a directory" << std::endl; return; }
+
+  std::set<int> mirror;
+  TvEBDurable * tree = vEB_durable_open ( dir, universe, segCnt, groupSize, flags );
+  testCnt++;
+  if ( !tree ) { std::cout << "failed to create the durable tree, test number " << testCnt << std::endl; failedTestsCnt++; std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl; return; }
+  int uni = tree->tree->uni;
+  segCnt = tree->segCnt;
+
+  int changed = durableChanges ( tree, mirror, opCnt, 0, uni );
+  vEB_durable_commit ( tree );
+  testCnt++;
+  if ( tree->syncCnt != ( uint64_t ) ( ( changed + groupSize - 1 ) / groupSize ) ) { std::cout << tree->syncCnt << " flushes of " << changed << " changes, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  // the changes after the last commit are lost in a crash
+  std::set<int> committed = mirror;
+  durableChanges ( tree, mirror, std::min ( groupSize - 1, 20 ), 0, uni );
+  delete tree;
+  tree = vEB_durable_open ( dir, universe, segCnt, groupSize, flags );
+  testCnt++;
+  if ( !tree || elements ( tree->tree ) != std::vector<int> ( committed.begin(), committed.end() ) ) { std::cout << "recovered tree differs from the committed one, test number " << testCnt << std::endl; failedTestsCnt++; }
+  mirror = committed;
+
+  // a torn record at the end of the log is cut off
+  delete tree;
+  std::string wal = std::string ( dir ) + "/wal";
+  FILE * f = fopen ( wal.c_str(), "ab" );
+  for ( int i = 0; i < 27; ++i ) fputc ( rand(), f );
+  fclose ( f );
+  tree = vEB_durable_open ( dir, universe, segCnt, groupSize, flags );
+  testCnt++;
+  if ( !tree || elements ( tree->tree ) != std::vector<int> ( mirror.begin(), mirror.end() ) ) { std::cout << "torn log was not recovered, test number " << testCnt << std::endl; failedTestsCnt++; }
+  durableChanges ( tree, mirror, opCnt / 4, 0, uni );
+  vEB_durable_close ( tree );
+
+  // only the segments changed since the last checkpoint are rewritten
+  tree = vEB_durable_open ( dir, universe, segCnt, groupSize, flags );
+  int written = vEB_durable_checkpoint ( tree );
+  testCnt++;
+  if ( written < 0 || written > segCnt ) { std::cout << "checkpoint failed, test number " << testCnt << std::endl; failedTestsCnt++; }
+  int seg = rand() % segCnt;
+  int segUni = uni / segCnt;
+  durableChanges ( tree, mirror, opCnt / 4 + 1, seg * segUni, ( seg + 1 ) * segUni );
+  if ( vEB_insert ( tree, seg * segUni ) ) mirror.insert ( seg * segUni );
+  else if ( vEB_delete ( tree, seg * segUni ) ) mirror.erase ( seg * segUni );
+  testCnt++;
+  if ( vEB_durable_checkpoint ( tree ) != 1 || vEB_durable_checkpoint ( tree ) != 0 ) { std::cout << "checkpoint did not rewrite exactly the changed segment, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  // recovery replays the log over the images
+  durableChanges ( tree, mirror, opCnt / 2, 0, uni );
+  vEB_durable_commit ( tree );
+  delete tree;
+  tree = vEB_durable_open ( dir, 1, 1, groupSize, flags );
+  testCnt++;
+  if ( !tree || tree->segCnt != segCnt || elements ( tree->tree ) != std::vector<int> ( mirror.begin(), mirror.end() ) ) { std::cout << "tree recovered from the images and the log differs, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  // a failed group commit refuses the change which completed the group
+  vEB_durable_commit ( tree );
+  int logFd = tree->logFd;
+  tree->logFd = open ( wal.c_str(), O_RDONLY );
+  int refused = 0;
+  for ( int val = 0, added = 0; val < uni && added <= groupSize; ++val )
+  {
+    if ( mirror.count ( val ) ) continue;
+    if ( vEB_insert ( tree, val ) ) mirror.insert ( val );
+    else refused++;
+    added++;
+  }
+  testCnt++;
+  if ( refused != 2 || tree->pendingCnt != groupSize - 1 || elements ( tree->tree ) != std::vector<int> ( mirror.begin(), mirror.end() ) ) { std::cout << refused << " changes refused by a failed commit, test number " << testCnt << std::endl; failedTestsCnt++; }
+  close ( tree->logFd );
+  tree->logFd = logFd;
+  vEB_durable_commit ( tree );
+  delete tree;
+  tree = vEB_durable_open ( dir, universe, segCnt, groupSize, flags );
+  testCnt++;
+  if ( !tree || elements ( tree->tree ) != std::vector<int> ( mirror.begin(), mirror.end() ) ) { std::cout << "group committed after a failure was not recovered, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  // an emptied tree removes its images
+  for ( std::set<int>::iterator it = mirror.begin(); it != mirror.end(); ++it ) vEB_delete ( tree, *it );
+  vEB_insert ( tree, uni - 1 );
+  vEB_durable_checkpoint ( tree );
+  vEB_durable_close ( tree );
+  tree = vEB_durable_open ( dir, universe, segCnt, groupSize, flags );
+  testCnt++;
+  if ( !tree || elements ( tree->tree ) != std::vector<int> ( 1, uni - 1 ) || vEB_insert ( tree, uni ) || vEB_delete ( tree, -1 ) ) { std::cout << "emptied tree was not recovered, test number " << testCnt << std::endl; failedTestsCnt++; }
+  vEB_durable_close ( tree );
+
+  FILE * m = fopen ( ( std::string ( dir ) + "/manifest" ).c_str(), "r+b" );
+  fseek ( m, 16, SEEK_SET );
+  fputc ( 99, m );
+  fclose ( m );
+  testCnt++;
+  if ( vEB_durable_open ( dir, universe ) ) { std::cout << "damaged manifest was accepted, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  for ( int i = 0; i < segCnt; ++i )
+  {
+    char name[32];
+    snprintf ( name, sizeof ( name ), "/seg-%d.img", i );
+    remove ( ( std::string ( dir ) + name ).c_str() );
+  }
+  remove ( wal.c_str() );
+  remove ( ( std::string ( dir ) + "/manifest" ).c_str() );
+  rmdir ( dir );
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+}
+
+/***************************************************************************//**
+ * @brief      Struct containing the arguments of a thread reading a snapshot.
+ ******************************************************************************/
+struct TSnapshotArgs
+{
+  TvEBSnapshot * snapshot;
+  long long sum;
+  int rounds;
+  int wrong;
+};
+
+/***************************************************************************//**
+ * @brief      Sums the snapshot over and over while the tree changes, then
+ *             releases it.
+ ******************************************************************************/
+void * snapshotReader ( void * arg )
+{
+  TSnapshotArgs * a = ( TSnapshotArgs * ) arg;
+  for ( int r = 0; r < a->rounds; ++r )
+  {
+    long long sum = 0;
+    TvEBIterator it;
+    for ( bool valid = vEB_iter_succ ( a->snapshot->root, it, -1 ); valid; valid = vEB_iter_next ( it ) ) sum += it.val;
+    if ( sum != a->sum ) a->wrong++;
+  }
+  vEB_snapshot_release ( a->snapshot );
+  return NULL;
+}
+
+/***************************************************************************//**
+ * @brief      Applies random updates, single and batched, to the given
+ *             persistent tree and its mirror.
+ ******************************************************************************/
+void persistentChanges ( TvEBPersistent * tree, std::set<int> & mirror, int cnt )
+{
+  for ( int i = 0; i < cnt; ++i )
+  {
+    int val = rand() % tree->uni;
+    if ( rand() % 2 ) { if ( vEB_insert ( tree, val ) ) mirror.insert ( val ); }
+    else if ( vEB_delete ( tree, val ) ) mirror.erase ( val );
+  }
+  std::vector<int> batch;
+  for ( int i = 0; i < cnt / 4; ++i ) batch.push_back ( rand() % tree->uni );
+  if ( rand() % 2 )
+  {
+    vEB_insert_batch ( tree, batch.data(), batch.size() );
+    mirror.insert ( batch.begin(), batch.end() );
+  }
+  else
+  {
+    vEB_delete_batch ( tree, batch.data(), batch.size() );
+    for ( size_t i = 0; i < batch.size(); ++i ) mirror.erase ( batch[i] );
+  }
+}
+
+void testSuite19 ( int universe, int density, int snapCnt, int opCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEBPersistent * tree = new TvEBPersistent ( universe, flags );
+  std::set<int> mirror;
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 ) { vEB_insert ( tree, i ); mirror.insert ( i ); }
+  }
+
+  // the snapshots are released in random order while the tree changes, each
+  // must still hold what the tree held when it was taken
+  std::vector<TvEBSnapshot *> snaps;
+  std::vector<std::vector<int> > expected;
+  int unshared = 0;
+  int wrong = 0;
+  for ( int s = 0; s < snapCnt; ++s )
+  {
+    TvEBSnapshot * snap = vEB_snapshot ( tree );
+    snaps.push_back ( snap );
+    expected.push_back ( std::vector<int> ( mirror.begin(), mirror.end() ) );
+
+    // one update copies only the clusters on its path
+    int val = rand() % tree->uni;
+    if ( vEB_insert ( tree, val ) ) mirror.insert ( val );
+    else if ( vEB_delete ( tree, val ) ) mirror.erase ( val );
+    if ( snap->root && tree->root && tree->uni > VEB_LEAF_UNI )
+    {
+      int differ = 0;
+      for ( int i = 0; i < tree->root->higherUniSqrt(); ++i )
+      {
+        differ += vEB_cluster ( tree->root, i ) != vEB_cluster ( snap->root, i ) || vEB_leaf ( tree->root, i ) != vEB_leaf ( snap->root, i );
+      }
+      if ( differ > 2 ) unshared++;
+    }
+
+    persistentChanges ( tree, mirror, opCnt );
+    while ( snaps.size() > 4 && rand() % 3 )
+    {
+      int k = rand() % snaps.size();
+      if ( elements ( snaps[k]->root ) != expected[k] ) wrong++;
+      if ( ( flags & VEB_COUNTED ) && expected[k].size() && vEB_rank ( snaps[k]->root, expected[k].back() ) != ( int ) expected[k].size() - 1 ) wrong++;
+      vEB_snapshot_release ( snaps[k] );
+      snaps.erase ( snaps.begin() + k );
+      expected.erase ( expected.begin() + k );
+    }
+  }
+  for ( size_t k = 0; k < snaps.size(); ++k )
+  {
+    if ( elements ( snaps[k]->root ) != expected[k] ) wrong++;
+    vEB_snapshot_release ( snaps[k] );
+  }
+  testCnt++;
+  if ( unshared ) { std::cout << unshared << " updates copied untouched clusters, test number " << testCnt << std::endl; failedTestsCnt++; }
+  testCnt++;
+  if ( wrong ) { std::cout << wrong << " snapshots changed, test number " << testCnt << std::endl; failedTestsCnt++; }
+  testCnt++;
+  if ( elements ( tree->root ) != std::vector<int> ( mirror.begin(), mirror.end() ) ) { std::cout << "tree differs after the snapshots, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  // updates which fail copy nothing, even with a snapshot sharing the tree, a
+  // sweep may still reuse what older snapshots left
+  TvEBSnapshot * shared = vEB_snapshot ( tree );
+  TvEB * root = tree->root;
+  int retiredCnt = tree->retiredCnt;
+  wrong = 0;
+  for ( int i = 0; i < 1000; ++i )
+  {
+    int val = rand() % tree->uni;
+    if ( mirror.count ( val ) ? vEB_insert ( tree, val ) : vEB_delete ( tree, val ) ) wrong++;
+  }
+  testCnt++;
+  if ( wrong || tree->root != root || tree->retiredCnt > retiredCnt ) { std::cout << "failed updates copied nodes, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  // so do batches of present values to insert and absent ones to delete
+  std::vector<int> present ( mirror.begin(), mirror.end() ), absent;
+  for ( int i = 0; i < 1000 && present.size(); ++i )
+  {
+    int val = present.front() + rand() % ( present.back() - present.front() + 1 );
+    if ( !mirror.count ( val ) ) absent.push_back ( val );
+  }
+  size_t changed = vEB_insert_batch ( tree, present.data(), present.size() )
+                   + vEB_delete_batch ( tree, absent.data(), absent.size() );
+  testCnt++;
+  if ( changed || tree->root != root || tree->retiredCnt > retiredCnt ) { std::cout << "batches changing nothing copied nodes, test number " << testCnt << std::endl; failedTestsCnt++; }
+  vEB_snapshot_release ( shared );
+
+  // a thread reads a snapshot while the tree changes
+  TSnapshotArgs args;
+  args.snapshot = vEB_snapshot ( tree );
+  args.sum = 0;
+  for ( std::set<int>::iterator it = mirror.begin(); it != mirror.end(); ++it ) args.sum += *it;
+  args.rounds = 20;
+  args.wrong = 0;
+  pthread_t reader;
+  pthread_create ( &reader, NULL, snapshotReader, &args );
+  for ( int i = 0; i < 16; ++i )
+  {
+    persistentChanges ( tree, mirror, opCnt );
+    vEB_snapshot_release ( vEB_snapshot ( tree ) );
+  }
+  pthread_join ( reader, NULL );
+  testCnt++;
+  if ( args.wrong || elements ( tree->root ) != std::vector<int> ( mirror.begin(), mirror.end() ) ) { std::cout << "snapshot read by another thread changed, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  // with no snapshot left all the replaced nodes are reused
+  persistentChanges ( tree, mirror, 4 );
+  testCnt++;
+  if ( tree->retiredCnt || elements ( tree->root ) != std::vector<int> ( mirror.begin(), mirror.end() ) ) { std::cout << tree->retiredCnt << " replaced nodes were not reused, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  delete tree;
+}
+
+int countNodes ( TvEB * tree )
+{
+  if ( !tree ) return 0;
+  if ( tree->uni <= VEB_LEAF_UNI ) return 1;
+  int cnt = 1 + ( tree->higherUniSqrt() > VEB_LEAF_UNI ? countNodes ( tree->summary ) : 0 );
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ); ) cnt += countNodes ( vEB_cluster ( tree, i ) );
+  return cnt;
+}
+
+struct TStatsArgs
+{
+  int universe;
+  int opCnt;
+};
+
+void * statsWorker ( void * arg )
+{
+  TStatsArgs * a = ( TStatsArgs * ) arg;
+  TvEB * tree = NULL;
+  for ( int i = 0; i < a->opCnt; ++i ) vEB_insert ( tree, i % a->universe, a->universe );
+  delete tree;
+  return NULL;
+}
+
+void testSuite20 ( int universe, int opCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  vEB_stats_reset();
+  TvEB * tree = NULL;
+  uint64_t calls[VEB_OP_CNT] = { 0 };
+  int res;
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    int val = rand() % universe;
+    switch ( rand() % 5 )
+    {
+      case 0: case 1: vEB_insert ( tree, val, universe, NULL, flags ); calls[VEB_OP_INSERT]++; break;
+      case 2: vEB_delete ( tree, val ); calls[VEB_OP_DELETE]++; break;
+      case 3: vEB_find ( tree, val ); calls[VEB_OP_FIND]++; break;
+      default: vEB_succ ( tree, val, res ); vEB_pred ( tree, val, res ); calls[VEB_OP_SUCC]++; calls[VEB_OP_PRED]++;
+    }
+  }
+
+  TvEBStats stats;
+  bool enabled = vEB_stats_snapshot ( stats );
+  int wrong = 0;
+  int64_t timed = 0, callCnt = 0;
+  for ( int op = 0; op < VEB_OP_CNT; ++op )
+  {
+    // the disabled statistics are all zero
+    uint64_t depthSum = 0, latencySum = 0;
+    for ( int d = 0; d < VEB_STATS_DEPTHS; ++d ) depthSum += stats.depth[op][d];
+    for ( int b = 0; b < VEB_STATS_BUCKETS; ++b ) latencySum += stats.latency[op][b];
+    uint64_t expected = enabled ? calls[op] : 0;
+    if ( stats.ops[op] != expected || depthSum != expected || latencySum > expected ) wrong++;
+    if ( stats.depth[op][VEB_STATS_DEPTHS - 1] ) wrong++;
+    timed += latencySum;
+    callCnt += expected;
+  }
+  // one operation in VEB_STATS_SAMPLE is timed
+  if ( std::abs ( timed * VEB_STATS_SAMPLE - callCnt ) >= VEB_STATS_SAMPLE ) wrong++;
+  testCnt++;
+  if ( wrong ) { std::cout << wrong << " operations counted wrong, test number " << testCnt << std::endl; failedTestsCnt++; }
+  testCnt++;
+  if ( stats.summaryDescents[VEB_OP_FIND] || ( enabled && universe > VEB_LEAF_UNI && tree && !stats.clusterDescents[VEB_OP_INSERT] ) )
+  {
+    std::cout << "descents counted wrong, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+  testCnt++;
+  if ( stats.nodeAllocs - stats.nodeFrees != ( uint64_t ) ( enabled ? countNodes ( tree ) : 0 ) )
+  {
+    std::cout << stats.nodeAllocs << " nodes allocated and " << stats.nodeFrees << " freed, but "
+              << countNodes ( tree ) << " in the tree, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  // the operations of an exited thread stay counted
+  TStatsArgs args = { universe, opCnt };
+  pthread_t worker;
+  pthread_create ( &worker, NULL, statsWorker, &args );
+  pthread_join ( worker, NULL );
+  TvEBStats after;
+  vEB_stats_snapshot ( after );
+  testCnt++;
+  if ( after.ops[VEB_OP_INSERT] - stats.ops[VEB_OP_INSERT] != ( enabled ? ( uint64_t ) opCnt : 0 ) )
+  {
+    std::cout << "operations of an exited thread lost, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  vEB_stats_reset();
+  vEB_stats_snapshot ( stats );
+  testCnt++;
+  if ( stats.ops[VEB_OP_INSERT] || stats.nodeAllocs ) { std::cout << "statistics not reset, test number " << testCnt << std::endl; failedTestsCnt++; }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  if ( tree ) delete tree;
+}
+
+// counts the leaves kept as bare words in their parents
+int countLeafWords ( const TvEB * tree )
+{
+  if ( !tree || tree->uni <= VEB_LEAF_UNI ) return 0;
+  int cnt = tree->higherUniSqrt() > VEB_LEAF_UNI ? countLeafWords ( tree->summary ) : tree->summaryBits != 0;
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ); )
+  {
+    cnt += tree->lowerUniSqrt() > VEB_LEAF_UNI ? countLeafWords ( vEB_cluster ( tree, i ) ) : 1;
+  }
+  return cnt;
+}
+
+// checks that the nodes follow each other in memory in van Emde Boas order
+bool inVebOrder ( const TvEB * tree, const TvEB *& last )
+{
+  if ( !tree ) return true;
+  if ( last && tree <= last ) return false;
+  last = tree;
+  if ( tree->uni <= VEB_LEAF_UNI ) return true;
+  if ( tree->higherUniSqrt() > VEB_LEAF_UNI && !inVebOrder ( tree->summary, last ) ) return false;
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ); )
+  {
+    if ( !inVebOrder ( vEB_cluster ( tree, i ), last ) ) return false;
+  }
+  return true;
+}
+
+void testSuite21 ( int universe, int density, int opCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEB * tree = NULL;
+  std::set<int> mirror;
+  for ( int i = 0; i < universe; ++i )
+  {
+    if ( rand() % density == 0 && vEB_insert ( tree, i, universe, NULL, flags ) ) mirror.insert ( i );
+  }
+  // churn leaves most of the clusters nearly empty
+  for ( std::set<int>::iterator it = mirror.begin(); it != mirror.end(); )
+  {
+    if ( rand() % 8 ) { vEB_delete ( tree, *it ); mirror.erase ( it++ ); }
+    else ++it;
+  }
+
+  TvEBMemoryUsage before;
+  vEB_memory_usage ( tree, before );
+  size_t nodes = 0, bytes = 0, leafBytes = 0;
+  for ( int l = 0; l < VEB_MEMORY_LEVELS; ++l )
+  {
+    for ( int k = 0; k < VEB_NODE_TYPES; ++k )
+    {
+      nodes += before.nodes[l][k];
+      bytes += before.bytes[l][k];
+    }
+    if ( l ) leafBytes += before.bytes[l][VEB_NODE_LEAF];
+  }
+  testCnt++;
+  if ( leafBytes ) { std::cout << "leaves below the root took " << leafBytes << " bytes of their own, test number " << testCnt << std::endl; failedTestsCnt++; }
+  testCnt++;
+  if ( nodes != ( size_t ) ( countNodes ( tree ) + countLeafWords ( tree ) ) || bytes != before.total || before.usedSlots > before.slots
+       || ( tree && before.nodes[0][tree->uni <= VEB_LEAF_UNI ? VEB_NODE_LEAF : ( flags & VEB_SPARSE ) ? VEB_NODE_SPARSE : VEB_NODE_DENSE] != 1 ) )
+  {
+    std::cout << "memory usage of " << nodes << " nodes and " << bytes << " bytes does not add up, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  TvEBArena arena ( 2 * before.total + 4096 );
+  TvEB * packed = vEB_compact ( tree, &arena );
+  TvEB * heap = vEB_compact ( tree, NULL );
+  TvEBMemoryUsage after;
+  vEB_memory_usage ( packed, after );
+  std::vector<int> expected ( mirror.begin(), mirror.end() );
+  testCnt++;
+  if ( elements ( packed ) != expected || elements ( heap ) != expected )
+  {
+    std::cout << "compacted tree differs, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+  testCnt++;
+  if ( after.total > before.total || after.usedSlots != before.usedSlots )
+  {
+    std::cout << "compacted tree holds " << after.total << " bytes instead of " << before.total << ", test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  // the trimmed records save bytes even where every node keeps its array
+  TvEBMemoryUsage onHeap;
+  vEB_memory_usage ( heap, onHeap );
+  testCnt++;
+  if ( tree && ( after.total >= before.total || onHeap.total >= before.total ) )
+  {
+    std::cout << "compacted tree holds " << after.total << " and " << onHeap.total << " bytes, not less than "
+              << before.total << ", test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+  const TvEB * last = NULL;
+  testCnt++;
+  if ( !inVebOrder ( packed, last ) )
+  {
+    std::cout << "compacted tree is not in van Emde Boas order, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+  delete tree;
+
+  // both copies keep working with the representations they got
+  int wrong = 0;
+  int res, resPacked, resHeap;
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    int val = rand() % universe;
+    bool isNew = mirror.insert ( val ).second;
+    if ( !isNew ) mirror.erase ( val );
+    if ( isNew != vEB_insert ( packed, val, universe, &arena, flags ) ) wrong++;
+    if ( isNew != vEB_insert ( heap, val, universe, NULL, flags ) ) wrong++;
+    if ( !isNew && ( !vEB_delete ( packed, val ) || !vEB_delete ( heap, val ) ) ) wrong++;
+
+    val = rand() % universe;
+    std::set<int>::iterator it = mirror.upper_bound ( val );
+    bool found = vEB_succ ( packed, val, resPacked );
+    if ( found != vEB_succ ( heap, val, resHeap ) || found != ( it != mirror.end() )
+         || ( found && ( resPacked != *it || resHeap != *it ) ) ) wrong++;
+    if ( ( flags & VEB_COUNTED ) && packed && vEB_rank ( packed, val ) != ( int ) std::distance ( mirror.begin(), mirror.lower_bound ( val ) ) ) wrong++;
+  }
+  testCnt++;
+  if ( wrong || elements ( packed ) != std::vector<int> ( mirror.begin(), mirror.end() )
+       || elements ( heap ) != std::vector<int> ( mirror.begin(), mirror.end() ) || ( packed && !vEB_min ( packed, res ) ) )
+  {
+    std::cout << wrong << " operations on the compacted trees failed, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+
+  if ( heap ) delete heap;
+}
+
+void testSuite22 ( int universe, int itemCnt, int opCnt, int flags = 0 )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEB * tree = NULL;
+  TvEBMap<int> * map = NULL;
+  std::map<int, int> mirror;
+  int wrong = 0;
+  int res, key, value;
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    int val = rand() % universe;
+    if ( rand() % 3 && vEB_insert ( tree, val, universe, NULL, flags ) )
+    {
+      mirror[val] = i;
+      if ( !vEB_insert ( map, val, i, universe ) ) wrong++;
+    }
+    if ( rand() % 3 ) continue;
+
+    // the fused pops, alternating ends
+    bool fromMin = rand() % 2;
+    bool found = fromMin ? vEB_extract_min ( tree, res ) : vEB_extract_max ( tree, res );
+    bool mapFound = fromMin ? vEB_extract_min ( map, key, value ) : vEB_extract_max ( map, key, value );
+    if ( found != !mirror.empty() || mapFound != found ) { wrong++; continue; }
+    if ( !found ) continue;
+    std::map<int, int>::iterator it = fromMin ? mirror.begin() : --mirror.end();
+    if ( res != it->first || key != it->first || value != it->second ) wrong++;
+    mirror.erase ( it );
+    if ( ( flags & VEB_COUNTED ) && tree && vEB_rank ( tree, val ) != ( int ) std::distance ( mirror.begin(), mirror.lower_bound ( val ) ) ) wrong++;
+  }
+  std::vector<int> expected;
+  for ( std::map<int, int>::iterator it = mirror.begin(); it != mirror.end(); ++it ) expected.push_back ( it->first );
+  testCnt++;
+  if ( wrong || elements ( tree ) != expected )
+  {
+    std::cout << wrong << " extractions of the minimum or maximum failed, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+  // emptying them releases every node
+  while ( vEB_extract_max ( tree, res ) && vEB_extract_min ( map, key, value ) ) {}
+  testCnt++;
+  if ( tree || vEB_extract_min ( map, key, value ) || map )
+  {
+    std::cout << "emptied tree or map is not released, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  TvEBPQ pq ( universe, itemCnt );
+  std::set<std::pair<int, int> > queue;
+  std::vector<int> prios ( itemCnt, UNDEFINED );
+  wrong = 0;
+  int item, prio;
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    item = rand() % itemCnt;
+    // few priorities make buckets of many items
+    prio = rand() % ( rand() % 2 ? universe : std::min ( universe, 8 ) );
+    switch ( rand() % 5 )
+    {
+      case 0:
+      case 1:
+        if ( vEB_push ( &pq, item, prio ) != ( prios[item] == UNDEFINED ) ) wrong++;
+        if ( prios[item] == UNDEFINED ) { prios[item] = prio; queue.insert ( std::make_pair ( prio, item ) ); }
+        break;
+      case 2:
+        if ( vEB_decrease_key ( &pq, item, prio ) != ( prios[item] != UNDEFINED && prio < prios[item] ) ) wrong++;
+        if ( prios[item] != UNDEFINED && prio < prios[item] )
+        {
+          queue.erase ( std::make_pair ( prios[item], item ) );
+          prios[item] = prio;
+          queue.insert ( std::make_pair ( prio, item ) );
+        }
+        break;
+      case 3:
+        if ( vEB_delete ( &pq, item ) != ( prios[item] != UNDEFINED ) ) wrong++;
+        if ( prios[item] != UNDEFINED ) { queue.erase ( std::make_pair ( prios[item], item ) ); prios[item] = UNDEFINED; }
+        break;
+      default:
+        bool fromMin = rand() % 4;
+        bool found = fromMin ? vEB_pop_min ( &pq, item, prio ) : vEB_pop_max ( &pq, item, prio );
+        if ( found != !queue.empty() ) { wrong++; break; }
+        if ( !found ) break;
+        // any item of the extreme priority may come out
+        int extreme = fromMin ? queue.begin()->first : queue.rbegin()->first;
+        if ( prio != extreme || !queue.erase ( std::make_pair ( prio, item ) ) ) { wrong++; break; }
+        prios[item] = UNDEFINED;
+    }
+    if ( pq.size != ( int ) queue.size() ) wrong++;
+    if ( !queue.empty() && ( !vEB_min ( &pq, item, prio ) || prio != queue.begin()->first || prios[item] != prio ) ) wrong++;
+  }
+  testCnt++;
+  if ( wrong )
+  {
+    std::cout << wrong << " priority queue operations failed, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+  // popping the rest gives the priorities in order
+  wrong = 0;
+  for ( std::set<std::pair<int, int> >::iterator it = queue.begin(); it != queue.end(); ++it )
+  {
+    if ( !vEB_pop_min ( &pq, item, prio ) || prio != it->first ) wrong++;
+  }
+  testCnt++;
+  if ( wrong || vEB_pop_min ( &pq, item, prio ) || pq.root || pq.size )
+  {
+    std::cout << wrong << " priorities popped out of order, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+}
+
+bool collectCounts ( int val, int cnt, void * ctx )
+{
+  std::vector<std::pair<int, int> > * counts = ( std::vector<std::pair<int, int> > * ) ctx;
+  counts->push_back ( std::make_pair ( val, cnt ) );
+  return counts->size() < 1000;
+}
+
+void testSuite23 ( int universe, int valueCnt, int opCnt )
+{
+  int testCnt = 0;
+  int failedTestsCnt = 0;
+
+  srand ( time ( NULL ) );
+  TvEBMultiset set ( universe );
+  std::map<int, int> mirror;
+  size_t occurrences = 0;
+  std::vector<int> values ( valueCnt );
+  for ( int i = 0; i < valueCnt; ++i ) values[i] = rand() % universe;
+
+  int wrong = 0;
+  int res, cnt;
+  for ( int i = 0; i < opCnt; ++i )
+  {
+    // few values repeat a lot
+    int val = values[rand() % valueCnt];
+    int many = 1 + rand() % 3;
+    if ( rand() % 2 )
+    {
+      if ( !vEB_insert ( &set, val, many ) ) wrong++;
+      mirror[val] += many;
+      occurrences += many;
+    }
+    else
+    {
+      int expected = mirror.count ( val ) ? std::min ( mirror[val], many ) : 0;
+      if ( vEB_delete ( &set, val, many ) != expected ) wrong++;
+      if ( expected && !( mirror[val] -= expected ) ) mirror.erase ( val );
+      occurrences -= expected;
+    }
+    if ( vEB_count ( &set, val ) != ( mirror.count ( val ) ? mirror[val] : 0 ) ) wrong++;
+
+    val = rand() % universe;
+    std::map<int, int>::iterator it = mirror.upper_bound ( val );
+    bool found = vEB_succ ( &set, val, res, cnt );
+    if ( found != ( it != mirror.end() ) || ( found && ( res != it->first || cnt != it->second ) ) ) wrong++;
+    it = mirror.lower_bound ( val );
+    found = vEB_pred ( &set, val, res, cnt );
+    if ( found != ( it != mirror.begin() ) || ( found && ( res != ( --it )->first || cnt != it->second ) ) ) wrong++;
+  }
+  testCnt++;
+  if ( wrong || set.size != occurrences || set.distinct != ( int ) mirror.size() )
+  {
+    std::cout << wrong << " multiset operations failed, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  // scans of random ranges report every count, the callback stops the long ones
+  wrong = 0;
+  for ( int i = 0; i < 100; ++i )
+  {
+    int lo = rand() % universe - 2, hi = lo + rand() % ( universe / 4 + 2 );
+    std::vector<std::pair<int, int> > counts, expected;
+    size_t visited = vEB_range ( &set, lo, hi, collectCounts, &counts );
+    for ( std::map<int, int>::iterator it = mirror.lower_bound ( lo ); it != mirror.end() && it->first <= hi && expected.size() < 1000; ++it )
+    {
+      expected.push_back ( *it );
+    }
+    if ( counts != expected || visited != counts.size() ) wrong++;
+  }
+  testCnt++;
+  if ( wrong )
+  {
+    std::cout << wrong << " scans of the multiset failed, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  // counting a present value up and down leaves the keys alone, which the
+  // statistics show when they are built in
+  TvEBStats before, after;
+  bool stats = vEB_stats_snapshot ( before );
+  int top = 0;
+  if ( vEB_max ( &set, res, cnt ) && cnt == mirror.rbegin()->second )
+  {
+    for ( int i = 0; i < 1000; ++i ) vEB_insert ( &set, res );
+    for ( int i = 0; i < 1000; ++i ) vEB_delete ( &set, res );
+    top = vEB_count ( &set, res ) - cnt;
+  }
+  vEB_stats_snapshot ( after );
+  testCnt++;
+  if ( top || ( stats && ( after.ops[VEB_OP_INSERT] != before.ops[VEB_OP_INSERT]
+                          || after.ops[VEB_OP_DELETE] != before.ops[VEB_OP_DELETE] ) ) )
+  {
+    std::cout << "counting a present value changed the keys, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  testCnt++;
+  if ( vEB_insert ( &set, set.uni ) || vEB_insert ( &set, 0, 0 ) || vEB_delete ( &set, -1 )
+       || ( vEB_insert ( &set, 0, INT_MAX ) && vEB_insert ( &set, 0, INT_MAX ) ) )
+  {
+    std::cout << "multiset accepted a wrong value or count, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+  // removing all the occurrences empties it
+  for ( int val = -1; vEB_succ ( &set, val, val, cnt ); ) vEB_delete ( &set, val, INT_MAX );
+  testCnt++;
+  if ( set.root || set.size || set.distinct || vEB_min ( &set, res, cnt ) )
+  {
+    std::cout << "emptied multiset is not empty, test number " << testCnt << std::endl;
+    failedTestsCnt++;
+  }
+
+  std::cout << failedTestsCnt << " out of " << testCnt << " tests failed" << std::endl;
+}
+
 int main ( int argc, char ** argv )
 {
   testSuite1();
+  testSuite3<6> ( 40, 1000 );
+  testSuite3<16> ( 20000, 20000 );
+  testSuite3<32> ( 200000, 100000 );
+  testSuite3<48> ( 200000, 100000 );
+  testSuite3<64> ( 200000, 100000 );
   for ( int i = 100; i < 8000000; i += ( rand() % 300000 ) + 50000 )
   {
     testSuite2 ( i );
   }
   testSuite2 ( 16777216 ); // 2 ^ 24
+  TvEBArena arena;
+  testSuite2 ( 16777216, &arena );
+  testSuite2 ( 1 << 20, NULL, VEB_SPARSE );
+  testSuite2 ( 16777216, &arena, VEB_SPARSE );
+  testSuite4();
+  testSuite4 ( 1 << 20, VEB_SPARSE );
+  testSuite5 ( 16, 17 );
+  testSuite5 ( 1000, 1001 );
+  testSuite5 ( 65536, 65537 );
+  testSuite5 ( 1 << 22, 100000 );
+  testSuite6 ( 50, 40, 51 );
+  testSuite6 ( 65536, 20000, 65537 );
+  testSuite6 ( 1 << 24, 200000, 100000 );
+  testSuite7 ( 16, 50 );
+  testSuite7 ( 5000, 50 );
+  testSuite7 ( 1 << 20, 20 );
+  testSuite7 ( 1 << 20, 20, &arena );
+  testSuite7 ( 1 << 20, 20, NULL, VEB_SPARSE );
+  testSuite8 ( 1, 1 );
+  testSuite8 ( 50, 2 );
+  testSuite8 ( 100000, 3 );
+  testSuite8 ( 1 << 22, 1 );
+  testSuite8 ( 1 << 22, 64, &arena );
+  testSuite8 ( 1 << 22, 64, NULL, VEB_SPARSE );
+  testSuite9 ( 64, 3, 200 );
+  testSuite9 ( 1000, 1000000, 2000 );
+  testSuite9 ( 1 << 16, 2, 100000 );
+  testSuite9 ( 1 << 24, 50, 1000000 );
+  testSuite9 ( 1 << 24, 4000, 1000000, VEB_SPARSE );
+  testSuite10 ( 1, 1 );
+  testSuite10 ( 40, 2 );
+  testSuite10 ( 5000, 3 );
+  testSuite10 ( 1 << 20, 1 );
+  testSuite10 ( 1 << 22, 30, &arena );
+  testSuite10 ( 1 << 24, 5000, NULL, VEB_SPARSE );
+  testSuite11 ( 64, 100 );
+  testSuite11 ( 3000, 5000 );
+  testSuite11 ( 1 << 20, 200000 );
+  testSuite11 ( 1 << 20, 200000, &arena );
+  testSuite11 ( 1 << 20, 200000, NULL, VEB_COUNTED | VEB_SPARSE );
+  testSuite11 ( 1 << 20, 50000, NULL, 0 );
+  testSuite12 ( 50, 2, 3 );
+  testSuite12 ( 5000, 3, 2 );
+  testSuite12 ( 1 << 20, 2, 5 );
+  testSuite12 ( 1 << 20, 1, 1 );
+  testSuite12 ( 1 << 22, 200, 50, VEB_SPARSE, 0 );
+  testSuite12 ( 1 << 24, 5000, 3000, VEB_SPARSE, VEB_SPARSE | VEB_COUNTED );
+  testSuite13 ( 100, 2, 10000 );
+  testSuite13 ( 1 << 16, 4, 200000 );
+  testSuite13 ( 1 << 20, 8, 200000, VEB_SPARSE );
+  testSuite14 ( 100, 2, 10000 );
+  testSuite14 ( 1 << 16, 4, 200000 );
+  testSuite14 ( 1 << 20, 8, 200000, VEB_COUNTED );
+  testSuite14 ( 1 << 24, 4, 100000, VEB_SPARSE );
+  testSuite14 ( 1 << 24, 4, 100000, VEB_SPARSE | VEB_COUNTED );
+  testSuite15 ( 1, 100, 2, 10000 );
+  testSuite15 ( 7, 50, 3, 20000 );
+  testSuite15 ( 256, 4096, 4, 200000 );
+  testSuite15 ( 4096, 256, 8, 200000, VEB_SPARSE );
+  testSuite16 ( 50, 2, 2 );
+  testSuite16 ( 1 << 16, 3, 1 );
+  testSuite16 ( 1 << 22, 2, 4 );
+  testSuite16 ( 1 << 22, 16, 8, VEB_COUNTED );
+  testSuite16 ( 1 << 26, 4096, 4, VEB_SPARSE );
+  testSuite17 ( 1, 2 );
+  testSuite17 ( 40, 2 );
+  testSuite17 ( 100000, 1000000 );
+  testSuite17 ( 1 << 20, 3 );
+  testSuite17 ( 1 << 22, 200, VEB_COUNTED );
+  testSuite17 ( 1 << 28, 100000, VEB_SPARSE );
+  testSuite18 ( 64, 1, 1, 200 );
+  testSuite18 ( 5000, 16, 8, 5000 );
+  testSuite18 ( 1 << 20, 64, 64, 100000 );
+  testSuite18 ( 1 << 20, 1000, 100, 20000, VEB_COUNTED );
+  testSuite18 ( 1 << 28, 256, 1000, 50000, VEB_SPARSE );
+  testSuite19 ( 50, 2, 20, 10 );
+  testSuite19 ( 5000, 3, 50, 100 );
+  testSuite19 ( 1 << 20, 4, 100, 2000 );
+  testSuite19 ( 1 << 20, 50, 100, 2000, VEB_COUNTED );
+  testSuite19 ( 1 << 26, 2000, 100, 5000, VEB_SPARSE );
+  testSuite19 ( 1 << 26, 2000, 50, 5000, VEB_SPARSE | VEB_COUNTED );
+  testSuite20 ( 50, 1000 );
+  testSuite20 ( 1 << 16, 100000 );
+  testSuite20 ( 1 << 24, 200000, VEB_COUNTED );
+  testSuite20 ( 1 << 28, 200000, VEB_SPARSE );
+  testSuite21 ( 1, 1, 10 );
+  testSuite21 ( 50, 2, 200 );
+  testSuite21 ( 1 << 12, 1, 2000 );
+  testSuite21 ( 1 << 16, 2, 20000 );
+  testSuite21 ( 1 << 20, 4, 20000 );
+  testSuite21 ( 1 << 20, 64, 20000, VEB_COUNTED );
+  testSuite21 ( 1 << 26, 1000, 20000, VEB_SPARSE );
+  testSuite21 ( 1 << 26, 1000, 20000, VEB_SPARSE | VEB_COUNTED );
+  testSuite22 ( 1, 1, 100 );
+  testSuite22 ( 50, 20, 2000 );
+  testSuite22 ( 1 << 16, 1000, 100000 );
+  testSuite22 ( 1 << 20, 100000, 200000, VEB_COUNTED );
+  testSuite22 ( 1 << 28, 100000, 200000, VEB_SPARSE );
+  testSuite22 ( 1 << 28, 10000, 200000, VEB_SPARSE | VEB_COUNTED );
+  testSuite23 ( 1, 1, 100 );
+  testSuite23 ( 100, 10, 5000 );
+  testSuite23 ( 1 << 16, 5000, 100000 );
+  testSuite23 ( 1 << 28, 100000, 200000 );
   return 0;
 }
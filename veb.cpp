@@ -17,358 +17,2982 @@
  * @license    This project is released undes the MIT License.
  ******************************************************************************/
 
+#include <algorithm>
+#include <cstddef>
+#include <new>
 #include "veb.hpp"
+#include "vebpool.hpp"
+#include "vebstats.hpp"
 
-TvEB::TvEB ( int uniSize )
-  : uni ( powTwoRoundUp ( uniSize ) ), uniSqrt ( sqrt ( uni ) ),
-    lowerUniSqrt ( lowerSqrt ( uni ) ), higherUniSqrt ( higherSqrt ( uni ) ),
-    min ( UNDEFINED ), max ( UNDEFINED ), summary ( NULL )
-{
-  if ( uniSize <= 0 )
-  {
-    std::cerr << "universe size of TvEB must be bigger than 0" << std::endl;
-    return;
-  }
-
-  if ( uni > 2 )
-  {
-    cluster = new TvEB * [higherUniSqrt];
-    for ( int i = 0; i < higherUniSqrt; ++i )
-    {
-      cluster[i] = NULL;
-    }
-  }
-  else
-  {
-    cluster = NULL;
-  }
-}
-
-TvEB::~TvEB()
+/***************************************************************************//**
+ * @brief      Returns whether the clusters of the tree are leaves, kept as bare
+ *             words in its cluster array or hash table. It holds for leaves
+ *             too, which keep their own word instead.
+ ******************************************************************************/
+static inline bool leafClusters ( const TvEB * tree )
 {
-  if ( summary ) delete summary;
-  if ( cluster )
-  {
-    for ( int i = 0; i < higherUniSqrt; ++i )
-    {
-      if ( cluster[i] ) delete cluster[i];
-    }
-    delete [] cluster;
-  }
+  return tree->lowerUniSqrt() <= VEB_LEAF_UNI;
 }
 
-int powTwoRoundUp ( int x )
+/***************************************************************************//**
+ * @brief      Returns whether the summary of the tree is a leaf, kept as the
+ *             bare word summaryBits. It holds for leaves too, whose summaryBits
+ *             stays 0.
+ ******************************************************************************/
+static inline bool leafSummary ( const TvEB * tree )
 {
-  if ( x < 0 ) return 0;
-  --x;
-  x |= x >> 1;
-  x |= x >> 2;
-  x |= x >> 4;
-  x |= x >> 8;
-  x |= x >> 16;
-  return x + 1;
+  return tree->higherUniSqrt() <= VEB_LEAF_UNI;
 }
 
-float lowerSqrt ( int val )
+/***************************************************************************//**
+ * @brief      Returns the bytes of a VEB_TRIMMED record of the given universe
+ *             and flags up to the pointer to its arena, which are the fields
+ *             up to the cluster union and the part of the union it uses.
+ ******************************************************************************/
+static inline size_t trimmedHead ( int uni, int flags )
 {
-  return pow ( 2, floor ( log2 ( val )  / 2 ) );
+  if ( uni > VEB_LEAF_UNI && ( flags & VEB_SPARSE ) ) return offsetof ( TvEB, counts );
+  return offsetof ( TvEB, bits ) + sizeof ( uint64_t );
 }
 
-float higherSqrt ( int val )
+/***************************************************************************//**
+ * @brief      Returns the arena of the tree, kept after the head of a
+ *             VEB_TRIMMED record allocated from an arena.
+ ******************************************************************************/
+static inline TvEBArena * nodeArena ( const TvEB * tree )
 {
-  return pow ( 2, ceil ( log2 ( val )  / 2 ) );
+  if ( ! ( tree->flags & VEB_TRIMMED ) ) return tree->arena;
+  if ( ! ( tree->flags & VEB_TRIMMED_ARENA ) ) return NULL;
+  return * ( TvEBArena ** ) ( ( const char * ) tree + trimmedHead ( tree->uni, tree->flags ) );
 }
 
-int low ( TvEB * tree, int val )
+/***************************************************************************//**
+ * @brief      Returns the Fenwick tree of the tree, kept at the end of a
+ *             VEB_TRIMMED record, or NULL.
+ ******************************************************************************/
+static inline int * nodeCounts ( const TvEB * tree )
 {
-  return val % ( int ) lowerSqrt ( tree->uni );
+  if ( ! ( tree->flags & VEB_TRIMMED ) ) return tree->counts;
+  if ( tree->uni <= VEB_LEAF_UNI || ! ( tree->flags & VEB_COUNTED ) ) return NULL;
+  size_t head = trimmedHead ( tree->uni, tree->flags )
+                + ( tree->flags & VEB_TRIMMED_ARENA ? sizeof ( TvEBArena * ) : 0 );
+  return ( int * ) ( ( const char * ) tree + head );
 }
 
-int high ( TvEB * tree, int val )
+/***************************************************************************//**
+ * @brief      Returns the bytes of a VEB_TRIMMED record of the given universe
+ *             and flags.
+ ******************************************************************************/
+static inline size_t trimmedBytes ( int uni, int flags )
 {
-  return val / lowerSqrt ( tree->uni );
+  size_t bytes = trimmedHead ( uni, flags ) + ( flags & VEB_TRIMMED_ARENA ? sizeof ( TvEBArena * ) : 0 );
+  if ( uni > VEB_LEAF_UNI && ( flags & VEB_COUNTED ) ) bytes += ( uni >> log2Int ( uni ) / 2 ) * sizeof ( int );
+  return bytes;
 }
 
-int index ( TvEB * tree, int high, int low )
+/***************************************************************************//**
+ * @brief      Returns the flags the subtrees of the tree are created with.
+ ******************************************************************************/
+static inline int nodeFlags ( const TvEB * tree )
 {
-  return high * lowerSqrt ( tree->uni ) + low;
+  return tree->flags & ~ ( VEB_TRIMMED | VEB_TRIMMED_ARENA );
 }
 
-bool vEB_min ( TvEB * tree, int & res )
+/***************************************************************************//**
+ * @brief      Allocates the empty cluster array of a tree without VEB_SPARSE,
+ *             of pointers or of leaf words.
+ ******************************************************************************/
+static void allocClusters ( TvEB * tree, TvEBArena * arena )
 {
-  if ( tree )
+  int cnt = tree->higherUniSqrt();
+  if ( leafClusters ( tree ) )
   {
-    res = tree->min;
-    return true;
+    if ( arena )
+    {
+      tree->leaves = ( uint64_t * ) arena->allocBytes ( cnt * sizeof ( uint64_t ) );
+    }
+    else
+    {
+      tree->leaves = new uint64_t [cnt];
+    }
+    std::fill ( tree->leaves, tree->leaves + cnt, ( uint64_t ) 0 );
   }
-  return false;
-}
-
-bool vEB_max ( TvEB * tree, int & res )
-{
-  if ( tree )
+  else
   {
-    res = tree->max;
-    return true;
+    if ( arena )
+    {
+      tree->cluster = ( TvEB ** ) arena->allocBytes ( cnt * sizeof ( TvEB * ) );
+    }
+    else
+    {
+      tree->cluster = new TvEB * [cnt];
+    }
+    std::fill ( tree->cluster, tree->cluster + cnt, ( TvEB * ) NULL );
   }
-  return false;
 }
 
-bool vEB_insert ( TvEB *& tree, int val, int parentUniSqrt )
+TvEB::TvEB ( int uniSize, TvEBArena * arena, int flags )
+  : uni ( powTwoRoundUp ( uniSize ) ), flags ( flags ),
+    min ( UNDEFINED ), max ( UNDEFINED ), size ( 0 ), gen ( arena ? arena->gen : 0 ),
+    summary ( NULL ),
+    cluster ( NULL ), counts ( NULL ), arena ( arena )
 {
-  if ( !tree )
+  if ( leafSummary ( this ) ) summaryBits = 0;
+
+  if ( uni <= VEB_LEAF_UNI )
   {
-    tree = new TvEB ( parentUniSqrt );
+    bits = 0;
   }
-
-#ifdef DEBUG
-  DEBUG_OS << "inserting " << val << " to tree " << tree
-           << " of size " << tree->uni << DEBUG_OS_ENDL;
-#endif /* DEBUG */
-
-  if ( val < 0 || val >= tree->uni ) return false;
-
-  if ( tree->min == val || tree->max == val ) return false;
-
-  if ( tree->min == UNDEFINED )
+  else if ( flags & VEB_SPARSE )
   {
-    tree->min = tree->max = val;
-    return true;
+    clusterMap.vals = NULL;
+    clusterMap.capBits = 0;
+    clusterMap.cnt = 0;
   }
 
-  if ( val < tree->min )
+  if ( uniSize <= 0 )
   {
-    int tmp = val;
-    val = tree->min;
-    tree->min = tmp;
+    std::cerr << "universe size of TvEB must be bigger than 0" << std::endl;
+    return;
   }
 
-  if ( val > tree->max )
+  if ( uni > VEB_LEAF_UNI && ! ( flags & VEB_SPARSE ) )
   {
-    tree->max = val;
+    allocClusters ( this, arena );
   }
 
-  if ( tree->uni > 2 )
+  if ( uni > VEB_LEAF_UNI && ( flags & VEB_COUNTED ) )
   {
-    int lowVal = low ( tree, val );
-    int highVal = high ( tree, val );
-    if ( !tree->cluster[highVal] )
+    if ( arena )
     {
-      if ( !vEB_insert ( tree->summary, highVal, tree->higherUniSqrt ) ) return false;
+      counts = ( int * ) arena->allocBytes ( higherUniSqrt() * sizeof ( int ) );
     }
-
-    if ( !vEB_insert ( tree->cluster[highVal], lowVal, tree->lowerUniSqrt ) ) return false;
+    else
+    {
+      counts = new int [higherUniSqrt()];
+    }
+    std::fill ( counts, counts + higherUniSqrt(), 0 );
   }
-  return true;
 }
 
-bool vEB_delete ( TvEB *& tree, int val )
+TvEB::TvEB ( const TvEB * tree, int flags )
+  : uni ( tree->uni ), flags ( flags ),
+    min ( tree->min ), max ( tree->max ), size ( tree->size ), gen ( 0 ),
+    summary ( NULL ), cluster ( NULL )
 {
-  if ( !tree ) return false;
+  // counts and arena lie past the end of the record, they are not touched
+  if ( leafSummary ( this ) ) summaryBits = 0;
 
-#ifdef DEBUG
-  DEBUG_OS << "deleting " << val << " from tree " << tree
-           << " of size " << tree->uni << DEBUG_OS_ENDL;
-#endif /* DEBUG */
+  if ( uni <= VEB_LEAF_UNI )
+  {
+    bits = tree->bits;
+  }
+  else if ( flags & VEB_SPARSE )
+  {
+    clusterMap.vals = NULL;
+    clusterMap.capBits = 0;
+    clusterMap.cnt = 0;
+  }
+}
 
-  if ( val < 0 || val >= tree->uni ) return false;
-  if ( tree->min > val || tree->max < val ) return false;
+void * TvEB::operator new ( size_t bytes )
+{
+  return ::operator new ( bytes );
+}
 
-  if ( tree->min == val )
-  {
-    int i;
-    if ( !vEB_min ( tree->summary, i ) || i == UNDEFINED )
-    {
-      if ( tree->min != tree->max )
-      {
-        tree->min = tree->max;
-        return true;
-      }
+void * TvEB::operator new ( size_t, void * place )
+{
+  return place;
+}
 
-      tree->min = tree->max = UNDEFINED;
-      delete tree;
-      tree = NULL;
-      return true;
-    }
+void TvEB::operator delete ( void * ptr )
+{
+  ::operator delete ( ptr );
+}
 
-    val = tree->min = index ( tree, i, tree->cluster[i]->min );
+TvEB::~TvEB()
+{
+  if ( nodeArena ( this ) || uni <= VEB_LEAF_UNI ) return;
+  if ( !leafSummary ( this ) && summary ) delete summary;
+  if ( ( flags & VEB_SPARSE ) && leafClusters ( this ) )
+  {
+    delete [] ( char * ) clusterMap.leaves;
   }
-
-  if ( tree->uni > 2 )
+  else if ( flags & VEB_SPARSE )
   {
-    int highVal = high ( tree, val );
-    if ( !vEB_delete ( tree->cluster[highVal], low ( tree, val ) ) ) return false;
-
-    int tmp;
-    if ( !vEB_min ( tree->cluster[highVal], tmp ) || tmp == UNDEFINED )
+    for ( int i = 0; i < 1 << clusterMap.capBits && clusterMap.vals; ++i )
     {
-      if ( !vEB_delete ( tree->summary, highVal ) ) return false;
+      if ( clusterMap.vals[i] ) delete clusterMap.vals[i];
     }
+    delete [] ( char * ) clusterMap.vals;
   }
-
-  if ( tree->max == val )
+  else if ( leafClusters ( this ) )
   {
-    int tmp;
-    if ( !vEB_max ( tree->summary, tmp ) || tmp == UNDEFINED )
-    {
-      tree->max = tree->min;
-    }
-    else
+    delete [] leaves;
+  }
+  else if ( cluster )
+  {
+    for ( int i = 0; i < higherUniSqrt(); ++i )
     {
-      int i;
-      if ( !vEB_max ( tree->summary, i ) ) return false;
-      tree->max = index ( tree, i, tree->cluster[i]->max );
+      if ( cluster[i] ) delete cluster[i];
     }
+    delete [] cluster;
   }
-  return true;
+  if ( ! ( flags & VEB_TRIMMED ) ) delete [] counts;
 }
 
-bool vEB_find ( TvEB * tree, int val )
+TvEBArena::TvEBArena ( size_t chunkSize )
+  : chunkSize ( chunkSize ), chunks ( NULL ), pos ( NULL ), left ( 0 ),
+    retire ( NULL ), retireCtx ( NULL ), gen ( 0 )
 {
-  if ( !tree ) return false;
+  clear();
+}
 
-#ifdef DEBUG
-  DEBUG_OS << "looking for " << val << " in tree " << tree << DEBUG_OS_ENDL;
-#endif /* DEBUG */
+TvEBArena::~TvEBArena()
+{
+  clear();
+}
 
-  if ( val < 0 || val >= tree->uni ) return false;
-  if ( tree->min > val || tree->max < val ) return false;
-  if ( tree->min == val ) return true;
-  if ( !tree->summary )
+TvEB * TvEBArena::alloc ( int uniSize, int flags )
+{
+  int sizeClass = log2Int ( powTwoRoundUp ( uniSize ) );
+  TvEB *& list = recycled[flags & 3][sizeClass];
+  if ( uniSize > 0 && list && list->flags == flags )
   {
-    return tree->max == val;
+    TvEB * tree = list;
+    list = tree->summary;
+    tree->summary = NULL;
+    if ( leafSummary ( tree ) ) tree->summaryBits = 0;
+    tree->gen = gen;
+    return tree;
   }
-  if ( !vEB_find ( tree->cluster[high ( tree, val )], low ( tree, val ) ) )
-    return false;
-  return true;
+  return new ( allocBytes ( sizeof ( TvEB ) ) ) TvEB ( uniSize, this, flags );
 }
 
-bool vEB_succ ( TvEB * tree, int val, int & res )
+void TvEBArena::recycle ( TvEB * tree )
 {
-  if ( !tree ) return false;
-
-#ifdef DEBUG
-  DEBUG_OS << "looking for successor of " << val << " in tree " << tree
-           << " of size " << tree->uni << DEBUG_OS_ENDL;
-#endif /* DEBUG */
+  if ( retire )
+  {
+    retire ( tree, retireCtx );
+    return;
+  }
+  reuse ( tree );
+}
 
-  if ( val < -1 || val >= tree->uni ) return false;
+void TvEBArena::reuse ( TvEB * tree )
+{
+  TvEB *& list = recycled[tree->flags & 3][log2Int ( tree->uni )];
+  tree->min = tree->max = UNDEFINED;
+  tree->size = 0;
+  if ( tree->uni <= VEB_LEAF_UNI ) tree->bits = 0;
+  tree->summary = list;
+  list = tree;
+}
 
-  if ( tree->min > val )
+void TvEBArena::reuseCopied ( TvEB * tree )
+{
+  if ( tree->uni <= VEB_LEAF_UNI )
   {
-    res = tree->min;
-    return true;
+    // a leaf keeps nothing but its word
   }
-
-  if ( !tree->summary )
+  else if ( tree->flags & VEB_SPARSE )
   {
-    if ( tree->max > val )
-    {
-      res = tree->max;
-      return true;
-    }
-    return false;
+    if ( tree->clusterMap.vals ) recycleBlock ( tree->clusterMap.vals, tree->clusterMap.capBits );
+    tree->clusterMap.vals = NULL;
+    tree->clusterMap.capBits = 0;
+    tree->clusterMap.cnt = 0;
   }
-
-  int lowVal = low ( tree, val );
-  int highVal = high ( tree, val );
-  int i = highVal;
-  int j = UNDEFINED;
-  int tmp;
-  if ( vEB_max ( tree->cluster[i], tmp ) && lowVal < tmp )
+  else if ( leafClusters ( tree ) )
   {
-    if ( !vEB_succ ( tree->cluster[i], lowVal, j ) ) return false;
+    std::fill ( tree->leaves, tree->leaves + tree->higherUniSqrt(), ( uint64_t ) 0 );
   }
-  else
+  else if ( tree->cluster )
   {
-    if ( !vEB_succ ( tree->summary, highVal, i ) )
-    {
-      if ( tree->max > val )
-      {
-        res = tree->max;
-        return true;
-      }
-      return false;
-    }
-    if ( !vEB_min ( tree->cluster[i], j ) ) return false;
+    std::fill ( tree->cluster, tree->cluster + tree->higherUniSqrt(), ( TvEB * ) NULL );
   }
-
-  res = index ( tree, i, j );
-  return true;
+  if ( tree->counts )
+  {
+    std::fill ( tree->counts, tree->counts + tree->higherUniSqrt(), 0 );
+  }
+  reuse ( tree );
 }
 
-bool vEB_pred ( TvEB * tree, int val, int & res )
+void * TvEBArena::allocBlock ( int sizeClass, size_t bytes )
 {
-  if ( !tree ) return false;
-
-#ifdef DEBUG
-  DEBUG_OS << "looking for predecessor of " << val << " in tree " << tree
-           << " of size " << tree->uni << DEBUG_OS_ENDL;
-#endif /* DEBUG */
-
-  if ( val < 0 || val > tree->uni ) return false;
+  void * block = recycledBlocks[sizeClass];
+  if ( !block ) return allocBytes ( bytes );
+  recycledBlocks[sizeClass] = * ( void ** ) block;
+  return block;
+}
 
-  if ( tree->max < val )
-  {
-    res = tree->max;
-    return true;
-  }
+void TvEBArena::recycleBlock ( void * block, int sizeClass )
+{
+  * ( void ** ) block = recycledBlocks[sizeClass];
+  recycledBlocks[sizeClass] = block;
+}
 
-  if ( !tree->summary )
+void * TvEBArena::allocBytes ( size_t bytes )
+{
+  const size_t align = 16;
+  bytes = ( bytes + align - 1 ) & ~ ( align - 1 );
+  if ( bytes > left )
   {
-    if ( tree->min < val )
+    size_t size = bytes > chunkSize ? bytes : chunkSize;
+    char * chunk = ( char * ) malloc ( align + size );
+    * ( void ** ) chunk = chunks;
+    chunks = chunk;
+    if ( bytes == size && left > 0 )
     {
-      res = tree->min;
-      return true;
+      // an oversized request gets its own chunk, keep filling the current one
+      return chunk + align;
     }
-    return false;
+    pos = chunk + align;
+    left = size;
   }
+  void * res = pos;
+  pos += bytes;
+  left -= bytes;
+  return res;
+}
 
-  int lowVal = low ( tree, val );
-  int highVal = high ( tree, val );
-  int i = highVal;
-  int j = UNDEFINED;
-  int tmp;
-  if ( vEB_min ( tree->cluster[i], tmp ) && lowVal > tmp )
+void TvEBArena::clear()
+{
+  while ( chunks )
   {
-    if ( !vEB_pred ( tree->cluster[i], lowVal, j ) ) return false;
+    void * next = * ( void ** ) chunks;
+    free ( chunks );
+    chunks = next;
   }
-  else
+  pos = NULL;
+  left = 0;
+  for ( int i = 0; i < 32; ++i )
   {
-    if ( !vEB_pred ( tree->summary, highVal, i ) )
+    for ( int j = 0; j < 4; ++j )
     {
-      if ( tree->min < val )
-      {
-        res = tree->min;
-        return true;
-      }
-      return false;
+      recycled[j][i] = NULL;
     }
-    if ( !vEB_max ( tree->cluster[i], j ) ) return false;
+    recycledBlocks[i] = NULL;
   }
+}
 
-  res = index ( tree, i, j );
-  return true;
+/***************************************************************************//**
+ * @brief      Returns the home slot of the cluster index in a table with
+ *             2^capBits slots, by Fibonacci hashing.
+ ******************************************************************************/
+static inline int mapHome ( int key, int capBits )
+{
+  return ( uint32_t ) key * 2654435769u >> ( 32 - capBits );
 }
 
-void vEB_print ( TvEB * tree, std::ostream & os )
+/***************************************************************************//**
+ * @brief      Returns the bytes of a hash table of the tree with 2^capBits
+ *             slots, the values followed by the keys.
+ ******************************************************************************/
+static inline size_t mapBytes ( const TvEB * tree, int capBits )
 {
-  if ( !tree ) return;
-  os << "tree: " << tree << std::endl;
-  os << "min: " << tree->min << ", max: " << tree->max << std::endl;
-  os << "uni: " << tree->uni << ", uniSqrt: " << tree->uniSqrt << std::endl;
-  os << "lowerUniSqrt: " << tree->lowerUniSqrt;
-  os << ", higherUniSqrt: " << tree->higherUniSqrt << std::endl;
-  os << "summary: " << tree->summary << std::endl;
-  if ( tree->uni > 2 )
-  {
-    for ( int i = 0; i < tree->higherUniSqrt; ++i )
-    {
-      os << "cluster " << i << ": " << tree->cluster[i] << std::endl;
-    }
-  }
-  else
+  size_t valBytes = leafClusters ( tree ) ? sizeof ( uint64_t ) : sizeof ( TvEB * );
+  return ( ( size_t ) 1 << capBits ) * ( valBytes + sizeof ( int ) );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the cluster slots of the tree, its array or the values
+ *             of its hash table, as T, which is TvEB * for clusters that are
+ *             nodes and uint64_t for leaves.
+ ******************************************************************************/
+template <typename T> static inline T * slots ( const TvEB * tree );
+
+template <> inline TvEB ** slots ( const TvEB * tree )
+{
+  return tree->flags & VEB_SPARSE ? tree->clusterMap.vals : tree->cluster;
+}
+
+template <> inline uint64_t * slots ( const TvEB * tree )
+{
+  return tree->flags & VEB_SPARSE ? tree->clusterMap.leaves : tree->leaves;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the keys of the hash table, which follow its values.
+ ******************************************************************************/
+template <typename T> static inline int * mapKeys ( const TvEB * tree )
+{
+  return ( int * ) ( slots<T> ( tree ) + ( 1 << tree->clusterMap.capBits ) );
+}
+
+/***************************************************************************//**
+ * @brief      Replaces the hash table of the sparse tree by an empty one with
+ *             2^capBits slots, or by none when capBits is 0, and moves the
+ *             clusters over.
+ ******************************************************************************/
+template <typename T> static void mapResizeAs ( TvEB * tree, int capBits )
+{
+  TvEBClusterMap & map = tree->clusterMap;
+  T * oldVals = slots<T> ( tree );
+  int * oldKeys = oldVals ? mapKeys<T> ( tree ) : NULL;
+  int oldCapBits = map.capBits;
+  TvEBArena * arena = nodeArena ( tree );
+
+  T * vals = NULL;
+  if ( capBits )
+  {
+    size_t cap = ( size_t ) 1 << capBits;
+    size_t bytes = mapBytes ( tree, capBits );
+    vals = ( T * ) ( arena ? arena->allocBlock ( capBits, bytes ) : new char [bytes] );
+    for ( size_t i = 0; i < cap; ++i )
+    {
+      vals[i] = T();
+    }
+  }
+  map.vals = ( TvEB ** ) vals;
+  map.capBits = capBits;
+  map.cnt = 0;
+
+  if ( !oldVals ) return;
+  int * keys = mapKeys<T> ( tree );
+  for ( int i = 0; i < 1 << oldCapBits; ++i )
+  {
+    if ( !oldVals[i] ) continue;
+    int slot = mapHome ( oldKeys[i], capBits );
+    while ( vals[slot] ) slot = ( slot + 1 ) & ( ( 1 << capBits ) - 1 );
+    keys[slot] = oldKeys[i];
+    vals[slot] = oldVals[i];
+    map.cnt++;
+  }
+  if ( arena ) arena->recycleBlock ( oldVals, oldCapBits );
+  else delete [] ( char * ) oldVals;
+}
+
+/***************************************************************************//**
+ * @brief      Resizes the hash table of the sparse tree, see mapResizeAs.
+ ******************************************************************************/
+static void mapResize ( TvEB * tree, int capBits )
+{
+  if ( leafClusters ( tree ) ) mapResizeAs<uint64_t> ( tree, capBits );
+  else mapResizeAs<TvEB *> ( tree, capBits );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the content of the slot of the cluster of the given
+ *             index, empty if there is none.
+ ******************************************************************************/
+template <typename T> static inline T slotFind ( const TvEB * tree, int high )
+{
+  if ( ! ( tree->flags & VEB_SPARSE ) ) return slots<T> ( tree )[high];
+
+  T * vals = slots<T> ( tree );
+  if ( !vals ) return T();
+  int * keys = mapKeys<T> ( tree );
+  int mask = ( 1 << tree->clusterMap.capBits ) - 1;
+  for ( int slot = mapHome ( high, tree->clusterMap.capBits ); vals[slot]; slot = ( slot + 1 ) & mask )
+  {
+    if ( keys[slot] == high ) return vals[slot];
+  }
+  return T();
+}
+
+/***************************************************************************//**
+ * @brief      Returns the slot of the cluster of the given index, claiming an
+ *             empty slot for it if there is none. A claimed slot must be
+ *             filled before the next lookup.
+ ******************************************************************************/
+template <typename T> static T & slotRef ( TvEB * tree, int high )
+{
+  if ( ! ( tree->flags & VEB_SPARSE ) ) return slots<T> ( tree )[high];
+
+  TvEBClusterMap & map = tree->clusterMap;
+  if ( ( map.cnt + 1 ) * 4 > 3 << map.capBits )
+  {
+    mapResizeAs<T> ( tree, map.capBits ? map.capBits + 1 : 2 );
+  }
+  T * vals = slots<T> ( tree );
+  int * keys = mapKeys<T> ( tree );
+  int mask = ( 1 << map.capBits ) - 1;
+  int slot = mapHome ( high, map.capBits );
+  while ( vals[slot] && keys[slot] != high ) slot = ( slot + 1 ) & mask;
+  if ( !vals[slot] )
+  {
+    keys[slot] = high;
+    map.cnt++;
+  }
+  return vals[slot];
+}
+
+/***************************************************************************//**
+ * @brief      Forgets the emptied cluster of the given index.
+ ******************************************************************************/
+template <typename T> static void slotErase ( TvEB * tree, int high )
+{
+  if ( ! ( tree->flags & VEB_SPARSE ) )
+  {
+    slots<T> ( tree )[high] = T();
+    return;
+  }
+
+  TvEBClusterMap & map = tree->clusterMap;
+  T * vals = slots<T> ( tree );
+  int * keys = mapKeys<T> ( tree );
+  int mask = ( 1 << map.capBits ) - 1;
+  int slot = mapHome ( high, map.capBits );
+  while ( keys[slot] != high ) slot = ( slot + 1 ) & mask;
+
+  // backward shift deletion: move up every following entry of the probe run
+  // whose home slot does not lie between the hole and the entry
+  for ( ;; )
+  {
+    vals[slot] = T();
+    int next = slot;
+    int home;
+    do
+    {
+      next = ( next + 1 ) & mask;
+      if ( !vals[next] ) break;
+      home = mapHome ( keys[next], map.capBits );
+    }
+    while ( slot <= next ? ( slot < home && home <= next )
+                         : ( slot < home || home <= next ) );
+    if ( !vals[next] ) break;
+    keys[slot] = keys[next];
+    vals[slot] = vals[next];
+    slot = next;
+  }
+  map.cnt--;
+
+  if ( !map.cnt ) mapResizeAs<T> ( tree, 0 );
+  else if ( map.capBits > 2 && map.cnt * 8 < 1 << map.capBits ) mapResizeAs<T> ( tree, map.capBits - 1 );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the slot of the cluster of the given index, claiming an
+ *             empty slot for it if there is none.
+ ******************************************************************************/
+static inline TvEB *& clusterRef ( TvEB * tree, int high )
+{
+  return slotRef<TvEB *> ( tree, high );
+}
+
+/***************************************************************************//**
+ * @brief      Forgets the emptied and already released cluster of the given
+ *             index.
+ ******************************************************************************/
+static inline void clusterErase ( TvEB * tree, int high )
+{
+  slotErase<TvEB *> ( tree, high );
+}
+
+/***************************************************************************//**
+ * @brief      Stores the word of the leaf cluster of the given index, an
+ *             emptied leaf gives its slot up.
+ ******************************************************************************/
+static inline void leafSet ( TvEB * tree, int high, uint64_t word )
+{
+  if ( word ) slotRef<uint64_t> ( tree, high ) = word;
+  else slotErase<uint64_t> ( tree, high );
+}
+
+/***************************************************************************//**
+ * @brief      Releases the emptied tree, into its arena if it has one.
+ *
+ * @param[in]  tree  The pointer to the van Emde Boas tree, set to NULL.
+ ******************************************************************************/
+static void releaseTree ( TvEB *& tree )
+{
+  VEB_STATS_FREE();
+  if ( nodeArena ( tree ) )
+  {
+    nodeArena ( tree )->recycle ( tree );
+  }
+  else
+  {
+    delete tree;
+  }
+  tree = NULL;
+}
+
+/***************************************************************************//**
+ * @brief      Releases a VEB_TRIMMED record replaced by its full copy, without
+ *             its summary and clusters, which the copy took over. A record in
+ *             an arena stays there until the arena is cleared.
+ ******************************************************************************/
+static void dropTrimmed ( TvEB * tree )
+{
+  if ( nodeArena ( tree ) ) return;
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    // the word is all there is
+  }
+  else if ( tree->flags & VEB_SPARSE )
+  {
+    delete [] ( char * ) tree->clusterMap.vals;
+  }
+  else if ( leafClusters ( tree ) )
+  {
+    delete [] tree->leaves;
+  }
+  else
+  {
+    delete [] tree->cluster;
+  }
+  TvEB::operator delete ( tree );
+}
+
+/***************************************************************************//**
+ * @brief      Replaces the given tree of an older generation, or a VEB_TRIMMED
+ *             record, by its full copy from the same arena or the heap, which
+ *             shares the summary and the clusters, and retires the tree.
+ ******************************************************************************/
+static void cloneTree ( TvEB *& tree )
+{
+  TvEBArena * arena = nodeArena ( tree );
+  TvEB * copy = arena ? arena->alloc ( tree->uni, nodeFlags ( tree ) )
+                : new TvEB ( tree->uni, NULL, nodeFlags ( tree ) );
+  copy->min = tree->min;
+  copy->max = tree->max;
+  copy->size = tree->size;
+  if ( tree->uni <= VEB_LEAF_UNI ) copy->bits = tree->bits;
+  else if ( leafSummary ( tree ) ) copy->summaryBits = tree->summaryBits;
+  else copy->summary = tree->summary;
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    // the word is all there is
+  }
+  else if ( ( tree->flags & VEB_SPARSE ) && tree->clusterMap.vals )
+  {
+    size_t bytes = mapBytes ( tree, tree->clusterMap.capBits );
+    char * table = arena ? ( char * ) arena->allocBlock ( tree->clusterMap.capBits, bytes )
+                   : new char [bytes];
+    std::copy ( ( char * ) tree->clusterMap.vals, ( char * ) tree->clusterMap.vals + bytes, table );
+    copy->clusterMap.vals = ( TvEB ** ) table;
+    copy->clusterMap.capBits = tree->clusterMap.capBits;
+    copy->clusterMap.cnt = tree->clusterMap.cnt;
+  }
+  else if ( ! ( tree->flags & VEB_SPARSE ) && leafClusters ( tree ) )
+  {
+    std::copy ( tree->leaves, tree->leaves + tree->higherUniSqrt(), copy->leaves );
+  }
+  else if ( ! ( tree->flags & VEB_SPARSE ) )
+  {
+    std::copy ( tree->cluster, tree->cluster + tree->higherUniSqrt(), copy->cluster );
+  }
+  if ( nodeCounts ( tree ) )
+  {
+    std::copy ( nodeCounts ( tree ), nodeCounts ( tree ) + tree->higherUniSqrt(), copy->counts );
+  }
+  VEB_STATS_ALLOC();
+  VEB_STATS_FREE();
+  if ( tree->flags & VEB_TRIMMED ) dropTrimmed ( tree );
+  else arena->recycle ( tree );
+  tree = copy;
+}
+
+/***************************************************************************//**
+ * @brief      Makes sure the given tree, which is about to change, is neither
+ *             shared with a snapshot nor a VEB_TRIMMED record.
+ ******************************************************************************/
+static inline void unshare ( TvEB *& tree )
+{
+  if ( tree->flags & VEB_TRIMMED ) cloneTree ( tree );
+  else if ( tree->arena && tree->gen != tree->arena->gen ) cloneTree ( tree );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the number of elements of the tree.
+ ******************************************************************************/
+static inline int treeSize ( const TvEB * tree )
+{
+  if ( !tree ) return 0;
+  if ( tree->uni <= VEB_LEAF_UNI ) return __builtin_popcountll ( tree->bits );
+  return tree->size;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the lowest element of the nonempty leaf word.
+ ******************************************************************************/
+static inline int wordMin ( uint64_t word )
+{
+  return __builtin_ctzll ( word );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the highest element of the nonempty leaf word.
+ ******************************************************************************/
+static inline int wordMax ( uint64_t word )
+{
+  return 63 - __builtin_clzll ( word );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the elements of the leaf word above val, which is at
+ *             least -1.
+ ******************************************************************************/
+static inline uint64_t wordAbove ( uint64_t word, int val )
+{
+  if ( val < 0 ) return word;
+  return val < 63 ? word & ( ~ ( uint64_t ) 1 << val ) : 0;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the elements of the leaf word below val, which is at
+ *             most 64.
+ ******************************************************************************/
+static inline uint64_t wordBelow ( uint64_t word, int val )
+{
+  if ( val >= 64 ) return word;
+  return val > 0 ? word & ( ( ( uint64_t ) 1 << val ) - 1 ) : 0;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the k-th lowest element of the leaf word, which has
+ *             more than k elements.
+ ******************************************************************************/
+static inline int wordSelect ( uint64_t word, int k )
+{
+  for ( ; k > 0; --k ) word &= word - 1;
+  return __builtin_ctzll ( word );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the leaf word of the sorted values.
+ ******************************************************************************/
+static inline uint64_t wordOf ( const int * vals, size_t n )
+{
+  uint64_t word = 0;
+  for ( size_t i = 0; i < n; ++i ) word |= ( uint64_t ) 1 << vals[i];
+  return word;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the index of the first cluster of the tree, UNDEFINED if
+ *             it has none.
+ ******************************************************************************/
+static inline int summaryMin ( const TvEB * tree )
+{
+  if ( leafSummary ( tree ) ) return tree->summaryBits ? wordMin ( tree->summaryBits ) : UNDEFINED;
+  return tree->summary ? tree->summary->min : UNDEFINED;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the index of the last cluster of the tree, UNDEFINED if
+ *             it has none.
+ ******************************************************************************/
+static inline int summaryMax ( const TvEB * tree )
+{
+  if ( leafSummary ( tree ) ) return tree->summaryBits ? wordMax ( tree->summaryBits ) : UNDEFINED;
+  return tree->summary ? tree->summary->max : UNDEFINED;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the index of the last cluster of the tree before high.
+ ******************************************************************************/
+static inline bool summaryPred ( const TvEB * tree, int high, int & res )
+{
+  if ( !leafSummary ( tree ) ) return vEB_pred ( tree->summary, high, res );
+  uint64_t word = wordBelow ( tree->summaryBits, high );
+  if ( !word ) return false;
+  res = wordMax ( word );
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Adds the index of the new cluster to the summary of the tree,
+ *             which is already unshared.
+ ******************************************************************************/
+static inline bool summaryInsert ( TvEB * tree, int high )
+{
+  if ( !leafSummary ( tree ) )
+  {
+    return vEB_insert ( tree->summary, high, tree->higherUniSqrt(), nodeArena ( tree ),
+                        nodeFlags ( tree ) & ~VEB_COUNTED );
+  }
+  uint64_t bit = ( uint64_t ) 1 << high;
+  if ( tree->summaryBits & bit ) return false;
+  tree->summaryBits |= bit;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Removes the index of the emptied cluster from the summary of the
+ *             tree, which is already unshared.
+ ******************************************************************************/
+static inline void summaryDelete ( TvEB * tree, int high )
+{
+  if ( leafSummary ( tree ) ) tree->summaryBits &= ~ ( ( uint64_t ) 1 << high );
+  else vEB_delete ( tree->summary, high );
+}
+
+/***************************************************************************//**
+ * @brief      Returns whether the cluster of the given index is empty.
+ ******************************************************************************/
+static inline bool clusterEmpty ( const TvEB * tree, int high )
+{
+  if ( leafClusters ( tree ) ) return !vEB_leaf ( tree, high );
+  return !vEB_cluster ( tree, high );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the number of elements of the cluster of the given index.
+ ******************************************************************************/
+static inline int clusterSize ( const TvEB * tree, int high )
+{
+  if ( leafClusters ( tree ) ) return __builtin_popcountll ( vEB_leaf ( tree, high ) );
+  return treeSize ( vEB_cluster ( tree, high ) );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the lowest element of the nonempty cluster of the given
+ *             index.
+ ******************************************************************************/
+static inline int clusterMin ( const TvEB * tree, int high )
+{
+  if ( leafClusters ( tree ) ) return wordMin ( vEB_leaf ( tree, high ) );
+  return vEB_cluster ( tree, high )->min;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the highest element of the nonempty cluster of the given
+ *             index.
+ ******************************************************************************/
+static inline int clusterMax ( const TvEB * tree, int high )
+{
+  if ( leafClusters ( tree ) ) return wordMax ( vEB_leaf ( tree, high ) );
+  return vEB_cluster ( tree, high )->max;
+}
+
+/***************************************************************************//**
+ * @brief      Adds delta to the size of the cluster of the given index in the
+ *             Fenwick tree of a VEB_COUNTED tree.
+ ******************************************************************************/
+static inline void countAdd ( TvEB * tree, int high, int delta )
+{
+  int * counts = nodeCounts ( tree );
+  if ( !counts ) return;
+  for ( int i = high + 1; i <= tree->higherUniSqrt(); i += i & -i )
+  {
+    counts[i - 1] += delta;
+  }
+}
+
+/***************************************************************************//**
+ * @brief      Removes the minimum, or the maximum when max is set, of the
+ *             nonempty cluster of the given index of the tree, which is
+ *             already unshared, and drops the cluster from the summary once it
+ *             is empty.
+ *
+ * @return     The removed element, relative to the cluster.
+ ******************************************************************************/
+static int clusterExtract ( TvEB * tree, int high, bool max )
+{
+  int res;
+  bool emptied;
+  VEB_STATS_CLUSTER();
+  if ( leafClusters ( tree ) )
+  {
+    uint64_t word = vEB_leaf ( tree, high );
+    res = max ? wordMax ( word ) : wordMin ( word );
+    word &= ~ ( ( uint64_t ) 1 << res );
+    leafSet ( tree, high, word );
+    emptied = !word;
+  }
+  else
+  {
+    TvEB * cluster = vEB_cluster ( tree, high );
+    TvEB * old = cluster;
+    if ( max ) vEB_extract_max ( cluster, res );
+    else vEB_extract_min ( cluster, res );
+    if ( !cluster ) clusterErase ( tree, high );
+    else if ( cluster != old ) clusterRef ( tree, high ) = cluster;
+    emptied = !cluster;
+  }
+  countAdd ( tree, high, -1 );
+  if ( emptied )
+  {
+    VEB_STATS_SUMMARY();
+    summaryDelete ( tree, high );
+  }
+  return res;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the number of elements in the clusters of the tree
+ *             before the cluster of the given index.
+ ******************************************************************************/
+static int countBelow ( const TvEB * tree, int high )
+{
+  int res = 0;
+  const int * counts = nodeCounts ( tree );
+  if ( counts )
+  {
+    for ( int i = high; i > 0; i -= i & -i ) res += counts[i - 1];
+    return res;
+  }
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ) && i < high; )
+  {
+    res += clusterSize ( tree, i );
+  }
+  return res;
+}
+
+int powTwoRoundUp ( int x )
+{
+  if ( x < 0 ) return 0;
+  --x;
+  x |= x >> 1;
+  x |= x >> 2;
+  x |= x >> 4;
+  x |= x >> 8;
+  x |= x >> 16;
+  return x + 1;
+}
+
+int log2Int ( int val )
+{
+  int res = 0;
+  while ( val >>= 1 ) ++res;
+  return res;
+}
+
+float lowerSqrt ( int val )
+{
+  return pow ( 2, floor ( log2 ( val )  / 2 ) );
+}
+
+float higherSqrt ( int val )
+{
+  return pow ( 2, ceil ( log2 ( val )  / 2 ) );
+}
+
+int low ( TvEB * tree, int val )
+{
+  return val & tree->lowMask();
+}
+
+int high ( TvEB * tree, int val )
+{
+  return val >> tree->lowBits();
+}
+
+int index ( TvEB * tree, int high, int low )
+{
+  return ( high << tree->lowBits() ) | low;
+}
+
+TvEB * vEB_cluster ( const TvEB * tree, int high )
+{
+  if ( leafClusters ( tree ) ) return NULL;
+  return slotFind<TvEB *> ( tree, high );
+}
+
+uint64_t vEB_leaf ( const TvEB * tree, int high )
+{
+  if ( tree->uni <= VEB_LEAF_UNI || !leafClusters ( tree ) ) return 0;
+  return slotFind<uint64_t> ( tree, high );
+}
+
+bool vEB_cluster_succ ( const TvEB * tree, int high, int & res )
+{
+  if ( tree->uni <= VEB_LEAF_UNI ) return false;
+  if ( !leafSummary ( tree ) ) return vEB_succ ( tree->summary, high, res );
+  uint64_t word = wordAbove ( tree->summaryBits, high );
+  if ( !word ) return false;
+  res = wordMin ( word );
+  return true;
+}
+
+bool vEB_min ( TvEB * tree, int & res )
+{
+  if ( tree )
+  {
+    res = tree->min;
+    return true;
+  }
+  return false;
+}
+
+bool vEB_max ( TvEB * tree, int & res )
+{
+  if ( tree )
+  {
+    res = tree->max;
+    return true;
+  }
+  return false;
+}
+
+bool vEB_insert ( TvEB *& tree, int val, int parentUniSqrt, TvEBArena * arena,
+                  int flags )
+{
+  VEB_STATS_SCOPE ( VEB_OP_INSERT );
+  if ( !tree )
+  {
+    tree = arena ? arena->alloc ( parentUniSqrt, flags )
+           : new TvEB ( parentUniSqrt, NULL, flags );
+    VEB_STATS_ALLOC();
+  }
+
+#ifdef DEBUG
+  DEBUG_OS << "inserting " << val << " to tree " << tree
+           << " of size " << tree->uni << DEBUG_OS_ENDL;
+#endif /* DEBUG */
+
+  if ( val < 0 || val >= tree->uni ) return false;
+
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    uint64_t bit = ( uint64_t ) 1 << val;
+    if ( tree->bits & bit ) return false;
+    unshare ( tree );
+    if ( !tree->bits || val < tree->min ) tree->min = val;
+    if ( !tree->bits || val > tree->max ) tree->max = val;
+    tree->bits |= bit;
+    return true;
+  }
+
+  if ( tree->min == val || tree->max == val ) return false;
+
+  // a value between the minimum and the maximum may already be in its cluster,
+  // then the node is copied only once the cluster took the value
+  if ( tree->min == UNDEFINED || val < tree->min || val > tree->max ) unshare ( tree );
+
+  if ( tree->min == UNDEFINED )
+  {
+    tree->min = tree->max = val;
+    tree->size = 1;
+    return true;
+  }
+
+  if ( val < tree->min )
+  {
+    int tmp = val;
+    val = tree->min;
+    tree->min = tmp;
+  }
+
+  if ( val > tree->max )
+  {
+    tree->max = val;
+  }
+
+  int lowVal = low ( tree, val );
+  int highVal = high ( tree, val );
+  if ( leafClusters ( tree ) )
+  {
+    uint64_t word = vEB_leaf ( tree, highVal );
+    uint64_t bit = ( uint64_t ) 1 << lowVal;
+    VEB_STATS_CLUSTER();
+    if ( word & bit ) return false;
+    unshare ( tree );
+    if ( !word )
+    {
+      VEB_STATS_SUMMARY();
+      summaryInsert ( tree, highVal );
+    }
+    leafSet ( tree, highVal, word | bit );
+  }
+  else
+  {
+    TvEB * cluster = vEB_cluster ( tree, highVal );
+    TvEB * old = cluster;
+    if ( !cluster )
+    {
+      unshare ( tree );
+      VEB_STATS_SUMMARY();
+      if ( !summaryInsert ( tree, highVal ) ) return false;
+    }
+
+    VEB_STATS_CLUSTER();
+    if ( !vEB_insert ( cluster, lowVal, tree->lowerUniSqrt(), nodeArena ( tree ), nodeFlags ( tree ) ) ) return false;
+    unshare ( tree );
+    if ( cluster != old ) clusterRef ( tree, highVal ) = cluster;
+  }
+  countAdd ( tree, highVal, 1 );
+  tree->size++;
+  return true;
+}
+
+bool vEB_delete ( TvEB *& tree, int val )
+{
+  VEB_STATS_SCOPE ( VEB_OP_DELETE );
+  if ( !tree ) return false;
+
+#ifdef DEBUG
+  DEBUG_OS << "deleting " << val << " from tree " << tree
+           << " of size " << tree->uni << DEBUG_OS_ENDL;
+#endif /* DEBUG */
+
+  if ( val < 0 || val >= tree->uni ) return false;
+  if ( tree->min > val || tree->max < val ) return false;
+
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    uint64_t bit = ( uint64_t ) 1 << val;
+    if ( !( tree->bits & bit ) ) return false;
+    unshare ( tree );
+    tree->bits &= ~bit;
+    if ( !tree->bits )
+    {
+      releaseTree ( tree );
+      return true;
+    }
+    tree->min = __builtin_ctzll ( tree->bits );
+    tree->max = 63 - __builtin_clzll ( tree->bits );
+    return true;
+  }
+
+  // only the minimum is known to be there, any other value copies the node
+  // once its cluster really lost it
+  if ( tree->min == val )
+  {
+    unshare ( tree );
+    int i = summaryMin ( tree );
+    if ( i == UNDEFINED )
+    {
+      if ( tree->min != tree->max )
+      {
+        tree->min = tree->max;
+        tree->size--;
+        return true;
+      }
+
+      tree->min = tree->max = UNDEFINED;
+      releaseTree ( tree );
+      return true;
+    }
+
+    val = tree->min = index ( tree, i, clusterMin ( tree, i ) );
+  }
+
+  int highVal = high ( tree, val );
+  bool emptied;
+  VEB_STATS_CLUSTER();
+  if ( leafClusters ( tree ) )
+  {
+    uint64_t word = vEB_leaf ( tree, highVal );
+    uint64_t bit = ( uint64_t ) 1 << low ( tree, val );
+    if ( ! ( word & bit ) ) return false;
+    unshare ( tree );
+    leafSet ( tree, highVal, word & ~bit );
+    emptied = word == bit;
+  }
+  else
+  {
+    TvEB * cluster = vEB_cluster ( tree, highVal );
+    TvEB * old = cluster;
+    if ( !vEB_delete ( cluster, low ( tree, val ) ) ) return false;
+    unshare ( tree );
+    if ( !cluster ) clusterErase ( tree, highVal );
+    else if ( cluster != old ) clusterRef ( tree, highVal ) = cluster;
+    emptied = !cluster;
+  }
+  countAdd ( tree, highVal, -1 );
+  if ( emptied )
+  {
+    VEB_STATS_SUMMARY();
+    summaryDelete ( tree, highVal );
+  }
+
+  if ( tree->max == val )
+  {
+    int i = summaryMax ( tree );
+    tree->max = i == UNDEFINED ? tree->min : index ( tree, i, clusterMax ( tree, i ) );
+  }
+  tree->size--;
+  return true;
+}
+
+bool vEB_extract_min ( TvEB *& tree, int & res )
+{
+  VEB_STATS_SCOPE ( VEB_OP_DELETE );
+  if ( !tree || tree->min == UNDEFINED ) return false;
+
+  res = tree->min;
+  unshare ( tree );
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    tree->bits &= tree->bits - 1;
+    if ( !tree->bits )
+    {
+      releaseTree ( tree );
+      return true;
+    }
+    tree->min = __builtin_ctzll ( tree->bits );
+    return true;
+  }
+
+  int i = summaryMin ( tree );
+  if ( i == UNDEFINED )
+  {
+    if ( tree->min == tree->max )
+    {
+      tree->min = tree->max = UNDEFINED;
+      releaseTree ( tree );
+      return true;
+    }
+    tree->min = tree->max;
+    tree->size--;
+    return true;
+  }
+
+  // the new minimum is the one of the first cluster, which leaves it, the
+  // emptied cluster was the last one only when it held the maximum too
+  tree->min = index ( tree, i, clusterExtract ( tree, i, false ) );
+  tree->size--;
+  return true;
+}
+
+bool vEB_extract_max ( TvEB *& tree, int & res )
+{
+  VEB_STATS_SCOPE ( VEB_OP_DELETE );
+  if ( !tree || tree->min == UNDEFINED ) return false;
+
+  res = tree->max;
+  unshare ( tree );
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    tree->bits &= ~( ( uint64_t ) 1 << tree->max );
+    if ( !tree->bits )
+    {
+      releaseTree ( tree );
+      return true;
+    }
+    tree->max = 63 - __builtin_clzll ( tree->bits );
+    return true;
+  }
+
+  if ( tree->min == tree->max )
+  {
+    tree->min = tree->max = UNDEFINED;
+    releaseTree ( tree );
+    return true;
+  }
+
+  clusterExtract ( tree, summaryMax ( tree ), true );
+  int i = summaryMax ( tree );
+  tree->max = i == UNDEFINED ? tree->min : index ( tree, i, clusterMax ( tree, i ) );
+  tree->size--;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Inserts the sorted distinct values, all inside the universe of
+ *             the tree, into the given tree. Each summary gets the indices of
+ *             all the clusters the batch creates in one batch and each cluster
+ *             gets its contiguous slice of the values.
+ *
+ * @return     The number of inserted values.
+ ******************************************************************************/
+static size_t insertSorted ( TvEB *& tree, int * vals, size_t n, int uniSize,
+                             TvEBArena * arena, int flags )
+{
+  if ( !n ) return 0;
+  if ( n == 1 ) return vEB_insert ( tree, vals[0], uniSize, arena, flags );
+
+  if ( !tree )
+  {
+    tree = arena ? arena->alloc ( uniSize, flags )
+           : new TvEB ( uniSize, NULL, flags );
+    VEB_STATS_ALLOC();
+  }
+
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    uint64_t bits = wordOf ( vals, n );
+    size_t cnt = __builtin_popcountll ( bits & ~tree->bits );
+    if ( !cnt ) return 0;
+    unshare ( tree );
+    tree->bits |= bits;
+    tree->min = __builtin_ctzll ( tree->bits );
+    tree->max = 63 - __builtin_clzll ( tree->bits );
+    return cnt;
+  }
+
+  // values that leave the minimum, the maximum and the summary alone copy the
+  // node only once one of its clusters took some of them
+  if ( tree->min == UNDEFINED || vals[0] < tree->min || vals[n - 1] > tree->max )
+  {
+    unshare ( tree );
+  }
+  size_t cnt = 0;
+  if ( tree->min == UNDEFINED )
+  {
+    tree->min = tree->max = vals[0];
+    ++vals;
+    --n;
+    ++cnt;
+  }
+  else if ( vals[0] == tree->min )
+  {
+    ++vals;
+    --n;
+  }
+  else if ( vals[0] < tree->min )
+  {
+    // the first value becomes the minimum and the old minimum goes down with
+    // the rest, the counts of the two cancel out
+    int oldMin = tree->min;
+    tree->min = vals[0];
+    int * pos = std::lower_bound ( vals + 1, vals + n, oldMin );
+    if ( pos == vals + n || *pos != oldMin )
+    {
+      std::copy ( vals + 1, pos, vals );
+      pos[-1] = oldMin;
+    }
+    else
+    {
+      ++vals;
+      --n;
+    }
+  }
+  if ( !n )
+  {
+    if ( cnt ) tree->size += cnt;
+    return cnt;
+  }
+  if ( vals[n - 1] > tree->max ) tree->max = vals[n - 1];
+
+  int * fresh = new int [n];
+  size_t freshCnt = 0;
+  for ( size_t i = 0; i < n; )
+  {
+    int highVal = high ( tree, vals[i] );
+    if ( clusterEmpty ( tree, highVal ) ) fresh[freshCnt++] = highVal;
+    while ( i < n && high ( tree, vals[i] ) == highVal ) ++i;
+  }
+  if ( freshCnt )
+  {
+    unshare ( tree );
+    if ( leafSummary ( tree ) ) tree->summaryBits |= wordOf ( fresh, freshCnt );
+    else insertSorted ( tree->summary, fresh, freshCnt, tree->higherUniSqrt(), nodeArena ( tree ),
+                        nodeFlags ( tree ) & ~VEB_COUNTED );
+  }
+  delete [] fresh;
+
+  for ( size_t i = 0, j; i < n; i = j )
+  {
+    int highVal = high ( tree, vals[i] );
+    for ( j = i; j < n && high ( tree, vals[j] ) == highVal; ++j )
+    {
+      vals[j] = low ( tree, vals[j] );
+    }
+    size_t added;
+    if ( leafClusters ( tree ) )
+    {
+      uint64_t word = vEB_leaf ( tree, highVal );
+      uint64_t bits = wordOf ( vals + i, j - i );
+      added = __builtin_popcountll ( bits & ~word );
+      if ( !added ) continue;
+      unshare ( tree );
+      leafSet ( tree, highVal, word | bits );
+    }
+    else
+    {
+      TvEB * cluster = vEB_cluster ( tree, highVal );
+      TvEB * old = cluster;
+      added = insertSorted ( cluster, vals + i, j - i, tree->lowerUniSqrt(),
+                             nodeArena ( tree ), nodeFlags ( tree ) );
+      if ( !added ) continue;
+      unshare ( tree );
+      if ( cluster != old ) clusterRef ( tree, highVal ) = cluster;
+    }
+    countAdd ( tree, highVal, added );
+    cnt += added;
+  }
+  if ( cnt ) tree->size += cnt;
+  return cnt;
+}
+
+/***************************************************************************//**
+ * @brief      Removes the sorted distinct values from the given tree. The
+ *             indices of all the clusters the batch empties are removed from
+ *             the summary in one batch.
+ *
+ * @return     The number of removed values.
+ ******************************************************************************/
+static size_t deleteSorted ( TvEB *& tree, int * vals, size_t n )
+{
+  if ( !tree || !n ) return 0;
+  if ( n == 1 ) return vEB_delete ( tree, vals[0] );
+
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    uint64_t bits = wordOf ( vals, n );
+    size_t cnt = __builtin_popcountll ( bits & tree->bits );
+    if ( !cnt ) return 0;
+    unshare ( tree );
+    tree->bits &= ~bits;
+    if ( !tree->bits )
+    {
+      releaseTree ( tree );
+      return cnt;
+    }
+    tree->min = __builtin_ctzll ( tree->bits );
+    tree->max = 63 - __builtin_clzll ( tree->bits );
+    return cnt;
+  }
+
+  if ( tree->min == UNDEFINED ) return 0;
+  int * end = std::upper_bound ( vals, vals + n, tree->max );
+  vals = std::lower_bound ( vals, end, tree->min );
+  n = end - vals;
+  if ( !n ) return 0;
+
+  // values missing from the clusters copy the node only when the batch takes
+  // the minimum or a cluster reports a removal
+  size_t cnt = 0;
+  bool minGone = vals[0] == tree->min;
+  if ( minGone )
+  {
+    unshare ( tree );
+    ++vals;
+    --n;
+    ++cnt;
+  }
+
+  int * emptied = new int [n + 1];
+  size_t emptiedCnt = 0;
+  for ( size_t i = 0, j; i < n; i = j )
+  {
+    int highVal = high ( tree, vals[i] );
+    for ( j = i; j < n && high ( tree, vals[j] ) == highVal; ++j )
+    {
+      vals[j] = low ( tree, vals[j] );
+    }
+    size_t removed;
+    bool gone;
+    if ( leafClusters ( tree ) )
+    {
+      uint64_t word = vEB_leaf ( tree, highVal );
+      uint64_t bits = wordOf ( vals + i, j - i );
+      removed = __builtin_popcountll ( bits & word );
+      if ( !removed ) continue;
+      unshare ( tree );
+      leafSet ( tree, highVal, word & ~bits );
+      gone = ! ( word & ~bits );
+    }
+    else
+    {
+      TvEB * cluster = vEB_cluster ( tree, highVal );
+      if ( !cluster ) continue;
+      TvEB * old = cluster;
+      removed = deleteSorted ( cluster, vals + i, j - i );
+      if ( !removed ) continue;
+      unshare ( tree );
+      if ( !cluster ) clusterErase ( tree, highVal );
+      else if ( cluster != old ) clusterRef ( tree, highVal ) = cluster;
+      gone = !cluster;
+    }
+    countAdd ( tree, highVal, - ( int ) removed );
+    cnt += removed;
+    if ( gone ) emptied[emptiedCnt++] = highVal;
+  }
+  if ( !leafSummary ( tree ) ) deleteSorted ( tree->summary, emptied, emptiedCnt );
+  else if ( emptiedCnt ) tree->summaryBits &= ~wordOf ( emptied, emptiedCnt );
+  delete [] emptied;
+  if ( !cnt ) return 0;
+
+  int i;
+  if ( minGone )
+  {
+    i = summaryMin ( tree );
+    if ( i == UNDEFINED )
+    {
+      tree->min = tree->max = UNDEFINED;
+      releaseTree ( tree );
+      return cnt;
+    }
+    tree->min = index ( tree, i, clusterExtract ( tree, i, false ) );
+  }
+
+  i = summaryMax ( tree );
+  tree->max = i == UNDEFINED ? tree->min : index ( tree, i, clusterMax ( tree, i ) );
+  tree->size -= cnt;
+  return cnt;
+}
+
+/***************************************************************************//**
+ * @brief      Copies the values of the batch that fit into the universe into
+ *             a new array, sorted and without duplicates.
+ *
+ * @return     The number of copied values.
+ ******************************************************************************/
+static size_t sortedCopy ( const int * vals, size_t n, int uni, int *& res )
+{
+  res = new int [n];
+  size_t cnt = 0;
+  for ( size_t i = 0; i < n; ++i )
+  {
+    if ( vals[i] >= 0 && vals[i] < uni ) res[cnt++] = vals[i];
+  }
+
+  if ( cnt < 4096 )
+  {
+    if ( !std::is_sorted ( res, res + cnt ) ) std::sort ( res, res + cnt );
+  }
+  else if ( !std::is_sorted ( res, res + cnt ) )
+  {
+    // least significant digit radix sort by 11 bits, the batches are large
+    // and the values bounded by the universe
+    int * tmp = new int [cnt];
+    for ( int shift = 0; shift < log2Int ( uni ); shift += 11 )
+    {
+      size_t pos[2048] = { 0 };
+      for ( size_t i = 0; i < cnt; ++i ) pos[( res[i] >> shift ) & 2047]++;
+      for ( size_t i = 0, sum = 0; i < 2048; ++i )
+      {
+        size_t digitCnt = pos[i];
+        pos[i] = sum;
+        sum += digitCnt;
+      }
+      for ( size_t i = 0; i < cnt; ++i ) tmp[pos[( res[i] >> shift ) & 2047]++] = res[i];
+      std::swap ( res, tmp );
+    }
+    delete [] tmp;
+  }
+  return std::unique ( res, res + cnt ) - res;
+}
+
+size_t vEB_insert_batch ( TvEB *& tree, const int * vals, size_t n,
+                          int parentUniSqrt, TvEBArena * arena, int flags )
+{
+  int * sorted;
+  size_t cnt = sortedCopy ( vals, n, tree ? tree->uni : powTwoRoundUp ( parentUniSqrt ), sorted );
+  cnt = insertSorted ( tree, sorted, cnt, parentUniSqrt, arena, flags );
+  delete [] sorted;
+  return cnt;
+}
+
+size_t vEB_delete_batch ( TvEB *& tree, const int * vals, size_t n )
+{
+  if ( !tree ) return 0;
+  int * sorted;
+  size_t cnt = sortedCopy ( vals, n, tree->uni, sorted );
+  cnt = deleteSorted ( tree, sorted, cnt );
+  delete [] sorted;
+  return cnt;
+}
+
+/***************************************************************************//**
+ * @brief      Builds the tree over the given universe holding the sorted
+ *             distinct values, all inside the universe. The clusters are
+ *             built first, their indices are collected in scratch and the
+ *             summary is built from them last, with vals, no longer needed,
+ *             as its scratch.
+ *
+ * @return     The pointer to the built tree.
+ ******************************************************************************/
+static TvEB * buildSorted ( int * vals, int * scratch, size_t n, int uniSize,
+                            TvEBArena * arena, int flags )
+{
+  TvEB * tree = arena ? arena->alloc ( uniSize, flags )
+                : new TvEB ( uniSize, NULL, flags );
+  if ( !n ) return tree;
+
+  tree->min = vals[0];
+  tree->max = vals[n - 1];
+  tree->size = n;
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    tree->bits = wordOf ( vals, n );
+    return tree;
+  }
+
+  if ( tree->flags & VEB_SPARSE )
+  {
+    size_t clusterCnt = 0;
+    for ( size_t i = 1; i < n; ++i )
+    {
+      if ( i == 1 || high ( tree, vals[i] ) != high ( tree, vals[i - 1] ) ) clusterCnt++;
+    }
+    int capBits = 2;
+    while ( clusterCnt * 4 > ( size_t ) 3 << capBits ) capBits++;
+    if ( clusterCnt ) mapResize ( tree, capBits );
+  }
+
+  size_t clusterCnt = 0;
+  for ( size_t i = 1, j; i < n; i = j )
+  {
+    int highVal = high ( tree, vals[i] );
+    for ( j = i; j < n && high ( tree, vals[j] ) == highVal; ++j )
+    {
+      vals[j] = low ( tree, vals[j] );
+    }
+    if ( leafClusters ( tree ) )
+    {
+      leafSet ( tree, highVal, wordOf ( vals + i, j - i ) );
+    }
+    else
+    {
+      clusterRef ( tree, highVal ) = buildSorted ( vals + i, scratch + i, j - i,
+                                                   tree->lowerUniSqrt(), nodeArena ( tree ), nodeFlags ( tree ) );
+    }
+    countAdd ( tree, highVal, j - i );
+    scratch[clusterCnt++] = highVal;
+  }
+  if ( clusterCnt && leafSummary ( tree ) )
+  {
+    tree->summaryBits = wordOf ( scratch, clusterCnt );
+  }
+  else if ( clusterCnt )
+  {
+    tree->summary = buildSorted ( scratch, vals, clusterCnt, tree->higherUniSqrt(),
+                                  nodeArena ( tree ), nodeFlags ( tree ) & ~VEB_COUNTED );
+  }
+  return tree;
+}
+
+TvEB * vEB_build_from_sorted ( const int * vals, size_t n, int uniSize,
+                               TvEBArena * arena, int flags )
+{
+  int uni = powTwoRoundUp ( uniSize );
+  for ( size_t i = 0; i < n; ++i )
+  {
+    if ( vals[i] < 0 || vals[i] >= uni || ( i && vals[i] <= vals[i - 1] ) )
+    {
+      std::cerr << "values passed to vEB_build_from_sorted must be sorted, distinct"
+                << " and inside the universe" << std::endl;
+      return NULL;
+    }
+  }
+
+  int * copy = new int [2 * n];
+  std::copy ( vals, vals + n, copy );
+  TvEB * tree = buildSorted ( copy, copy + n, n, uniSize, arena, flags );
+  delete [] copy;
+  return tree;
+}
+
+/***************************************************************************//**
+ * @brief      Struct containing the shared state of a parallel build.
+ ******************************************************************************/
+struct TvEBBuildJob
+{
+  /*************************************************************************//**
+   * @brief      The root being built.
+   ****************************************************************************/
+  TvEB * tree;
+
+  /*************************************************************************//**
+   * @brief      The values without the minimum, turned into the cluster ones.
+   ****************************************************************************/
+  int * vals;
+
+  /*************************************************************************//**
+   * @brief      The scratch space of buildSorted, as long as vals.
+   ****************************************************************************/
+  int * scratch;
+
+  /*************************************************************************//**
+   * @brief      The first value of each cluster, followed by the count.
+   ****************************************************************************/
+  size_t * starts;
+
+  /*************************************************************************//**
+   * @brief      The built clusters.
+   ****************************************************************************/
+  TvEB ** built;
+};
+
+/***************************************************************************//**
+ * @brief      Builds the clusters of the given range of a parallel build.
+ ******************************************************************************/
+static void buildClusters ( int lo, int hi, void * ctx )
+{
+  TvEBBuildJob * job = ( TvEBBuildJob * ) ctx;
+  TvEB * tree = job->tree;
+  for ( int k = lo; k < hi; ++k )
+  {
+    size_t i = job->starts[k];
+    size_t j = job->starts[k + 1];
+    for ( size_t p = i; p < j; ++p ) job->vals[p] = low ( tree, job->vals[p] );
+    job->built[k] = buildSorted ( job->vals + i, job->scratch + i, j - i,
+                                  tree->lowerUniSqrt(), NULL, nodeFlags ( tree ) );
+  }
+}
+
+TvEB * vEB_build_parallel ( const int * vals, size_t n, int uniSize,
+                            TvEBPool * pool, int flags )
+{
+  // clusters that are bare words are built in no time, not worth a thread
+  int uni = powTwoRoundUp ( uniSize );
+  if ( !pool || 1 << ( log2Int ( uni ) / 2 ) <= VEB_LEAF_UNI || n < 2 )
+  {
+    return vEB_build_from_sorted ( vals, n, uniSize, NULL, flags );
+  }
+  for ( size_t i = 0; i < n; ++i )
+  {
+    if ( vals[i] < 0 || vals[i] >= uni || ( i && vals[i] <= vals[i - 1] ) )
+    {
+      std::cerr << "values passed to vEB_build_parallel must be sorted, distinct"
+                << " and inside the universe" << std::endl;
+      return NULL;
+    }
+  }
+
+  TvEB * tree = new TvEB ( uniSize, NULL, flags );
+  tree->min = vals[0];
+  tree->max = vals[n - 1];
+  tree->size = n;
+
+  // the clusters are split off sequentially, it is a fraction of the build
+  int * copy = new int [2 * n];
+  std::copy ( vals + 1, vals + n, copy );
+  size_t * starts = new size_t [n];
+  int * highs = new int [2 * n];
+  int clusterCnt = 0;
+  for ( size_t i = 0; i < n - 1; ++i )
+  {
+    int highVal = high ( tree, copy[i] );
+    if ( !clusterCnt || highVal != highs[clusterCnt - 1] )
+    {
+      starts[clusterCnt] = i;
+      highs[clusterCnt++] = highVal;
+    }
+  }
+  starts[clusterCnt] = n - 1;
+
+  TvEBBuildJob job;
+  job.tree = tree;
+  job.vals = copy;
+  job.scratch = copy + n;
+  job.starts = starts;
+  job.built = new TvEB * [clusterCnt];
+  int grain = clusterCnt / ( pool->threadCnt * 16 );
+  vEB_pool_for ( pool, 0, clusterCnt, grain > 0 ? grain : 1, buildClusters, &job );
+
+  if ( tree->flags & VEB_SPARSE )
+  {
+    int capBits = 2;
+    while ( ( size_t ) clusterCnt * 4 > ( size_t ) 3 << capBits ) capBits++;
+    mapResize ( tree, capBits );
+  }
+  for ( int k = 0; k < clusterCnt; ++k )
+  {
+    clusterRef ( tree, highs[k] ) = job.built[k];
+    countAdd ( tree, highs[k], starts[k + 1] - starts[k] );
+  }
+  tree->summary = buildSorted ( highs, highs + n, clusterCnt, tree->higherUniSqrt(),
+                                NULL, nodeFlags ( tree ) & ~VEB_COUNTED );
+
+  delete [] job.built;
+  delete [] highs;
+  delete [] starts;
+  delete [] copy;
+  return tree;
+}
+
+/***************************************************************************//**
+ * @brief      Deletes the top-level clusters of the given range of slots.
+ ******************************************************************************/
+static void destroyClusters ( int lo, int hi, void * ctx )
+{
+  TvEB * tree = ( TvEB * ) ctx;
+  TvEB ** slots = tree->flags & VEB_SPARSE ? tree->clusterMap.vals : tree->cluster;
+  for ( int i = lo; i < hi; ++i )
+  {
+    if ( slots[i] ) delete slots[i];
+    slots[i] = NULL;
+  }
+}
+
+void vEB_destroy_parallel ( TvEB * tree, TvEBPool * pool )
+{
+  if ( !tree || nodeArena ( tree ) ) return;
+
+  int slotCnt = leafClusters ( tree ) ? 0
+                : ! ( tree->flags & VEB_SPARSE ) ? ( tree->cluster ? tree->higherUniSqrt() : 0 )
+                : tree->clusterMap.vals ? 1 << tree->clusterMap.capBits : 0;
+  int grain = pool ? slotCnt / ( pool->threadCnt * 16 ) : slotCnt;
+  vEB_pool_for ( pool, 0, slotCnt, grain > 0 ? grain : 1, destroyClusters, tree );
+  delete tree;
+}
+
+bool vEB_find ( TvEB * tree, int val )
+{
+  VEB_STATS_SCOPE ( VEB_OP_FIND );
+  if ( !tree ) return false;
+
+#ifdef DEBUG
+  DEBUG_OS << "looking for " << val << " in tree " << tree << DEBUG_OS_ENDL;
+#endif /* DEBUG */
+
+  if ( val < 0 || val >= tree->uni ) return false;
+  if ( tree->min > val || tree->max < val ) return false;
+  if ( tree->min == val ) return true;
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    return ( tree->bits >> val ) & 1;
+  }
+  if ( tree->max == val ) return true;
+  VEB_STATS_CLUSTER();
+  if ( leafClusters ( tree ) )
+  {
+    return ( vEB_leaf ( tree, high ( tree, val ) ) >> low ( tree, val ) ) & 1;
+  }
+  if ( !vEB_find ( vEB_cluster ( tree, high ( tree, val ) ), low ( tree, val ) ) )
+    return false;
+  return true;
+}
+
+bool vEB_succ ( TvEB * tree, int val, int & res )
+{
+  VEB_STATS_SCOPE ( VEB_OP_SUCC );
+  if ( !tree ) return false;
+
+#ifdef DEBUG
+  DEBUG_OS << "looking for successor of " << val << " in tree " << tree
+           << " of size " << tree->uni << DEBUG_OS_ENDL;
+#endif /* DEBUG */
+
+  if ( val < -1 || val >= tree->uni ) return false;
+
+  if ( tree->min > val )
+  {
+    res = tree->min;
+    return true;
+  }
+
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    if ( tree->max <= val ) return false;
+    res = __builtin_ctzll ( tree->bits & ( ~ ( uint64_t ) 1 << val ) );
+    return true;
+  }
+
+  if ( tree->max <= val ) return false;
+
+  int lowVal = low ( tree, val );
+  int highVal = high ( tree, val );
+  int i = highVal;
+  int j = UNDEFINED;
+  if ( leafClusters ( tree ) )
+  {
+    uint64_t word = wordAbove ( vEB_leaf ( tree, i ), lowVal );
+    if ( word )
+    {
+      res = index ( tree, i, wordMin ( word ) );
+      return true;
+    }
+  }
+  else
+  {
+    TvEB * cluster = vEB_cluster ( tree, i );
+    if ( cluster && lowVal < cluster->max )
+    {
+      VEB_STATS_CLUSTER();
+      if ( !vEB_succ ( cluster, lowVal, j ) ) return false;
+      res = index ( tree, i, j );
+      return true;
+    }
+  }
+
+  // the max is above val, so some later cluster holds the successor
+  VEB_STATS_SUMMARY();
+  if ( !vEB_cluster_succ ( tree, highVal, i ) ) return false;
+  res = index ( tree, i, clusterMin ( tree, i ) );
+  return true;
+}
+
+bool vEB_pred ( TvEB * tree, int val, int & res )
+{
+  VEB_STATS_SCOPE ( VEB_OP_PRED );
+  if ( !tree ) return false;
+
+#ifdef DEBUG
+  DEBUG_OS << "looking for predecessor of " << val << " in tree " << tree
+           << " of size " << tree->uni << DEBUG_OS_ENDL;
+#endif /* DEBUG */
+
+  if ( val < 0 || val > tree->uni ) return false;
+
+  if ( tree->max < val )
+  {
+    res = tree->max;
+    return true;
+  }
+
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    if ( tree->min >= val ) return false;
+    res = 63 - __builtin_clzll ( tree->bits & ( ( ( uint64_t ) 1 << val ) - 1 ) );
+    return true;
+  }
+
+  if ( tree->min >= val ) return false;
+
+  int lowVal = low ( tree, val );
+  int highVal = high ( tree, val );
+  int i = highVal;
+  int j = UNDEFINED;
+  if ( leafClusters ( tree ) )
+  {
+    uint64_t word = wordBelow ( vEB_leaf ( tree, i ), lowVal );
+    if ( word )
+    {
+      res = index ( tree, i, wordMax ( word ) );
+      return true;
+    }
+  }
+  else
+  {
+    TvEB * cluster = vEB_cluster ( tree, i );
+    if ( cluster && lowVal > cluster->min )
+    {
+      VEB_STATS_CLUSTER();
+      if ( !vEB_pred ( cluster, lowVal, j ) ) return false;
+      res = index ( tree, i, j );
+      return true;
+    }
+  }
+
+  // the min is below val, it is the predecessor when no earlier cluster is
+  VEB_STATS_SUMMARY();
+  if ( !summaryPred ( tree, highVal, i ) )
+  {
+    res = tree->min;
+    return true;
+  }
+  res = index ( tree, i, clusterMax ( tree, i ) );
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      The number of queries of a batch that are in flight at once.
+ ******************************************************************************/
+static const int QUERY_WIDTH = 16;
+
+/***************************************************************************//**
+ * @brief      The steps of a query of a batch. Each step touches memory
+ *             prefetched by the previous step of the same query.
+ ******************************************************************************/
+enum
+{
+  QUERY_VISIT,   ///< compare the value with the node's minimum and maximum
+  QUERY_CHILD,   ///< load the pointer to the cluster of the value
+  QUERY_CHECK,   ///< descend into the cluster or ask the summary
+  QUERY_RESUME,  ///< load the pointer to the cluster the summary answered
+  QUERY_EXTREME  ///< answer with the extreme of that cluster
+};
+
+/***************************************************************************//**
+ * @brief      Struct containing the state of a query of a batch, which is
+ *             the recursion of vEB_succ or vEB_pred unrolled into steps.
+ ******************************************************************************/
+struct TvEBQuery
+{
+  /// the index of the query in the batch
+  size_t idx;
+  /// the node the query is at
+  const TvEB * node;
+  /// the value relative to the node, or the index of the answered cluster
+  int val;
+  /// the value of the first element of the node in the tree the node
+  /// belongs to
+  int base;
+  /// the next step
+  int step;
+  /// the cluster of the value
+  const TvEB * cluster;
+  /// the number of nodes waiting for the answer of their summary
+  int depth;
+  /// the nodes waiting for the answer of their summary
+  const TvEB * waitNode[8];
+  /// the bases of the waiting nodes
+  int waitBase[8];
+};
+
+static inline void prefetchNode ( const TvEB * tree )
+{
+  __builtin_prefetch ( tree );
+  __builtin_prefetch ( ( const char * ) tree + 64 );
+}
+
+template <typename T> static inline void prefetchSlot ( const TvEB * tree, int high )
+{
+  if ( ! ( tree->flags & VEB_SPARSE ) ) __builtin_prefetch ( &slots<T> ( tree )[high] );
+  else if ( tree->clusterMap.vals )
+  {
+    int slot = mapHome ( high, tree->clusterMap.capBits );
+    __builtin_prefetch ( &slots<T> ( tree )[slot] );
+    __builtin_prefetch ( &mapKeys<T> ( tree )[slot] );
+  }
+}
+
+static inline void prefetchCluster ( const TvEB * tree, int high )
+{
+  if ( leafClusters ( tree ) ) prefetchSlot<uint64_t> ( tree, high );
+  else prefetchSlot<TvEB *> ( tree, high );
+}
+
+/***************************************************************************//**
+ * @brief      Hands the answer of the query in its current node to the node
+ *             waiting for it.
+ *
+ * @param[in]  q      The query.
+ * @param[in]  res    The answer relative to the current node, UNDEFINED if
+ *                    there is none.
+ * @param[in]  succ   Whether the query is for the successor.
+ *
+ * @retval     true   The query is answered, the answer is in q.val.
+ * @retval     false  The query continues.
+ ******************************************************************************/
+static bool queryAnswer ( TvEBQuery & q, int res, bool succ )
+{
+  for ( ;; )
+  {
+    if ( res != UNDEFINED ) res += q.base;
+    if ( !q.depth )
+    {
+      q.val = res;
+      return true;
+    }
+
+    q.depth--;
+    q.node = q.waitNode[q.depth];
+    q.base = q.waitBase[q.depth];
+    if ( res != UNDEFINED )
+    {
+      q.val = res;
+      q.step = QUERY_RESUME;
+      prefetchCluster ( q.node, res );
+      return false;
+    }
+    // no cluster in the direction, only the predecessor has the minimum left
+    res = succ ? UNDEFINED : q.node->min;
+  }
+}
+
+/***************************************************************************//**
+ * @brief      Does the next step of the query.
+ *
+ * @retval     true   The query is answered, the answer is in q.val.
+ * @retval     false  The query continues.
+ ******************************************************************************/
+static bool queryStep ( TvEBQuery & q, bool succ )
+{
+  const TvEB * tree = q.node;
+  int val = q.val;
+
+  switch ( q.step )
+  {
+    case QUERY_VISIT:
+    {
+      if ( tree->uni <= VEB_LEAF_UNI )
+      {
+        uint64_t word = tree->bits;
+        if ( succ && val >= 0 ) word = val < 63 ? word & ( ~ ( uint64_t ) 1 << val ) : 0;
+        if ( !succ && val < 64 ) word = val > 0 ? word & ( ( ( uint64_t ) 1 << val ) - 1 ) : 0;
+        if ( !word ) return queryAnswer ( q, UNDEFINED, succ );
+        return queryAnswer ( q, succ ? __builtin_ctzll ( word ) : 63 - __builtin_clzll ( word ), succ );
+      }
+
+      if ( tree->min == UNDEFINED ) return queryAnswer ( q, UNDEFINED, succ );
+      if ( succ )
+      {
+        if ( val < tree->min ) return queryAnswer ( q, tree->min, succ );
+        if ( val >= tree->max ) return queryAnswer ( q, UNDEFINED, succ );
+      }
+      else
+      {
+        if ( val > tree->max ) return queryAnswer ( q, tree->max, succ );
+        if ( val <= tree->min ) return queryAnswer ( q, UNDEFINED, succ );
+      }
+
+      prefetchCluster ( tree, val >> tree->lowBits() );
+      q.step = QUERY_CHILD;
+      return false;
+    }
+
+    case QUERY_CHILD:
+      if ( leafClusters ( tree ) )
+      {
+        // a leaf cluster is a word of the node, answered right away
+        int highVal = val >> tree->lowBits();
+        uint64_t word = vEB_leaf ( tree, highVal );
+        word = succ ? wordAbove ( word, val & tree->lowMask() ) : wordBelow ( word, val & tree->lowMask() );
+        if ( !word ) break;
+        return queryAnswer ( q, ( highVal << tree->lowBits() )
+                                | ( succ ? wordMin ( word ) : wordMax ( word ) ), succ );
+      }
+      q.cluster = vEB_cluster ( tree, val >> tree->lowBits() );
+      if ( q.cluster )
+      {
+        prefetchNode ( q.cluster );
+        q.step = QUERY_CHECK;
+        return false;
+      }
+      break;
+
+    case QUERY_CHECK:
+      if ( succ ? ( val & tree->lowMask() ) < q.cluster->max
+                : ( val & tree->lowMask() ) > q.cluster->min )
+      {
+        q.base += val & ~tree->lowMask();
+        q.node = q.cluster;
+        q.val = val & tree->lowMask();
+        q.step = QUERY_VISIT;
+        return false;
+      }
+      break;
+
+    case QUERY_RESUME:
+      if ( leafClusters ( tree ) )
+      {
+        uint64_t word = vEB_leaf ( tree, val );
+        return queryAnswer ( q, ( val << tree->lowBits() )
+                                | ( succ ? wordMin ( word ) : wordMax ( word ) ), succ );
+      }
+      q.cluster = vEB_cluster ( tree, val );
+      prefetchNode ( q.cluster );
+      q.step = QUERY_EXTREME;
+      return false;
+
+    case QUERY_EXTREME:
+      return queryAnswer ( q, ( val << tree->lowBits() )
+                                | ( succ ? q.cluster->min : q.cluster->max ), succ );
+  }
+
+  // the answer is not in the cluster of the value, the summary tells which
+  // cluster has it
+  q.waitNode[q.depth] = tree;
+  q.waitBase[q.depth] = q.base;
+  q.depth++;
+  q.val = val >> tree->lowBits();
+  q.base = 0;
+  if ( leafSummary ( tree ) )
+  {
+    uint64_t word = succ ? wordAbove ( tree->summaryBits, q.val ) : wordBelow ( tree->summaryBits, q.val );
+    if ( !word ) return queryAnswer ( q, UNDEFINED, succ );
+    return queryAnswer ( q, succ ? wordMin ( word ) : wordMax ( word ), succ );
+  }
+  q.node = tree->summary;
+  q.step = QUERY_VISIT;
+  prefetchNode ( q.node );
+  return false;
+}
+
+/***************************************************************************//**
+ * @brief      Answers the batch of successor or predecessor queries, keeping
+ *             up to QUERY_WIDTH of them in flight and doing one step of each
+ *             in turn, so the cache misses of different queries overlap.
+ ******************************************************************************/
+static size_t queryBatch ( TvEB * tree, const int * vals, size_t n, int * res, bool succ )
+{
+  TvEBQuery queries[QUERY_WIDTH];
+  int active = 0;
+  size_t next = 0;
+  size_t found = 0;
+
+  for ( ;; )
+  {
+    // refill the empty places by the next queries
+    while ( active < QUERY_WIDTH && next < n )
+    {
+      int val = vals[next];
+      if ( !tree || val < ( succ ? -1 : 0 ) || val > ( succ ? tree->uni - 1 : tree->uni ) )
+      {
+        res[next++] = UNDEFINED;
+        continue;
+      }
+      TvEBQuery & q = queries[active++];
+      q.idx = next++;
+      q.node = tree;
+      q.val = val;
+      q.base = 0;
+      q.step = QUERY_VISIT;
+      q.depth = 0;
+    }
+    if ( !active ) break;
+
+    for ( int i = 0; i < active; )
+    {
+      if ( !queryStep ( queries[i], succ ) )
+      {
+        ++i;
+        continue;
+      }
+      res[queries[i].idx] = queries[i].val;
+      if ( queries[i].val != UNDEFINED ) found++;
+      queries[i] = queries[--active];
+    }
+  }
+  return found;
+}
+
+size_t vEB_succ_batch ( TvEB * tree, const int * vals, size_t n, int * res )
+{
+  return queryBatch ( tree, vals, n, res, true );
+}
+
+size_t vEB_pred_batch ( TvEB * tree, const int * vals, size_t n, int * res )
+{
+  return queryBatch ( tree, vals, n, res, false );
+}
+
+/***************************************************************************//**
+ * @brief      Pushes the frame of the nonempty leaf word at the given bit onto
+ *             the iterator.
+ ******************************************************************************/
+static inline void iterLeaf ( TvEBIterator & it, uint64_t word, int base, int bit )
+{
+  int d = it.depth++;
+  it.node[d] = NULL;
+  it.base[d] = base;
+  it.pos[d] = bit;
+  it.leaf = word;
+  it.val = base + bit;
+}
+
+/***************************************************************************//**
+ * @brief      Pushes the frames of the path to the minimum of the non-empty
+ *             tree, which is not a leaf, onto the iterator.
+ ******************************************************************************/
+static void iterFirst ( TvEBIterator & it, const TvEB * tree, int base )
+{
+  int d = it.depth++;
+  it.node[d] = tree;
+  it.base[d] = base;
+  it.pos[d] = -1;
+  it.val = base + tree->min;
+}
+
+/***************************************************************************//**
+ * @brief      Pushes the frames of the path to the maximum of the non-empty
+ *             tree, which is not a leaf, onto the iterator.
+ ******************************************************************************/
+static void iterLast ( TvEBIterator & it, const TvEB * tree, int base )
+{
+  for ( ;; )
+  {
+    int d = it.depth++;
+    it.node[d] = tree;
+    it.base[d] = base;
+    if ( tree->min == tree->max )
+    {
+      it.pos[d] = -1;
+      it.val = base + tree->min;
+      return;
+    }
+    int i = summaryMax ( tree );
+    it.pos[d] = i;
+    base += i << tree->lowBits();
+    if ( leafClusters ( tree ) )
+    {
+      uint64_t word = vEB_leaf ( tree, i );
+      iterLeaf ( it, word, base, wordMax ( word ) );
+      return;
+    }
+    tree = vEB_cluster ( tree, i );
+  }
+}
+
+/***************************************************************************//**
+ * @brief      Pushes the frames of the path to the minimum, or the maximum
+ *             when last is set, of the nonempty cluster of the given index of
+ *             the tree onto the iterator, whose top frame is the tree's one.
+ ******************************************************************************/
+static void iterCluster ( TvEBIterator & it, const TvEB * tree, int high, bool last )
+{
+  int base = it.base[it.depth - 1] + ( high << tree->lowBits() );
+  it.pos[it.depth - 1] = high;
+  if ( leafClusters ( tree ) )
+  {
+    uint64_t word = vEB_leaf ( tree, high );
+    iterLeaf ( it, word, base, last ? wordMax ( word ) : wordMin ( word ) );
+  }
+  else if ( last )
+  {
+    iterLast ( it, vEB_cluster ( tree, high ), base );
+  }
+  else
+  {
+    iterFirst ( it, vEB_cluster ( tree, high ), base );
+  }
+}
+
+bool vEB_iter_succ ( const TvEB * tree, TvEBIterator & it, int val )
+{
+  it.depth = 0;
+  it.val = UNDEFINED;
+  if ( !tree || val < -1 || val >= tree->uni ) return false;
+
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    uint64_t word = wordAbove ( tree->bits, val );
+    if ( !word ) return false;
+    iterLeaf ( it, tree->bits, 0, wordMin ( word ) );
+    return true;
+  }
+
+  int base = 0;
+  for ( ;; )
+  {
+    if ( tree->min == UNDEFINED || val >= tree->max ) return false;
+    if ( val < tree->min )
+    {
+      iterFirst ( it, tree, base );
+      return true;
+    }
+
+    int highVal = val >> tree->lowBits();
+    int lowVal = val & tree->lowMask();
+    it.node[it.depth] = tree;
+    it.base[it.depth++] = base;
+    if ( leafClusters ( tree ) )
+    {
+      uint64_t word = vEB_leaf ( tree, highVal );
+      uint64_t above = wordAbove ( word, lowVal );
+      if ( above )
+      {
+        it.pos[it.depth - 1] = highVal;
+        iterLeaf ( it, word, base + ( highVal << tree->lowBits() ), wordMin ( above ) );
+        return true;
+      }
+    }
+    else
+    {
+      const TvEB * cluster = vEB_cluster ( tree, highVal );
+      if ( cluster && lowVal < cluster->max )
+      {
+        it.pos[it.depth - 1] = highVal;
+        base += highVal << tree->lowBits();
+        tree = cluster;
+        val = lowVal;
+        continue;
+      }
+    }
+
+    int i;
+    vEB_cluster_succ ( tree, highVal, i );
+    iterCluster ( it, tree, i, false );
+    return true;
+  }
+}
+
+bool vEB_iter_pred ( const TvEB * tree, TvEBIterator & it, int val )
+{
+  it.depth = 0;
+  it.val = UNDEFINED;
+  if ( !tree || val < 0 || val > tree->uni ) return false;
+
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    uint64_t word = wordBelow ( tree->bits, val );
+    if ( !word ) return false;
+    iterLeaf ( it, tree->bits, 0, wordMax ( word ) );
+    return true;
+  }
+
+  int base = 0;
+  for ( ;; )
+  {
+    if ( tree->min == UNDEFINED || val <= tree->min ) return false;
+    if ( val > tree->max )
+    {
+      iterLast ( it, tree, base );
+      return true;
+    }
+
+    int highVal = val >> tree->lowBits();
+    int lowVal = val & tree->lowMask();
+    it.node[it.depth] = tree;
+    it.base[it.depth++] = base;
+    if ( leafClusters ( tree ) )
+    {
+      uint64_t word = vEB_leaf ( tree, highVal );
+      uint64_t below = wordBelow ( word, lowVal );
+      if ( below )
+      {
+        it.pos[it.depth - 1] = highVal;
+        iterLeaf ( it, word, base + ( highVal << tree->lowBits() ), wordMax ( below ) );
+        return true;
+      }
+    }
+    else
+    {
+      const TvEB * cluster = vEB_cluster ( tree, highVal );
+      if ( cluster && lowVal > cluster->min )
+      {
+        it.pos[it.depth - 1] = highVal;
+        base += highVal << tree->lowBits();
+        tree = cluster;
+        val = lowVal;
+        continue;
+      }
+    }
+
+    int i;
+    if ( !summaryPred ( tree, highVal, i ) )
+    {
+      it.pos[it.depth - 1] = -1;
+      it.val = base + tree->min;
+      return true;
+    }
+    iterCluster ( it, tree, i, true );
+    return true;
+  }
+}
+
+bool vEB_iter_next ( TvEBIterator & it )
+{
+  if ( !it.depth ) return false;
+
+  int d = it.depth - 1;
+  if ( !it.node[d] )
+  {
+    uint64_t word = wordAbove ( it.leaf, it.pos[d] );
+    if ( word )
+    {
+      it.pos[d] = wordMin ( word );
+      it.val = it.base[d] + it.pos[d];
+      return true;
+    }
+    it.depth--;
+  }
+
+  // the rest of the tree of the top frame is in the clusters after the one
+  // the path went through, when there are none, it is done as well
+  while ( it.depth )
+  {
+    const TvEB * tree = it.node[it.depth - 1];
+    int i;
+    if ( vEB_cluster_succ ( tree, it.pos[it.depth - 1], i ) )
+    {
+      iterCluster ( it, tree, i, false );
+      return true;
+    }
+    it.depth--;
+  }
+  it.val = UNDEFINED;
+  return false;
+}
+
+bool vEB_iter_prev ( TvEBIterator & it )
+{
+  if ( !it.depth ) return false;
+
+  int d = it.depth - 1;
+  if ( !it.node[d] )
+  {
+    uint64_t word = wordBelow ( it.leaf, it.pos[d] );
+    if ( word )
+    {
+      it.pos[d] = wordMax ( word );
+      it.val = it.base[d] + it.pos[d];
+      return true;
+    }
+    it.depth--;
+  }
+
+  // before the cluster the path went through are the preceding clusters and
+  // then the node's own minimum
+  while ( it.depth )
+  {
+    d = it.depth - 1;
+    const TvEB * tree = it.node[d];
+    if ( it.pos[d] >= 0 )
+    {
+      int i;
+      if ( summaryPred ( tree, it.pos[d], i ) )
+      {
+        iterCluster ( it, tree, i, true );
+        return true;
+      }
+      it.pos[d] = -1;
+      it.val = it.base[d] + tree->min;
+      return true;
+    }
+    it.depth--;
+  }
+  it.val = UNDEFINED;
+  return false;
+}
+
+size_t vEB_range ( const TvEB * tree, int lo, int hi,
+                   bool ( * callback ) ( int val, void * ctx ), void * ctx )
+{
+  if ( !tree || lo > hi ) return 0;
+  if ( lo < 0 ) lo = 0;
+
+  TvEBIterator it;
+  size_t cnt = 0;
+  for ( bool valid = vEB_iter_succ ( tree, it, lo - 1 );
+        valid && it.val <= hi; valid = vEB_iter_next ( it ) )
+  {
+    cnt++;
+    if ( !callback ( it.val, ctx ) ) break;
+  }
+  return cnt;
+}
+
+int vEB_rank ( const TvEB * tree, int val )
+{
+  if ( !tree || val <= 0 ) return 0;
+  if ( val >= tree->uni ) return treeSize ( tree );
+
+  int res = 0;
+  for ( ;; )
+  {
+    if ( tree->uni <= VEB_LEAF_UNI )
+    {
+      return res + __builtin_popcountll ( tree->bits & ( ( ( uint64_t ) 1 << val ) - 1 ) );
+    }
+    if ( tree->min == UNDEFINED || val <= tree->min ) return res;
+    if ( val > tree->max ) return res + tree->size;
+
+    int highVal = val >> tree->lowBits();
+    res += 1 + countBelow ( tree, highVal );
+    val &= tree->lowMask();
+    if ( leafClusters ( tree ) )
+    {
+      return res + __builtin_popcountll ( wordBelow ( vEB_leaf ( tree, highVal ), val ) );
+    }
+    tree = vEB_cluster ( tree, highVal );
+    if ( !tree ) return res;
+  }
+}
+
+bool vEB_select ( const TvEB * tree, int k, int & res )
+{
+  if ( !tree || k < 0 || k >= treeSize ( tree ) ) return false;
+
+  int base = 0;
+  for ( ;; )
+  {
+    if ( tree->uni <= VEB_LEAF_UNI )
+    {
+      res = base + wordSelect ( tree->bits, k );
+      return true;
+    }
+    if ( !k )
+    {
+      res = base + tree->min;
+      return true;
+    }
+    k--;
+
+    // find the cluster holding the k-th element of the clusters
+    int highVal = 0;
+    const int * counts = nodeCounts ( tree );
+    if ( counts )
+    {
+      for ( int step = tree->higherUniSqrt(); step; step >>= 1 )
+      {
+        if ( highVal + step <= tree->higherUniSqrt() && counts[highVal + step - 1] <= k )
+        {
+          highVal += step;
+          k -= counts[highVal - 1];
+        }
+      }
+    }
+    else
+    {
+      for ( highVal = -1; vEB_cluster_succ ( tree, highVal, highVal ); )
+      {
+        int size = clusterSize ( tree, highVal );
+        if ( k < size ) break;
+        k -= size;
+      }
+    }
+
+    base += highVal << tree->lowBits();
+    if ( leafClusters ( tree ) )
+    {
+      res = base + wordSelect ( vEB_leaf ( tree, highVal ), k );
+      return true;
+    }
+    tree = vEB_cluster ( tree, highVal );
+  }
+}
+
+int vEB_count ( const TvEB * tree, int lo, int hi )
+{
+  if ( !tree || lo > hi || hi < 0 || lo >= tree->uni ) return 0;
+  if ( hi >= tree->uni ) hi = tree->uni - 1;
+  return vEB_rank ( tree, hi + 1 ) - vEB_rank ( tree, lo );
+}
+
+/***************************************************************************//**
+ * @brief      The set operations of setWalk.
+ ******************************************************************************/
+enum
+{
+  SET_UNION,
+  SET_INTERSECT,
+  SET_DIFFERENCE
+};
+
+/***************************************************************************//**
+ * @brief      Returns the smallest cluster index from high on of the elements
+ *             of the tree and the extra values, INT_MAX if there is none.
+ ******************************************************************************/
+static int nextHigh ( const TvEB * tree, const int * extra, int extraCnt,
+                      int lowBits, int high )
+{
+  int res = INT_MAX;
+  if ( tree && !vEB_cluster_succ ( tree, high - 1, res ) ) res = INT_MAX;
+  for ( int i = 0; i < extraCnt; ++i )
+  {
+    if ( extra[i] >> lowBits >= high )
+    {
+      if ( extra[i] >> lowBits < res ) res = extra[i] >> lowBits;
+      break;
+    }
+  }
+  return res;
+}
+
+/***************************************************************************//**
+ * @brief      Writes the extra values merged with the minimum of the tree, if
+ *             there is one, to res.
+ *
+ * @return     The number of the written values.
+ ******************************************************************************/
+static int withMin ( const TvEB * tree, const int * extra, int extraCnt, int * res )
+{
+  int cnt = 0;
+  bool pending = tree;
+  for ( int i = 0; i < extraCnt; ++i )
+  {
+    if ( pending && tree->min < extra[i] )
+    {
+      res[cnt++] = tree->min;
+      pending = false;
+    }
+    res[cnt++] = extra[i];
+  }
+  if ( pending ) res[cnt++] = tree->min;
+  return cnt;
+}
+
+/***************************************************************************//**
+ * @brief      Writes the elements of the tree, which may be NULL, merged with
+ *             the extra values to out, in ascending order.
+ ******************************************************************************/
+static void setDump ( const TvEB * tree, const int * extra, int extraCnt,
+                      int base, int *& out )
+{
+  TvEBIterator it;
+  bool valid = vEB_iter_succ ( tree, it, -1 );
+  for ( int i = 0; valid || i < extraCnt; )
+  {
+    if ( valid && ( i == extraCnt || it.val < extra[i] ) )
+    {
+      *out++ = base + it.val;
+      valid = vEB_iter_next ( it );
+    }
+    else
+    {
+      *out++ = base + extra[i++];
+    }
+  }
+}
+
+/***************************************************************************//**
+ * @brief      Writes the result of the set operation on the elements of the
+ *             leaf words a and b and their extra values to out, in ascending
+ *             order.
+ ******************************************************************************/
+static void setLeaf ( uint64_t wordA, const int * extraA, int extraACnt,
+                      uint64_t wordB, const int * extraB, int extraBCnt,
+                      int base, int op, int *& out )
+{
+  wordA |= wordOf ( extraA, extraACnt );
+  wordB |= wordOf ( extraB, extraBCnt );
+  uint64_t word = op == SET_UNION ? wordA | wordB
+                  : op == SET_INTERSECT ? wordA & wordB : wordA & ~wordB;
+  for ( ; word; word &= word - 1 ) *out++ = base + __builtin_ctzll ( word );
+}
+
+/***************************************************************************//**
+ * @brief      Writes the result of the set operation on the elements of the
+ *             trees a and b over the universe uni to out, in ascending order.
+ *             Either tree may be NULL. The minimum of a node is not in any of
+ *             its clusters, so it is handed down with the cluster it belongs
+ *             to as an extra value of the cluster's side, the extra values
+ *             are sorted and there is at most one per level.
+ ******************************************************************************/
+static void setWalk ( const TvEB * a, const int * extraA, int extraACnt,
+                      const TvEB * b, const int * extraB, int extraBCnt,
+                      int uni, int base, int op, int *& out )
+{
+  if ( uni <= VEB_LEAF_UNI )
+  {
+    setLeaf ( a ? a->bits : 0, extraA, extraACnt, b ? b->bits : 0, extraB, extraBCnt,
+              base, op, out );
+    return;
+  }
+
+  if ( a && a->min == UNDEFINED ) a = NULL;
+  if ( b && b->min == UNDEFINED ) b = NULL;
+  bool emptyA = !a && !extraACnt;
+  bool emptyB = !b && !extraBCnt;
+  if ( emptyA && op != SET_UNION ) return;
+  if ( emptyB && op == SET_INTERSECT ) return;
+  if ( emptyB )
+  {
+    setDump ( a, extraA, extraACnt, base, out );
+    return;
+  }
+  if ( emptyA )
+  {
+    setDump ( b, extraB, extraBCnt, base, out );
+    return;
+  }
+
+  int xa[VEB_ITER_DEPTH + 1], xb[VEB_ITER_DEPTH + 1];
+  int xaCnt = withMin ( a, extraA, extraACnt, xa );
+  int xbCnt = withMin ( b, extraB, extraBCnt, xb );
+
+  int lowBits = log2Int ( uni ) / 2;
+  int lowMask = ( 1 << lowBits ) - 1;
+  // the next cluster index of each side, b does not lead the difference
+  int highA = nextHigh ( a, xa, xaCnt, lowBits, 0 );
+  int highB = op == SET_DIFFERENCE ? INT_MAX : nextHigh ( b, xb, xbCnt, lowBits, 0 );
+  for ( ;; )
+  {
+    int high;
+    if ( op == SET_INTERSECT )
+    {
+      if ( highA == INT_MAX || highB == INT_MAX ) break;
+      // skip the clusters missing on either side
+      if ( highA < highB )
+      {
+        highA = nextHigh ( a, xa, xaCnt, lowBits, highB );
+        continue;
+      }
+      if ( highB < highA )
+      {
+        highB = nextHigh ( b, xb, xbCnt, lowBits, highA );
+        continue;
+      }
+    }
+    high = highB < highA ? highB : highA;
+    if ( high == INT_MAX ) break;
+
+    int ca[VEB_ITER_DEPTH + 1], cb[VEB_ITER_DEPTH + 1];
+    int caCnt = 0, cbCnt = 0;
+    for ( int i = 0; i < xaCnt; ++i )
+    {
+      if ( xa[i] >> lowBits == high ) ca[caCnt++] = xa[i] & lowMask;
+    }
+    for ( int i = 0; i < xbCnt; ++i )
+    {
+      if ( xb[i] >> lowBits == high ) cb[cbCnt++] = xb[i] & lowMask;
+    }
+    if ( 1 << lowBits <= VEB_LEAF_UNI )
+    {
+      setLeaf ( a ? vEB_leaf ( a, high ) : 0, ca, caCnt, b ? vEB_leaf ( b, high ) : 0, cb, cbCnt,
+                base + ( high << lowBits ), op, out );
+    }
+    else
+    {
+      setWalk ( a ? vEB_cluster ( a, high ) : NULL, ca, caCnt,
+                b ? vEB_cluster ( b, high ) : NULL, cb, cbCnt,
+                1 << lowBits, base + ( high << lowBits ), op, out );
+    }
+
+    if ( highA == high ) highA = nextHigh ( a, xa, xaCnt, lowBits, high + 1 );
+    if ( highB == high ) highB = nextHigh ( b, xb, xbCnt, lowBits, high + 1 );
+  }
+}
+
+/***************************************************************************//**
+ * @brief      Writes the result of the set operation on the two trees to
+ *             a new array, which has twice the needed size, so buildSorted
+ *             can use the second half.
+ *
+ * @return     The number of the values written, -1 if the universes differ.
+ ******************************************************************************/
+static int setCollect ( const TvEB * a, const TvEB * b, int op, int *& vals )
+{
+  vals = NULL;
+  if ( !a && !b ) return 0;
+  if ( a && b && a->uni != b->uni )
+  {
+    std::cerr << "set operations need trees of the same universe size" << std::endl;
+    return -1;
+  }
+
+  vals = new int [2 * ( treeSize ( a ) + treeSize ( b ) ) + 1];
+  int * end = vals;
+  setWalk ( a, NULL, 0, b, NULL, 0, a ? a->uni : b->uni, 0, op, end );
+  return end - vals;
+}
+
+static TvEB * setBuild ( const TvEB * a, const TvEB * b, int op,
+                         TvEBArena * arena, int flags )
+{
+  int * vals;
+  int n = setCollect ( a, b, op, vals );
+  TvEB * res = n < 0 ? NULL
+               : buildSorted ( vals, vals + n, n, a ? a->uni : b ? b->uni : 1, arena, flags );
+  delete [] vals;
+  return res;
+}
+
+TvEB * vEB_union ( const TvEB * a, const TvEB * b, TvEBArena * arena, int flags )
+{
+  return setBuild ( a, b, SET_UNION, arena, flags );
+}
+
+TvEB * vEB_intersect ( const TvEB * a, const TvEB * b, TvEBArena * arena, int flags )
+{
+  return setBuild ( a, b, SET_INTERSECT, arena, flags );
+}
+
+TvEB * vEB_difference ( const TvEB * a, const TvEB * b, TvEBArena * arena, int flags )
+{
+  return setBuild ( a, b, SET_DIFFERENCE, arena, flags );
+}
+
+size_t vEB_union_into ( TvEB *& a, const TvEB * b, TvEBArena * arena, int flags )
+{
+  // add what b has on top of a, an empty a gets the caller's arena and flags
+  int * vals;
+  int n = setCollect ( b, a, SET_DIFFERENCE, vals );
+  size_t res = n <= 0 ? 0 : vEB_insert_batch ( a, vals, n, b->uni, arena, flags );
+  delete [] vals;
+  return res;
+}
+
+size_t vEB_intersect_into ( TvEB *& a, const TvEB * b )
+{
+  // remove what a has and b has not
+  int * vals;
+  int n = setCollect ( a, b, SET_DIFFERENCE, vals );
+  size_t res = n <= 0 ? 0 : vEB_delete_batch ( a, vals, n );
+  delete [] vals;
+  return res;
+}
+
+size_t vEB_difference_into ( TvEB *& a, const TvEB * b )
+{
+  // remove what both have
+  int * vals;
+  int n = setCollect ( a, b, SET_INTERSECT, vals );
+  size_t res = n <= 0 ? 0 : vEB_delete_batch ( a, vals, n );
+  delete [] vals;
+  return res;
+}
+
+/***************************************************************************//**
+ * @brief      Adds the memory of the given subtree at the given level.
+ ******************************************************************************/
+static void memoryUsage ( const TvEB * tree, int level, TvEBMemoryUsage & usage )
+{
+  if ( !tree ) return;
+
+  int kind = tree->uni <= VEB_LEAF_UNI ? VEB_NODE_LEAF
+             : tree->flags & VEB_SPARSE ? VEB_NODE_SPARSE : VEB_NODE_DENSE;
+  size_t bytes = tree->flags & VEB_TRIMMED ? trimmedBytes ( tree->uni, tree->flags ) : sizeof ( TvEB );
+  if ( kind == VEB_NODE_DENSE )
+  {
+    bytes += tree->higherUniSqrt() * ( leafClusters ( tree ) ? sizeof ( uint64_t ) : sizeof ( TvEB * ) );
+    usage.slots += tree->higherUniSqrt();
+  }
+  if ( kind == VEB_NODE_SPARSE && tree->clusterMap.vals )
+  {
+    bytes += mapBytes ( tree, tree->clusterMap.capBits );
+    usage.slots += ( size_t ) 1 << tree->clusterMap.capBits;
+  }
+  if ( ! ( tree->flags & VEB_TRIMMED ) && tree->counts ) bytes += tree->higherUniSqrt() * sizeof ( int );
+  if ( level >= VEB_MEMORY_LEVELS ) level = VEB_MEMORY_LEVELS - 1;
+  usage.nodes[level][kind]++;
+  usage.bytes[level][kind] += bytes;
+  usage.total += bytes;
+  if ( kind == VEB_NODE_LEAF ) return;
+
+  // the leaf words belong to the bytes of this node
+  int next = level + 1 < VEB_MEMORY_LEVELS ? level + 1 : level;
+  if ( !leafSummary ( tree ) ) memoryUsage ( tree->summary, level + 1, usage );
+  else if ( tree->summaryBits ) usage.nodes[next][VEB_NODE_LEAF]++;
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ); )
+  {
+    usage.usedSlots++;
+    if ( leafClusters ( tree ) ) usage.nodes[next][VEB_NODE_LEAF]++;
+    else memoryUsage ( vEB_cluster ( tree, i ), level + 1, usage );
+  }
+}
+
+void vEB_memory_usage ( const TvEB * tree, TvEBMemoryUsage & usage )
+{
+  std::fill ( &usage.nodes[0][0], &usage.nodes[0][0] + VEB_MEMORY_LEVELS * VEB_NODE_TYPES, ( size_t ) 0 );
+  std::fill ( &usage.bytes[0][0], &usage.bytes[0][0] + VEB_MEMORY_LEVELS * VEB_NODE_TYPES, ( size_t ) 0 );
+  usage.slots = usage.usedSlots = usage.total = 0;
+  memoryUsage ( tree, 0, usage );
+}
+
+/***************************************************************************//**
+ * @brief      Copies the given subtree into VEB_TRIMMED records, the node
+ *             first, then its summary and its clusters, which is the van Emde
+ *             Boas order.
+ ******************************************************************************/
+static TvEB * compactTree ( const TvEB * tree, TvEBArena * arena )
+{
+  int flags = ( nodeFlags ( tree ) & ~VEB_SPARSE ) | VEB_TRIMMED | ( arena ? VEB_TRIMMED_ARENA : 0 );
+  int capBits = 0;
+  if ( tree->uni > VEB_LEAF_UNI )
+  {
+    // the table stays below the load at which slotRef grows it
+    int clusterCnt = leafSummary ( tree ) ? __builtin_popcountll ( tree->summaryBits )
+                     : treeSize ( tree->summary );
+    capBits = clusterCnt ? 2 : 0;
+    while ( capBits && clusterCnt * 4 > 3 << capBits ) ++capBits;
+    size_t tableBytes = capBits ? mapBytes ( tree, capBits ) : 0;
+    size_t arrayBytes = tree->higherUniSqrt() * ( leafClusters ( tree ) ? sizeof ( uint64_t ) : sizeof ( TvEB * ) );
+    if ( tableBytes * 4 <= arrayBytes ) flags |= VEB_SPARSE;
+  }
+
+  size_t bytes = trimmedBytes ( tree->uni, flags );
+  TvEB * copy = new ( arena ? arena->allocBytes ( bytes ) : TvEB::operator new ( bytes ) ) TvEB ( tree, flags );
+  if ( arena ) * ( TvEBArena ** ) ( ( char * ) copy + trimmedHead ( tree->uni, flags ) ) = arena;
+  if ( tree->uni <= VEB_LEAF_UNI ) return copy;
+  if ( nodeCounts ( tree ) )
+  {
+    std::copy ( nodeCounts ( tree ), nodeCounts ( tree ) + tree->higherUniSqrt(), nodeCounts ( copy ) );
+  }
+  if ( ! ( flags & VEB_SPARSE ) ) allocClusters ( copy, arena );
+  else if ( capBits ) mapResize ( copy, capBits );
+
+  if ( leafSummary ( tree ) ) copy->summaryBits = tree->summaryBits;
+  else if ( tree->summary ) copy->summary = compactTree ( tree->summary, arena );
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ); )
+  {
+    if ( leafClusters ( tree ) ) leafSet ( copy, i, vEB_leaf ( tree, i ) );
+    else clusterRef ( copy, i ) = compactTree ( vEB_cluster ( tree, i ), arena );
+  }
+  return copy;
+}
+
+TvEB * vEB_compact ( const TvEB * tree, TvEBArena * arena )
+{
+  if ( !tree ) return NULL;
+  return compactTree ( tree, arena );
+}
+
+void vEB_print ( TvEB * tree, std::ostream & os )
+{
+  if ( !tree ) return;
+  os << "tree: " << tree << std::endl;
+  os << "min: " << tree->min << ", max: " << tree->max << std::endl;
+  os << "uni: " << tree->uni << std::endl;
+  os << "lowerUniSqrt: " << tree->lowerUniSqrt();
+  os << ", higherUniSqrt: " << tree->higherUniSqrt() << std::endl;
+  os << "lowBits: " << tree->lowBits();
+  os << ", lowMask: " << tree->lowMask() << std::endl;
+  if ( tree->uni <= VEB_LEAF_UNI )
+  {
+    os << "bits: " << std::hex << tree->bits << std::dec << std::endl;
+    return;
+  }
+  if ( leafSummary ( tree ) ) os << "summary bits: " << std::hex << tree->summaryBits << std::dec << std::endl;
+  else os << "summary: " << tree->summary << std::endl;
+  if ( tree->flags & VEB_SPARSE )
+  {
+    const TvEBClusterMap & map = tree->clusterMap;
+    os << "sparse clusters: " << map.cnt << " in " << ( map.vals ? 1 << map.capBits : 0 ) << " slots" << std::endl;
+  }
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ); )
   {
-    os << "cluster " << tree->cluster << std::endl;
+    if ( leafClusters ( tree ) ) os << "leaf " << i << ": " << std::hex << vEB_leaf ( tree, i ) << std::dec << std::endl;
+    else os << "cluster " << i << ": " << vEB_cluster ( tree, i ) << std::endl;
   }
 }
@@ -25,6 +25,7 @@
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
+#include <stdint.h>
 
 // #define DEBUG
 #define DEBUG_OS std::cout
@@ -32,6 +33,83 @@
 
 #define UNDEFINED INT_MIN
 
+/***************************************************************************//**
+ * @brief      Trees with universe up to VEB_LEAF_UNI are leaves keeping their
+ *             elements in a single machine word.
+ ******************************************************************************/
+#define VEB_LEAF_UNI 64
+
+/***************************************************************************//**
+ * @brief      The flag of a tree keeping its clusters in a hash map.
+ ******************************************************************************/
+#define VEB_SPARSE 1
+
+/***************************************************************************//**
+ * @brief      The flag of a tree keeping the sizes of its clusters in a
+ *             Fenwick tree, which makes vEB_rank, vEB_select and vEB_count
+ *             fast.
+ ******************************************************************************/
+#define VEB_COUNTED 2
+
+/***************************************************************************//**
+ * @brief      The flag of a trimmed record written by vEB_compact, which keeps
+ *             the fields up to the clusters, followed by the pointer to its
+ *             arena if VEB_TRIMMED_ARENA is set as well and by the Fenwick tree
+ *             of a VEB_COUNTED tree. It is set by the library only.
+ ******************************************************************************/
+#define VEB_TRIMMED 4
+
+/***************************************************************************//**
+ * @brief      The flag of a trimmed record allocated from an arena.
+ ******************************************************************************/
+#define VEB_TRIMMED_ARENA 8
+
+struct TvEB;
+struct TvEBArena;
+struct TvEBPool;
+
+/***************************************************************************//**
+ * @brief      Struct containing the clusters of a sparse tree.
+ *
+ * @details    It is an open addressing hash table with linear probing keyed by
+ *             the cluster index. The table holds 2^capBits slots, the values
+ *             first and the keys, the cluster indices, right after them in one
+ *             block, an empty slot has a NULL value. It grows at 3/4 load,
+ *             shrinks at 1/8 load and is released when the last cluster is
+ *             erased, so a sparse tree takes memory proportional to its
+ *             occupied clusters.
+ ******************************************************************************/
+struct TvEBClusterMap
+{
+  /*************************************************************************//**
+   * @brief      The values of the slots, followed by the keys. They are the
+   *             clusters, or the bitmaps of the clusters when these are
+   *             leaves, an empty leaf has no slot.
+   ****************************************************************************/
+  union
+  {
+    /***********************************************************************//**
+     * @brief    The clusters.
+     **************************************************************************/
+    TvEB ** vals;
+
+    /***********************************************************************//**
+     * @brief    The bitmaps of the leaf clusters.
+     **************************************************************************/
+    uint64_t * leaves;
+  };
+
+  /*************************************************************************//**
+   * @brief      The binary logarithm of the number of slots, 0 for no table.
+   ****************************************************************************/
+  int capBits;
+
+  /*************************************************************************//**
+   * @brief      The number of occupied slots.
+   ****************************************************************************/
+  int cnt;
+};
+
 /***************************************************************************//**
  * @brief      Struct containing the Van Emde Boas tree.
  *
@@ -46,6 +124,27 @@
  *             stored in the tree respectively. These both run in O(1) time,
  *             since the minimum and maximum element are stored as attributes in
  *             each tree.
+ *
+ *             The recursion ends at trees with universe of at most
+ *             VEB_LEAF_UNI elements. Such a leaf has neither summary nor
+ *             clusters, it keeps all its elements (including the minimum and
+ *             the maximum) as bits of one word and answers all operations
+ *             with a single bit scan. A leaf summary or cluster is not a
+ *             node of its own, its parent keeps the bare word in place of the
+ *             pointer to it, only a tree whose whole universe is that small
+ *             is a leaf TvEB.
+ *
+ *             A tree created with the VEB_SPARSE flag, and all its subtrees,
+ *             keep their clusters in a TvEBClusterMap instead of an array of
+ *             higherUniSqrt pointers, which makes huge sparsely populated
+ *             universes affordable. All the functions accept both kinds and
+ *             access the clusters through vEB_cluster, or vEB_leaf when they
+ *             are leaf words.
+ *
+ *             A tree that is not a leaf counts its elements in size. A tree
+ *             created with the VEB_COUNTED flag, and all its clusters, also
+ *             keep a Fenwick tree over the sizes of their clusters, the
+ *             summaries do not need it and are created without the flag.
  ******************************************************************************/
 struct TvEB
 {
@@ -53,33 +152,57 @@ struct TvEB
    * @brief      Constructor.
    *
    * @param[in]  uniSize  The size of the tree universe
+   * @param[in]  arena    The arena the tree's nodes are allocated from, or
+   *                      NULL to allocate them on the heap.
+   * @param[in]  flags    VEB_SPARSE for the hash map clusters and
+   *                      VEB_COUNTED for the cluster sizes, or 0.
    ****************************************************************************/
-  TvEB ( int uniSize );
+  TvEB ( int uniSize, TvEBArena * arena = NULL, int flags = 0 );
 
   /*************************************************************************//**
-   * @brief      Destructor.
+   * @brief      Destructor. A tree allocated from an arena owns no memory, so
+   *             its destructor does nothing and the nodes are released
+   *             together with the arena.
    ****************************************************************************/
   ~TvEB();
 
   /*************************************************************************//**
-   * @brief      The size of the universe.
+   * @brief      Constructor of the trimmed record written by vEB_compact. It
+   *             sets only the fields up to the clusters, copying the elements
+   *             of a leaf and the minimum, maximum and size of other trees,
+   *             the record ends where the fields it uses end.
+   *
+   * @param[in]  tree   The tree the record is a copy of.
+   * @param[in]  flags  The flags of the record, including VEB_TRIMMED.
    ****************************************************************************/
-  const int uni;
+  TvEB ( const TvEB * tree, int flags );
 
   /*************************************************************************//**
-   * @brief      The square root of the universe size.
+   * @brief      Allocation function of a tree, or of a trimmed record of the
+   *             given size.
    ****************************************************************************/
-  const int uniSqrt;
+  static void * operator new ( size_t bytes );
 
   /*************************************************************************//**
-   * @brief      The lower square root of the universe size.
+   * @brief      Placement allocation function of a tree in an arena.
    ****************************************************************************/
-  const int lowerUniSqrt;
+  static void * operator new ( size_t bytes, void * place );
 
   /*************************************************************************//**
-   * @brief      The higher square root of the universe size.
+   * @brief      Deallocation function, which also releases the trimmed records
+   *             vEB_compact allocates with their own size.
    ****************************************************************************/
-  const int higherUniSqrt;
+  static void operator delete ( void * ptr );
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  const int uni;
+
+  /*************************************************************************//**
+   * @brief      The flags the tree was created with, passed to its subtrees.
+   ****************************************************************************/
+  const int flags;
 
   /*************************************************************************//**
    * @brief      The minimal value in the tree.
@@ -92,14 +215,318 @@ struct TvEB
   int max;
 
   /*************************************************************************//**
-   * @brief      The pointer to the summary structure of the tree.
+   * @brief      The number of elements of a tree that is not a leaf.
+   ****************************************************************************/
+  int size;
+
+  /*************************************************************************//**
+   * @brief      The generation of the arena the tree was allocated in. A tree
+   *             of an older generation than its arena's is shared with a
+   *             snapshot, so vEB_insert and vEB_delete change a copy of it.
+   ****************************************************************************/
+  int gen;
+
+  /*************************************************************************//**
+   * @brief      The summary of the tree, a leaf when its universe,
+   *             higherUniSqrt, is at most VEB_LEAF_UNI.
+   ****************************************************************************/
+  union
+  {
+    /***********************************************************************//**
+     * @brief    The pointer to the summary structure of the tree.
+     **************************************************************************/
+    TvEB * summary;
+
+    /***********************************************************************//**
+     * @brief    The bitmap of the leaf summary.
+     **************************************************************************/
+    uint64_t summaryBits;
+  };
+
+  /*************************************************************************//**
+   * @brief      The clusters of the tree, kept in one of the forms chosen by
+   *             VEB_SPARSE in flags and by their universe, lowerUniSqrt, or
+   *             the elements of a leaf.
+   ****************************************************************************/
+  union
+  {
+    /***********************************************************************//**
+     * @brief    The pointer to the array of clusters of a tree without
+     *           VEB_SPARSE.
+     **************************************************************************/
+    TvEB ** cluster;
+
+    /***********************************************************************//**
+     * @brief    The pointer to the array of the bitmaps of the clusters of a
+     *           tree without VEB_SPARSE whose clusters are leaves.
+     **************************************************************************/
+    uint64_t * leaves;
+
+    /***********************************************************************//**
+     * @brief    The clusters of a VEB_SPARSE tree.
+     **************************************************************************/
+    TvEBClusterMap clusterMap;
+
+    /***********************************************************************//**
+     * @brief    The bitmap of the elements of a leaf tree.
+     **************************************************************************/
+    uint64_t bits;
+  };
+
+  /*************************************************************************//**
+   * @brief      The Fenwick tree of the sizes of the clusters of a VEB_COUNTED
+   *             tree, NULL for leaves and other trees. A VEB_TRIMMED record
+   *             has neither this field nor arena.
+   ****************************************************************************/
+  int * counts;
+
+  /*************************************************************************//**
+   * @brief      The arena the tree was allocated from, or NULL.
+   ****************************************************************************/
+  TvEBArena * arena;
+
+  /*************************************************************************//**
+   * @brief      The number of low bits of a value addressing the element inside
+   *             its cluster, which is log_2 ( lowerUniSqrt() ).
+   ****************************************************************************/
+  int lowBits() const
+  {
+    return uni ? __builtin_ctz ( uni ) / 2 : 0;
+  }
+
+  /*************************************************************************//**
+   * @brief      The mask selecting the low bits of a value.
+   ****************************************************************************/
+  int lowMask() const
+  {
+    return lowerUniSqrt() - 1;
+  }
+
+  /*************************************************************************//**
+   * @brief      The lower square root of the universe size, the universe of
+   *             the clusters.
    ****************************************************************************/
-  TvEB * summary;
+  int lowerUniSqrt() const
+  {
+    return 1 << lowBits();
+  }
 
   /*************************************************************************//**
-   * @brief      The pointer to the array of clusters of the tree.
+   * @brief      The higher square root of the universe size, the number of
+   *             clusters and the universe of the summary.
    ****************************************************************************/
-  TvEB ** cluster;
+  int higherUniSqrt() const
+  {
+    return uni >> lowBits();
+  }
+};
+
+/***************************************************************************//**
+ * @brief      Struct containing a memory arena for the nodes of one tree.
+ *
+ * @details    Nodes and their cluster arrays are carved out of large chunks.
+ *             A node emptied by vEB_delete is not freed but kept, together
+ *             with its (all empty) cluster array, on a free list of its size
+ *             class, which is the binary logarithm of its universe, and is
+ *             handed out again by the next alloc of the same universe and
+ *             flags. Hash tables of sparse trees are recycled the same way,
+ *             keyed by their capacity. The
+ *             whole tree is released by releasing the chunks, in O(chunks)
+ *             instead of visiting every node.
+ ******************************************************************************/
+struct TvEBArena
+{
+  /*************************************************************************//**
+   * @brief      Constructor.
+   *
+   * @param[in]  chunkSize  The size of one chunk in bytes.
+   ****************************************************************************/
+  TvEBArena ( size_t chunkSize = 1 << 20 );
+
+  /*************************************************************************//**
+   * @brief      Destructor. Releases all the chunks.
+   ****************************************************************************/
+  ~TvEBArena();
+
+  /*************************************************************************//**
+   * @brief      Returns an empty tree of the given universe size, reusing a
+   *             recycled one when possible.
+   *
+   * @param[in]  uniSize  The size of the tree universe.
+   * @param[in]  flags    The flags of the tree.
+   *
+   * @return     The pointer to the empty tree.
+   ****************************************************************************/
+  TvEB * alloc ( int uniSize, int flags = 0 );
+
+  /*************************************************************************//**
+   * @brief      Returns an emptied tree to the free list of its size class, or
+   *             hands it to the retire callback when there is one.
+   *
+   * @param[in]  tree  The pointer to the empty tree.
+   ****************************************************************************/
+  void recycle ( TvEB * tree );
+
+  /*************************************************************************//**
+   * @brief      Returns an emptied tree to the free list of its size class,
+   *             regardless of the retire callback.
+   *
+   * @param[in]  tree  The pointer to the empty tree.
+   ****************************************************************************/
+  void reuse ( TvEB * tree );
+
+  /*************************************************************************//**
+   * @brief      Returns a tree replaced by its copy to the free lists. Its
+   *             clusters and summary belong to the copy, so it only forgets
+   *             them, and its hash table goes to the free blocks.
+   *
+   * @param[in]  tree  The pointer to the replaced tree.
+   ****************************************************************************/
+  void reuseCopied ( TvEB * tree );
+
+  /*************************************************************************//**
+   * @brief      Returns a block of the given size class, reusing a recycled
+   *             one when possible. All blocks of one class must have the same
+   *             size.
+   *
+   * @param[in]  sizeClass  The size class of the block.
+   * @param[in]  bytes      The size of the block.
+   *
+   * @return     The pointer to the block.
+   ****************************************************************************/
+  void * allocBlock ( int sizeClass, size_t bytes );
+
+  /*************************************************************************//**
+   * @brief      Returns a block to the free list of its size class.
+   *
+   * @param[in]  block      The pointer to the block.
+   * @param[in]  sizeClass  The size class of the block.
+   ****************************************************************************/
+  void recycleBlock ( void * block, int sizeClass );
+
+  /*************************************************************************//**
+   * @brief      Returns raw memory from the current chunk.
+   *
+   * @param[in]  bytes  The number of bytes.
+   *
+   * @return     The pointer to the memory.
+   ****************************************************************************/
+  void * allocBytes ( size_t bytes );
+
+  /*************************************************************************//**
+   * @brief      Releases all the chunks, invalidating every tree allocated
+   *             from the arena.
+   ****************************************************************************/
+  void clear();
+
+  /*************************************************************************//**
+   * @brief      The size of one chunk in bytes.
+   ****************************************************************************/
+  const size_t chunkSize;
+
+  /*************************************************************************//**
+   * @brief      The list of allocated chunks, linked through their first word.
+   ****************************************************************************/
+  void * chunks;
+
+  /*************************************************************************//**
+   * @brief      The first unused byte of the current chunk.
+   ****************************************************************************/
+  char * pos;
+
+  /*************************************************************************//**
+   * @brief      The number of unused bytes in the current chunk.
+   ****************************************************************************/
+  size_t left;
+
+  /*************************************************************************//**
+   * @brief      The free lists of recycled trees, linked through their summary
+   *             pointer and indexed by the flags and the binary
+   *             logarithm of the universe.
+   ****************************************************************************/
+  TvEB * recycled[4][32];
+
+  /*************************************************************************//**
+   * @brief      The free lists of recycled blocks, linked through their first
+   *             word and indexed by the size class.
+   ****************************************************************************/
+  void * recycledBlocks[32];
+
+  /*************************************************************************//**
+   * @brief      The callback receiving the emptied trees instead of the free
+   *             lists, so that their reuse can wait until no reader can see
+   *             them, or NULL. The trees are left untouched and the callback
+   *             returns them by reuse later. It also receives the trees of the
+   *             older generations replaced by their copies, whose clusters
+   *             still belong to the copies.
+   ****************************************************************************/
+  void ( * retire ) ( TvEB * tree, void * ctx );
+
+  /*************************************************************************//**
+   * @brief      The context passed to the retire callback.
+   ****************************************************************************/
+  void * retireCtx;
+
+  /*************************************************************************//**
+   * @brief      The generation of the trees allocated now. A persistent tree
+   *             advances it with every snapshot, freezing all its nodes, and
+   *             must set the retire callback.
+   ****************************************************************************/
+  int gen;
+};
+
+/***************************************************************************//**
+ * @brief      The maximal depth of the path of an iterator, the recursion
+ *             over a universe of 2^31 elements is 4 levels deep.
+ ******************************************************************************/
+#define VEB_ITER_DEPTH 8
+
+/***************************************************************************//**
+ * @brief      Struct containing an iterator over the elements of a TvEB.
+ *
+ * @details    It keeps the path from the root to the current element, one
+ *             frame per level. A frame of a node that is not a leaf holds the
+ *             index of the cluster the path continues into, or -1 when the
+ *             current element is the node's own minimum. The last frame of a
+ *             path ending in a leaf has no node, it holds the bit of the
+ *             current element and the leaf word. Moving to the neighbour
+ *             inside a leaf is a single bit scan and moving to the next
+ *             cluster asks only the summary of the node owning it, so the
+ *             iteration never goes back to the root. Any update of the tree
+ *             invalidates its iterators.
+ ******************************************************************************/
+struct TvEBIterator
+{
+  /*************************************************************************//**
+   * @brief      The current element, UNDEFINED after the end.
+   ****************************************************************************/
+  int val;
+
+  /*************************************************************************//**
+   * @brief      The number of frames on the path.
+   ****************************************************************************/
+  int depth;
+
+  /*************************************************************************//**
+   * @brief      The nodes on the path.
+   ****************************************************************************/
+  const TvEB * node[VEB_ITER_DEPTH];
+
+  /*************************************************************************//**
+   * @brief      The values of the first elements of the nodes on the path.
+   ****************************************************************************/
+  int base[VEB_ITER_DEPTH];
+
+  /*************************************************************************//**
+   * @brief      The positions on the path, the cluster index or -1 for the
+   *             minimum in the nodes and the bit in the leaves.
+   ****************************************************************************/
+  int pos[VEB_ITER_DEPTH];
+
+  /*************************************************************************//**
+   * @brief      The bitmap of the leaf ending the path.
+   ****************************************************************************/
+  uint64_t leaf;
 };
 
 /***************************************************************************//**
@@ -111,6 +538,15 @@ struct TvEB
  ******************************************************************************/
 int powTwoRoundUp ( int val );
 
+/***************************************************************************//**
+ * @brief      Returns the binary logarithm of the given power of two.
+ *
+ * @param[in]  val   The power of two.
+ *
+ * @return     The exponent of the power of two.
+ ******************************************************************************/
+int log2Int ( int val );
+
 /***************************************************************************//**
  * @brief      Returns the lower square root of the given value, which is 2^(
  *             floor ( log_2 ( value ) / 2 ) ).
@@ -162,6 +598,41 @@ int high ( TvEB * tree, int val );
  ******************************************************************************/
 int index ( TvEB * tree, int high, int low );
 
+/***************************************************************************//**
+ * @brief      Returns the cluster of the given index.
+ *
+ * @param[in]  tree  The pointer to the van Emde Boas tree.
+ * @param[in]  high  The cluster index.
+ *
+ * @return     The pointer to the cluster, NULL if the cluster is empty or
+ *             is a leaf kept as a bare word, see vEB_leaf.
+ ******************************************************************************/
+TvEB * vEB_cluster ( const TvEB * tree, int high );
+
+/***************************************************************************//**
+ * @brief      Returns the bitmap of the cluster of the given index of a tree
+ *             whose clusters are leaves, lowerUniSqrt at most VEB_LEAF_UNI.
+ *
+ * @param[in]  tree  The pointer to the van Emde Boas tree.
+ * @param[in]  high  The cluster index.
+ *
+ * @return     The bitmap of the cluster, 0 if the cluster is empty.
+ ******************************************************************************/
+uint64_t vEB_leaf ( const TvEB * tree, int high );
+
+/***************************************************************************//**
+ * @brief      Finds the next nonempty cluster of the given tree, answered by
+ *             its summary whatever form the summary has.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree, not a leaf.
+ * @param[in]  high   The cluster index to search after, -1 for the first.
+ * @param[out] res    The index of the next nonempty cluster.
+ *
+ * @retval     true   Successfully found the cluster.
+ * @retval     false  There is no nonempty cluster after high.
+ ******************************************************************************/
+bool vEB_cluster_succ ( const TvEB * tree, int high, int & res );
+
 /***************************************************************************//**
  * @brief      Finds the lowest value stored in the given tree.
  *
@@ -189,11 +660,17 @@ bool vEB_max ( TvEB * tree, int & res );
  *
  * @param[in]  tree   The pointer to the van Emde Boas tree.
  * @param[in]  val    The value of the element to insert.
+ * @param[in]  parentUniSqrt  The universe size of the tree created when the
+ *                    pointer is NULL.
+ * @param[in]  arena  The arena the tree is created from when the pointer is
+ *                    NULL.
+ * @param[in]  flags  The flags of the tree created when the pointer is NULL.
  *
  * @retval     true   Successfully inserted the value.
  * @retval     false  Failed to insert the value.
  ******************************************************************************/
-bool vEB_insert ( TvEB *& tree, int val, int parentUniSqrt = 65536 );
+bool vEB_insert ( TvEB *& tree, int val, int parentUniSqrt = 65536,
+                  TvEBArena * arena = NULL, int flags = 0 );
 
 /***************************************************************************//**
  * @brief      Removes the given value from the given vEB tree.
@@ -206,6 +683,118 @@ bool vEB_insert ( TvEB *& tree, int val, int parentUniSqrt = 65536 );
  ******************************************************************************/
 bool vEB_delete ( TvEB *& tree, int val );
 
+/***************************************************************************//**
+ * @brief      Removes the lowest value from the given vEB tree. It takes the
+ *             one descent vEB_delete of the minimum takes, without the
+ *             vEB_min before it and the checks of the value.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[out] res    The removed value.
+ *
+ * @retval     true   Successfully removed the minimum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+bool vEB_extract_min ( TvEB *& tree, int & res );
+
+/***************************************************************************//**
+ * @brief      Removes the highest value from the given vEB tree in one
+ *             descent.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[out] res    The removed value.
+ *
+ * @retval     true   Successfully removed the maximum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+bool vEB_extract_max ( TvEB *& tree, int & res );
+
+/***************************************************************************//**
+ * @brief      Inserts the given batch of values into the given vEB tree.
+ *
+ * @details    The batch is sorted and grouped by cluster, so every node on
+ *             the way is entered once per batch instead of once per value.
+ *             Values out of the universe and duplicates are skipped.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  vals   The values of the elements to insert.
+ * @param[in]  n      The number of the values.
+ * @param[in]  parentUniSqrt  The universe size of the tree created when the
+ *                    pointer is NULL.
+ * @param[in]  arena  The arena the tree is created from when the pointer is
+ *                    NULL.
+ * @param[in]  flags  The flags of the tree created when the pointer is NULL.
+ *
+ * @return     The number of values that were not in the tree before.
+ ******************************************************************************/
+size_t vEB_insert_batch ( TvEB *& tree, const int * vals, size_t n,
+                          int parentUniSqrt = 65536, TvEBArena * arena = NULL,
+                          int flags = 0 );
+
+/***************************************************************************//**
+ * @brief      Removes the given batch of values from the given vEB tree.
+ *
+ * @details    The batch is sorted and grouped by cluster as in
+ *             vEB_insert_batch.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  vals   The values of the elements to remove.
+ * @param[in]  n      The number of the values.
+ *
+ * @return     The number of values that were in the tree.
+ ******************************************************************************/
+size_t vEB_delete_batch ( TvEB *& tree, const int * vals, size_t n );
+
+/***************************************************************************//**
+ * @brief      Builds a vEB tree holding the given sorted values.
+ *
+ * @details    The tree is built bottom-up in one pass over the values, each
+ *             node is allocated once and filled completely, the hash tables
+ *             of VEB_SPARSE trees are allocated with their final size.
+ *
+ * @param[in]  vals   The strictly increasing values of the elements.
+ * @param[in]  n      The number of the values.
+ * @param[in]  uniSize  The size of the tree universe.
+ * @param[in]  arena  The arena the tree is created from, or NULL.
+ * @param[in]  flags  The flags of the tree.
+ *
+ * @return     The pointer to the new tree, or NULL when the values are not
+ *             strictly increasing or do not fit into the universe.
+ ******************************************************************************/
+TvEB * vEB_build_from_sorted ( const int * vals, size_t n, int uniSize,
+                               TvEBArena * arena = NULL, int flags = 0 );
+
+/***************************************************************************//**
+ * @brief      Builds a vEB tree holding the given sorted values, building the
+ *             top-level clusters in parallel on the given pool.
+ *
+ * @details    The values are split by their top-level cluster and the
+ *             clusters, which are independent, are built as by
+ *             vEB_build_from_sorted by the workers of the pool, then attached
+ *             to the root. Arenas are not thread-safe, so the tree is always
+ *             allocated on the heap.
+ *
+ * @param[in]  vals   The strictly increasing values of the elements.
+ * @param[in]  n      The number of the values.
+ * @param[in]  uniSize  The size of the tree universe.
+ * @param[in]  pool   The pool to build on, or NULL to build sequentially.
+ * @param[in]  flags  The flags of the tree.
+ *
+ * @return     The pointer to the new tree, or NULL when the values are not
+ *             strictly increasing or do not fit into the universe.
+ ******************************************************************************/
+TvEB * vEB_build_parallel ( const int * vals, size_t n, int uniSize,
+                            TvEBPool * pool, int flags = 0 );
+
+/***************************************************************************//**
+ * @brief      Deletes the given heap allocated tree, releasing the top-level
+ *             clusters in parallel on the given pool. A tree allocated from
+ *             an arena is left alone, it is released with the arena.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  pool   The pool to release on, or NULL to release sequentially.
+ ******************************************************************************/
+void vEB_destroy_parallel ( TvEB * tree, TvEBPool * pool );
+
 /***************************************************************************//**
  * @brief      Finds if the given value is in the given vEB tree.
  *
@@ -243,6 +832,305 @@ bool vEB_succ ( TvEB * tree, int val, int & res );
  ******************************************************************************/
 bool vEB_pred ( TvEB * tree, int val, int & res );
 
+/***************************************************************************//**
+ * @brief      Finds the successors of the given batch of values.
+ *
+ * @details    The queries are independent, so instead of answering them one
+ *             by one, a group of them is kept in flight and each takes one
+ *             step down its path in turn, prefetching the node or the cluster
+ *             pointer it needs next. The cache misses of the group overlap
+ *             instead of stalling every step of a single query.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  vals   The lower bounds for the values of the sought elements,
+ *                    -1 finds the minimum.
+ * @param[in]  n      The number of the values.
+ * @param[out] res    The found elements, UNDEFINED where there is none.
+ *
+ * @return     The number of the found elements.
+ ******************************************************************************/
+size_t vEB_succ_batch ( TvEB * tree, const int * vals, size_t n, int * res );
+
+/***************************************************************************//**
+ * @brief      Finds the predecessors of the given batch of values as
+ *             vEB_succ_batch finds the successors.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  vals   The upper bounds for the values of the sought elements,
+ *                    uni finds the maximum.
+ * @param[in]  n      The number of the values.
+ * @param[out] res    The found elements, UNDEFINED where there is none.
+ *
+ * @return     The number of the found elements.
+ ******************************************************************************/
+size_t vEB_pred_batch ( TvEB * tree, const int * vals, size_t n, int * res );
+
+/***************************************************************************//**
+ * @brief      Points the iterator to the smallest element greater than the
+ *             given value.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[out] it     The iterator.
+ * @param[in]  val    The lower bound for the value of the element, -1 points
+ *                    to the minimum.
+ *
+ * @retval     true   The iterator points to the found element.
+ * @retval     false  There is no such element, the iterator is at the end.
+ ******************************************************************************/
+bool vEB_iter_succ ( const TvEB * tree, TvEBIterator & it, int val );
+
+/***************************************************************************//**
+ * @brief      Points the iterator to the largest element smaller than the
+ *             given value.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[out] it     The iterator.
+ * @param[in]  val    The upper bound for the value of the element, uni
+ *                    points to the maximum.
+ *
+ * @retval     true   The iterator points to the found element.
+ * @retval     false  There is no such element, the iterator is at the end.
+ ******************************************************************************/
+bool vEB_iter_pred ( const TvEB * tree, TvEBIterator & it, int val );
+
+/***************************************************************************//**
+ * @brief      Moves the iterator to the next element.
+ *
+ * @param[in]  it     The iterator.
+ *
+ * @retval     true   The iterator points to the next element.
+ * @retval     false  There is no next element, the iterator is at the end.
+ ******************************************************************************/
+bool vEB_iter_next ( TvEBIterator & it );
+
+/***************************************************************************//**
+ * @brief      Moves the iterator to the previous element.
+ *
+ * @param[in]  it     The iterator.
+ *
+ * @retval     true   The iterator points to the previous element.
+ * @retval     false  There is no previous element, the iterator is at the
+ *                    end.
+ ******************************************************************************/
+bool vEB_iter_prev ( TvEBIterator & it );
+
+/***************************************************************************//**
+ * @brief      Calls the callback for the elements from lo to hi, inclusive,
+ *             in ascending order.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  lo     The lowest value of the range.
+ * @param[in]  hi     The highest value of the range.
+ * @param[in]  callback  The function called with each element and ctx, the
+ *                    scan stops when it returns false.
+ * @param[in]  ctx    The pointer passed to the callback.
+ *
+ * @return     The number of elements the callback was called with.
+ ******************************************************************************/
+size_t vEB_range ( const TvEB * tree, int lo, int hi,
+                   bool ( * callback ) ( int val, void * ctx ), void * ctx );
+
+/***************************************************************************//**
+ * @brief      Counts the elements of the given tree smaller than the given
+ *             value.
+ *
+ * @details    With VEB_COUNTED every level adds the sizes of the clusters
+ *             before the value's one from its Fenwick tree, so it takes
+ *             O ( log U ) time, without the flag it sums the clusters one by
+ *             one.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  val    The value.
+ *
+ * @return     The number of the smaller elements.
+ ******************************************************************************/
+int vEB_rank ( const TvEB * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Finds the element of the given rank in the given tree.
+ *
+ * @details    It descends by the Fenwick trees like vEB_rank.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  k      The rank, 0 finds the minimum.
+ * @param[out] res    The element with k smaller elements.
+ *
+ * @retval     true   Successfully found the element.
+ * @retval     false  The tree has k or less elements.
+ ******************************************************************************/
+bool vEB_select ( const TvEB * tree, int k, int & res );
+
+/***************************************************************************//**
+ * @brief      Counts the elements of the given tree from lo to hi, inclusive.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  lo     The lowest value of the range.
+ * @param[in]  hi     The highest value of the range.
+ *
+ * @return     The number of the elements in the range.
+ ******************************************************************************/
+int vEB_count ( const TvEB * tree, int lo, int hi );
+
+/***************************************************************************//**
+ * @brief      Builds the union of the given trees.
+ *
+ * @details    Both trees are walked together level by level, a cluster index
+ *             is visited only when one of the trees has the cluster, so the
+ *             time is proportional to the occupied structure of the trees.
+ *             The result is built bottom-up as by vEB_build_from_sorted.
+ *
+ * @param[in]  a      The pointer to the first van Emde Boas tree, or NULL.
+ * @param[in]  b      The pointer to the second van Emde Boas tree, or NULL.
+ * @param[in]  arena  The arena the result is created from, or NULL.
+ * @param[in]  flags  The flags of the result.
+ *
+ * @return     The pointer to the new tree, NULL when both trees are NULL or
+ *             their universe sizes differ.
+ ******************************************************************************/
+TvEB * vEB_union ( const TvEB * a, const TvEB * b, TvEBArena * arena = NULL,
+                   int flags = 0 );
+
+/***************************************************************************//**
+ * @brief      Builds the intersection of the given trees as vEB_union builds
+ *             the union, the clusters missing in either tree are skipped.
+ ******************************************************************************/
+TvEB * vEB_intersect ( const TvEB * a, const TvEB * b, TvEBArena * arena = NULL,
+                       int flags = 0 );
+
+/***************************************************************************//**
+ * @brief      Builds the difference a - b of the given trees as vEB_union
+ *             builds the union, only the clusters of a are visited.
+ ******************************************************************************/
+TvEB * vEB_difference ( const TvEB * a, const TvEB * b, TvEBArena * arena = NULL,
+                        int flags = 0 );
+
+/***************************************************************************//**
+ * @brief      Adds the elements of b to a.
+ *
+ * @details    The elements missing in a are found by the walk of
+ *             vEB_difference and inserted by vEB_insert_batch. The _into
+ *             variants of the intersection and the difference remove the
+ *             elements found the same way by vEB_delete_batch.
+ *
+ * @param[in]  a      The pointer to the van Emde Boas tree to update.
+ * @param[in]  b      The pointer to the other van Emde Boas tree.
+ * @param[in]  arena  The arena a is created from when the pointer is NULL,
+ *                    never the one of b, whose nodes may go before a's.
+ * @param[in]  flags  The flags of a when it is created.
+ *
+ * @return     The number of the inserted or removed elements.
+ ******************************************************************************/
+size_t vEB_union_into ( TvEB *& a, const TvEB * b, TvEBArena * arena = NULL,
+                        int flags = 0 );
+
+/***************************************************************************//**
+ * @brief      Removes the elements missing in b from a.
+ ******************************************************************************/
+size_t vEB_intersect_into ( TvEB *& a, const TvEB * b );
+
+/***************************************************************************//**
+ * @brief      Removes the elements of b from a.
+ ******************************************************************************/
+size_t vEB_difference_into ( TvEB *& a, const TvEB * b );
+
+/***************************************************************************//**
+ * @brief      The number of the levels told apart by TvEBMemoryUsage, deeper
+ *             nodes fall into the last one.
+ ******************************************************************************/
+#define VEB_MEMORY_LEVELS 8
+
+/***************************************************************************//**
+ * @brief      The kinds of nodes told apart by TvEBMemoryUsage.
+ ******************************************************************************/
+enum
+{
+  VEB_NODE_LEAF,    ///< a leaf keeping its elements in a bitmap, a bare word
+                    ///< in its parent below the root
+  VEB_NODE_DENSE,   ///< a node with an array of higherUniSqrt clusters
+  VEB_NODE_SPARSE,  ///< a node with a hash map of its clusters
+  VEB_NODE_TYPES
+};
+
+/***************************************************************************//**
+ * @brief      Struct containing the memory held by a tree.
+ *
+ * @details    The bytes of a node are the node itself and the cluster array,
+ *             the hash table and the cluster counts it owns. A leaf below the
+ *             root is a word of its parent, counted there, and has no bytes of
+ *             its own. The level of the
+ *             root is 0, the summary and the clusters of a node are one level
+ *             deeper. The headers of the heap and the free lists of an arena
+ *             are not counted.
+ ******************************************************************************/
+struct TvEBMemoryUsage
+{
+  /*************************************************************************//**
+   * @brief      The number of the nodes by level and kind.
+   ****************************************************************************/
+  size_t nodes[VEB_MEMORY_LEVELS][VEB_NODE_TYPES];
+
+  /*************************************************************************//**
+   * @brief      The bytes of the nodes by level and kind.
+   ****************************************************************************/
+  size_t bytes[VEB_MEMORY_LEVELS][VEB_NODE_TYPES];
+
+  /*************************************************************************//**
+   * @brief      The number of the cluster slots of all the arrays and hash
+   *             tables.
+   ****************************************************************************/
+  size_t slots;
+
+  /*************************************************************************//**
+   * @brief      The number of the slots holding a cluster.
+   ****************************************************************************/
+  size_t usedSlots;
+
+  /*************************************************************************//**
+   * @brief      The bytes of all the nodes.
+   ****************************************************************************/
+  size_t total;
+};
+
+/***************************************************************************//**
+ * @brief      Sums the memory held by the given tree.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree, or NULL.
+ * @param[out] usage  The memory of the tree.
+ ******************************************************************************/
+void vEB_memory_usage ( const TvEB * tree, TvEBMemoryUsage & usage );
+
+/***************************************************************************//**
+ * @brief      Copies the given tree into one contiguous run of the arena,
+ *             choosing the cluster storage of every node anew.
+ *
+ * @details    The nodes are laid out in van Emde Boas order, every node
+ *             followed by its cluster array or hash table, its summary and
+ *             then its clusters in increasing order, so a search walks
+ *             forward through memory. Each node gets the smaller of the two
+ *             cluster representations: a node whose hash table would take at
+ *             most a quarter of its cluster array gets the table and the
+ *             VEB_SPARSE flag, the other nodes get the array, and nodes with
+ *             no clusters get neither. A fresh arena holds nothing else, so
+ *             freeing the old tree or clearing its arena gives back all of
+ *             the memory churn left in it.
+ *
+ *             The nodes are written as VEB_TRIMMED records, which end after
+ *             the fields they use: the record of a leaf or of a node with a
+ *             cluster array ends after its first word of the cluster union,
+ *             the pointer to the arena is kept only in an arena and the
+ *             counts of VEB_COUNTED trees follow the record in place of their
+ *             pointer. The first vEB_insert or vEB_delete changing a trimmed
+ *             node copies it into a full TvEB.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree, or NULL.
+ * @param[in]  arena  The arena of the copy, or NULL for the heap, where the
+ *                    representations are chosen but the nodes are not
+ *                    contiguous.
+ *
+ * @return     The pointer to the copy, NULL for an empty tree.
+ ******************************************************************************/
+TvEB * vEB_compact ( const TvEB * tree, TvEBArena * arena );
+
 /***************************************************************************//**
  * @brief      Prints pointer values of the given tree.
  *
@@ -0,0 +1,553 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebconc.cpp
+ *
+ * @brief      File containing definitions of thread-safe Van Emde Boas trees,
+ *             one locking its top-level clusters separately and one with
+ *             lock-free readers.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include <algorithm>
+#include "vebconc.hpp"
+
+TvEBConcurrent::TvEBConcurrent ( int uniSize, int flags )
+  : uni ( powTwoRoundUp ( uniSize ) ), lowBits ( log2Int ( uni ) / 2 ),
+    clusterCnt ( uni >> lowBits ), flags ( flags ), summary ( NULL )
+{
+  cluster = new TvEB * [clusterCnt];
+  locks = new TvEBLock [clusterCnt];
+  for ( int i = 0; i < clusterCnt; ++i )
+  {
+    cluster[i] = NULL;
+    pthread_rwlock_init ( &locks[i].lock, NULL );
+  }
+  pthread_rwlock_init ( &summaryLock.lock, NULL );
+}
+
+TvEBConcurrent::~TvEBConcurrent()
+{
+  for ( int i = 0; i < clusterCnt; ++i )
+  {
+    if ( cluster[i] ) delete cluster[i];
+    pthread_rwlock_destroy ( &locks[i].lock );
+  }
+  if ( summary ) delete summary;
+  pthread_rwlock_destroy ( &summaryLock.lock );
+  delete [] cluster;
+  delete [] locks;
+}
+
+/***************************************************************************//**
+ * @brief      Locks the given lock for reading.
+ ******************************************************************************/
+static inline void readLock ( TvEBLock & l )
+{
+  pthread_rwlock_rdlock ( &l.lock );
+}
+
+/***************************************************************************//**
+ * @brief      Locks the given lock for writing.
+ ******************************************************************************/
+static inline void writeLock ( TvEBLock & l )
+{
+  pthread_rwlock_wrlock ( &l.lock );
+}
+
+/***************************************************************************//**
+ * @brief      Unlocks the given lock.
+ ******************************************************************************/
+static inline void unlock ( TvEBLock & l )
+{
+  pthread_rwlock_unlock ( &l.lock );
+}
+
+bool vEB_min ( TvEBConcurrent * tree, int & res )
+{
+  if ( !tree ) return false;
+
+  int i, j;
+  bool found = false;
+  readLock ( tree->summaryLock );
+  if ( vEB_min ( tree->summary, i ) )
+  {
+    readLock ( tree->locks[i] );
+    found = vEB_min ( tree->cluster[i], j );
+    if ( found ) res = ( i << tree->lowBits ) | j;
+    unlock ( tree->locks[i] );
+  }
+  unlock ( tree->summaryLock );
+  return found;
+}
+
+bool vEB_max ( TvEBConcurrent * tree, int & res )
+{
+  if ( !tree ) return false;
+
+  int i, j;
+  bool found = false;
+  readLock ( tree->summaryLock );
+  if ( vEB_max ( tree->summary, i ) )
+  {
+    readLock ( tree->locks[i] );
+    found = vEB_max ( tree->cluster[i], j );
+    if ( found ) res = ( i << tree->lowBits ) | j;
+    unlock ( tree->locks[i] );
+  }
+  unlock ( tree->summaryLock );
+  return found;
+}
+
+bool vEB_insert ( TvEBConcurrent * tree, int val )
+{
+  if ( !tree ) return false;
+  if ( val < 0 || val >= tree->uni ) return false;
+
+  int highVal = val >> tree->lowBits;
+  int lowVal = val & ( ( 1 << tree->lowBits ) - 1 );
+  bool ok;
+
+  // the cluster is already in the summary, it stays there
+  writeLock ( tree->locks[highVal] );
+  if ( tree->cluster[highVal] )
+  {
+    ok = vEB_insert ( tree->cluster[highVal], lowVal, 1 << tree->lowBits, NULL,
+                      tree->flags );
+    unlock ( tree->locks[highVal] );
+    return ok;
+  }
+  unlock ( tree->locks[highVal] );
+
+  // the cluster may become non-empty, the summary has to be changed with it
+  writeLock ( tree->summaryLock );
+  writeLock ( tree->locks[highVal] );
+  bool fresh = !tree->cluster[highVal];
+  ok = vEB_insert ( tree->cluster[highVal], lowVal, 1 << tree->lowBits, NULL,
+                    tree->flags );
+  if ( ok && fresh )
+  {
+    vEB_insert ( tree->summary, highVal, tree->clusterCnt );
+  }
+  unlock ( tree->locks[highVal] );
+  unlock ( tree->summaryLock );
+  return ok;
+}
+
+bool vEB_delete ( TvEBConcurrent * tree, int val )
+{
+  if ( !tree ) return false;
+  if ( val < 0 || val >= tree->uni ) return false;
+
+  int highVal = val >> tree->lowBits;
+  int lowVal = val & ( ( 1 << tree->lowBits ) - 1 );
+  bool ok;
+
+  // the cluster keeps another element, the summary stays the same
+  writeLock ( tree->locks[highVal] );
+  TvEB * c = tree->cluster[highVal];
+  if ( !c || c->min != c->max )
+  {
+    ok = vEB_delete ( tree->cluster[highVal], lowVal );
+    unlock ( tree->locks[highVal] );
+    return ok;
+  }
+  if ( c->min != lowVal )
+  {
+    unlock ( tree->locks[highVal] );
+    return false;
+  }
+  unlock ( tree->locks[highVal] );
+
+  // the cluster may become empty, the summary has to be changed with it
+  writeLock ( tree->summaryLock );
+  writeLock ( tree->locks[highVal] );
+  ok = vEB_delete ( tree->cluster[highVal], lowVal );
+  if ( ok && !tree->cluster[highVal] )
+  {
+    vEB_delete ( tree->summary, highVal );
+  }
+  unlock ( tree->locks[highVal] );
+  unlock ( tree->summaryLock );
+  return ok;
+}
+
+bool vEB_find ( TvEBConcurrent * tree, int val )
+{
+  if ( !tree ) return false;
+  if ( val < 0 || val >= tree->uni ) return false;
+
+  int highVal = val >> tree->lowBits;
+  readLock ( tree->locks[highVal] );
+  bool found = vEB_find ( tree->cluster[highVal],
+                          val & ( ( 1 << tree->lowBits ) - 1 ) );
+  unlock ( tree->locks[highVal] );
+  return found;
+}
+
+bool vEB_succ ( TvEBConcurrent * tree, int val, int & res )
+{
+  if ( !tree ) return false;
+  if ( val < -1 || val >= tree->uni ) return false;
+
+  int highVal = val < 0 ? -1 : val >> tree->lowBits;
+  int lowVal = val & ( ( 1 << tree->lowBits ) - 1 );
+  int i, j;
+
+  // the successor is in the same cluster
+  if ( highVal >= 0 )
+  {
+    readLock ( tree->locks[highVal] );
+    bool found = vEB_succ ( tree->cluster[highVal], lowVal, j );
+    unlock ( tree->locks[highVal] );
+    if ( found )
+    {
+      res = val - lowVal + j;
+      return true;
+    }
+  }
+
+  // the successor is in the next non-empty cluster, the cluster of the value
+  // has to be checked again as it might have changed in the meantime
+  bool found = false;
+  readLock ( tree->summaryLock );
+  if ( highVal >= 0 )
+  {
+    readLock ( tree->locks[highVal] );
+    if ( vEB_succ ( tree->cluster[highVal], lowVal, j ) )
+    {
+      res = val - lowVal + j;
+      found = true;
+    }
+  }
+  if ( !found && vEB_succ ( tree->summary, highVal, i ) )
+  {
+    readLock ( tree->locks[i] );
+    found = vEB_min ( tree->cluster[i], j );
+    if ( found ) res = ( i << tree->lowBits ) | j;
+    unlock ( tree->locks[i] );
+  }
+  if ( highVal >= 0 ) unlock ( tree->locks[highVal] );
+  unlock ( tree->summaryLock );
+  return found;
+}
+
+bool vEB_pred ( TvEBConcurrent * tree, int val, int & res )
+{
+  if ( !tree ) return false;
+  if ( val < 0 || val > tree->uni ) return false;
+
+  int highVal = val == tree->uni ? tree->clusterCnt : val >> tree->lowBits;
+  int lowVal = val & ( ( 1 << tree->lowBits ) - 1 );
+  int i, j;
+
+  // the predecessor is in the same cluster
+  if ( highVal < tree->clusterCnt )
+  {
+    readLock ( tree->locks[highVal] );
+    bool found = vEB_pred ( tree->cluster[highVal], lowVal, j );
+    unlock ( tree->locks[highVal] );
+    if ( found )
+    {
+      res = val - lowVal + j;
+      return true;
+    }
+  }
+
+  // the predecessor is in the previous non-empty cluster, the cluster locks
+  // are taken in the ascending order, so the lower one has to be locked first
+  bool found = false;
+  readLock ( tree->summaryLock );
+  if ( vEB_pred ( tree->summary, highVal, i ) && i != UNDEFINED )
+  {
+    readLock ( tree->locks[i] );
+    if ( highVal < tree->clusterCnt )
+    {
+      readLock ( tree->locks[highVal] );
+      if ( vEB_pred ( tree->cluster[highVal], lowVal, j ) )
+      {
+        res = val - lowVal + j;
+        found = true;
+      }
+      unlock ( tree->locks[highVal] );
+    }
+    if ( !found && vEB_max ( tree->cluster[i], j ) )
+    {
+      res = ( i << tree->lowBits ) | j;
+      found = true;
+    }
+    unlock ( tree->locks[i] );
+  }
+  else if ( highVal < tree->clusterCnt )
+  {
+    readLock ( tree->locks[highVal] );
+    if ( vEB_pred ( tree->cluster[highVal], lowVal, j ) )
+    {
+      res = val - lowVal + j;
+      found = true;
+    }
+    unlock ( tree->locks[highVal] );
+  }
+  unlock ( tree->summaryLock );
+  return found;
+}
+
+/***************************************************************************//**
+ * @brief      The reading operations of TvEBRcu.
+ ******************************************************************************/
+enum
+{
+  RCU_MIN,
+  RCU_MAX,
+  RCU_FIND,
+  RCU_SUCC,
+  RCU_PRED
+};
+
+/***************************************************************************//**
+ * @brief      The retire callback of the TvEBRcu arena. A node of the running
+ *             write was never published and is reused at once, an older one
+ *             replaced by its copy or emptied waits with the current epoch.
+ ******************************************************************************/
+static void rcuRetire ( TvEB * node, void * ctx )
+{
+  TvEBRcu * tree = ( TvEBRcu * ) ctx;
+  if ( node->gen == tree->arena.gen )
+  {
+    tree->arena.reuse ( node );
+    return;
+  }
+  if ( tree->retiredCnt == tree->retiredCap )
+  {
+    int cap = tree->retiredCap ? tree->retiredCap * 2 : 64;
+    TvEB ** nodes = new TvEB * [cap];
+    unsigned long * epochs = new unsigned long [cap];
+    std::copy ( tree->retired, tree->retired + tree->retiredCnt, nodes );
+    std::copy ( tree->retiredEpochs, tree->retiredEpochs + tree->retiredCnt, epochs );
+    delete [] tree->retired;
+    delete [] tree->retiredEpochs;
+    tree->retired = nodes;
+    tree->retiredEpochs = epochs;
+    tree->retiredCap = cap;
+  }
+  tree->retired[tree->retiredCnt] = node;
+  tree->retiredEpochs[tree->retiredCnt++] = tree->epoch;
+}
+
+TvEBRcu::TvEBRcu ( int uniSize, int flags )
+  : uni ( powTwoRoundUp ( uniSize ) ), flags ( flags ), root ( NULL ),
+    epoch ( 1 ), retired ( NULL ), retiredEpochs ( NULL ),
+    retiredCnt ( 0 ), retiredCap ( 0 )
+{
+  arena.retire = rcuRetire;
+  arena.retireCtx = this;
+  for ( int i = 0; i < VEB_RCU_READERS; ++i )
+  {
+    slots[i].epoch = 0;
+    slots[i].used = 0;
+  }
+  pthread_mutex_init ( &writeLock, NULL );
+}
+
+TvEBRcu::~TvEBRcu()
+{
+  pthread_mutex_destroy ( &writeLock );
+  delete [] retired;
+  delete [] retiredEpochs;
+}
+
+/***************************************************************************//**
+ * @brief      Sets the generation of all the nodes of the tree back to 0.
+ ******************************************************************************/
+static void rcuRestamp ( TvEB * tree )
+{
+  if ( !tree ) return;
+  tree->gen = 0;
+  if ( tree->uni <= VEB_LEAF_UNI ) return;
+  // the leaf summary and clusters are words of the node, stamped with it
+  if ( tree->higherUniSqrt() > VEB_LEAF_UNI ) rcuRestamp ( tree->summary );
+  if ( tree->lowerUniSqrt() <= VEB_LEAF_UNI ) return;
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ); ) rcuRestamp ( vEB_cluster ( tree, i ) );
+}
+
+/***************************************************************************//**
+ * @brief      Starts a change of the tree. It freezes all the published nodes
+ *             by a new generation of the arena, so the change copies each of
+ *             them it touches and leaves the original to the readers.
+ ******************************************************************************/
+static inline void rcuWriteBegin ( TvEBRcu * tree )
+{
+  pthread_mutex_lock ( &tree->writeLock );
+  // only writers read the generations, so they may start over
+  if ( tree->arena.gen == INT_MAX )
+  {
+    rcuRestamp ( tree->root );
+    tree->arena.gen = 0;
+  }
+  tree->arena.gen++;
+}
+
+/***************************************************************************//**
+ * @brief      Publishes the new root and reuses the replaced nodes no reader
+ *             can see anymore.
+ ******************************************************************************/
+static void rcuWriteEnd ( TvEBRcu * tree, TvEB * root )
+{
+  __atomic_store_n ( &tree->root, root, __ATOMIC_SEQ_CST );
+
+  if ( tree->retiredCnt )
+  {
+    // readers entering from now on find the new root
+    unsigned long oldest = __atomic_add_fetch ( &tree->epoch, 1, __ATOMIC_SEQ_CST );
+    for ( int i = 0; i < VEB_RCU_READERS; ++i )
+    {
+      unsigned long e = __atomic_load_n ( &tree->slots[i].epoch, __ATOMIC_SEQ_CST );
+      if ( e && e < oldest ) oldest = e;
+    }
+
+    int kept = 0;
+    for ( int i = 0; i < tree->retiredCnt; ++i )
+    {
+      if ( tree->retiredEpochs[i] < oldest )
+      {
+        tree->arena.reuseCopied ( tree->retired[i] );
+        continue;
+      }
+      tree->retired[kept] = tree->retired[i];
+      tree->retiredEpochs[kept++] = tree->retiredEpochs[i];
+    }
+    tree->retiredCnt = kept;
+  }
+
+  pthread_mutex_unlock ( &tree->writeLock );
+}
+
+/***************************************************************************//**
+ * @brief      Runs the given reading operation on the given version.
+ ******************************************************************************/
+static inline bool rcuSearch ( TvEB * root, int op, int val, int & res )
+{
+  switch ( op )
+  {
+    case RCU_MIN:
+      return root && vEB_min ( root, res );
+    case RCU_MAX:
+      return root && vEB_max ( root, res );
+    case RCU_FIND:
+      return vEB_find ( root, val );
+    case RCU_SUCC:
+      return vEB_succ ( root, val, res );
+    default:
+      return vEB_pred ( root, val, res );
+  }
+}
+
+/***************************************************************************//**
+ * @brief      Runs the given reading operation on the version published when
+ *             it starts, without locks and without retrying.
+ ******************************************************************************/
+static bool rcuRead ( TvEBRcu * tree, int reader, int op, int val, int & res )
+{
+  if ( !tree ) return false;
+
+  bool found;
+  int tmp = UNDEFINED;
+  if ( reader < 0 || reader >= VEB_RCU_READERS )
+  {
+    pthread_mutex_lock ( &tree->writeLock );
+    found = rcuSearch ( tree->root, op, val, tmp );
+    pthread_mutex_unlock ( &tree->writeLock );
+    if ( found ) res = tmp;
+    return found;
+  }
+
+  // the epoch is visible before the root is read, so the writer which
+  // replaces any node of this version keeps it
+  TvEBEpochSlot & slot = tree->slots[reader];
+  __atomic_store_n ( &slot.epoch, __atomic_load_n ( &tree->epoch, __ATOMIC_ACQUIRE ),
+                     __ATOMIC_SEQ_CST );
+  __atomic_thread_fence ( __ATOMIC_SEQ_CST );
+  found = rcuSearch ( __atomic_load_n ( &tree->root, __ATOMIC_ACQUIRE ), op, val, tmp );
+  __atomic_store_n ( &slot.epoch, 0, __ATOMIC_RELEASE );
+
+  if ( found ) res = tmp;
+  return found;
+}
+
+int vEB_rcu_register ( TvEBRcu * tree )
+{
+  if ( !tree ) return -1;
+  for ( int i = 0; i < VEB_RCU_READERS; ++i )
+  {
+    int expected = 0;
+    if ( __atomic_compare_exchange_n ( &tree->slots[i].used, &expected, 1, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_RELAXED ) )
+      return i;
+  }
+  return -1;
+}
+
+void vEB_rcu_unregister ( TvEBRcu * tree, int reader )
+{
+  if ( !tree || reader < 0 || reader >= VEB_RCU_READERS ) return;
+  __atomic_store_n ( &tree->slots[reader].epoch, 0, __ATOMIC_RELEASE );
+  __atomic_store_n ( &tree->slots[reader].used, 0, __ATOMIC_RELEASE );
+}
+
+bool vEB_insert ( TvEBRcu * tree, int val )
+{
+  if ( !tree ) return false;
+  if ( val < 0 || val >= tree->uni ) return false;
+
+  rcuWriteBegin ( tree );
+  TvEB * root = tree->root;
+  bool ok = vEB_insert ( root, val, tree->uni, &tree->arena, tree->flags );
+  rcuWriteEnd ( tree, root );
+  return ok;
+}
+
+bool vEB_delete ( TvEBRcu * tree, int val )
+{
+  if ( !tree ) return false;
+
+  rcuWriteBegin ( tree );
+  TvEB * root = tree->root;
+  bool ok = vEB_delete ( root, val );
+  rcuWriteEnd ( tree, root );
+  return ok;
+}
+
+bool vEB_min ( TvEBRcu * tree, int reader, int & res )
+{
+  return rcuRead ( tree, reader, RCU_MIN, 0, res );
+}
+
+bool vEB_max ( TvEBRcu * tree, int reader, int & res )
+{
+  return rcuRead ( tree, reader, RCU_MAX, 0, res );
+}
+
+bool vEB_find ( TvEBRcu * tree, int reader, int val )
+{
+  int res;
+  return rcuRead ( tree, reader, RCU_FIND, val, res );
+}
+
+bool vEB_succ ( TvEBRcu * tree, int reader, int val, int & res )
+{
+  return rcuRead ( tree, reader, RCU_SUCC, val, res );
+}
+
+bool vEB_pred ( TvEBRcu * tree, int reader, int val, int & res )
+{
+  return rcuRead ( tree, reader, RCU_PRED, val, res );
+}
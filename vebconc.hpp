@@ -0,0 +1,426 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebconc.hpp
+ *
+ * @brief      File containing declarations of thread-safe Van Emde Boas trees,
+ *             one locking its top-level clusters separately and one with
+ *             lock-free readers.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBCONC_H_918273645091827364509182736450918273645091827364509182__
+#define __VEBCONC_H_918273645091827364509182736450918273645091827364509182__
+
+#include <pthread.h>
+#include "veb.hpp"
+
+/***************************************************************************//**
+ * @brief      Struct containing a read-write lock alone in its cache line, so
+ *             the locks of neighbouring clusters do not share a line.
+ ******************************************************************************/
+struct TvEBLock
+{
+  pthread_rwlock_t lock;
+} __attribute__ ( ( aligned ( 64 ) ) );
+
+/***************************************************************************//**
+ * @brief      Struct containing the thread-safe Van Emde Boas tree.
+ *
+ * @details    The top level of the tree is split as in TvEB, but the root
+ *             keeps no minimum of its own, every element is in one of the
+ *             top-level clusters. Each cluster is an ordinary TvEB guarded by
+ *             its own read-write lock, the summary of the non-empty clusters
+ *             is guarded by one more lock.
+ *
+ *             The locks are always taken in the same order, the summary lock
+ *             first and then the cluster locks by ascending index, and a
+ *             writer holds at most one cluster lock, so there is no deadlock.
+ *
+ *             vEB_find locks only the cluster of the value. vEB_insert and
+ *             vEB_delete write-lock only the cluster of the value, unless the
+ *             cluster becomes non-empty or empty, then they retry with the
+ *             summary write-locked as well. vEB_succ and vEB_pred first try
+ *             the cluster of the value alone, when the answer is not there,
+ *             they read-lock the summary, the cluster of the value and the
+ *             cluster the summary points to. Every operation is linearizable,
+ *             its linearization point is the moment it holds all the locks it
+ *             ends up with: no other operation can change what it read, as
+ *             the set of non-empty clusters can not change without the
+ *             summary lock.
+ ******************************************************************************/
+struct TvEBConcurrent
+{
+  /*************************************************************************//**
+   * @brief      Constructor.
+   *
+   * @param[in]  uniSize  The size of the tree universe
+   * @param[in]  flags    The flags of the clusters, see TvEB.
+   ****************************************************************************/
+  TvEBConcurrent ( int uniSize, int flags = 0 );
+
+  /*************************************************************************//**
+   * @brief      Destructor.
+   ****************************************************************************/
+  ~TvEBConcurrent();
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  const int uni;
+
+  /*************************************************************************//**
+   * @brief      The number of low bits of a value addressing the element inside
+   *             its cluster.
+   ****************************************************************************/
+  const int lowBits;
+
+  /*************************************************************************//**
+   * @brief      The number of the top-level clusters.
+   ****************************************************************************/
+  const int clusterCnt;
+
+  /*************************************************************************//**
+   * @brief      The flags the clusters are created with.
+   ****************************************************************************/
+  const int flags;
+
+  /*************************************************************************//**
+   * @brief      The summary of the non-empty clusters.
+   ****************************************************************************/
+  TvEB * summary;
+
+  /*************************************************************************//**
+   * @brief      The clusters, NULL when empty.
+   ****************************************************************************/
+  TvEB ** cluster;
+
+  /*************************************************************************//**
+   * @brief      The lock of the summary.
+   ****************************************************************************/
+  TvEBLock summaryLock;
+
+  /*************************************************************************//**
+   * @brief      The locks of the clusters.
+   ****************************************************************************/
+  TvEBLock * locks;
+};
+
+/***************************************************************************//**
+ * @brief      The number of readers which can be registered with one TvEBRcu at
+ *             the same time.
+ ******************************************************************************/
+#define VEB_RCU_READERS 64
+
+/***************************************************************************//**
+ * @brief      Struct containing the epoch of one reader alone in its cache line.
+ ******************************************************************************/
+struct TvEBEpochSlot
+{
+  /*************************************************************************//**
+   * @brief      The global epoch the reader entered in, or 0 outside of reads.
+   ****************************************************************************/
+  unsigned long epoch;
+
+  /*************************************************************************//**
+   * @brief      Whether the slot is taken by a registered reader.
+   ****************************************************************************/
+  int used;
+} __attribute__ ( ( aligned ( 64 ) ) );
+
+/***************************************************************************//**
+ * @brief      Struct containing a Van Emde Boas tree for read-mostly workloads,
+ *             which readers search without taking any lock or ever waiting.
+ *
+ * @details    Writers are serialized by a mutex and never change a node a
+ *             reader can reach. Each write starts a new generation of the
+ *             arena, so, as in TvEBPersistent, it copies every node on its
+ *             path before changing it and works on a private version of the
+ *             tree, whose root it then publishes by one atomic store. A
+ *             reader loads the root once and searches that version, whose
+ *             nodes no longer change, so every read is linearizable at the
+ *             load and never retries, however long a writer runs.
+ *
+ *             The replaced nodes go to the arena's retire callback, each
+ *             tagged by the global epoch. A reader publishes the epoch it
+ *             entered in before it loads the root, and a node is reused only
+ *             when every active reader entered in a later epoch, after the
+ *             root without the node was published.
+ *
+ *             Readers only write their own slot, so they scale with the
+ *             number of cores. Each reading thread registers once by
+ *             vEB_rcu_register and passes the slot to the reading functions.
+ *             A reader which got no slot passes -1 and reads under the mutex.
+ *             A write copies O(log log M) nodes with their cluster arrays or
+ *             hash tables, which makes it slower than one of TvEBConcurrent.
+ ******************************************************************************/
+struct TvEBRcu
+{
+  /*************************************************************************//**
+   * @brief      Constructor.
+   *
+   * @param[in]  uniSize  The size of the tree universe
+   * @param[in]  flags    VEB_SPARSE and VEB_COUNTED, or 0.
+   ****************************************************************************/
+  TvEBRcu ( int uniSize, int flags = 0 );
+
+  /*************************************************************************//**
+   * @brief      Destructor. There must be no reader or writer left.
+   ****************************************************************************/
+  ~TvEBRcu();
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  const int uni;
+
+  /*************************************************************************//**
+   * @brief      The flags of the tree.
+   ****************************************************************************/
+  const int flags;
+
+  /*************************************************************************//**
+   * @brief      The published version of the tree, NULL when empty.
+   ****************************************************************************/
+  TvEB * root;
+
+  /*************************************************************************//**
+   * @brief      The arena of the tree nodes.
+   ****************************************************************************/
+  TvEBArena arena;
+
+  /*************************************************************************//**
+   * @brief      The global epoch, starting at 1, advanced by the writes which
+   *             replaced some nodes.
+   ****************************************************************************/
+  unsigned long epoch __attribute__ ( ( aligned ( 64 ) ) );
+
+  /*************************************************************************//**
+   * @brief      The epochs of the readers.
+   ****************************************************************************/
+  TvEBEpochSlot slots[VEB_RCU_READERS];
+
+  /*************************************************************************//**
+   * @brief      The emptied nodes waiting for reuse.
+   ****************************************************************************/
+  TvEB ** retired;
+
+  /*************************************************************************//**
+   * @brief      The epochs the emptied nodes were retired in.
+   ****************************************************************************/
+  unsigned long * retiredEpochs;
+
+  /*************************************************************************//**
+   * @brief      The number of the emptied nodes waiting for reuse.
+   ****************************************************************************/
+  int retiredCnt;
+
+  /*************************************************************************//**
+   * @brief      The capacity of the retired arrays.
+   ****************************************************************************/
+  int retiredCap;
+
+  /*************************************************************************//**
+   * @brief      The mutex of the writers.
+   ****************************************************************************/
+  pthread_mutex_t writeLock;
+};
+
+/***************************************************************************//**
+ * @brief      Finds the lowest value stored in the given tree.
+ *
+ * @param[in]  tree   The pointer to the concurrent van Emde Boas tree.
+ * @param[out] res    The lowest element.
+ *
+ * @retval     true   Successfully found the minimum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+bool vEB_min ( TvEBConcurrent * tree, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the highest value stored in the given tree.
+ *
+ * @param[in]  tree   The pointer to the concurrent van Emde Boas tree.
+ * @param[out] res    The highest element.
+ *
+ * @retval     true   Successfully found the maximum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+bool vEB_max ( TvEBConcurrent * tree, int & res );
+
+/***************************************************************************//**
+ * @brief      Inserts the given value into the given concurrent tree.
+ *
+ * @param[in]  tree   The pointer to the concurrent van Emde Boas tree.
+ * @param[in]  val    The value of the element to insert.
+ *
+ * @retval     true   Successfully inserted the value.
+ * @retval     false  Failed to insert the value.
+ ******************************************************************************/
+bool vEB_insert ( TvEBConcurrent * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Removes the given value from the given concurrent tree.
+ *
+ * @param[in]  tree   The pointer to the concurrent van Emde Boas tree.
+ * @param[in]  val    The value of the element to remove.
+ *
+ * @retval     true   Successfully removed the value.
+ * @retval     false  Failed to remove the value.
+ ******************************************************************************/
+bool vEB_delete ( TvEBConcurrent * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Finds if the given value is in the given concurrent tree.
+ *
+ * @param[in]  tree   The pointer to the concurrent van Emde Boas tree.
+ * @param[in]  val    The value of the element to find.
+ *
+ * @retval     true   Successfully found the element.
+ * @retval     false  Failed to found the element.
+ ******************************************************************************/
+bool vEB_find ( TvEBConcurrent * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Finds the smallest value greater than the given value in the
+ *             given concurrent tree.
+ *
+ * @param[in]  tree   The pointer to the concurrent van Emde Boas tree.
+ * @param[in]  val    The lower bound for the value of the sought element, -1
+ *                    finds the minimum.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the successor.
+ * @retval     false  Failed to found the successor.
+ ******************************************************************************/
+bool vEB_succ ( TvEBConcurrent * tree, int val, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the largest value smaller than the given value in the
+ *             given concurrent tree.
+ *
+ * @param[in]  tree   The pointer to the concurrent van Emde Boas tree.
+ * @param[in]  val    The upper bound for the value of the sought element, uni
+ *                    finds the maximum.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the predecessor.
+ * @retval     false  Failed to found the predecessor.
+ ******************************************************************************/
+bool vEB_pred ( TvEBConcurrent * tree, int val, int & res );
+
+/***************************************************************************//**
+ * @brief      Registers the calling reader with the given tree.
+ *
+ * @param[in]  tree  The pointer to the read-mostly van Emde Boas tree.
+ *
+ * @return     The slot of the reader, or -1 when all of them are taken.
+ ******************************************************************************/
+int vEB_rcu_register ( TvEBRcu * tree );
+
+/***************************************************************************//**
+ * @brief      Releases the slot of a reader which will not read anymore.
+ *
+ * @param[in]  tree    The pointer to the read-mostly van Emde Boas tree.
+ * @param[in]  reader  The slot of the reader, -1 is ignored.
+ ******************************************************************************/
+void vEB_rcu_unregister ( TvEBRcu * tree, int reader );
+
+/***************************************************************************//**
+ * @brief      Inserts the given value into the given read-mostly tree.
+ *
+ * @param[in]  tree   The pointer to the read-mostly van Emde Boas tree.
+ * @param[in]  val    The value of the element to insert.
+ *
+ * @retval     true   Successfully inserted the value.
+ * @retval     false  Failed to insert the value.
+ ******************************************************************************/
+bool vEB_insert ( TvEBRcu * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Removes the given value from the given read-mostly tree.
+ *
+ * @param[in]  tree   The pointer to the read-mostly van Emde Boas tree.
+ * @param[in]  val    The value of the element to remove.
+ *
+ * @retval     true   Successfully removed the value.
+ * @retval     false  Failed to remove the value.
+ ******************************************************************************/
+bool vEB_delete ( TvEBRcu * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Finds the lowest value stored in the given read-mostly tree.
+ *
+ * @param[in]  tree    The pointer to the read-mostly van Emde Boas tree.
+ * @param[in]  reader  The slot of the reader, or -1.
+ * @param[out] res     The lowest element.
+ *
+ * @retval     true    Successfully found the minimum.
+ * @retval     false   The tree is empty.
+ ******************************************************************************/
+bool vEB_min ( TvEBRcu * tree, int reader, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the highest value stored in the given read-mostly tree.
+ *
+ * @param[in]  tree    The pointer to the read-mostly van Emde Boas tree.
+ * @param[in]  reader  The slot of the reader, or -1.
+ * @param[out] res     The highest element.
+ *
+ * @retval     true    Successfully found the maximum.
+ * @retval     false   The tree is empty.
+ ******************************************************************************/
+bool vEB_max ( TvEBRcu * tree, int reader, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds if the given value is in the given read-mostly tree.
+ *
+ * @param[in]  tree    The pointer to the read-mostly van Emde Boas tree.
+ * @param[in]  reader  The slot of the reader, or -1.
+ * @param[in]  val     The value of the element to find.
+ *
+ * @retval     true    Successfully found the element.
+ * @retval     false   Failed to found the element.
+ ******************************************************************************/
+bool vEB_find ( TvEBRcu * tree, int reader, int val );
+
+/***************************************************************************//**
+ * @brief      Finds the smallest value greater than the given value in the
+ *             given read-mostly tree.
+ *
+ * @param[in]  tree    The pointer to the read-mostly van Emde Boas tree.
+ * @param[in]  reader  The slot of the reader, or -1.
+ * @param[in]  val     The lower bound for the value of the sought element, -1
+ *                     finds the minimum.
+ * @param[out] res     The found element.
+ *
+ * @retval     true    Successfully found the successor.
+ * @retval     false   Failed to found the successor.
+ ******************************************************************************/
+bool vEB_succ ( TvEBRcu * tree, int reader, int val, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the largest value smaller than the given value in the
+ *             given read-mostly tree.
+ *
+ * @param[in]  tree    The pointer to the read-mostly van Emde Boas tree.
+ * @param[in]  reader  The slot of the reader, or -1.
+ * @param[in]  val     The upper bound for the value of the sought element, uni
+ *                     finds the maximum.
+ * @param[out] res     The found element.
+ *
+ * @retval     true    Successfully found the predecessor.
+ * @retval     false   Failed to found the predecessor.
+ ******************************************************************************/
+bool vEB_pred ( TvEBRcu * tree, int reader, int val, int & res );
+
+#endif /* __VEBCONC_H_918273645091827364509182736450918273645091827364509182__ */
@@ -0,0 +1,541 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebfile.cpp
+ *
+ * @brief      File containing definitions of the on-disk image of a Van Emde
+ *             Boas tree, which can be searched directly in a mapped file.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "vebfile.hpp"
+
+/***************************************************************************//**
+ * @brief      Struct containing the image being written.
+ ******************************************************************************/
+struct TvEBImageWriter
+{
+  /*************************************************************************//**
+   * @brief      The leaf bitmaps.
+   ****************************************************************************/
+  std::vector<uint64_t> leaves;
+
+  /*************************************************************************//**
+   * @brief      The inner node records.
+   ****************************************************************************/
+  std::vector<uint64_t> nodes;
+
+  /*************************************************************************//**
+   * @brief      The offset of the first leaf bitmap.
+   ****************************************************************************/
+  uint64_t leafBase;
+
+  /*************************************************************************//**
+   * @brief      The offset of the first inner node record.
+   ****************************************************************************/
+  uint64_t nodeBase;
+};
+
+/***************************************************************************//**
+ * @brief      Returns the number of leaves of the given tree.
+ ******************************************************************************/
+static uint64_t countLeaves ( const TvEB * tree )
+{
+  if ( !tree ) return 0;
+  if ( tree->uni <= VEB_LEAF_UNI ) return 1;
+
+  // the leaf summary and clusters are bare words of the node
+  uint64_t cnt = tree->higherUniSqrt() <= VEB_LEAF_UNI ? tree->summaryBits != 0
+                 : countLeaves ( tree->summary );
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ); )
+  {
+    cnt += tree->lowerUniSqrt() <= VEB_LEAF_UNI ? 1 : countLeaves ( vEB_cluster ( tree, i ) );
+  }
+  return cnt;
+}
+
+/***************************************************************************//**
+ * @brief      Appends the given non-empty leaf word to the image and returns
+ *             its offset.
+ ******************************************************************************/
+static uint64_t saveLeaf ( uint64_t word, TvEBImageWriter & w )
+{
+  w.leaves.push_back ( word );
+  return w.leafBase + 8 * ( w.leaves.size() - 1 );
+}
+
+/***************************************************************************//**
+ * @brief      Appends the given non-empty tree to the image, the children
+ *             first, and returns its offset.
+ ******************************************************************************/
+static uint64_t saveTree ( const TvEB * tree, TvEBImageWriter & w )
+{
+  if ( !tree ) return 0;
+  if ( tree->uni <= VEB_LEAF_UNI ) return saveLeaf ( tree->bits, w );
+
+  std::vector<uint32_t> highs;
+  std::vector<uint64_t> refs;
+  for ( int i = -1; vEB_cluster_succ ( tree, i, i ); )
+  {
+    highs.push_back ( i );
+    refs.push_back ( tree->lowerUniSqrt() <= VEB_LEAF_UNI ? saveLeaf ( vEB_leaf ( tree, i ), w )
+                     : saveTree ( vEB_cluster ( tree, i ), w ) );
+  }
+  uint64_t summary = tree->higherUniSqrt() > VEB_LEAF_UNI ? saveTree ( tree->summary, w )
+                     : tree->summaryBits ? saveLeaf ( tree->summaryBits, w ) : 0;
+
+  size_t cnt = highs.size();
+  bool table = ( size_t ) tree->higherUniSqrt() <= cnt + ( cnt + 1 ) / 2;
+  uint64_t offset = w.nodeBase + 8 * w.nodes.size();
+  w.nodes.push_back ( ( uint32_t ) tree->min | ( uint64_t ) ( uint32_t ) tree->max << 32 );
+  w.nodes.push_back ( cnt | ( uint64_t ) ( table ? VEB_IMAGE_TABLE : VEB_IMAGE_KEYS ) << 32 );
+  w.nodes.push_back ( tree->size );
+  w.nodes.push_back ( summary );
+  if ( table )
+  {
+    size_t start = w.nodes.size();
+    w.nodes.resize ( start + tree->higherUniSqrt(), 0 );
+    for ( size_t k = 0; k < cnt; ++k ) w.nodes[start + highs[k]] = refs[k];
+    return offset;
+  }
+  w.nodes.insert ( w.nodes.end(), refs.begin(), refs.end() );
+  for ( size_t k = 0; k < cnt; k += 2 )
+  {
+    w.nodes.push_back ( highs[k] | ( k + 1 < cnt ? ( uint64_t ) highs[k + 1] << 32 : 0 ) );
+  }
+  return offset;
+}
+
+bool vEB_save ( const TvEB * tree, const char * path )
+{
+  if ( !tree || !path ) return false;
+
+  TvEBImageHeader header;
+  std::memset ( &header, 0, sizeof ( header ) );
+  header.magic = VEB_IMAGE_MAGIC;
+  header.version = VEB_IMAGE_VERSION;
+  header.uni = tree->uni;
+
+  TvEBImageWriter w;
+  bool empty = tree->uni <= VEB_LEAF_UNI ? !tree->bits : tree->min == UNDEFINED;
+  header.leafCnt = empty ? 0 : countLeaves ( tree );
+  header.leaves = w.leafBase = sizeof ( header );
+  w.nodeBase = w.leafBase + 8 * header.leafCnt;
+  if ( !empty )
+  {
+    w.leaves.reserve ( header.leafCnt );
+    header.root = saveTree ( tree, w );
+    header.size = tree->uni <= VEB_LEAF_UNI ? __builtin_popcountll ( tree->bits ) : tree->size;
+  }
+  header.bytes = w.nodeBase + 8 * w.nodes.size();
+
+  // the image replaces the file at once, a reader never sees half of it
+  std::string tmp = std::string ( path ) + ".tmp";
+  FILE * f = fopen ( tmp.c_str(), "wb" );
+  if ( !f )
+  {
+    std::cerr << "failed to create " << tmp << std::endl;
+    return false;
+  }
+  bool ok = fwrite ( &header, sizeof ( header ), 1, f ) == 1
+            && ( w.leaves.empty() || fwrite ( w.leaves.data(), 8, w.leaves.size(), f ) == w.leaves.size() )
+            && ( w.nodes.empty() || fwrite ( w.nodes.data(), 8, w.nodes.size(), f ) == w.nodes.size() );
+  ok = fflush ( f ) == 0 && fsync ( fileno ( f ) ) == 0 && ok;
+  ok = fclose ( f ) == 0 && ok;
+  if ( !ok || rename ( tmp.c_str(), path ) )
+  {
+    std::cerr << "failed to write " << path << std::endl;
+    remove ( tmp.c_str() );
+    return false;
+  }
+
+  // the new name is durable only once its directory is
+  std::string dir ( path );
+  size_t slash = dir.rfind ( '/' );
+  dir = slash == std::string::npos ? "." : slash ? dir.substr ( 0, slash ) : "/";
+  int fd = open ( dir.c_str(), O_RDONLY );
+  ok = fd >= 0 && fsync ( fd ) == 0;
+  if ( fd >= 0 ) close ( fd );
+  if ( !ok )
+  {
+    std::cerr << "failed to sync the directory of " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Checks the given subtree over 2^bits elements of the image: every
+ *             offset points to a whole record of the right kind inside the
+ *             file, every value and cluster index lies in its universe and
+ *             the records visited so far take at most the given number of
+ *             words, which bounds the work of an image whose nodes share
+ *             children or refer to themselves.
+ ******************************************************************************/
+static bool imageCheck ( const TvEBImage * image, uint64_t ref, int bits, uint64_t & words )
+{
+  if ( !ref ) return true;
+  const TvEBImageHeader * header = ( const TvEBImageHeader * ) image->words;
+  uint64_t leafEnd = header->leaves + 8 * header->leafCnt;
+  if ( ref % 8 ) return false;
+  if ( bits <= 6 )
+  {
+    if ( ref < header->leaves || ref >= leafEnd || !words ) return false;
+    words--;
+    uint64_t word = image->words[ref / 8];
+    return word && ( bits == 6 || ! ( word >> ( 1 << bits ) ) );
+  }
+  if ( ref < leafEnd || ref >= image->bytes || image->bytes - ref < 32 ) return false;
+
+  const uint64_t * node = image->words + ref / 8;
+  uint32_t min = ( uint32_t ) node[0], max = ( uint32_t ) ( node[0] >> 32 );
+  uint32_t cnt = ( uint32_t ) node[1];
+  int lowBits = bits / 2;
+  uint32_t highCnt = 1u << ( bits - lowBits );
+  if ( min > max || max >> bits || cnt > highCnt ) return false;
+  uint64_t len = node[1] >> 32 == VEB_IMAGE_TABLE ? 4 + highCnt
+                 : node[1] >> 32 == VEB_IMAGE_KEYS ? 4 + cnt + ( cnt + 1 ) / 2 : 0;
+  if ( !len || ( image->bytes - ref ) / 8 < len || words < len ) return false;
+  words -= len;
+  if ( !imageCheck ( image, node[3], bits - lowBits, words ) ) return false;
+
+  if ( node[1] >> 32 == VEB_IMAGE_TABLE )
+  {
+    for ( uint32_t i = 0; i < highCnt; ++i )
+    {
+      if ( !imageCheck ( image, node[4 + i], lowBits, words ) ) return false;
+    }
+    return true;
+  }
+  const uint32_t * keys = ( const uint32_t * ) ( node + 4 + cnt );
+  for ( uint32_t k = 0; k < cnt; ++k )
+  {
+    if ( keys[k] >= highCnt || ( k && keys[k] <= keys[k - 1] ) ) return false;
+    if ( !imageCheck ( image, node[4 + k], lowBits, words ) ) return false;
+  }
+  return true;
+}
+
+TvEBImage * vEB_image_open ( const char * path )
+{
+  int fd = open ( path, O_RDONLY );
+  if ( fd < 0 ) return NULL;
+
+  struct stat st;
+  void * map = MAP_FAILED;
+  if ( !fstat ( fd, &st ) && ( size_t ) st.st_size >= sizeof ( TvEBImageHeader ) )
+  {
+    map = mmap ( NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+  }
+  close ( fd );
+  if ( map == MAP_FAILED ) return NULL;
+
+  const TvEBImageHeader * header = ( const TvEBImageHeader * ) map;
+  if ( header->magic != VEB_IMAGE_MAGIC || header->version != VEB_IMAGE_VERSION
+       || header->bytes != ( uint64_t ) st.st_size || !header->uni
+       || header->uni & ( header->uni - 1 ) || header->uni > ( 1u << 30 )
+       || header->root % 8 || header->root >= header->bytes || header->size > header->uni
+       || header->leaves < sizeof ( TvEBImageHeader ) || header->leafCnt > header->bytes / 8
+       || header->leaves + 8 * header->leafCnt > header->bytes )
+  {
+    std::cerr << path << " is not a vEB image of version " << VEB_IMAGE_VERSION << std::endl;
+    munmap ( map, st.st_size );
+    return NULL;
+  }
+
+  TvEBImage * image = new TvEBImage;
+  image->words = ( const uint64_t * ) map;
+  image->bytes = st.st_size;
+  image->uni = header->uni;
+
+  // the searches trust the offsets, so all of them are checked once here
+  uint64_t words = image->bytes / 8;
+  if ( !imageCheck ( image, header->root, log2Int ( image->uni ), words ) )
+  {
+    std::cerr << "vEB image " << path << " is damaged" << std::endl;
+    vEB_image_close ( image );
+    return NULL;
+  }
+  return image;
+}
+
+void vEB_image_close ( TvEBImage * image )
+{
+  if ( !image ) return;
+  munmap ( ( void * ) image->words, image->bytes );
+  delete image;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the offset of the cluster of the given index of the
+ *             given inner node, or 0.
+ ******************************************************************************/
+static inline uint64_t imageCluster ( const uint64_t * node, int high )
+{
+  uint32_t cnt = ( uint32_t ) node[1];
+  if ( node[1] >> 32 == VEB_IMAGE_TABLE ) return node[4 + high];
+
+  const uint32_t * keys = ( const uint32_t * ) ( node + 4 + cnt );
+  const uint32_t * key = std::lower_bound ( keys, keys + cnt, ( uint32_t ) high );
+  return key != keys + cnt && *key == ( uint32_t ) high ? node[4 + ( key - keys )] : 0;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the minimum of the given subtree over 2^bits elements.
+ ******************************************************************************/
+static inline bool imageMin ( const TvEBImage * image, uint64_t ref, int bits, int & res )
+{
+  if ( !ref ) return false;
+  const uint64_t * node = image->words + ref / 8;
+  if ( bits <= 6 )
+  {
+    if ( !*node ) return false;
+    res = __builtin_ctzll ( *node );
+    return true;
+  }
+  res = ( int ) ( uint32_t ) node[0];
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the maximum of the given subtree over 2^bits elements.
+ ******************************************************************************/
+static inline bool imageMax ( const TvEBImage * image, uint64_t ref, int bits, int & res )
+{
+  if ( !ref ) return false;
+  const uint64_t * node = image->words + ref / 8;
+  if ( bits <= 6 )
+  {
+    if ( !*node ) return false;
+    res = 63 - __builtin_clzll ( *node );
+    return true;
+  }
+  res = ( int ) ( node[0] >> 32 );
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the value in the given subtree over 2^bits elements.
+ ******************************************************************************/
+static bool imageFind ( const TvEBImage * image, uint64_t ref, int bits, int val )
+{
+  for ( ;; )
+  {
+    if ( !ref ) return false;
+    const uint64_t * node = image->words + ref / 8;
+    if ( bits <= 6 ) return ( *node >> val ) & 1;
+
+    int min = ( int ) ( uint32_t ) node[0];
+    int max = ( int ) ( node[0] >> 32 );
+    if ( val == min || val == max ) return true;
+    if ( val < min || val > max ) return false;
+    int lowBits = bits / 2;
+    ref = imageCluster ( node, val >> lowBits );
+    val &= ( 1 << lowBits ) - 1;
+    bits = lowBits;
+  }
+}
+
+/***************************************************************************//**
+ * @brief      Finds the successor in the given subtree over 2^bits elements.
+ ******************************************************************************/
+static bool imageSucc ( const TvEBImage * image, uint64_t ref, int bits, int val, int & res )
+{
+  if ( !ref ) return false;
+  const uint64_t * node = image->words + ref / 8;
+  if ( bits <= 6 )
+  {
+    uint64_t word = *node;
+    if ( val >= 0 ) word = val < 63 ? word & ( ~ ( uint64_t ) 1 << val ) : 0;
+    if ( !word ) return false;
+    res = __builtin_ctzll ( word );
+    return true;
+  }
+
+  int min = ( int ) ( uint32_t ) node[0];
+  int max = ( int ) ( node[0] >> 32 );
+  if ( val < min )
+  {
+    res = min;
+    return true;
+  }
+  if ( val >= max ) return false;
+  if ( !node[3] )
+  {
+    res = max;
+    return true;
+  }
+
+  int lowBits = bits / 2;
+  int high = val >> lowBits;
+  int low = val & ( ( 1 << lowBits ) - 1 );
+  int tmp;
+  uint64_t cluster = imageCluster ( node, high );
+  if ( imageMax ( image, cluster, lowBits, tmp ) && low < tmp )
+  {
+    if ( !imageSucc ( image, cluster, lowBits, low, tmp ) ) return false;
+    res = ( high << lowBits ) | tmp;
+    return true;
+  }
+  if ( !imageSucc ( image, node[3], bits - lowBits, high, high ) ) return false;
+  if ( !imageMin ( image, imageCluster ( node, high ), lowBits, tmp ) ) return false;
+  res = ( high << lowBits ) | tmp;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the predecessor in the given subtree over 2^bits elements.
+ ******************************************************************************/
+static bool imagePred ( const TvEBImage * image, uint64_t ref, int bits, int val, int & res )
+{
+  if ( !ref ) return false;
+  const uint64_t * node = image->words + ref / 8;
+  if ( bits <= 6 )
+  {
+    uint64_t word = *node;
+    if ( val < 64 ) word &= ( ( uint64_t ) 1 << val ) - 1;
+    if ( !word ) return false;
+    res = 63 - __builtin_clzll ( word );
+    return true;
+  }
+
+  int min = ( int ) ( uint32_t ) node[0];
+  int max = ( int ) ( node[0] >> 32 );
+  if ( val > max )
+  {
+    res = max;
+    return true;
+  }
+  if ( val <= min ) return false;
+  if ( !node[3] )
+  {
+    res = min;
+    return true;
+  }
+
+  int lowBits = bits / 2;
+  int high = val >> lowBits;
+  int low = val & ( ( 1 << lowBits ) - 1 );
+  int tmp;
+  uint64_t cluster = imageCluster ( node, high );
+  if ( imageMin ( image, cluster, lowBits, tmp ) && low > tmp )
+  {
+    if ( !imagePred ( image, cluster, lowBits, low, tmp ) ) return false;
+    res = ( high << lowBits ) | tmp;
+    return true;
+  }
+  if ( !imagePred ( image, node[3], bits - lowBits, high, high ) )
+  {
+    // the minimum is kept only in the node
+    res = min;
+    return true;
+  }
+  if ( !imageMax ( image, imageCluster ( node, high ), lowBits, tmp ) ) return false;
+  res = ( high << lowBits ) | tmp;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Appends the elements of the given subtree over 2^bits elements
+ *             increased by base to vals, in increasing order.
+ ******************************************************************************/
+static void imageCollect ( const TvEBImage * image, uint64_t ref, int bits, int base,
+                           std::vector<int> & vals )
+{
+  if ( !ref ) return;
+  const uint64_t * node = image->words + ref / 8;
+  if ( bits <= 6 )
+  {
+    for ( uint64_t word = *node; word; word &= word - 1 )
+    {
+      vals.push_back ( base + __builtin_ctzll ( word ) );
+    }
+    return;
+  }
+
+  vals.push_back ( base + ( int ) ( uint32_t ) node[0] );
+  int lowBits = bits / 2;
+  uint32_t cnt = ( uint32_t ) node[1];
+  if ( node[1] >> 32 == VEB_IMAGE_TABLE )
+  {
+    for ( int i = 0; i < 1 << ( bits - lowBits ); ++i )
+    {
+      imageCollect ( image, node[4 + i], lowBits, base + ( i << lowBits ), vals );
+    }
+    return;
+  }
+  const uint32_t * keys = ( const uint32_t * ) ( node + 4 + cnt );
+  for ( uint32_t k = 0; k < cnt; ++k )
+  {
+    imageCollect ( image, node[4 + k], lowBits, base + ( keys[k] << lowBits ), vals );
+  }
+}
+
+TvEB * vEB_load ( const char * path, TvEBArena * arena, int flags )
+{
+  TvEBImage * image = vEB_image_open ( path );
+  if ( !image ) return NULL;
+
+  std::vector<int> vals;
+  vals.reserve ( ( ( const TvEBImageHeader * ) image->words )->size );
+  imageCollect ( image, ( ( const TvEBImageHeader * ) image->words )->root,
+                 log2Int ( image->uni ), 0, vals );
+  TvEB * tree = vEB_build_from_sorted ( vals.data(), vals.size(), image->uni, arena, flags );
+  vEB_image_close ( image );
+  return tree;
+}
+
+bool vEB_min ( const TvEBImage * image, int & res )
+{
+  if ( !image ) return false;
+  return imageMin ( image, ( ( const TvEBImageHeader * ) image->words )->root,
+                    log2Int ( image->uni ), res );
+}
+
+bool vEB_max ( const TvEBImage * image, int & res )
+{
+  if ( !image ) return false;
+  return imageMax ( image, ( ( const TvEBImageHeader * ) image->words )->root,
+                    log2Int ( image->uni ), res );
+}
+
+bool vEB_find ( const TvEBImage * image, int val )
+{
+  if ( !image ) return false;
+  if ( val < 0 || val >= image->uni ) return false;
+  return imageFind ( image, ( ( const TvEBImageHeader * ) image->words )->root,
+                     log2Int ( image->uni ), val );
+}
+
+bool vEB_succ ( const TvEBImage * image, int val, int & res )
+{
+  if ( !image ) return false;
+  if ( val < -1 || val >= image->uni ) return false;
+  return imageSucc ( image, ( ( const TvEBImageHeader * ) image->words )->root,
+                     log2Int ( image->uni ), val, res );
+}
+
+bool vEB_pred ( const TvEBImage * image, int val, int & res )
+{
+  if ( !image ) return false;
+  if ( val < 0 || val > image->uni ) return false;
+  return imagePred ( image, ( ( const TvEBImageHeader * ) image->words )->root,
+                     log2Int ( image->uni ), val, res );
+}
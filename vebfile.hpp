@@ -0,0 +1,243 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebfile.hpp
+ *
+ * @brief      File containing declarations of the on-disk image of a Van Emde
+ *             Boas tree, which can be searched directly in a mapped file.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBFILE_H_673498126734981267349812673498126734981267349812673498__
+#define __VEBFILE_H_673498126734981267349812673498126734981267349812673498__
+
+#include "veb.hpp"
+
+/***************************************************************************//**
+ * @brief      The first word of an image, "vEBimage" read as a little endian
+ *             word, which also tells a byte-swapped file apart.
+ ******************************************************************************/
+#define VEB_IMAGE_MAGIC 0x6567616d69424576ULL
+
+/***************************************************************************//**
+ * @brief      The version of the image format written by vEB_save.
+ ******************************************************************************/
+#define VEB_IMAGE_VERSION 1
+
+/***************************************************************************//**
+ * @brief      Struct containing the header of an image.
+ *
+ * @details    An image is the header, followed by the bitmaps of all the
+ *             leaves in one contiguous run of words and then by the records of
+ *             the inner nodes, every child written before its parent. Nodes
+ *             refer to each other by byte offsets from the start of the image,
+ *             0 standing for no node, so the image is valid at any address.
+ *             Whether an offset points to a leaf follows from the universe of
+ *             the node, which halves the bits of its parent's as in TvEB.
+ *
+ *             An inner node record is the words
+ *             - the minimum in the low and the maximum in the high 32 bits,
+ *             - the number of non-empty clusters in the low and the layout in
+ *               the high 32 bits,
+ *             - the number of elements,
+ *             - the offset of the summary,
+ *             - for VEB_IMAGE_TABLE one offset for every cluster index, for
+ *               VEB_IMAGE_KEYS the offsets of the non-empty clusters followed
+ *               by their increasing indices packed two in a word, whichever
+ *               is smaller.
+ ******************************************************************************/
+struct TvEBImageHeader
+{
+  /*************************************************************************//**
+   * @brief      VEB_IMAGE_MAGIC.
+   ****************************************************************************/
+  uint64_t magic;
+
+  /*************************************************************************//**
+   * @brief      The version of the format.
+   ****************************************************************************/
+  uint32_t version;
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  uint32_t uni;
+
+  /*************************************************************************//**
+   * @brief      The number of elements.
+   ****************************************************************************/
+  uint64_t size;
+
+  /*************************************************************************//**
+   * @brief      The offset of the root, 0 for an empty tree.
+   ****************************************************************************/
+  uint64_t root;
+
+  /*************************************************************************//**
+   * @brief      The offset of the first leaf bitmap.
+   ****************************************************************************/
+  uint64_t leaves;
+
+  /*************************************************************************//**
+   * @brief      The number of the leaf bitmaps.
+   ****************************************************************************/
+  uint64_t leafCnt;
+
+  /*************************************************************************//**
+   * @brief      The size of the whole image in bytes.
+   ****************************************************************************/
+  uint64_t bytes;
+
+  /*************************************************************************//**
+   * @brief      Reserved for later versions, 0.
+   ****************************************************************************/
+  uint64_t reserved;
+};
+
+/***************************************************************************//**
+ * @brief      The layout of an inner node with a full array of cluster offsets.
+ ******************************************************************************/
+#define VEB_IMAGE_TABLE 0
+
+/***************************************************************************//**
+ * @brief      The layout of an inner node with the sorted non-empty clusters.
+ ******************************************************************************/
+#define VEB_IMAGE_KEYS 1
+
+/***************************************************************************//**
+ * @brief      Struct containing an image opened read-only.
+ ******************************************************************************/
+struct TvEBImage
+{
+  /*************************************************************************//**
+   * @brief      The image, mapped from the file.
+   ****************************************************************************/
+  const uint64_t * words;
+
+  /*************************************************************************//**
+   * @brief      The size of the image in bytes.
+   ****************************************************************************/
+  size_t bytes;
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  int uni;
+};
+
+/***************************************************************************//**
+ * @brief      Writes the image of the given tree to the given file. The file
+ *             and its directory are synced before it returns.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  path   The path of the file, which is replaced.
+ *
+ * @retval     true   Successfully written the image.
+ * @retval     false  Failed to write the file.
+ ******************************************************************************/
+bool vEB_save ( const TvEB * tree, const char * path );
+
+/***************************************************************************//**
+ * @brief      Reads the image of the given file into a new tree.
+ *
+ * @param[in]  path   The path of the file.
+ * @param[in]  arena  The arena the tree is created from, or NULL.
+ * @param[in]  flags  The flags of the new tree.
+ *
+ * @return     The pointer to the new tree, or NULL when the file is not a
+ *             valid image.
+ ******************************************************************************/
+TvEB * vEB_load ( const char * path, TvEBArena * arena = NULL, int flags = 0 );
+
+/***************************************************************************//**
+ * @brief      Maps the image of the given file read-only, so that it can be
+ *             searched without reading it first. The pages are loaded on
+ *             demand and shared by all processes mapping the same file. All
+ *             the node records are checked once, so a damaged file is
+ *             rejected here instead of being read out of its bounds later.
+ *
+ * @param[in]  path   The path of the file.
+ *
+ * @return     The pointer to the opened image, or NULL when the file is not a
+ *             valid image.
+ ******************************************************************************/
+TvEBImage * vEB_image_open ( const char * path );
+
+/***************************************************************************//**
+ * @brief      Unmaps and frees the given image.
+ *
+ * @param[in]  image  The pointer to the image.
+ ******************************************************************************/
+void vEB_image_close ( TvEBImage * image );
+
+/***************************************************************************//**
+ * @brief      Finds the lowest value stored in the given image.
+ *
+ * @param[in]  image  The pointer to the image.
+ * @param[out] res    The lowest element.
+ *
+ * @retval     true   Successfully found the minimum.
+ * @retval     false  The image is empty.
+ ******************************************************************************/
+bool vEB_min ( const TvEBImage * image, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the highest value stored in the given image.
+ *
+ * @param[in]  image  The pointer to the image.
+ * @param[out] res    The highest element.
+ *
+ * @retval     true   Successfully found the maximum.
+ * @retval     false  The image is empty.
+ ******************************************************************************/
+bool vEB_max ( const TvEBImage * image, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds if the given value is in the given image.
+ *
+ * @param[in]  image  The pointer to the image.
+ * @param[in]  val    The value of the element to find.
+ *
+ * @retval     true   Successfully found the element.
+ * @retval     false  Failed to found the element.
+ ******************************************************************************/
+bool vEB_find ( const TvEBImage * image, int val );
+
+/***************************************************************************//**
+ * @brief      Finds the smallest value greater than the given value in the
+ *             given image.
+ *
+ * @param[in]  image  The pointer to the image.
+ * @param[in]  val    The lower bound for the value of the sought element, -1
+ *                    finds the minimum.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the successor.
+ * @retval     false  Failed to found the successor.
+ ******************************************************************************/
+bool vEB_succ ( const TvEBImage * image, int val, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the largest value smaller than the given value in the
+ *             given image.
+ *
+ * @param[in]  image  The pointer to the image.
+ * @param[in]  val    The upper bound for the value of the sought element, uni
+ *                    finds the maximum.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the predecessor.
+ * @retval     false  Failed to found the predecessor.
+ ******************************************************************************/
+bool vEB_pred ( const TvEBImage * image, int val, int & res );
+
+#endif /* __VEBFILE_H_673498126734981267349812673498126734981267349812673498__ */
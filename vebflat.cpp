@@ -0,0 +1,334 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebflat.cpp
+ *
+ * @brief      File containing definitions of a pointer-free Van Emde Boas tree
+ *             stored in one contiguous buffer.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include "vebflat.hpp"
+
+/***************************************************************************//**
+ * @brief      The header word of an empty tree, minimum 2^32 - 1 and maximum 0.
+ ******************************************************************************/
+static const uint64_t EMPTY_HEADER = 0xFFFFFFFFULL;
+
+static inline bool isLeaf ( int b )
+{
+  return ( 1 << b ) <= VEB_LEAF_UNI;
+}
+
+static inline uint64_t header ( int min, int max )
+{
+  return ( uint32_t ) min | ( ( uint64_t ) ( uint32_t ) max << 32 );
+}
+
+static inline bool isEmpty ( const TvEBFlat * tree, size_t off, int b )
+{
+  uint64_t word = tree->words[off];
+  return isLeaf ( b ) ? !word : ( uint32_t ) word > ( word >> 32 );
+}
+
+static inline int nodeMin ( const TvEBFlat * tree, size_t off, int b )
+{
+  uint64_t word = tree->words[off];
+  return isLeaf ( b ) ? __builtin_ctzll ( word ) : ( int ) ( uint32_t ) word;
+}
+
+static inline int nodeMax ( const TvEBFlat * tree, size_t off, int b )
+{
+  uint64_t word = tree->words[off];
+  return isLeaf ( b ) ? 63 - __builtin_clzll ( word ) : ( int ) ( word >> 32 );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the offset of the cluster high of the tree over 2^b
+ *             elements at the given offset. The summary is at offset + 1.
+ ******************************************************************************/
+static inline size_t clusterOff ( const TvEBFlat * tree, size_t off, int b, int high )
+{
+  return off + 1 + tree->nodeSize[b - b / 2] + high * tree->nodeSize[b / 2];
+}
+
+static void initNode ( TvEBFlat * tree, size_t off, int b )
+{
+  if ( isLeaf ( b ) )
+  {
+    tree->words[off] = 0;
+    return;
+  }
+  tree->words[off] = EMPTY_HEADER;
+  initNode ( tree, off + 1, b - b / 2 );
+  for ( int i = 0; i < 1 << ( b - b / 2 ); ++i )
+  {
+    initNode ( tree, clusterOff ( tree, off, b, i ), b / 2 );
+  }
+}
+
+TvEBFlat::TvEBFlat ( int uniSize )
+  : uni ( powTwoRoundUp ( uniSize ) ), uniBits ( log2Int ( uni ) )
+{
+  if ( uniSize <= 0 )
+  {
+    std::cerr << "universe size of TvEBFlat must be bigger than 0" << std::endl;
+  }
+
+  for ( int b = 0; b <= uniBits; ++b )
+  {
+    nodeSize[b] = isLeaf ( b ) ? 1
+                  : 1 + nodeSize[b - b / 2] + ( ( size_t ) 1 << ( b - b / 2 ) ) * nodeSize[b / 2];
+  }
+  words = new uint64_t [nodeSize[uniBits]];
+  initNode ( this, 0, uniBits );
+}
+
+TvEBFlat::~TvEBFlat()
+{
+  delete [] words;
+}
+
+static bool flatInsert ( TvEBFlat * tree, size_t off, int b, int val )
+{
+  if ( isLeaf ( b ) )
+  {
+    uint64_t bit = ( uint64_t ) 1 << val;
+    if ( tree->words[off] & bit ) return false;
+    tree->words[off] |= bit;
+    return true;
+  }
+
+  if ( isEmpty ( tree, off, b ) )
+  {
+    tree->words[off] = header ( val, val );
+    return true;
+  }
+
+  int min = nodeMin ( tree, off, b );
+  int max = nodeMax ( tree, off, b );
+  if ( val == min || val == max ) return false;
+
+  if ( val < min )
+  {
+    int tmp = val;
+    val = min;
+    min = tmp;
+  }
+  if ( val > max ) max = val;
+
+  int lowBits = b / 2;
+  int highVal = val >> lowBits;
+  size_t cluster = clusterOff ( tree, off, b, highVal );
+  if ( isEmpty ( tree, cluster, lowBits ) )
+  {
+    flatInsert ( tree, off + 1, b - lowBits, highVal );
+  }
+  if ( !flatInsert ( tree, cluster, lowBits, val & ( ( 1 << lowBits ) - 1 ) ) ) return false;
+
+  tree->words[off] = header ( min, max );
+  return true;
+}
+
+static bool flatDelete ( TvEBFlat * tree, size_t off, int b, int val )
+{
+  if ( isLeaf ( b ) )
+  {
+    uint64_t bit = ( uint64_t ) 1 << val;
+    if ( !( tree->words[off] & bit ) ) return false;
+    tree->words[off] &= ~bit;
+    return true;
+  }
+
+  if ( isEmpty ( tree, off, b ) ) return false;
+
+  int min = nodeMin ( tree, off, b );
+  int max = nodeMax ( tree, off, b );
+  if ( val < min || val > max ) return false;
+
+  if ( min == max )
+  {
+    tree->words[off] = EMPTY_HEADER;
+    return true;
+  }
+
+  int lowBits = b / 2;
+  int highBits = b - lowBits;
+  if ( val == min )
+  {
+    int i = nodeMin ( tree, off + 1, highBits );
+    val = min = ( i << lowBits ) | nodeMin ( tree, clusterOff ( tree, off, b, i ), lowBits );
+  }
+
+  int highVal = val >> lowBits;
+  size_t cluster = clusterOff ( tree, off, b, highVal );
+  if ( !flatDelete ( tree, cluster, lowBits, val & ( ( 1 << lowBits ) - 1 ) ) ) return false;
+  if ( isEmpty ( tree, cluster, lowBits ) )
+  {
+    flatDelete ( tree, off + 1, highBits, highVal );
+  }
+
+  if ( val == max )
+  {
+    if ( isEmpty ( tree, off + 1, highBits ) )
+    {
+      max = min;
+    }
+    else
+    {
+      int i = nodeMax ( tree, off + 1, highBits );
+      max = ( i << lowBits ) | nodeMax ( tree, clusterOff ( tree, off, b, i ), lowBits );
+    }
+  }
+
+  tree->words[off] = header ( min, max );
+  return true;
+}
+
+static bool flatFind ( const TvEBFlat * tree, size_t off, int b, int val )
+{
+  while ( !isLeaf ( b ) )
+  {
+    if ( isEmpty ( tree, off, b ) ) return false;
+    if ( val == nodeMin ( tree, off, b ) || val == nodeMax ( tree, off, b ) ) return true;
+    int lowBits = b / 2;
+    off = clusterOff ( tree, off, b, val >> lowBits );
+    val &= ( 1 << lowBits ) - 1;
+    b = lowBits;
+  }
+  return ( tree->words[off] >> val ) & 1;
+}
+
+static bool flatSucc ( const TvEBFlat * tree, size_t off, int b, int val, int & res )
+{
+  if ( isLeaf ( b ) )
+  {
+    uint64_t word = tree->words[off];
+    if ( val >= 0 ) word = val < 63 ? word & ( ~ ( uint64_t ) 1 << val ) : 0;
+    if ( !word ) return false;
+    res = __builtin_ctzll ( word );
+    return true;
+  }
+
+  if ( isEmpty ( tree, off, b ) ) return false;
+
+  int min = nodeMin ( tree, off, b );
+  if ( val < min )
+  {
+    res = min;
+    return true;
+  }
+  if ( val >= nodeMax ( tree, off, b ) ) return false;
+
+  int lowBits = b / 2;
+  int highVal = val >> lowBits;
+  int lowVal = val & ( ( 1 << lowBits ) - 1 );
+  size_t cluster = clusterOff ( tree, off, b, highVal );
+  if ( !isEmpty ( tree, cluster, lowBits ) && lowVal < nodeMax ( tree, cluster, lowBits ) )
+  {
+    flatSucc ( tree, cluster, lowBits, lowVal, res );
+    res |= highVal << lowBits;
+    return true;
+  }
+
+  int i;
+  if ( !flatSucc ( tree, off + 1, b - lowBits, highVal, i ) ) return false;
+  res = ( i << lowBits ) | nodeMin ( tree, clusterOff ( tree, off, b, i ), lowBits );
+  return true;
+}
+
+static bool flatPred ( const TvEBFlat * tree, size_t off, int b, int val, int & res )
+{
+  if ( isLeaf ( b ) )
+  {
+    uint64_t word = tree->words[off];
+    if ( val < 64 ) word = val > 0 ? word & ( ( ( uint64_t ) 1 << val ) - 1 ) : 0;
+    if ( !word ) return false;
+    res = 63 - __builtin_clzll ( word );
+    return true;
+  }
+
+  if ( isEmpty ( tree, off, b ) ) return false;
+
+  int max = nodeMax ( tree, off, b );
+  if ( val > max )
+  {
+    res = max;
+    return true;
+  }
+  int min = nodeMin ( tree, off, b );
+  if ( val <= min ) return false;
+
+  int lowBits = b / 2;
+  int highVal = val >> lowBits;
+  int lowVal = val & ( ( 1 << lowBits ) - 1 );
+  size_t cluster = clusterOff ( tree, off, b, highVal );
+  if ( !isEmpty ( tree, cluster, lowBits ) && lowVal > nodeMin ( tree, cluster, lowBits ) )
+  {
+    flatPred ( tree, cluster, lowBits, lowVal, res );
+    res |= highVal << lowBits;
+    return true;
+  }
+
+  int i;
+  if ( !flatPred ( tree, off + 1, b - lowBits, highVal, i ) )
+  {
+    res = min;
+    return true;
+  }
+  res = ( i << lowBits ) | nodeMax ( tree, clusterOff ( tree, off, b, i ), lowBits );
+  return true;
+}
+
+bool vEB_min ( TvEBFlat * tree, int & res )
+{
+  if ( !tree || isEmpty ( tree, 0, tree->uniBits ) ) return false;
+  res = nodeMin ( tree, 0, tree->uniBits );
+  return true;
+}
+
+bool vEB_max ( TvEBFlat * tree, int & res )
+{
+  if ( !tree || isEmpty ( tree, 0, tree->uniBits ) ) return false;
+  res = nodeMax ( tree, 0, tree->uniBits );
+  return true;
+}
+
+bool vEB_insert ( TvEBFlat * tree, int val )
+{
+  if ( !tree || val < 0 || val >= tree->uni ) return false;
+  return flatInsert ( tree, 0, tree->uniBits, val );
+}
+
+bool vEB_delete ( TvEBFlat * tree, int val )
+{
+  if ( !tree || val < 0 || val >= tree->uni ) return false;
+  return flatDelete ( tree, 0, tree->uniBits, val );
+}
+
+bool vEB_find ( TvEBFlat * tree, int val )
+{
+  if ( !tree || val < 0 || val >= tree->uni ) return false;
+  return flatFind ( tree, 0, tree->uniBits, val );
+}
+
+bool vEB_succ ( TvEBFlat * tree, int val, int & res )
+{
+  if ( !tree || val < -1 || val >= tree->uni ) return false;
+  return flatSucc ( tree, 0, tree->uniBits, val, res );
+}
+
+bool vEB_pred ( TvEBFlat * tree, int val, int & res )
+{
+  if ( !tree || val < 0 || val > tree->uni ) return false;
+  return flatPred ( tree, 0, tree->uniBits, val, res );
+}
@@ -0,0 +1,159 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebflat.hpp
+ *
+ * @brief      File containing declarations of a pointer-free Van Emde Boas
+ *             tree stored in one contiguous buffer.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBFLAT_H_239847523984752398475239847523984752398475239847523984__
+#define __VEBFLAT_H_239847523984752398475239847523984752398475239847523984__
+
+#include "veb.hpp"
+
+/***************************************************************************//**
+ * @brief      Struct containing the Van Emde Boas tree in a flat layout.
+ *
+ * @details    Holds the same recursive structure as TvEB, with every summary
+ *             and every cluster present, so the position of each subtree is
+ *             implied by its parent's and nothing has to be pointed to. A
+ *             tree over 2^b elements with b > log_2 ( VEB_LEAF_UNI ) is one
+ *             header word (the minimum in the low and the maximum in the high
+ *             32 bits, an empty tree has minimum > maximum), followed by its
+ *             summary over 2^ceil ( b / 2 ) elements and then by all its
+ *             2^ceil ( b / 2 ) clusters over 2^floor ( b / 2 ) elements each.
+ *             A leaf is a single bitmap word as in TvEB. The whole tree is
+ *             allocated once by the constructor, it takes about uni / 8 bytes
+ *             regardless of how many elements are stored, so it is meant for
+ *             densely populated universes up to about 2^26.
+ ******************************************************************************/
+struct TvEBFlat
+{
+  /*************************************************************************//**
+   * @brief      Constructor.
+   *
+   * @param[in]  uniSize  The size of the tree universe
+   ****************************************************************************/
+  TvEBFlat ( int uniSize );
+
+  /*************************************************************************//**
+   * @brief      Destructor.
+   ****************************************************************************/
+  ~TvEBFlat();
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  const int uni;
+
+  /*************************************************************************//**
+   * @brief      The binary logarithm of the universe size.
+   ****************************************************************************/
+  const int uniBits;
+
+  /*************************************************************************//**
+   * @brief      The number of words of a tree over 2^b elements, indexed by b.
+   ****************************************************************************/
+  size_t nodeSize[32];
+
+  /*************************************************************************//**
+   * @brief      The buffer holding the whole tree, the root starts at 0.
+   ****************************************************************************/
+  uint64_t * words;
+};
+
+/***************************************************************************//**
+ * @brief      Finds the lowest value stored in the given tree.
+ *
+ * @param[in]  tree   The pointer to the flat van Emde Boas tree.
+ * @param[out] res    The lowest element.
+ *
+ * @retval     true   Successfully found the minimum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+bool vEB_min ( TvEBFlat * tree, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the highest value stored in the given tree.
+ *
+ * @param[in]  tree   The pointer to the flat van Emde Boas tree.
+ * @param[out] res    The highest element.
+ *
+ * @retval     true   Successfully found the maximum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+bool vEB_max ( TvEBFlat * tree, int & res );
+
+/***************************************************************************//**
+ * @brief      Inserts the given value into the given flat vEB tree.
+ *
+ * @param[in]  tree   The pointer to the flat van Emde Boas tree.
+ * @param[in]  val    The value of the element to insert.
+ *
+ * @retval     true   Successfully inserted the value.
+ * @retval     false  Failed to insert the value.
+ ******************************************************************************/
+bool vEB_insert ( TvEBFlat * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Removes the given value from the given flat vEB tree.
+ *
+ * @param[in]  tree   The pointer to the flat van Emde Boas tree.
+ * @param[in]  val    The value of the element to remove.
+ *
+ * @retval     true   Successfully removed the value.
+ * @retval     false  Failed to remove the value.
+ ******************************************************************************/
+bool vEB_delete ( TvEBFlat * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Finds if the given value is in the given flat vEB tree.
+ *
+ * @param[in]  tree   The pointer to the flat van Emde Boas tree.
+ * @param[in]  val    The value of the element to find.
+ *
+ * @retval     true   Successfully found the element.
+ * @retval     false  Failed to found the element.
+ ******************************************************************************/
+bool vEB_find ( TvEBFlat * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Finds the smallest value greater than the given value in the
+ *             given flat tree.
+ *
+ * @param[in]  tree   The pointer to the flat van Emde Boas tree.
+ * @param[in]  val    The lower bound for the value of the sought element, -1
+ *                    finds the minimum.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the successor.
+ * @retval     false  Failed to found the successor.
+ ******************************************************************************/
+bool vEB_succ ( TvEBFlat * tree, int val, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the largest value smaller than the given value in the
+ *             given flat tree.
+ *
+ * @param[in]  tree   The pointer to the flat van Emde Boas tree.
+ * @param[in]  val    The upper bound for the value of the sought element, uni
+ *                    finds the maximum.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the predecessor.
+ * @retval     false  Failed to found the predecessor.
+ ******************************************************************************/
+bool vEB_pred ( TvEBFlat * tree, int val, int & res );
+
+#endif /* __VEBFLAT_H_239847523984752398475239847523984752398475239847523984__ */
@@ -0,0 +1,650 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebmap.hpp
+ *
+ * @brief      File containing a class template implementing an ordered map on
+ *             top of the Van Emde Boas tree data structure.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBMAP_H_564738291056473829105647382910564738291056473829105647__
+#define __VEBMAP_H_564738291056473829105647382910564738291056473829105647__
+
+#include "veb.hpp"
+
+/***************************************************************************//**
+ * @brief      Struct template containing the Van Emde Boas tree which maps
+ *             its keys to values of type V.
+ *
+ * @details    It has the recursive structure of TvEB. A tree that is not a
+ *             leaf keeps the value of its minimum in minVal, next to the
+ *             minimum itself, which is stored in no cluster. Every other
+ *             value lives in the leaf holding its key, where the values are
+ *             kept in key order, so the value of a key is found by counting
+ *             the smaller keys of the leaf's bitmap. The summary only needs
+ *             the keys and is a plain TvEB. Find, succ and pred return the
+ *             value from the same traversal that finds the key. V has to be
+ *             default constructible and assignable.
+ ******************************************************************************/
+template <typename V>
+struct TvEBMap
+{
+  /*************************************************************************//**
+   * @brief      Constructor.
+   *
+   * @param[in]  uniSize  The size of the tree universe
+   ****************************************************************************/
+  TvEBMap ( int uniSize )
+    : uni ( powTwoRoundUp ( uniSize ) ), lowBits ( log2Int ( uni ) / 2 ),
+      lowMask ( ( 1 << lowBits ) - 1 ), higherUniSqrt ( uni >> lowBits ),
+      min ( UNDEFINED ), max ( UNDEFINED ), summary ( NULL ), cluster ( NULL ),
+      bits ( 0 ), vals ( NULL ), valCap ( 0 )
+  {
+    if ( uniSize <= 0 )
+    {
+      std::cerr << "universe size of TvEBMap must be bigger than 0" << std::endl;
+      return;
+    }
+
+    if ( uni > VEB_LEAF_UNI )
+    {
+      cluster = new TvEBMap<V> * [higherUniSqrt]();
+    }
+  }
+
+  /*************************************************************************//**
+   * @brief      Destructor.
+   ****************************************************************************/
+  ~TvEBMap()
+  {
+    if ( summary ) delete summary;
+    if ( cluster )
+    {
+      for ( int i = 0; i < higherUniSqrt; ++i )
+      {
+        if ( cluster[i] ) delete cluster[i];
+      }
+      delete [] cluster;
+    }
+    delete [] vals;
+  }
+
+  /*************************************************************************//**
+   * @brief      Returns the position of the leaf's element in vals.
+   ****************************************************************************/
+  int rank ( int val ) const
+  {
+    return __builtin_popcountll ( bits & ( ( ( uint64_t ) 1 << val ) - 1 ) );
+  }
+
+  /*************************************************************************//**
+   * @brief      Returns the value of the minimum of a non-empty tree.
+   ****************************************************************************/
+  V & minValue()
+  {
+    return cluster ? minVal : vals[0];
+  }
+
+  /*************************************************************************//**
+   * @brief      Returns the value of the maximum of a non-empty tree.
+   ****************************************************************************/
+  V & maxValue()
+  {
+    TvEBMap<V> * tree = this;
+    while ( tree->cluster && tree->max != tree->min )
+    {
+      tree = tree->cluster[tree->max >> tree->lowBits];
+    }
+    return tree->cluster ? tree->minVal : tree->vals[__builtin_popcountll ( tree->bits ) - 1];
+  }
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  const int uni;
+
+  /*************************************************************************//**
+   * @brief      The number of low bits of a value addressing the element inside
+   *             its cluster.
+   ****************************************************************************/
+  const int lowBits;
+
+  /*************************************************************************//**
+   * @brief      The mask selecting the low bits of a value.
+   ****************************************************************************/
+  const int lowMask;
+
+  /*************************************************************************//**
+   * @brief      The number of clusters.
+   ****************************************************************************/
+  const int higherUniSqrt;
+
+  /*************************************************************************//**
+   * @brief      The minimal key in the tree.
+   ****************************************************************************/
+  int min;
+
+  /*************************************************************************//**
+   * @brief      The maximal key in the tree.
+   ****************************************************************************/
+  int max;
+
+  /*************************************************************************//**
+   * @brief      The value of the minimal key of a tree that is not a leaf.
+   ****************************************************************************/
+  V minVal;
+
+  /*************************************************************************//**
+   * @brief      The pointer to the summary of the occupied clusters.
+   ****************************************************************************/
+  TvEB * summary;
+
+  /*************************************************************************//**
+   * @brief      The pointer to the array of clusters, NULL for leaves.
+   ****************************************************************************/
+  TvEBMap<V> ** cluster;
+
+  /*************************************************************************//**
+   * @brief      The bitmap of the keys of a leaf.
+   ****************************************************************************/
+  uint64_t bits;
+
+  /*************************************************************************//**
+   * @brief      The values of a leaf in the order of their keys.
+   ****************************************************************************/
+  V * vals;
+
+  /*************************************************************************//**
+   * @brief      The capacity of vals.
+   ****************************************************************************/
+  int valCap;
+};
+
+/***************************************************************************//**
+ * @brief      Finds the lowest key stored in the given map and its value.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[out] res    The lowest key.
+ * @param[out] value  The value of the key.
+ *
+ * @retval     true   Successfully found the minimum.
+ * @retval     false  The map is empty.
+ ******************************************************************************/
+template <typename V>
+bool vEB_min ( TvEBMap<V> * tree, int & res, V & value )
+{
+  if ( !tree || tree->min == UNDEFINED ) return false;
+  res = tree->min;
+  value = tree->minValue();
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the highest key stored in the given map and its value.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[out] res    The highest key.
+ * @param[out] value  The value of the key.
+ *
+ * @retval     true   Successfully found the maximum.
+ * @retval     false  The map is empty.
+ ******************************************************************************/
+template <typename V>
+bool vEB_max ( TvEBMap<V> * tree, int & res, V & value )
+{
+  if ( !tree || tree->min == UNDEFINED ) return false;
+  res = tree->max;
+  value = tree->maxValue();
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Inserts the given key with the given value into the given map.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[in]  key    The key to insert.
+ * @param[in]  value  The value of the key.
+ * @param[in]  parentUniSqrt  The universe size of the map created when the
+ *                    pointer is NULL.
+ *
+ * @retval     true   Successfully inserted the key.
+ * @retval     false  The key is out of the universe or already present, the
+ *                    map is not modified.
+ ******************************************************************************/
+template <typename V>
+bool vEB_insert ( TvEBMap<V> *& tree, int key, const V & value,
+                  int parentUniSqrt = 65536 )
+{
+  if ( !tree )
+  {
+    tree = new TvEBMap<V> ( parentUniSqrt );
+  }
+
+  if ( key < 0 || key >= tree->uni ) return false;
+
+  if ( !tree->cluster )
+  {
+    uint64_t bit = ( uint64_t ) 1 << key;
+    if ( tree->bits & bit ) return false;
+
+    int cnt = __builtin_popcountll ( tree->bits );
+    if ( cnt == tree->valCap )
+    {
+      tree->valCap = tree->valCap ? 2 * tree->valCap : 2;
+      V * vals = new V [tree->valCap];
+      for ( int i = 0; i < cnt; ++i ) vals[i] = tree->vals[i];
+      delete [] tree->vals;
+      tree->vals = vals;
+    }
+    int pos = tree->rank ( key );
+    for ( int i = cnt; i > pos; --i ) tree->vals[i] = tree->vals[i - 1];
+    tree->vals[pos] = value;
+
+    if ( !tree->bits || key < tree->min ) tree->min = key;
+    if ( !tree->bits || key > tree->max ) tree->max = key;
+    tree->bits |= bit;
+    return true;
+  }
+
+  if ( tree->min == UNDEFINED )
+  {
+    tree->min = tree->max = key;
+    tree->minVal = value;
+    return true;
+  }
+
+  if ( tree->min == key || tree->max == key ) return false;
+
+  V val = value;
+  if ( key < tree->min )
+  {
+    int tmpKey = key;
+    key = tree->min;
+    tree->min = tmpKey;
+    V tmpVal = val;
+    val = tree->minVal;
+    tree->minVal = tmpVal;
+  }
+
+  int highVal = key >> tree->lowBits;
+  if ( tree->cluster[highVal] )
+  {
+    if ( !vEB_insert ( tree->cluster[highVal], key & tree->lowMask, val ) ) return false;
+  }
+  else
+  {
+    vEB_insert ( tree->summary, highVal, tree->higherUniSqrt );
+    vEB_insert ( tree->cluster[highVal], key & tree->lowMask, val, 1 << tree->lowBits );
+  }
+
+  if ( key > tree->max ) tree->max = key;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Removes the given key and its value from the given map.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[in]  key    The key to remove.
+ *
+ * @retval     true   Successfully removed the key.
+ * @retval     false  The key is not in the map.
+ ******************************************************************************/
+template <typename V>
+bool vEB_delete ( TvEBMap<V> *& tree, int key )
+{
+  if ( !tree ) return false;
+  if ( key < 0 || key >= tree->uni ) return false;
+  if ( tree->min == UNDEFINED || tree->min > key || tree->max < key ) return false;
+
+  if ( !tree->cluster )
+  {
+    uint64_t bit = ( uint64_t ) 1 << key;
+    if ( !( tree->bits & bit ) ) return false;
+
+    int cnt = __builtin_popcountll ( tree->bits );
+    for ( int i = tree->rank ( key ); i < cnt - 1; ++i ) tree->vals[i] = tree->vals[i + 1];
+    tree->bits &= ~bit;
+    if ( !tree->bits )
+    {
+      delete tree;
+      tree = NULL;
+      return true;
+    }
+    tree->min = __builtin_ctzll ( tree->bits );
+    tree->max = 63 - __builtin_clzll ( tree->bits );
+    return true;
+  }
+
+  if ( tree->min == tree->max )
+  {
+    delete tree;
+    tree = NULL;
+    return true;
+  }
+
+  if ( tree->min == key )
+  {
+    int i = tree->summary->min;
+    TvEBMap<V> * cluster = tree->cluster[i];
+    key = tree->min = ( i << tree->lowBits ) | cluster->min;
+    tree->minVal = cluster->minValue();
+  }
+
+  int highVal = key >> tree->lowBits;
+  if ( !vEB_delete ( tree->cluster[highVal], key & tree->lowMask ) ) return false;
+  if ( !tree->cluster[highVal] )
+  {
+    vEB_delete ( tree->summary, highVal );
+  }
+
+  if ( tree->max == key )
+  {
+    if ( !tree->summary )
+    {
+      tree->max = tree->min;
+    }
+    else
+    {
+      int i = tree->summary->max;
+      tree->max = ( i << tree->lowBits ) | tree->cluster[i]->max;
+    }
+  }
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Removes the lowest key from the given map and returns it with
+ *             its value, in one descent.
+ *
+ * @details    When keep is given, it is called with the value of the lowest
+ *             key before anything changes. If it returns true, the key stays
+ *             in the map with the value as keep left it, which turns the
+ *             descent into an update of the value in place.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[out] res    The lowest key.
+ * @param[out] value  The value of the key, as it was before keep.
+ * @param[in]  keep   The function deciding whether the key stays, or NULL.
+ * @param[in]  ctx    The context passed to keep.
+ *
+ * @retval     true   Successfully found the minimum.
+ * @retval     false  The map is empty.
+ ******************************************************************************/
+template <typename V>
+bool vEB_extract_min ( TvEBMap<V> *& tree, int & res, V & value,
+                       bool ( * keep ) ( V & value, void * ctx ) = NULL, void * ctx = NULL )
+{
+  if ( !tree || tree->min == UNDEFINED ) return false;
+
+  res = tree->min;
+  if ( !tree->cluster )
+  {
+    value = tree->vals[0];
+    if ( keep && keep ( tree->vals[0], ctx ) ) return true;
+    int cnt = __builtin_popcountll ( tree->bits );
+    for ( int i = 0; i < cnt - 1; ++i ) tree->vals[i] = tree->vals[i + 1];
+    tree->bits &= tree->bits - 1;
+    if ( !tree->bits )
+    {
+      delete tree;
+      tree = NULL;
+      return true;
+    }
+    tree->min = __builtin_ctzll ( tree->bits );
+    return true;
+  }
+
+  value = tree->minVal;
+  if ( keep && keep ( tree->minVal, ctx ) ) return true;
+  if ( tree->min == tree->max )
+  {
+    delete tree;
+    tree = NULL;
+    return true;
+  }
+
+  // the first cluster gives up its minimum, the maximum stays where it is
+  int i = tree->summary->min;
+  int lowKey;
+  vEB_extract_min ( tree->cluster[i], lowKey, tree->minVal );
+  tree->min = ( i << tree->lowBits ) | lowKey;
+  if ( !tree->cluster[i] ) vEB_extract_min ( tree->summary, i );
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Removes the highest key from the given map and returns it with
+ *             its value, in one descent.
+ *
+ * @details    keep works as in vEB_extract_min, it is called at the bottom
+ *             of the descent, where the value of the highest key is.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[out] res    The highest key.
+ * @param[out] value  The value of the key, as it was before keep.
+ * @param[in]  keep   The function deciding whether the key stays, or NULL.
+ * @param[in]  ctx    The context passed to keep.
+ *
+ * @retval     true   Successfully found the maximum.
+ * @retval     false  The map is empty.
+ ******************************************************************************/
+template <typename V>
+bool vEB_extract_max ( TvEBMap<V> *& tree, int & res, V & value,
+                       bool ( * keep ) ( V & value, void * ctx ) = NULL, void * ctx = NULL )
+{
+  if ( !tree || tree->min == UNDEFINED ) return false;
+
+  res = tree->max;
+  if ( !tree->cluster )
+  {
+    int last = __builtin_popcountll ( tree->bits ) - 1;
+    value = tree->vals[last];
+    if ( keep && keep ( tree->vals[last], ctx ) ) return true;
+    tree->bits &= ~( ( uint64_t ) 1 << tree->max );
+    if ( !tree->bits )
+    {
+      delete tree;
+      tree = NULL;
+      return true;
+    }
+    tree->max = 63 - __builtin_clzll ( tree->bits );
+    return true;
+  }
+
+  if ( tree->min == tree->max )
+  {
+    value = tree->minVal;
+    if ( keep && keep ( tree->minVal, ctx ) ) return true;
+    delete tree;
+    tree = NULL;
+    return true;
+  }
+
+  // a kept key leaves its cluster as it was, and the maximum below with it
+  int i = tree->summary->max;
+  int lowKey;
+  vEB_extract_max ( tree->cluster[i], lowKey, value, keep, ctx );
+  if ( !tree->cluster[i] )
+  {
+    vEB_extract_max ( tree->summary, i );
+    if ( !tree->summary )
+    {
+      tree->max = tree->min;
+      return true;
+    }
+    i = tree->summary->max;
+  }
+  tree->max = ( i << tree->lowBits ) | tree->cluster[i]->max;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the given key in the given map.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[in]  key    The key to find.
+ *
+ * @return     The pointer to the value of the key, which may be modified in
+ *             place, or NULL when the key is not in the map.
+ ******************************************************************************/
+template <typename V>
+V * vEB_find_value ( TvEBMap<V> * tree, int key )
+{
+  if ( key < 0 ) return NULL;
+  while ( tree && key < tree->uni )
+  {
+    if ( !tree->cluster )
+    {
+      if ( !( ( tree->bits >> key ) & 1 ) ) return NULL;
+      return &tree->vals[tree->rank ( key )];
+    }
+    if ( tree->min == key ) return &tree->minVal;
+    if ( tree->min == UNDEFINED || tree->min > key || tree->max < key ) return NULL;
+    int highVal = key >> tree->lowBits;
+    key &= tree->lowMask;
+    tree = tree->cluster[highVal];
+  }
+  return NULL;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the given key in the given map and returns its value.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[in]  key    The key to find.
+ * @param[out] value  The value of the key.
+ *
+ * @retval     true   Successfully found the key.
+ * @retval     false  Failed to found the key.
+ ******************************************************************************/
+template <typename V>
+bool vEB_find ( TvEBMap<V> * tree, int key, V & value )
+{
+  V * found = vEB_find_value ( tree, key );
+  if ( !found ) return false;
+  value = *found;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the smallest key greater than the given key in the given
+ *             map and returns its value.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[in]  key    The lower bound for the sought key, -1 finds the minimum.
+ * @param[out] res    The found key.
+ * @param[out] value  The value of the found key.
+ *
+ * @retval     true   Successfully found the successor.
+ * @retval     false  Failed to found the successor.
+ ******************************************************************************/
+template <typename V>
+bool vEB_succ ( TvEBMap<V> * tree, int key, int & res, V & value )
+{
+  if ( !tree ) return false;
+  if ( key < -1 || key >= tree->uni ) return false;
+  if ( tree->min == UNDEFINED ) return false;
+
+  if ( key < tree->min )
+  {
+    res = tree->min;
+    value = tree->minValue();
+    return true;
+  }
+  if ( key >= tree->max ) return false;
+
+  if ( !tree->cluster )
+  {
+    res = __builtin_ctzll ( tree->bits & ( ~ ( uint64_t ) 1 << key ) );
+    value = tree->vals[tree->rank ( res )];
+    return true;
+  }
+
+  int highVal = key >> tree->lowBits;
+  int lowVal = key & tree->lowMask;
+  TvEBMap<V> * cluster = tree->cluster[highVal];
+  if ( cluster && lowVal < cluster->max )
+  {
+    vEB_succ ( cluster, lowVal, res, value );
+    res |= highVal << tree->lowBits;
+    return true;
+  }
+
+  int i;
+  if ( !vEB_succ ( tree->summary, highVal, i ) ) return false;
+  cluster = tree->cluster[i];
+  res = ( i << tree->lowBits ) | cluster->min;
+  value = cluster->minValue();
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the largest key smaller than the given key in the given
+ *             map and returns its value.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas map.
+ * @param[in]  key    The upper bound for the sought key, uni finds the
+ *                    maximum.
+ * @param[out] res    The found key.
+ * @param[out] value  The value of the found key.
+ *
+ * @retval     true   Successfully found the predecessor.
+ * @retval     false  Failed to found the predecessor.
+ ******************************************************************************/
+template <typename V>
+bool vEB_pred ( TvEBMap<V> * tree, int key, int & res, V & value )
+{
+  if ( !tree ) return false;
+  if ( key < 0 || key > tree->uni ) return false;
+  if ( tree->min == UNDEFINED ) return false;
+
+  if ( key > tree->max )
+  {
+    res = tree->max;
+    value = tree->maxValue();
+    return true;
+  }
+  if ( key <= tree->min ) return false;
+
+  if ( !tree->cluster )
+  {
+    res = 63 - __builtin_clzll ( tree->bits & ( ( ( uint64_t ) 1 << key ) - 1 ) );
+    value = tree->vals[tree->rank ( res )];
+    return true;
+  }
+
+  int highVal = key >> tree->lowBits;
+  int lowVal = key & tree->lowMask;
+  TvEBMap<V> * cluster = tree->cluster[highVal];
+  if ( cluster && lowVal > cluster->min )
+  {
+    vEB_pred ( cluster, lowVal, res, value );
+    res |= highVal << tree->lowBits;
+    return true;
+  }
+
+  int i;
+  if ( !vEB_pred ( tree->summary, highVal, i ) )
+  {
+    res = tree->min;
+    value = tree->minVal;
+    return true;
+  }
+  cluster = tree->cluster[i];
+  res = ( i << tree->lowBits ) | cluster->max;
+  value = cluster->maxValue();
+  return true;
+}
+
+#endif /* __VEBMAP_H_564738291056473829105647382910564738291056473829105647__ */
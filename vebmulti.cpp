@@ -0,0 +1,161 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebmulti.cpp
+ *
+ * @brief      File containing definitions of a Van Emde Boas multiset, which
+ *             counts the occurrences of its values.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include "vebmulti.hpp"
+
+TvEBMultiset::TvEBMultiset ( int uniSize )
+  : uni ( powTwoRoundUp ( uniSize ) ), root ( NULL ), distinct ( 0 ), size ( 0 )
+{
+}
+
+TvEBMultiset::~TvEBMultiset()
+{
+  delete root;
+}
+
+bool vEB_insert ( TvEBMultiset * set, int val, int cnt )
+{
+  if ( !set || val < 0 || val >= set->uni || cnt <= 0 ) return false;
+
+  // a value that is there only counts one more, the keys stay as they are
+  int * count = vEB_find_value ( set->root, val );
+  if ( count )
+  {
+    if ( *count > INT_MAX - cnt ) return false;
+    *count += cnt;
+  }
+  else
+  {
+    vEB_insert ( set->root, val, cnt, set->uni );
+    set->distinct++;
+  }
+  set->size += cnt;
+  return true;
+}
+
+int vEB_delete ( TvEBMultiset * set, int val, int cnt )
+{
+  if ( !set || cnt <= 0 ) return 0;
+
+  int * count = vEB_find_value ( set->root, val );
+  if ( !count ) return 0;
+  if ( *count > cnt )
+  {
+    *count -= cnt;
+    set->size -= cnt;
+    return cnt;
+  }
+
+  int removed = *count;
+  vEB_delete ( set->root, val );
+  set->distinct--;
+  set->size -= removed;
+  return removed;
+}
+
+int vEB_count ( TvEBMultiset * set, int val )
+{
+  if ( !set ) return 0;
+
+  int * count = vEB_find_value ( set->root, val );
+  return count ? *count : 0;
+}
+
+bool vEB_min ( TvEBMultiset * set, int & res, int & cnt )
+{
+  if ( !set ) return false;
+  return vEB_min ( set->root, res, cnt );
+}
+
+bool vEB_max ( TvEBMultiset * set, int & res, int & cnt )
+{
+  if ( !set ) return false;
+  return vEB_max ( set->root, res, cnt );
+}
+
+bool vEB_succ ( TvEBMultiset * set, int val, int & res, int & cnt )
+{
+  if ( !set ) return false;
+  return vEB_succ ( set->root, val, res, cnt );
+}
+
+bool vEB_pred ( TvEBMultiset * set, int val, int & res, int & cnt )
+{
+  if ( !set ) return false;
+  return vEB_pred ( set->root, val, res, cnt );
+}
+
+/***************************************************************************//**
+ * @brief      Calls the callback for the keys of the map from lo to hi, both
+ *             inside its universe, in ascending order. A leaf reads the counts
+ *             one after another, a tree visits the occupied clusters of the
+ *             range through its summary.
+ *
+ * @return     false when the callback stopped the scan.
+ ******************************************************************************/
+static bool rangeWalk ( TvEBMap<int> * tree, int base, int lo, int hi,
+                        bool ( * callback ) ( int val, int cnt, void * ctx ), void * ctx,
+                        size_t & visited )
+{
+  if ( !tree->cluster )
+  {
+    uint64_t bits = tree->bits & ( ~ ( uint64_t ) 0 << lo );
+    if ( hi < 63 ) bits &= ( ( uint64_t ) 1 << ( hi + 1 ) ) - 1;
+    if ( !bits ) return true;
+    for ( int i = tree->rank ( __builtin_ctzll ( bits ) ); bits; bits &= bits - 1, ++i )
+    {
+      visited++;
+      if ( !callback ( base + __builtin_ctzll ( bits ), tree->vals[i], ctx ) ) return false;
+    }
+    return true;
+  }
+
+  if ( lo > tree->max || hi < tree->min ) return true;
+  if ( lo <= tree->min )
+  {
+    visited++;
+    if ( !callback ( base + tree->min, tree->minVal, ctx ) ) return false;
+  }
+  if ( !tree->summary ) return true;
+
+  int highLo = lo >> tree->lowBits, highHi = hi >> tree->lowBits;
+  TvEBIterator it;
+  for ( bool valid = vEB_iter_succ ( tree->summary, it, highLo - 1 );
+        valid && it.val <= highHi; valid = vEB_iter_next ( it ) )
+  {
+    int clusterLo = it.val == highLo ? lo & tree->lowMask : 0;
+    int clusterHi = it.val == highHi ? hi & tree->lowMask : tree->lowMask;
+    if ( !rangeWalk ( tree->cluster[it.val], base + ( it.val << tree->lowBits ),
+                      clusterLo, clusterHi, callback, ctx, visited ) ) return false;
+  }
+  return true;
+}
+
+size_t vEB_range ( TvEBMultiset * set, int lo, int hi,
+                   bool ( * callback ) ( int val, int cnt, void * ctx ), void * ctx )
+{
+  if ( !set || !set->root ) return 0;
+  if ( lo < 0 ) lo = 0;
+  if ( hi >= set->uni ) hi = set->uni - 1;
+  if ( lo > hi ) return 0;
+
+  size_t visited = 0;
+  rangeWalk ( set->root, 0, lo, hi, callback, ctx, visited );
+  return visited;
+}
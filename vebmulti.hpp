@@ -0,0 +1,178 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebmulti.hpp
+ *
+ * @brief      File containing declarations of a Van Emde Boas multiset, which
+ *             counts the occurrences of its values.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBMULTI_H_450918273645091827364509182736450918273645091827364509__
+#define __VEBMULTI_H_450918273645091827364509182736450918273645091827364509__
+
+#include <cstddef>
+#include "vebmap.hpp"
+
+/***************************************************************************//**
+ * @brief      Struct containing the Van Emde Boas multiset.
+ *
+ * @details    The distinct values are the keys of a TvEBMap, each mapped to
+ *             the number of its occurrences. Adding an occurrence of a value
+ *             that is already there, or removing one of several, only changes
+ *             the count in place, found by one vEB_find_value. The keys, and
+ *             the summaries with them, change only when a count goes from
+ *             zero or to zero. The successors, predecessors and scans return
+ *             the counts from the same traversal that finds the values.
+ ******************************************************************************/
+struct TvEBMultiset
+{
+  /*************************************************************************//**
+   * @brief      Constructor.
+   *
+   * @param[in]  uniSize  The size of the universe.
+   ****************************************************************************/
+  TvEBMultiset ( int uniSize );
+
+  /*************************************************************************//**
+   * @brief      Destructor.
+   ****************************************************************************/
+  ~TvEBMultiset();
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  const int uni;
+
+  /*************************************************************************//**
+   * @brief      The map of the distinct values to their counts, NULL when the
+   *             multiset is empty.
+   ****************************************************************************/
+  TvEBMap<int> * root;
+
+  /*************************************************************************//**
+   * @brief      The number of the distinct values.
+   ****************************************************************************/
+  int distinct;
+
+  /*************************************************************************//**
+   * @brief      The number of the occurrences of all the values.
+   ****************************************************************************/
+  size_t size;
+};
+
+/***************************************************************************//**
+ * @brief      Adds occurrences of the given value to the given multiset.
+ *
+ * @param[in]  set    The pointer to the van Emde Boas multiset.
+ * @param[in]  val    The value.
+ * @param[in]  cnt    The number of the occurrences to add.
+ *
+ * @retval     true   Successfully added the occurrences.
+ * @retval     false  The value is out of the universe, cnt is not positive or
+ *                    the count of the value would overflow.
+ ******************************************************************************/
+bool vEB_insert ( TvEBMultiset * set, int val, int cnt = 1 );
+
+/***************************************************************************//**
+ * @brief      Removes occurrences of the given value from the given multiset.
+ *
+ * @param[in]  set    The pointer to the van Emde Boas multiset.
+ * @param[in]  val    The value.
+ * @param[in]  cnt    The number of the occurrences to remove, INT_MAX removes
+ *                    all of them.
+ *
+ * @return     The number of the removed occurrences, at most cnt.
+ ******************************************************************************/
+int vEB_delete ( TvEBMultiset * set, int val, int cnt = 1 );
+
+/***************************************************************************//**
+ * @brief      Returns the number of the occurrences of the given value.
+ *
+ * @param[in]  set    The pointer to the van Emde Boas multiset.
+ * @param[in]  val    The value.
+ *
+ * @return     The number of the occurrences, 0 when the value is not there.
+ ******************************************************************************/
+int vEB_count ( TvEBMultiset * set, int val );
+
+/***************************************************************************//**
+ * @brief      Finds the lowest value of the given multiset.
+ *
+ * @param[in]  set    The pointer to the van Emde Boas multiset.
+ * @param[out] res    The lowest value.
+ * @param[out] cnt    The number of its occurrences.
+ *
+ * @retval     true   Successfully found the minimum.
+ * @retval     false  The multiset is empty.
+ ******************************************************************************/
+bool vEB_min ( TvEBMultiset * set, int & res, int & cnt );
+
+/***************************************************************************//**
+ * @brief      Finds the highest value of the given multiset.
+ *
+ * @param[in]  set    The pointer to the van Emde Boas multiset.
+ * @param[out] res    The highest value.
+ * @param[out] cnt    The number of its occurrences.
+ *
+ * @retval     true   Successfully found the maximum.
+ * @retval     false  The multiset is empty.
+ ******************************************************************************/
+bool vEB_max ( TvEBMultiset * set, int & res, int & cnt );
+
+/***************************************************************************//**
+ * @brief      Finds the smallest value greater than the given value in the
+ *             given multiset.
+ *
+ * @param[in]  set    The pointer to the van Emde Boas multiset.
+ * @param[in]  val    The lower bound for the sought value, -1 finds the
+ *                    minimum.
+ * @param[out] res    The found value.
+ * @param[out] cnt    The number of its occurrences.
+ *
+ * @retval     true   Successfully found the successor.
+ * @retval     false  Failed to found the successor.
+ ******************************************************************************/
+bool vEB_succ ( TvEBMultiset * set, int val, int & res, int & cnt );
+
+/***************************************************************************//**
+ * @brief      Finds the largest value smaller than the given value in the
+ *             given multiset.
+ *
+ * @param[in]  set    The pointer to the van Emde Boas multiset.
+ * @param[in]  val    The upper bound for the sought value, uni finds the
+ *                    maximum.
+ * @param[out] res    The found value.
+ * @param[out] cnt    The number of its occurrences.
+ *
+ * @retval     true   Successfully found the predecessor.
+ * @retval     false  Failed to found the predecessor.
+ ******************************************************************************/
+bool vEB_pred ( TvEBMultiset * set, int val, int & res, int & cnt );
+
+/***************************************************************************//**
+ * @brief      Calls the callback for the distinct values from lo to hi,
+ *             inclusive, in ascending order, with their counts.
+ *
+ * @param[in]  set    The pointer to the van Emde Boas multiset.
+ * @param[in]  lo     The lowest value of the range.
+ * @param[in]  hi     The highest value of the range.
+ * @param[in]  callback  The function called with each value, its count and
+ *                    ctx, the scan stops when it returns false.
+ * @param[in]  ctx    The pointer passed to the callback.
+ *
+ * @return     The number of the values the callback was called with.
+ ******************************************************************************/
+size_t vEB_range ( TvEBMultiset * set, int lo, int hi,
+                   bool ( * callback ) ( int val, int cnt, void * ctx ), void * ctx );
+
+#endif /* __VEBMULTI_H_450918273645091827364509182736450918273645091827364509__ */
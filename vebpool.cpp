@@ -0,0 +1,193 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebpool.cpp
+ *
+ * @brief      File containing definitions of a work-stealing thread pool
+ *             running the parallel parts of the Van Emde Boas trees.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include <sched.h>
+#include <cstddef>
+#include "vebpool.hpp"
+
+/***************************************************************************//**
+ * @brief      Struct containing the arguments of a worker thread.
+ ******************************************************************************/
+struct TvEBWorker
+{
+  /*************************************************************************//**
+   * @brief      The pool of the worker.
+   ****************************************************************************/
+  TvEBPool * pool;
+
+  /*************************************************************************//**
+   * @brief      The index of the worker and its deque.
+   ****************************************************************************/
+  int id;
+};
+
+/***************************************************************************//**
+ * @brief      Pushes the given task to the tail of the given deque.
+ ******************************************************************************/
+static void dequePush ( TvEBDeque & d, TvEBTask task )
+{
+  pthread_mutex_lock ( &d.lock );
+  d.tasks[d.tail++ % VEB_POOL_DEQUE] = task;
+  pthread_mutex_unlock ( &d.lock );
+}
+
+/***************************************************************************//**
+ * @brief      Takes a task from the tail, when own is true, or from the head
+ *             of the given deque.
+ ******************************************************************************/
+static bool dequeTake ( TvEBDeque & d, bool own, TvEBTask & task )
+{
+  pthread_mutex_lock ( &d.lock );
+  bool found = d.head != d.tail;
+  if ( found ) task = own ? d.tasks[--d.tail % VEB_POOL_DEQUE]
+                      : d.tasks[d.head++ % VEB_POOL_DEQUE];
+  pthread_mutex_unlock ( &d.lock );
+  return found;
+}
+
+/***************************************************************************//**
+ * @brief      Processes the tasks of the current loop until all its indices
+ *             are processed.
+ ******************************************************************************/
+static void work ( TvEBPool * pool, int id )
+{
+  TvEBDeque & own = pool->deques[id];
+  TvEBTask task;
+  unsigned victim = id;
+  while ( __atomic_load_n ( &pool->remaining, __ATOMIC_ACQUIRE ) > 0 )
+  {
+    bool found = dequeTake ( own, true, task );
+    for ( int i = 1; !found && i < pool->threadCnt; ++i )
+    {
+      victim = ( victim + 1 ) % pool->threadCnt;
+      if ( ( int ) victim != id ) found = dequeTake ( pool->deques[victim], false, task );
+    }
+    if ( !found )
+    {
+      sched_yield();
+      continue;
+    }
+
+    while ( task.hi - task.lo > pool->grain )
+    {
+      int mid = task.lo + ( task.hi - task.lo ) / 2;
+      TvEBTask upper = { mid, task.hi };
+      dequePush ( own, upper );
+      task.hi = mid;
+    }
+    pool->fn ( task.lo, task.hi, pool->ctx );
+    __atomic_fetch_sub ( &pool->remaining, task.hi - task.lo, __ATOMIC_RELEASE );
+  }
+}
+
+/***************************************************************************//**
+ * @brief      The body of a worker thread, waiting for the loops and working on
+ *             them.
+ ******************************************************************************/
+static void * workerMain ( void * arg )
+{
+  TvEBWorker * w = ( TvEBWorker * ) arg;
+  TvEBPool * pool = w->pool;
+  int id = w->id;
+  delete w;
+
+  int seen = 0;
+  while ( true )
+  {
+    pthread_mutex_lock ( &pool->lock );
+    while ( !pool->stop && pool->generation == seen )
+    {
+      pthread_cond_wait ( &pool->wake, &pool->lock );
+    }
+    bool stop = pool->stop;
+    seen = pool->generation;
+    pthread_mutex_unlock ( &pool->lock );
+    if ( stop ) return NULL;
+    work ( pool, id );
+  }
+}
+
+TvEBPool::TvEBPool ( int threadCnt )
+  : threadCnt ( threadCnt > 0 ? threadCnt : 1 ), fn ( NULL ), ctx ( NULL ),
+    grain ( 1 ), remaining ( 0 ), generation ( 0 ), stop ( false )
+{
+  pthread_mutex_init ( &lock, NULL );
+  pthread_cond_init ( &wake, NULL );
+  deques = new TvEBDeque [this->threadCnt];
+  for ( int i = 0; i < this->threadCnt; ++i )
+  {
+    pthread_mutex_init ( &deques[i].lock, NULL );
+    deques[i].head = deques[i].tail = 0;
+  }
+  threads = new pthread_t [this->threadCnt];
+  for ( int i = 1; i < this->threadCnt; ++i )
+  {
+    TvEBWorker * w = new TvEBWorker;
+    w->pool = this;
+    w->id = i;
+    pthread_create ( &threads[i], NULL, workerMain, w );
+  }
+}
+
+TvEBPool::~TvEBPool()
+{
+  pthread_mutex_lock ( &lock );
+  stop = true;
+  pthread_cond_broadcast ( &wake );
+  pthread_mutex_unlock ( &lock );
+  for ( int i = 1; i < threadCnt; ++i )
+  {
+    pthread_join ( threads[i], NULL );
+  }
+  for ( int i = 0; i < threadCnt; ++i )
+  {
+    pthread_mutex_destroy ( &deques[i].lock );
+  }
+  pthread_cond_destroy ( &wake );
+  pthread_mutex_destroy ( &lock );
+  delete [] threads;
+  delete [] deques;
+}
+
+void vEB_pool_for ( TvEBPool * pool, int lo, int hi, int grain,
+                    void ( * fn ) ( int lo, int hi, void * ctx ), void * ctx )
+{
+  if ( lo >= hi ) return;
+  if ( !pool || pool->threadCnt == 1 || hi - lo <= grain )
+  {
+    fn ( lo, hi, ctx );
+    return;
+  }
+
+  pool->fn = fn;
+  pool->ctx = ctx;
+  pool->grain = grain > 0 ? grain : 1;
+  // the count goes first, a worker still busy with the previous loop may
+  // take the task right after it is pushed
+  __atomic_store_n ( &pool->remaining, hi - lo, __ATOMIC_RELEASE );
+  TvEBTask task = { lo, hi };
+  dequePush ( pool->deques[0], task );
+
+  pthread_mutex_lock ( &pool->lock );
+  pool->generation++;
+  pthread_cond_broadcast ( &pool->wake );
+  pthread_mutex_unlock ( &pool->lock );
+
+  work ( pool, 0 );
+}
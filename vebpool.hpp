@@ -0,0 +1,176 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebpool.hpp
+ *
+ * @brief      File containing declarations of a work-stealing thread pool
+ *             running the parallel parts of the Van Emde Boas trees.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBPOOL_H_782364519827364519827364519827364519827364519827364519__
+#define __VEBPOOL_H_782364519827364519827364519827364519827364519827364519__
+
+#include <pthread.h>
+
+/***************************************************************************//**
+ * @brief      The capacity of the task deque of one worker. A worker splits a
+ *             range in halves, so it never holds more tasks than the number
+ *             of bits of an int.
+ ******************************************************************************/
+#define VEB_POOL_DEQUE 64
+
+/***************************************************************************//**
+ * @brief      Struct containing a range of indices to process.
+ ******************************************************************************/
+struct TvEBTask
+{
+  /*************************************************************************//**
+   * @brief      The first index of the range.
+   ****************************************************************************/
+  int lo;
+
+  /*************************************************************************//**
+   * @brief      The index behind the last one of the range.
+   ****************************************************************************/
+  int hi;
+};
+
+/***************************************************************************//**
+ * @brief      Struct containing the task deque of one worker alone in its
+ *             cache lines. The owner pushes and pops at the tail, the thieves
+ *             steal from the head, where the largest ranges are.
+ ******************************************************************************/
+struct TvEBDeque
+{
+  /*************************************************************************//**
+   * @brief      The lock of the deque.
+   ****************************************************************************/
+  pthread_mutex_t lock;
+
+  /*************************************************************************//**
+   * @brief      The tasks, from head to tail.
+   ****************************************************************************/
+  TvEBTask tasks[VEB_POOL_DEQUE];
+
+  /*************************************************************************//**
+   * @brief      The index of the oldest task.
+   ****************************************************************************/
+  int head;
+
+  /*************************************************************************//**
+   * @brief      The index behind the newest task.
+   ****************************************************************************/
+  int tail;
+} __attribute__ ( ( aligned ( 64 ) ) );
+
+/***************************************************************************//**
+ * @brief      Struct containing a work-stealing thread pool.
+ *
+ * @details    The pool runs one parallel loop at a time, started by
+ *             vEB_pool_for, whose caller works as the worker 0. The whole
+ *             range starts in the deque of the caller. A worker takes the
+ *             newest task of its own deque, keeps halving it while it is
+ *             larger than the grain, pushing the upper halves back, and
+ *             processes the rest. An idle worker steals the oldest task of
+ *             another deque, which is the largest one there, so the work
+ *             spreads in O(log n) steals and stays balanced even when the
+ *             indices take very different time.
+ ******************************************************************************/
+struct TvEBPool
+{
+  /*************************************************************************//**
+   * @brief      Constructor. Starts threadCnt - 1 worker threads.
+   *
+   * @param[in]  threadCnt  The number of the workers including the caller.
+   ****************************************************************************/
+  TvEBPool ( int threadCnt );
+
+  /*************************************************************************//**
+   * @brief      Destructor. Stops and joins the worker threads.
+   ****************************************************************************/
+  ~TvEBPool();
+
+  /*************************************************************************//**
+   * @brief      The number of the workers including the caller.
+   ****************************************************************************/
+  const int threadCnt;
+
+  /*************************************************************************//**
+   * @brief      The worker threads.
+   ****************************************************************************/
+  pthread_t * threads;
+
+  /*************************************************************************//**
+   * @brief      The deques of the workers.
+   ****************************************************************************/
+  TvEBDeque * deques;
+
+  /*************************************************************************//**
+   * @brief      The function processing a range of the current loop.
+   ****************************************************************************/
+  void ( * fn ) ( int lo, int hi, void * ctx );
+
+  /*************************************************************************//**
+   * @brief      The context of the current loop.
+   ****************************************************************************/
+  void * ctx;
+
+  /*************************************************************************//**
+   * @brief      The largest range the current loop processes at once.
+   ****************************************************************************/
+  int grain;
+
+  /*************************************************************************//**
+   * @brief      The number of the indices of the current loop not processed
+   *             yet.
+   ****************************************************************************/
+  int remaining;
+
+  /*************************************************************************//**
+   * @brief      The number of the loops started so far.
+   ****************************************************************************/
+  int generation;
+
+  /*************************************************************************//**
+   * @brief      Whether the workers have to stop.
+   ****************************************************************************/
+  bool stop;
+
+  /*************************************************************************//**
+   * @brief      The lock of the generation and the stop flag.
+   ****************************************************************************/
+  pthread_mutex_t lock;
+
+  /*************************************************************************//**
+   * @brief      The condition the idle workers wait on for the next loop.
+   ****************************************************************************/
+  pthread_cond_t wake;
+};
+
+/***************************************************************************//**
+ * @brief      Calls the given function on the subranges of the given range in
+ *             parallel and returns when all of them are processed. Each index
+ *             is processed exactly once. Without a pool, the function is called
+ *             once on the whole range.
+ *
+ * @param[in]  pool   The pointer to the pool, or NULL.
+ * @param[in]  lo     The first index of the range.
+ * @param[in]  hi     The index behind the last one of the range.
+ * @param[in]  grain  The largest subrange to process at once, at least 1.
+ * @param[in]  fn     The function processing a subrange.
+ * @param[in]  ctx    The context passed to the function.
+ ******************************************************************************/
+void vEB_pool_for ( TvEBPool * pool, int lo, int hi, int grain,
+                    void ( * fn ) ( int lo, int hi, void * ctx ), void * ctx );
+
+#endif /* __VEBPOOL_H_782364519827364519827364519827364519827364519827364519__ */
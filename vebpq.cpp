@@ -0,0 +1,146 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebpq.cpp
+ *
+ * @brief      File containing definitions of a priority queue of integer
+ *             priorities based on the Van Emde Boas map.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include <algorithm>
+#include "vebpq.hpp"
+
+TvEBPQ::TvEBPQ ( int uniSize, int itemCnt )
+  : uni ( powTwoRoundUp ( uniSize ) ), itemCnt ( itemCnt ), root ( NULL ),
+    prio ( new int [itemCnt] ), next ( new int [itemCnt] ),
+    prev ( new int [itemCnt] ), size ( 0 )
+{
+  std::fill ( prio, prio + itemCnt, UNDEFINED );
+}
+
+TvEBPQ::~TvEBPQ()
+{
+  delete root;
+  delete [] prio;
+  delete [] next;
+  delete [] prev;
+}
+
+/***************************************************************************//**
+ * @brief      Links the item as the first one of the bucket of the priority,
+ *             creating the bucket when there is none.
+ ******************************************************************************/
+static void link ( TvEBPQ * pq, int item, int prio )
+{
+  pq->prio[item] = prio;
+  pq->prev[item] = UNDEFINED;
+  pq->next[item] = UNDEFINED;
+  // a new priority takes one descent, an existing one fails it early
+  if ( vEB_insert ( pq->root, prio, item, pq->uni ) ) return;
+
+  int * first = vEB_find_value ( pq->root, prio );
+  pq->next[item] = *first;
+  pq->prev[*first] = item;
+  *first = item;
+}
+
+/***************************************************************************//**
+ * @brief      Unlinks the queued item from its bucket, removing the emptied
+ *             bucket.
+ ******************************************************************************/
+static void unlink ( TvEBPQ * pq, int item )
+{
+  int prev = pq->prev[item], next = pq->next[item];
+  if ( next != UNDEFINED ) pq->prev[next] = prev;
+  if ( prev != UNDEFINED )
+  {
+    pq->next[prev] = next;
+  }
+  else if ( next != UNDEFINED )
+  {
+    *vEB_find_value ( pq->root, pq->prio[item] ) = next;
+  }
+  else
+  {
+    vEB_delete ( pq->root, pq->prio[item] );
+  }
+  pq->prio[item] = UNDEFINED;
+}
+
+/***************************************************************************//**
+ * @brief      The keep function of vEB_extract_min and vEB_extract_max, it
+ *             moves a bucket of more items to its second item in place.
+ ******************************************************************************/
+static bool keepBucket ( int & first, void * ctx )
+{
+  TvEBPQ * pq = ( TvEBPQ * ) ctx;
+  int next = pq->next[first];
+  if ( next == UNDEFINED ) return false;
+  pq->prev[next] = UNDEFINED;
+  first = next;
+  return true;
+}
+
+bool vEB_push ( TvEBPQ * pq, int item, int prio )
+{
+  if ( !pq || item < 0 || item >= pq->itemCnt ) return false;
+  if ( prio < 0 || prio >= pq->uni || pq->prio[item] != UNDEFINED ) return false;
+
+  link ( pq, item, prio );
+  pq->size++;
+  return true;
+}
+
+bool vEB_pop_min ( TvEBPQ * pq, int & item, int & prio )
+{
+  if ( !pq || !vEB_extract_min ( pq->root, prio, item, keepBucket, pq ) ) return false;
+
+  pq->prio[item] = UNDEFINED;
+  pq->size--;
+  return true;
+}
+
+bool vEB_pop_max ( TvEBPQ * pq, int & item, int & prio )
+{
+  if ( !pq || !vEB_extract_max ( pq->root, prio, item, keepBucket, pq ) ) return false;
+
+  pq->prio[item] = UNDEFINED;
+  pq->size--;
+  return true;
+}
+
+bool vEB_min ( TvEBPQ * pq, int & item, int & prio )
+{
+  if ( !pq ) return false;
+  return vEB_min ( pq->root, prio, item );
+}
+
+bool vEB_decrease_key ( TvEBPQ * pq, int item, int prio )
+{
+  if ( !pq || item < 0 || item >= pq->itemCnt ) return false;
+  if ( prio < 0 || pq->prio[item] == UNDEFINED || prio >= pq->prio[item] ) return false;
+
+  unlink ( pq, item );
+  link ( pq, item, prio );
+  return true;
+}
+
+bool vEB_delete ( TvEBPQ * pq, int item )
+{
+  if ( !pq || item < 0 || item >= pq->itemCnt ) return false;
+  if ( pq->prio[item] == UNDEFINED ) return false;
+
+  unlink ( pq, item );
+  pq->size--;
+  return true;
+}
@@ -0,0 +1,173 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebpq.hpp
+ *
+ * @brief      File containing declarations of a priority queue of integer
+ *             priorities based on the Van Emde Boas map.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBPQ_H_736450918273645091827364509182736450918273645091827364__
+#define __VEBPQ_H_736450918273645091827364509182736450918273645091827364__
+
+#include "vebmap.hpp"
+
+/***************************************************************************//**
+ * @brief      Struct containing the priority queue of the items 0 to
+ *             itemCnt - 1 with priorities from the universe.
+ *
+ * @details    The queued priorities are the keys of a TvEBMap, each mapped to
+ *             the first item of its bucket, the doubly linked list of the
+ *             items of that priority. Popping the minimum reads the first
+ *             item of its bucket at the root, and either moves the bucket to
+ *             the next item in place or removes the priority in the same
+ *             descent, so it costs one vEB_extract_min at most. Popping the
+ *             maximum does the same at the bottom of the descent to the
+ *             maximum. Decreasing a key unlinks the item from its bucket,
+ *             updating the first item in the map payload when it was the
+ *             first, and links it to the new bucket.
+ *
+ *             It suits the monotone workloads, like Dijkstra's shortest paths
+ *             or an event scheduler, where the pushed priorities are never
+ *             below the last popped minimum, though it does not require them.
+ *             Items of equal priority are popped last pushed first.
+ ******************************************************************************/
+struct TvEBPQ
+{
+  /*************************************************************************//**
+   * @brief      Constructor.
+   *
+   * @param[in]  uniSize  The size of the universe of the priorities.
+   * @param[in]  itemCnt  The number of the items.
+   ****************************************************************************/
+  TvEBPQ ( int uniSize, int itemCnt );
+
+  /*************************************************************************//**
+   * @brief      Destructor.
+   ****************************************************************************/
+  ~TvEBPQ();
+
+  /*************************************************************************//**
+   * @brief      The size of the universe of the priorities.
+   ****************************************************************************/
+  const int uni;
+
+  /*************************************************************************//**
+   * @brief      The number of the items.
+   ****************************************************************************/
+  const int itemCnt;
+
+  /*************************************************************************//**
+   * @brief      The map of the queued priorities to the first items of their
+   *             buckets, NULL when the queue is empty.
+   ****************************************************************************/
+  TvEBMap<int> * root;
+
+  /*************************************************************************//**
+   * @brief      The priorities of the items, UNDEFINED for the items that are
+   *             not queued.
+   ****************************************************************************/
+  int * prio;
+
+  /*************************************************************************//**
+   * @brief      The next items in the buckets, UNDEFINED for the last ones.
+   ****************************************************************************/
+  int * next;
+
+  /*************************************************************************//**
+   * @brief      The previous items in the buckets, UNDEFINED for the first
+   *             ones.
+   ****************************************************************************/
+  int * prev;
+
+  /*************************************************************************//**
+   * @brief      The number of the queued items.
+   ****************************************************************************/
+  int size;
+};
+
+/***************************************************************************//**
+ * @brief      Queues the given item with the given priority.
+ *
+ * @param[in]  pq     The pointer to the priority queue.
+ * @param[in]  item   The item to queue.
+ * @param[in]  prio   The priority of the item.
+ *
+ * @retval     true   Successfully queued the item.
+ * @retval     false  The item or the priority is out of range or the item is
+ *                    already queued.
+ ******************************************************************************/
+bool vEB_push ( TvEBPQ * pq, int item, int prio );
+
+/***************************************************************************//**
+ * @brief      Removes an item of the lowest priority from the given queue.
+ *
+ * @param[in]  pq     The pointer to the priority queue.
+ * @param[out] item   The removed item.
+ * @param[out] prio   The priority of the item.
+ *
+ * @retval     true   Successfully removed the item.
+ * @retval     false  The queue is empty.
+ ******************************************************************************/
+bool vEB_pop_min ( TvEBPQ * pq, int & item, int & prio );
+
+/***************************************************************************//**
+ * @brief      Removes an item of the highest priority from the given queue.
+ *
+ * @param[in]  pq     The pointer to the priority queue.
+ * @param[out] item   The removed item.
+ * @param[out] prio   The priority of the item.
+ *
+ * @retval     true   Successfully removed the item.
+ * @retval     false  The queue is empty.
+ ******************************************************************************/
+bool vEB_pop_max ( TvEBPQ * pq, int & item, int & prio );
+
+/***************************************************************************//**
+ * @brief      Finds an item of the lowest priority in the given queue, the
+ *             one vEB_pop_min would remove.
+ *
+ * @param[in]  pq     The pointer to the priority queue.
+ * @param[out] item   The found item.
+ * @param[out] prio   The priority of the item.
+ *
+ * @retval     true   Successfully found the item.
+ * @retval     false  The queue is empty.
+ ******************************************************************************/
+bool vEB_min ( TvEBPQ * pq, int & item, int & prio );
+
+/***************************************************************************//**
+ * @brief      Lowers the priority of the given queued item.
+ *
+ * @param[in]  pq     The pointer to the priority queue.
+ * @param[in]  item   The queued item.
+ * @param[in]  prio   The new priority, lower than the current one.
+ *
+ * @retval     true   Successfully lowered the priority.
+ * @retval     false  The item is out of range or not queued, or the priority
+ *                    is negative or not lower than the current one.
+ ******************************************************************************/
+bool vEB_decrease_key ( TvEBPQ * pq, int item, int prio );
+
+/***************************************************************************//**
+ * @brief      Removes the given item from the given queue.
+ *
+ * @param[in]  pq     The pointer to the priority queue.
+ * @param[in]  item   The item to remove.
+ *
+ * @retval     true   Successfully removed the item.
+ * @retval     false  The item is out of range or not queued.
+ ******************************************************************************/
+bool vEB_delete ( TvEBPQ * pq, int item );
+
+#endif /* __VEBPQ_H_736450918273645091827364509182736450918273645091827364__ */
@@ -0,0 +1,231 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebshard.cpp
+ *
+ * @brief      File containing definitions of a thread-safe set of Van Emde
+ *             Boas trees each owning a range of the universe.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include <iostream>
+#include "vebshard.hpp"
+
+/***************************************************************************//**
+ * @brief      Checks that both sizes are positive and that the whole universe,
+ *             both rounded up to powers of two, stays within 2^30.
+ ******************************************************************************/
+static bool shardsFit ( int shardCnt, int shardUni )
+{
+  if ( shardCnt <= 0 || shardUni <= 0 || shardCnt > 1 << 30 || shardUni > 1 << 30 ) return false;
+  return log2Int ( powTwoRoundUp ( shardCnt ) ) + log2Int ( powTwoRoundUp ( shardUni ) ) <= 30;
+}
+
+TvEBSharded::TvEBSharded ( int shardCnt, int shardUni, int flags )
+  : shardCnt ( shardsFit ( shardCnt, shardUni ) ? powTwoRoundUp ( shardCnt ) : 0 ),
+    shardBits ( shardsFit ( shardCnt, shardUni ) ? log2Int ( powTwoRoundUp ( shardUni ) ) : 0 ),
+    uni ( this->shardCnt << shardBits ), flags ( flags )
+{
+  if ( !this->shardCnt )
+  {
+    std::cerr << "universe size of TvEBSharded must be bigger than 0 and at most 2^30"
+              << std::endl;
+  }
+  shard = new TvEB * [this->shardCnt];
+  locks = new TvEBLock [this->shardCnt];
+  nonEmpty = new uint64_t [( this->shardCnt + 63 ) / 64];
+  for ( int i = 0; i < this->shardCnt; ++i )
+  {
+    shard[i] = NULL;
+    pthread_rwlock_init ( &locks[i].lock, NULL );
+  }
+  for ( int i = 0; i < ( this->shardCnt + 63 ) / 64; ++i )
+  {
+    nonEmpty[i] = 0;
+  }
+}
+
+TvEBSharded::~TvEBSharded()
+{
+  for ( int i = 0; i < shardCnt; ++i )
+  {
+    if ( shard[i] ) delete shard[i];
+    pthread_rwlock_destroy ( &locks[i].lock );
+  }
+  delete [] shard;
+  delete [] locks;
+  delete [] nonEmpty;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the lowest non-empty shard above the given one, or -1.
+ ******************************************************************************/
+static int nextShard ( TvEBSharded * tree, int i )
+{
+  ++i;
+  if ( i >= tree->shardCnt ) return -1;
+  int w = i >> 6;
+  uint64_t word = __atomic_load_n ( &tree->nonEmpty[w], __ATOMIC_ACQUIRE )
+                  & ( ~ ( uint64_t ) 0 << ( i & 63 ) );
+  while ( !word )
+  {
+    if ( ++w >= ( tree->shardCnt + 63 ) / 64 ) return -1;
+    word = __atomic_load_n ( &tree->nonEmpty[w], __ATOMIC_ACQUIRE );
+  }
+  return ( w << 6 ) + __builtin_ctzll ( word );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the highest non-empty shard below the given one, or -1.
+ ******************************************************************************/
+static int prevShard ( TvEBSharded * tree, int i )
+{
+  --i;
+  if ( i < 0 ) return -1;
+  int w = i >> 6;
+  uint64_t word = __atomic_load_n ( &tree->nonEmpty[w], __ATOMIC_ACQUIRE )
+                  & ( ~ ( uint64_t ) 0 >> ( 63 - ( i & 63 ) ) );
+  while ( !word )
+  {
+    if ( --w < 0 ) return -1;
+    word = __atomic_load_n ( &tree->nonEmpty[w], __ATOMIC_ACQUIRE );
+  }
+  return ( w << 6 ) + 63 - __builtin_clzll ( word );
+}
+
+/***************************************************************************//**
+ * @brief      Finds the minimum or the maximum of the given shard under its
+ *             lock.
+ ******************************************************************************/
+static bool shardExtreme ( TvEBSharded * tree, int i, bool max, int & res )
+{
+  int j;
+  pthread_rwlock_rdlock ( &tree->locks[i].lock );
+  bool found = max ? vEB_max ( tree->shard[i], j ) : vEB_min ( tree->shard[i], j );
+  pthread_rwlock_unlock ( &tree->locks[i].lock );
+  if ( found ) res = ( i << tree->shardBits ) | j;
+  return found;
+}
+
+bool vEB_min ( TvEBSharded * tree, int & res )
+{
+  if ( !tree ) return false;
+  return vEB_succ ( tree, -1, res );
+}
+
+bool vEB_max ( TvEBSharded * tree, int & res )
+{
+  if ( !tree ) return false;
+  return vEB_pred ( tree, tree->uni, res );
+}
+
+bool vEB_insert ( TvEBSharded * tree, int val )
+{
+  if ( !tree ) return false;
+  if ( val < 0 || val >= tree->uni ) return false;
+
+  int i = val >> tree->shardBits;
+  pthread_rwlock_wrlock ( &tree->locks[i].lock );
+  bool fresh = !tree->shard[i];
+  bool ok = vEB_insert ( tree->shard[i], val & ( ( 1 << tree->shardBits ) - 1 ),
+                         1 << tree->shardBits, NULL, tree->flags );
+  if ( ok && fresh )
+  {
+    __atomic_fetch_or ( &tree->nonEmpty[i >> 6], ( uint64_t ) 1 << ( i & 63 ),
+                        __ATOMIC_RELEASE );
+  }
+  pthread_rwlock_unlock ( &tree->locks[i].lock );
+  return ok;
+}
+
+bool vEB_delete ( TvEBSharded * tree, int val )
+{
+  if ( !tree ) return false;
+  if ( val < 0 || val >= tree->uni ) return false;
+
+  int i = val >> tree->shardBits;
+  pthread_rwlock_wrlock ( &tree->locks[i].lock );
+  bool ok = vEB_delete ( tree->shard[i], val & ( ( 1 << tree->shardBits ) - 1 ) );
+  if ( ok && !tree->shard[i] )
+  {
+    __atomic_fetch_and ( &tree->nonEmpty[i >> 6], ~ ( ( uint64_t ) 1 << ( i & 63 ) ),
+                         __ATOMIC_RELEASE );
+  }
+  pthread_rwlock_unlock ( &tree->locks[i].lock );
+  return ok;
+}
+
+bool vEB_find ( TvEBSharded * tree, int val )
+{
+  if ( !tree ) return false;
+  if ( val < 0 || val >= tree->uni ) return false;
+
+  int i = val >> tree->shardBits;
+  pthread_rwlock_rdlock ( &tree->locks[i].lock );
+  bool found = vEB_find ( tree->shard[i], val & ( ( 1 << tree->shardBits ) - 1 ) );
+  pthread_rwlock_unlock ( &tree->locks[i].lock );
+  return found;
+}
+
+bool vEB_succ ( TvEBSharded * tree, int val, int & res )
+{
+  if ( !tree ) return false;
+  if ( val < -1 || val >= tree->uni ) return false;
+
+  int i = val < 0 ? -1 : val >> tree->shardBits;
+  if ( i >= 0 )
+  {
+    int j;
+    pthread_rwlock_rdlock ( &tree->locks[i].lock );
+    bool found = vEB_succ ( tree->shard[i], val & ( ( 1 << tree->shardBits ) - 1 ), j );
+    pthread_rwlock_unlock ( &tree->locks[i].lock );
+    if ( found )
+    {
+      res = ( i << tree->shardBits ) | j;
+      return true;
+    }
+  }
+
+  // a shard emptied since the bitmap was read is skipped
+  while ( ( i = nextShard ( tree, i ) ) >= 0 )
+  {
+    if ( shardExtreme ( tree, i, false, res ) ) return true;
+  }
+  return false;
+}
+
+bool vEB_pred ( TvEBSharded * tree, int val, int & res )
+{
+  if ( !tree ) return false;
+  if ( val < 0 || val > tree->uni ) return false;
+
+  int i = val >> tree->shardBits;
+  if ( i < tree->shardCnt )
+  {
+    int j;
+    pthread_rwlock_rdlock ( &tree->locks[i].lock );
+    bool found = vEB_pred ( tree->shard[i], val & ( ( 1 << tree->shardBits ) - 1 ), j );
+    pthread_rwlock_unlock ( &tree->locks[i].lock );
+    if ( found )
+    {
+      res = ( i << tree->shardBits ) | j;
+      return true;
+    }
+  }
+
+  // a shard emptied since the bitmap was read is skipped
+  while ( ( i = prevShard ( tree, i ) ) >= 0 )
+  {
+    if ( shardExtreme ( tree, i, true, res ) ) return true;
+  }
+  return false;
+}
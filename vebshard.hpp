@@ -0,0 +1,183 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebshard.hpp
+ *
+ * @brief      File containing declarations of a thread-safe set of Van Emde
+ *             Boas trees each owning a range of the universe.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBSHARD_H_560293847560293847560293847560293847560293847560293847__
+#define __VEBSHARD_H_560293847560293847560293847560293847560293847560293847__
+
+#include "vebconc.hpp"
+
+/***************************************************************************//**
+ * @brief      Struct containing the sharded Van Emde Boas tree.
+ *
+ * @details    The universe is split by the top bits of the values into
+ *             shardCnt independent TvEB shards of shardUni elements each,
+ *             every one guarded by its own read-write lock. Operations on
+ *             values of different shards never touch the same lock or cache
+ *             line, so point operations scale with the number of cores.
+ *
+ *             The non-empty shards are marked in a bitmap, changed by atomic
+ *             operations while holding the lock of the shard, and searched
+ *             word by word by vEB_succ and vEB_pred when the answer is not in
+ *             the shard of the value. Operations within one shard are
+ *             linearizable. A search crossing shards locks one shard at a
+ *             time, so it returns an element which was in the set and no
+ *             smaller (greater for vEB_pred) element of the shards it passed
+ *             was there while it checked them, but elements inserted into an
+ *             already passed shard meanwhile may be missed.
+ ******************************************************************************/
+struct TvEBSharded
+{
+  /*************************************************************************//**
+   * @brief      Constructor. Both sizes are rounded up to powers of two. When
+   *             either is not positive or their product exceeds 2^30, the
+   *             tree gets no shards and an empty universe, so it rejects every
+   *             value.
+   *
+   * @param[in]  shardCnt  The number of the shards.
+   * @param[in]  shardUni  The size of the universe of one shard.
+   * @param[in]  flags     The flags of the shards, see TvEB.
+   ****************************************************************************/
+  TvEBSharded ( int shardCnt, int shardUni, int flags = 0 );
+
+  /*************************************************************************//**
+   * @brief      Destructor.
+   ****************************************************************************/
+  ~TvEBSharded();
+
+  /*************************************************************************//**
+   * @brief      The number of the shards.
+   ****************************************************************************/
+  const int shardCnt;
+
+  /*************************************************************************//**
+   * @brief      The number of low bits of a value addressing the element inside
+   *             its shard.
+   ****************************************************************************/
+  const int shardBits;
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  const int uni;
+
+  /*************************************************************************//**
+   * @brief      The flags the shards are created with.
+   ****************************************************************************/
+  const int flags;
+
+  /*************************************************************************//**
+   * @brief      The shards, NULL when empty.
+   ****************************************************************************/
+  TvEB ** shard;
+
+  /*************************************************************************//**
+   * @brief      The locks of the shards.
+   ****************************************************************************/
+  TvEBLock * locks;
+
+  /*************************************************************************//**
+   * @brief      The bitmap of the non-empty shards.
+   ****************************************************************************/
+  uint64_t * nonEmpty;
+};
+
+/***************************************************************************//**
+ * @brief      Finds the lowest value stored in the given tree.
+ *
+ * @param[in]  tree   The pointer to the sharded van Emde Boas tree.
+ * @param[out] res    The lowest element.
+ *
+ * @retval     true   Successfully found the minimum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+bool vEB_min ( TvEBSharded * tree, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the highest value stored in the given tree.
+ *
+ * @param[in]  tree   The pointer to the sharded van Emde Boas tree.
+ * @param[out] res    The highest element.
+ *
+ * @retval     true   Successfully found the maximum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+bool vEB_max ( TvEBSharded * tree, int & res );
+
+/***************************************************************************//**
+ * @brief      Inserts the given value into the given sharded tree.
+ *
+ * @param[in]  tree   The pointer to the sharded van Emde Boas tree.
+ * @param[in]  val    The value of the element to insert.
+ *
+ * @retval     true   Successfully inserted the value.
+ * @retval     false  Failed to insert the value.
+ ******************************************************************************/
+bool vEB_insert ( TvEBSharded * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Removes the given value from the given sharded tree.
+ *
+ * @param[in]  tree   The pointer to the sharded van Emde Boas tree.
+ * @param[in]  val    The value of the element to remove.
+ *
+ * @retval     true   Successfully removed the value.
+ * @retval     false  Failed to remove the value.
+ ******************************************************************************/
+bool vEB_delete ( TvEBSharded * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Finds if the given value is in the given sharded tree.
+ *
+ * @param[in]  tree   The pointer to the sharded van Emde Boas tree.
+ * @param[in]  val    The value of the element to find.
+ *
+ * @retval     true   Successfully found the element.
+ * @retval     false  Failed to found the element.
+ ******************************************************************************/
+bool vEB_find ( TvEBSharded * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Finds the smallest value greater than the given value in the
+ *             given sharded tree.
+ *
+ * @param[in]  tree   The pointer to the sharded van Emde Boas tree.
+ * @param[in]  val    The lower bound for the value of the sought element, -1
+ *                    finds the minimum.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the successor.
+ * @retval     false  Failed to found the successor.
+ ******************************************************************************/
+bool vEB_succ ( TvEBSharded * tree, int val, int & res );
+
+/***************************************************************************//**
+ * @brief      Finds the largest value smaller than the given value in the
+ *             given sharded tree.
+ *
+ * @param[in]  tree   The pointer to the sharded van Emde Boas tree.
+ * @param[in]  val    The upper bound for the value of the sought element, uni
+ *                    finds the maximum.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the predecessor.
+ * @retval     false  Failed to found the predecessor.
+ ******************************************************************************/
+bool vEB_pred ( TvEBSharded * tree, int val, int & res );
+
+#endif /* __VEBSHARD_H_560293847560293847560293847560293847560293847560293847__ */
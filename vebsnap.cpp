@@ -0,0 +1,201 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebsnap.cpp
+ *
+ * @brief      File containing definitions of a persistent Van Emde Boas tree
+ *             with O(1) snapshots.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include <algorithm>
+#include "vebsnap.hpp"
+
+/***************************************************************************//**
+ * @brief      The retire callback of the arena of a persistent tree. An
+ *             emptied node is of the current generation, never seen by a
+ *             snapshot, and is reused at once, as is a replaced node when
+ *             there is no snapshot. The others wait.
+ ******************************************************************************/
+static void persistentRetire ( TvEB * node, void * ctx )
+{
+  TvEBPersistent * tree = ( TvEBPersistent * ) ctx;
+  if ( node->gen == tree->arena.gen )
+  {
+    tree->arena.reuse ( node );
+    return;
+  }
+  // only the writer adds snapshots, so none can appear meanwhile
+  if ( !__atomic_load_n ( &tree->liveCnt, __ATOMIC_ACQUIRE ) )
+  {
+    tree->arena.reuseCopied ( node );
+    return;
+  }
+
+  if ( tree->retiredCnt == tree->retiredCap )
+  {
+    int cap = tree->retiredCap ? tree->retiredCap * 2 : 64;
+    TvEB ** nodes = new TvEB * [cap];
+    int * born = new int [cap];
+    int * died = new int [cap];
+    std::copy ( tree->retired, tree->retired + tree->retiredCnt, nodes );
+    std::copy ( tree->retiredBorn, tree->retiredBorn + tree->retiredCnt, born );
+    std::copy ( tree->retiredDied, tree->retiredDied + tree->retiredCnt, died );
+    delete [] tree->retired;
+    delete [] tree->retiredBorn;
+    delete [] tree->retiredDied;
+    tree->retired = nodes;
+    tree->retiredBorn = born;
+    tree->retiredDied = died;
+    tree->retiredCap = cap;
+  }
+  tree->retired[tree->retiredCnt] = node;
+  tree->retiredBorn[tree->retiredCnt] = node->gen;
+  tree->retiredDied[tree->retiredCnt++] = tree->arena.gen;
+}
+
+/***************************************************************************//**
+ * @brief      Reuses the retired nodes no live snapshot can see, a node
+ *             replaced in generation died is seen by the snapshots from its
+ *             birth to died - 1.
+ ******************************************************************************/
+static void sweep ( TvEBPersistent * tree )
+{
+  pthread_mutex_lock ( &tree->lock );
+  int kept = 0;
+  for ( int i = 0; i < tree->retiredCnt; ++i )
+  {
+    int * seen = std::lower_bound ( tree->live, tree->live + tree->liveCnt, tree->retiredBorn[i] );
+    if ( seen == tree->live + tree->liveCnt || *seen >= tree->retiredDied[i] )
+    {
+      tree->arena.reuseCopied ( tree->retired[i] );
+      continue;
+    }
+    tree->retired[kept] = tree->retired[i];
+    tree->retiredBorn[kept] = tree->retiredBorn[i];
+    tree->retiredDied[kept++] = tree->retiredDied[i];
+  }
+  tree->retiredCnt = kept;
+  tree->released = 0;
+  pthread_mutex_unlock ( &tree->lock );
+  tree->sweepAt = 2 * kept + 1024;
+}
+
+/***************************************************************************//**
+ * @brief      Sweeps the retired nodes after an update when a snapshot was
+ *             released or when they doubled since the last sweep.
+ ******************************************************************************/
+static inline void maybeSweep ( TvEBPersistent * tree )
+{
+  if ( tree->retiredCnt >= tree->sweepAt
+       || ( tree->retiredCnt && __atomic_load_n ( &tree->released, __ATOMIC_RELAXED ) ) )
+  {
+    sweep ( tree );
+  }
+}
+
+TvEBPersistent::TvEBPersistent ( int uniSize, int flags )
+  : uni ( powTwoRoundUp ( uniSize ) ), flags ( flags ), root ( NULL ), live ( NULL ),
+    liveCnt ( 0 ), liveCap ( 0 ), retired ( NULL ), retiredBorn ( NULL ),
+    retiredDied ( NULL ), retiredCnt ( 0 ), retiredCap ( 0 ), sweepAt ( 1024 ),
+    released ( 0 )
+{
+  arena.retire = persistentRetire;
+  arena.retireCtx = this;
+  pthread_mutex_init ( &lock, NULL );
+}
+
+TvEBPersistent::~TvEBPersistent()
+{
+  pthread_mutex_destroy ( &lock );
+  delete [] live;
+  delete [] retired;
+  delete [] retiredBorn;
+  delete [] retiredDied;
+}
+
+TvEBSnapshot * vEB_snapshot ( TvEBPersistent * tree )
+{
+  if ( !tree ) return NULL;
+
+  TvEBSnapshot * snapshot = new TvEBSnapshot;
+  snapshot->root = tree->root;
+  snapshot->gen = tree->arena.gen;
+  snapshot->owner = tree;
+
+  pthread_mutex_lock ( &tree->lock );
+  if ( tree->liveCnt == tree->liveCap )
+  {
+    int cap = tree->liveCap ? tree->liveCap * 2 : 16;
+    int * live = new int [cap];
+    std::copy ( tree->live, tree->live + tree->liveCnt, live );
+    delete [] tree->live;
+    tree->live = live;
+    tree->liveCap = cap;
+  }
+  tree->live[tree->liveCnt++] = snapshot->gen;
+  pthread_mutex_unlock ( &tree->lock );
+
+  // every node there is now is frozen
+  tree->arena.gen++;
+  return snapshot;
+}
+
+void vEB_snapshot_release ( TvEBSnapshot * snapshot )
+{
+  if ( !snapshot ) return;
+
+  TvEBPersistent * tree = snapshot->owner;
+  pthread_mutex_lock ( &tree->lock );
+  int * pos = std::lower_bound ( tree->live, tree->live + tree->liveCnt, snapshot->gen );
+  std::copy ( pos + 1, tree->live + tree->liveCnt, pos );
+  __atomic_store_n ( &tree->liveCnt, tree->liveCnt - 1, __ATOMIC_RELEASE );
+  __atomic_fetch_add ( &tree->released, 1, __ATOMIC_RELAXED );
+  pthread_mutex_unlock ( &tree->lock );
+  delete snapshot;
+}
+
+bool vEB_insert ( TvEBPersistent * tree, int val )
+{
+  if ( !tree || val < 0 || val >= tree->uni ) return false;
+
+  bool ok = vEB_insert ( tree->root, val, tree->uni, &tree->arena, tree->flags );
+  maybeSweep ( tree );
+  return ok;
+}
+
+bool vEB_delete ( TvEBPersistent * tree, int val )
+{
+  if ( !tree ) return false;
+
+  bool ok = vEB_delete ( tree->root, val );
+  maybeSweep ( tree );
+  return ok;
+}
+
+size_t vEB_insert_batch ( TvEBPersistent * tree, const int * vals, size_t n )
+{
+  if ( !tree ) return 0;
+
+  size_t cnt = vEB_insert_batch ( tree->root, vals, n, tree->uni, &tree->arena, tree->flags );
+  maybeSweep ( tree );
+  return cnt;
+}
+
+size_t vEB_delete_batch ( TvEBPersistent * tree, const int * vals, size_t n )
+{
+  if ( !tree ) return 0;
+
+  size_t cnt = vEB_delete_batch ( tree->root, vals, n );
+  maybeSweep ( tree );
+  return cnt;
+}
@@ -0,0 +1,232 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebsnap.hpp
+ *
+ * @brief      File containing declarations of a persistent Van Emde Boas tree
+ *             with O(1) snapshots.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBSNAP_H_273645091827364509182736450918273645091827364509182736__
+#define __VEBSNAP_H_273645091827364509182736450918273645091827364509182736__
+
+#include <pthread.h>
+#include "veb.hpp"
+
+struct TvEBPersistent;
+
+/***************************************************************************//**
+ * @brief      Struct containing a frozen version of a persistent tree.
+ ******************************************************************************/
+struct TvEBSnapshot
+{
+  /*************************************************************************//**
+   * @brief      The tree as it was when the snapshot was taken, NULL when it
+   *             was empty. It is searched by the TvEB functions, vEB_find,
+   *             vEB_succ, the iterators, vEB_rank and so on, from any thread.
+   ****************************************************************************/
+  TvEB * root;
+
+  /*************************************************************************//**
+   * @brief      The generation of the nodes the snapshot froze.
+   ****************************************************************************/
+  int gen;
+
+  /*************************************************************************//**
+   * @brief      The tree the snapshot was taken of.
+   ****************************************************************************/
+  TvEBPersistent * owner;
+};
+
+/***************************************************************************//**
+ * @brief      Struct containing the persistent Van Emde Boas tree.
+ *
+ * @details    It is an ordinary TvEB, whose nodes come from its own arena, and
+ *             its snapshots share all its nodes. A snapshot only advances the
+ *             generation of the arena, so it takes O(1). vEB_insert and
+ *             vEB_delete copy each node of an older generation on their path
+ *             before changing it, the node keeps serving the snapshots and
+ *             its copy, which shares all its clusters, takes its place in the
+ *             tree. An update thus copies O(log log M) nodes, and a node is
+ *             copied at most once per snapshot, as the copy is of the current
+ *             generation. The clusters of the copied nodes are copied as an
+ *             array, never visited.
+ *
+ *             The replaced nodes are retired with the generations they lived
+ *             in. A node is reused once no live snapshot falls into that
+ *             range, which the writer checks on the first update after a
+ *             snapshot is released and whenever the number of retired nodes
+ *             doubles.
+ *
+ *             One thread updates the tree and takes the snapshots, any thread
+ *             may search and release them.
+ ******************************************************************************/
+struct TvEBPersistent
+{
+  /*************************************************************************//**
+   * @brief      Constructor.
+   *
+   * @param[in]  uniSize  The size of the tree universe
+   * @param[in]  flags    VEB_SPARSE and VEB_COUNTED, or 0.
+   ****************************************************************************/
+  TvEBPersistent ( int uniSize, int flags = 0 );
+
+  /*************************************************************************//**
+   * @brief      Destructor. Frees all the nodes, the snapshots must be
+   *             released first.
+   ****************************************************************************/
+  ~TvEBPersistent();
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  const int uni;
+
+  /*************************************************************************//**
+   * @brief      The flags of the tree.
+   ****************************************************************************/
+  const int flags;
+
+  /*************************************************************************//**
+   * @brief      The current version of the tree, NULL when empty. It is
+   *             searched by the TvEB functions from the updating thread only.
+   ****************************************************************************/
+  TvEB * root;
+
+  /*************************************************************************//**
+   * @brief      The arena of the nodes of all the versions.
+   ****************************************************************************/
+  TvEBArena arena;
+
+  /*************************************************************************//**
+   * @brief      The increasing generations of the live snapshots.
+   ****************************************************************************/
+  int * live;
+
+  /*************************************************************************//**
+   * @brief      The number of the live snapshots.
+   ****************************************************************************/
+  int liveCnt;
+
+  /*************************************************************************//**
+   * @brief      The capacity of the live array.
+   ****************************************************************************/
+  int liveCap;
+
+  /*************************************************************************//**
+   * @brief      The replaced nodes waiting for reuse.
+   ****************************************************************************/
+  TvEB ** retired;
+
+  /*************************************************************************//**
+   * @brief      The generations the replaced nodes were created in.
+   ****************************************************************************/
+  int * retiredBorn;
+
+  /*************************************************************************//**
+   * @brief      The generations the replaced nodes were replaced in.
+   ****************************************************************************/
+  int * retiredDied;
+
+  /*************************************************************************//**
+   * @brief      The number of the replaced nodes waiting for reuse.
+   ****************************************************************************/
+  int retiredCnt;
+
+  /*************************************************************************//**
+   * @brief      The capacity of the retired arrays.
+   ****************************************************************************/
+  int retiredCap;
+
+  /*************************************************************************//**
+   * @brief      The number of the retired nodes at which the next sweep runs.
+   ****************************************************************************/
+  int sweepAt;
+
+  /*************************************************************************//**
+   * @brief      The number of the snapshots released since the last sweep.
+   ****************************************************************************/
+  int released;
+
+  /*************************************************************************//**
+   * @brief      The mutex of the live array.
+   ****************************************************************************/
+  pthread_mutex_t lock;
+};
+
+/***************************************************************************//**
+ * @brief      Takes a snapshot of the given persistent tree in O(1).
+ *
+ * @param[in]  tree   The pointer to the persistent van Emde Boas tree.
+ *
+ * @return     The pointer to the snapshot.
+ ******************************************************************************/
+TvEBSnapshot * vEB_snapshot ( TvEBPersistent * tree );
+
+/***************************************************************************//**
+ * @brief      Releases the given snapshot, its nodes are reused by a later
+ *             update. It may be called from any thread.
+ *
+ * @param[in]  snapshot  The pointer to the snapshot.
+ ******************************************************************************/
+void vEB_snapshot_release ( TvEBSnapshot * snapshot );
+
+/***************************************************************************//**
+ * @brief      Inserts the given value into the given persistent tree, the
+ *             snapshots are left unchanged.
+ *
+ * @param[in]  tree   The pointer to the persistent van Emde Boas tree.
+ * @param[in]  val    The value of the element to insert.
+ *
+ * @retval     true   Successfully inserted the value.
+ * @retval     false  Failed to insert the value.
+ ******************************************************************************/
+bool vEB_insert ( TvEBPersistent * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Removes the given value from the given persistent tree, the
+ *             snapshots are left unchanged.
+ *
+ * @param[in]  tree   The pointer to the persistent van Emde Boas tree.
+ * @param[in]  val    The value of the element to remove.
+ *
+ * @retval     true   Successfully removed the value.
+ * @retval     false  Failed to remove the value.
+ ******************************************************************************/
+bool vEB_delete ( TvEBPersistent * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Inserts the given values into the given persistent tree, the
+ *             snapshots are left unchanged.
+ *
+ * @param[in]  tree   The pointer to the persistent van Emde Boas tree.
+ * @param[in]  vals   The values to insert, in any order.
+ * @param[in]  n      The number of the values.
+ *
+ * @return     The number of inserted values.
+ ******************************************************************************/
+size_t vEB_insert_batch ( TvEBPersistent * tree, const int * vals, size_t n );
+
+/***************************************************************************//**
+ * @brief      Removes the given values from the given persistent tree, the
+ *             snapshots are left unchanged.
+ *
+ * @param[in]  tree   The pointer to the persistent van Emde Boas tree.
+ * @param[in]  vals   The values to remove, in any order.
+ * @param[in]  n      The number of the values.
+ *
+ * @return     The number of removed values.
+ ******************************************************************************/
+size_t vEB_delete_batch ( TvEBPersistent * tree, const int * vals, size_t n );
+
+#endif /* __VEBSNAP_H_273645091827364509182736450918273645091827364509182736__ */
@@ -0,0 +1,180 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebstats.cpp
+ *
+ * @brief      File containing definitions of the statistics of the Van Emde
+ *             Boas tree operations.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include <cstring>
+#include <pthread.h>
+#include "vebstats.hpp"
+
+/***************************************************************************//**
+ * @brief      The number of the counters of TvEBStats.
+ ******************************************************************************/
+static const int STATS_FIELDS = sizeof ( TvEBStats ) / sizeof ( uint64_t );
+
+static const char * opNames[VEB_OP_CNT] = { "insert", "delete", "find", "succ", "pred" };
+
+/***************************************************************************//**
+ * @brief      Returns the upper bound in ns of the bucket of the latency
+ *             histogram holding the given share of the timed operations.
+ ******************************************************************************/
+static uint64_t latencyAt ( const uint64_t * hist, double share )
+{
+  uint64_t cnt = 0;
+  for ( int b = 0; b < VEB_STATS_BUCKETS; ++b ) cnt += hist[b];
+  uint64_t seen = 0;
+  for ( int b = 0; b < VEB_STATS_BUCKETS; ++b )
+  {
+    seen += hist[b];
+    if ( seen && seen >= share * cnt ) return ( ( uint64_t ) 1 << b ) - 1;
+  }
+  return 0;
+}
+
+void vEB_stats_print ( const TvEBStats & stats, std::ostream & os )
+{
+  for ( int op = 0; op < VEB_OP_CNT; ++op )
+  {
+    if ( !stats.ops[op] ) continue;
+    uint64_t depthSum = 0;
+    for ( int d = 0; d < VEB_STATS_DEPTHS; ++d ) depthSum += stats.depth[op][d] * ( d + 1 );
+    uint64_t descents = stats.summaryDescents[op] + stats.clusterDescents[op];
+    os << opNames[op] << ": " << stats.ops[op] << " ops, mean depth "
+       << ( double ) depthSum / stats.ops[op] << ", "
+       << ( descents ? 100.0 * stats.summaryDescents[op] / descents : 0 )
+       << " % of descents into a summary, p50 < "
+       << latencyAt ( stats.latency[op], 0.5 ) << " ns, p99 < "
+       << latencyAt ( stats.latency[op], 0.99 ) << " ns" << std::endl;
+  }
+  os << "nodes: " << stats.nodeAllocs << " allocated, " << stats.nodeFrees << " freed" << std::endl;
+}
+
+#ifdef VEB_STATS
+
+__thread TvEBStatsLocal vEBStatsLocal;
+
+/***************************************************************************//**
+ * @brief      The mutex of the list of the threads and of the sums below.
+ ******************************************************************************/
+static pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/***************************************************************************//**
+ * @brief      The key whose destructor unregisters an exiting thread.
+ ******************************************************************************/
+static pthread_key_t statsKey;
+
+static pthread_once_t statsKeyOnce = PTHREAD_ONCE_INIT;
+
+/***************************************************************************//**
+ * @brief      The list of the registered threads.
+ ******************************************************************************/
+static TvEBStatsLocal * statsThreads = NULL;
+
+/***************************************************************************//**
+ * @brief      The statistics of the exited threads.
+ ******************************************************************************/
+static TvEBStats statsExited;
+
+/***************************************************************************//**
+ * @brief      The statistics at the last vEB_stats_reset.
+ ******************************************************************************/
+static TvEBStats statsBase;
+
+/***************************************************************************//**
+ * @brief      Adds the statistics of the exiting thread to the ones of the
+ *             exited threads and removes it from the list.
+ ******************************************************************************/
+static void statsUnregister ( void * arg )
+{
+  TvEBStatsLocal * local = ( TvEBStatsLocal * ) arg;
+  pthread_mutex_lock ( &statsLock );
+  const uint64_t * src = ( const uint64_t * ) &local->stats;
+  uint64_t * dst = ( uint64_t * ) &statsExited;
+  for ( int i = 0; i < STATS_FIELDS; ++i ) dst[i] += src[i];
+  if ( local->prev ) local->prev->next = local->next;
+  else statsThreads = local->next;
+  if ( local->next ) local->next->prev = local->prev;
+  pthread_mutex_unlock ( &statsLock );
+}
+
+/***************************************************************************//**
+ * @brief      Creates the key on the first registration.
+ ******************************************************************************/
+static void statsCreateKey()
+{
+  pthread_key_create ( &statsKey, statsUnregister );
+}
+
+void vEB_stats_register()
+{
+  TvEBStatsLocal * local = &vEBStatsLocal;
+  pthread_once ( &statsKeyOnce, statsCreateKey );
+  pthread_mutex_lock ( &statsLock );
+  local->registered = true;
+  local->prev = NULL;
+  local->next = statsThreads;
+  if ( local->next ) local->next->prev = local;
+  statsThreads = local;
+  pthread_mutex_unlock ( &statsLock );
+  pthread_setspecific ( statsKey, local );
+}
+
+/***************************************************************************//**
+ * @brief      Sums the statistics of all the threads ever, under the lock.
+ ******************************************************************************/
+static void statsSum ( TvEBStats & stats )
+{
+  uint64_t * dst = ( uint64_t * ) &stats;
+  memcpy ( dst, &statsExited, sizeof ( stats ) );
+  for ( TvEBStatsLocal * local = statsThreads; local; local = local->next )
+  {
+    uint64_t * src = ( uint64_t * ) &local->stats;
+    for ( int i = 0; i < STATS_FIELDS; ++i ) dst[i] += __atomic_load_n ( src + i, __ATOMIC_RELAXED );
+  }
+}
+
+bool vEB_stats_snapshot ( TvEBStats & stats )
+{
+  pthread_mutex_lock ( &statsLock );
+  statsSum ( stats );
+  uint64_t * dst = ( uint64_t * ) &stats;
+  const uint64_t * base = ( const uint64_t * ) &statsBase;
+  for ( int i = 0; i < STATS_FIELDS; ++i ) dst[i] -= base[i];
+  pthread_mutex_unlock ( &statsLock );
+  return true;
+}
+
+void vEB_stats_reset()
+{
+  pthread_mutex_lock ( &statsLock );
+  statsSum ( statsBase );
+  pthread_mutex_unlock ( &statsLock );
+}
+
+#else
+
+bool vEB_stats_snapshot ( TvEBStats & stats )
+{
+  memset ( &stats, 0, sizeof ( stats ) );
+  return false;
+}
+
+void vEB_stats_reset()
+{
+}
+
+#endif /* VEB_STATS */
@@ -0,0 +1,273 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebstats.hpp
+ *
+ * @brief      File containing declarations of the statistics of the Van Emde
+ *             Boas tree operations, collected when built with VEB_STATS.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBSTATS_H_918273645091827364509182736450918273645091827364509182__
+#define __VEBSTATS_H_918273645091827364509182736450918273645091827364509182__
+
+#include <ctime>
+#include <iostream>
+#include <stdint.h>
+
+// #define VEB_STATS
+
+/***************************************************************************//**
+ * @brief      The number of the depths told apart by the histograms, deeper
+ *             operations fall into the last one.
+ ******************************************************************************/
+#define VEB_STATS_DEPTHS 16
+
+/***************************************************************************//**
+ * @brief      The number of the buckets of the latency histograms, bucket b
+ *             holds the operations taking 2^(b-1) to 2^b - 1 ns.
+ ******************************************************************************/
+#define VEB_STATS_BUCKETS 32
+
+/***************************************************************************//**
+ * @brief      One operation in VEB_STATS_SAMPLE of each thread is timed, as
+ *             reading the clock costs about as much as a small operation.
+ ******************************************************************************/
+#ifndef VEB_STATS_SAMPLE
+#define VEB_STATS_SAMPLE 16
+#endif
+
+/***************************************************************************//**
+ * @brief      The operations counted by the statistics.
+ ******************************************************************************/
+enum
+{
+  VEB_OP_INSERT,  ///< vEB_insert
+  VEB_OP_DELETE,  ///< vEB_delete
+  VEB_OP_FIND,    ///< vEB_find
+  VEB_OP_SUCC,    ///< vEB_succ
+  VEB_OP_PRED,    ///< vEB_pred
+  VEB_OP_CNT
+};
+
+/***************************************************************************//**
+ * @brief      Struct containing the statistics of the operations on all the
+ *             TvEB trees of all the threads.
+ *
+ * @details    An operation is a call of vEB_insert, vEB_delete, vEB_find,
+ *             vEB_succ or vEB_pred on a TvEB from outside of them, including
+ *             the calls the concurrent, sharded, durable and persistent trees
+ *             make. Its depth is the number of the nodes on its deepest path,
+ *             the root being 1.
+ ******************************************************************************/
+struct TvEBStats
+{
+  /*************************************************************************//**
+   * @brief      The number of the operations.
+   ****************************************************************************/
+  uint64_t ops[VEB_OP_CNT];
+
+  /*************************************************************************//**
+   * @brief      The histograms of the depths of the operations.
+   ****************************************************************************/
+  uint64_t depth[VEB_OP_CNT][VEB_STATS_DEPTHS];
+
+  /*************************************************************************//**
+   * @brief      The number of the recursive calls into a summary.
+   ****************************************************************************/
+  uint64_t summaryDescents[VEB_OP_CNT];
+
+  /*************************************************************************//**
+   * @brief      The number of the recursive calls into a cluster.
+   ****************************************************************************/
+  uint64_t clusterDescents[VEB_OP_CNT];
+
+  /*************************************************************************//**
+   * @brief      The histograms of the latencies of the timed operations.
+   ****************************************************************************/
+  uint64_t latency[VEB_OP_CNT][VEB_STATS_BUCKETS];
+
+  /*************************************************************************//**
+   * @brief      The number of the nodes created by the inserts, one by one
+   *             or in batches, and by the copies of the persistent trees.
+   ****************************************************************************/
+  uint64_t nodeAllocs;
+
+  /*************************************************************************//**
+   * @brief      The number of the emptied nodes released by the deletes, one
+   *             by one or in batches, and of the nodes replaced by their
+   *             copies.
+   ****************************************************************************/
+  uint64_t nodeFrees;
+};
+
+/***************************************************************************//**
+ * @brief      Sums the statistics of all the threads since the last
+ *             vEB_stats_reset. The counters are read while the other threads
+ *             keep updating them, so the sums are a moment of each thread,
+ *             not of all of them.
+ *
+ * @param[out] stats  The statistics.
+ *
+ * @retval     true   Successfully read the statistics.
+ * @retval     false  The library was built without VEB_STATS, stats is zeroed.
+ ******************************************************************************/
+bool vEB_stats_snapshot ( TvEBStats & stats );
+
+/***************************************************************************//**
+ * @brief      Starts the statistics of vEB_stats_snapshot from zero.
+ ******************************************************************************/
+void vEB_stats_reset();
+
+/***************************************************************************//**
+ * @brief      Prints the counts, the mean depth, the share of the descents
+ *             into a summary and the median and 99th percentile latency of
+ *             each operation, and the node counts.
+ *
+ * @param[in]  stats  The statistics.
+ * @param      os     The output stream.
+ ******************************************************************************/
+void vEB_stats_print ( const TvEBStats & stats, std::ostream & os );
+
+#ifdef VEB_STATS
+
+/***************************************************************************//**
+ * @brief      Struct containing the statistics of one thread, written by it
+ *             only and read by vEB_stats_snapshot. It is plain data, so the
+ *             hot path reaches it without the guard of a thread_local object.
+ ******************************************************************************/
+struct TvEBStatsLocal
+{
+  /*************************************************************************//**
+   * @brief      The statistics of the thread.
+   ****************************************************************************/
+  TvEBStats stats;
+
+  /*************************************************************************//**
+   * @brief      The depth of the running operation, 0 outside of one.
+   ****************************************************************************/
+  int depth;
+
+  /*************************************************************************//**
+   * @brief      The deepest depth the running operation reached.
+   ****************************************************************************/
+  int maxDepth;
+
+  /*************************************************************************//**
+   * @brief      The running operation.
+   ****************************************************************************/
+  int op;
+
+  /*************************************************************************//**
+   * @brief      Whether the thread is in the list of vEB_stats_snapshot.
+   ****************************************************************************/
+  bool registered;
+
+  /*************************************************************************//**
+   * @brief      The number of the operations of the thread, every
+   *             VEB_STATS_SAMPLE-th of them is timed.
+   ****************************************************************************/
+  unsigned sample;
+
+  /*************************************************************************//**
+   * @brief      The time the running operation started at in ns, 0 when it
+   *             is not timed.
+   ****************************************************************************/
+  uint64_t start;
+
+  /*************************************************************************//**
+   * @brief      The neighbours in the list of the registered threads.
+   ****************************************************************************/
+  TvEBStatsLocal * prev, * next;
+};
+
+/***************************************************************************//**
+ * @brief      The statistics of the calling thread.
+ ******************************************************************************/
+extern __thread TvEBStatsLocal vEBStatsLocal;
+
+/***************************************************************************//**
+ * @brief      Adds the statistics of the calling thread to the list of
+ *             vEB_stats_snapshot, and to the ones of the exited threads when
+ *             it exits.
+ ******************************************************************************/
+void vEB_stats_register();
+
+/***************************************************************************//**
+ * @brief      Increments the counter of the thread. The relaxed load and
+ *             store compile to a plain increment, and they keep the reads of
+ *             vEB_stats_snapshot free of data races.
+ ******************************************************************************/
+static inline void statsBump ( uint64_t & counter )
+{
+  __atomic_store_n ( &counter, __atomic_load_n ( &counter, __ATOMIC_RELAXED ) + 1, __ATOMIC_RELAXED );
+}
+
+/***************************************************************************//**
+ * @brief      Struct counting the recursion of an operation, it lives as long
+ *             as one call of it. The outermost call records the operation
+ *             when it returns, and times it when it is sampled.
+ ******************************************************************************/
+struct TvEBStatsScope
+{
+  TvEBStatsScope ( int op )
+  {
+    TvEBStatsLocal & local = vEBStatsLocal;
+    if ( local.depth++ )
+    {
+      if ( local.depth > local.maxDepth ) local.maxDepth = local.depth;
+      return;
+    }
+    if ( !local.registered ) vEB_stats_register();
+    local.op = op;
+    local.maxDepth = 1;
+    local.start = local.sample++ % VEB_STATS_SAMPLE ? 0 : now();
+  }
+
+  ~TvEBStatsScope()
+  {
+    TvEBStatsLocal & local = vEBStatsLocal;
+    if ( --local.depth ) return;
+    int depth = local.maxDepth - 1;
+    statsBump ( local.stats.ops[local.op] );
+    statsBump ( local.stats.depth[local.op][depth < VEB_STATS_DEPTHS ? depth : VEB_STATS_DEPTHS - 1] );
+    if ( !local.start ) return;
+    uint64_t ns = now() - local.start;
+    int bucket = ns ? 64 - __builtin_clzll ( ns ) : 0;
+    statsBump ( local.stats.latency[local.op][bucket < VEB_STATS_BUCKETS ? bucket : VEB_STATS_BUCKETS - 1] );
+  }
+
+  static uint64_t now()
+  {
+    timespec ts;
+    clock_gettime ( CLOCK_MONOTONIC, &ts );
+    return ( uint64_t ) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+  }
+};
+
+#define VEB_STATS_SCOPE(op) TvEBStatsScope vEBStatsScope ( op )
+#define VEB_STATS_SUMMARY() statsBump ( vEBStatsLocal.stats.summaryDescents[vEBStatsLocal.op] )
+#define VEB_STATS_CLUSTER() statsBump ( vEBStatsLocal.stats.clusterDescents[vEBStatsLocal.op] )
+#define VEB_STATS_ALLOC() statsBump ( vEBStatsLocal.stats.nodeAllocs )
+#define VEB_STATS_FREE() statsBump ( vEBStatsLocal.stats.nodeFrees )
+
+#else
+
+#define VEB_STATS_SCOPE(op)
+#define VEB_STATS_SUMMARY()
+#define VEB_STATS_CLUSTER()
+#define VEB_STATS_ALLOC()
+#define VEB_STATS_FREE()
+
+#endif /* VEB_STATS */
+
+#endif /* __VEBSTATS_H_918273645091827364509182736450918273645091827364509182__ */
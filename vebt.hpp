@@ -0,0 +1,617 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebt.hpp
+ *
+ * @brief      File containing a class template implementing Van Emde Boas tree
+ *             data structure over keys of a fixed bit width.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBT_H_783465873465873465983476598347659834765983476598347659834__
+#define __VEBT_H_783465873465873465983476598347659834765983476598347659834__
+
+#include <climits>
+#include <cstddef>
+#include <stdint.h>
+#include <unordered_map>
+#include <type_traits>
+
+/***************************************************************************//**
+ * @brief      Clusters wider than 2^VEB_DENSE_BITS are kept in a hash map
+ *             instead of a pointer array.
+ ******************************************************************************/
+#ifndef VEB_DENSE_BITS
+#define VEB_DENSE_BITS 10
+#endif /* VEB_DENSE_BITS */
+
+/***************************************************************************//**
+ * @brief      Trees over at most VEB_LEAF_BITS-bit keys are leaves keeping
+ *             their elements in a single 64-bit word.
+ ******************************************************************************/
+#define VEB_LEAF_BITS 6
+
+/***************************************************************************//**
+ * @brief      The smallest unsigned integer type holding Bits bits.
+ ******************************************************************************/
+template <unsigned Bits>
+struct TvEBKey
+{
+  typedef typename std::conditional < ( Bits <= 16 ), uint16_t,
+          typename std::conditional < ( Bits <= 32 ), uint32_t,
+          uint64_t >::type >::type type;
+};
+
+/***************************************************************************//**
+ * @brief      The clusters of a tree, indexed by the high bits of a value.
+ *
+ * @details    Narrow levels keep a pointer array with 2^HighBits entries which
+ *             is allocated on the first cluster, wide levels (64-bit keys have
+ *             2^32 clusters on the top level) keep only the occupied clusters
+ *             in a hash map.
+ ******************************************************************************/
+template <typename TCluster, unsigned HighBits,
+          bool Dense = ( HighBits <= VEB_DENSE_BITS )>
+struct TvEBTClusters;
+
+template <typename TCluster, unsigned HighBits>
+struct TvEBTClusters<TCluster, HighBits, true>
+{
+  typedef typename TvEBKey<HighBits>::type key_type;
+
+  TvEBTClusters() : slots ( NULL ) { }
+
+  ~TvEBTClusters()
+  {
+    if ( !slots ) return;
+    for ( size_t i = 0; i < ( size_t ) 1 << HighBits; ++i )
+    {
+      if ( slots[i] ) delete slots[i];
+    }
+    delete [] slots;
+  }
+
+  /*************************************************************************//**
+   * @brief      Returns the cluster with the given index or NULL.
+   ****************************************************************************/
+  TCluster * get ( key_type high ) const
+  {
+    return slots ? slots[high] : NULL;
+  }
+
+  /*************************************************************************//**
+   * @brief      Returns the slot of the cluster with the given index, creating
+   *             an empty one if there is none.
+   ****************************************************************************/
+  TCluster *& ref ( key_type high )
+  {
+    if ( !slots )
+    {
+      slots = new TCluster * [( size_t ) 1 << HighBits]();
+    }
+    return slots[high];
+  }
+
+  /*************************************************************************//**
+   * @brief      Forgets the slot of an emptied cluster. The array slot was
+   *             already cleared by the caller, this overload only exists so
+   *             that both cluster stores share one interface.
+   ****************************************************************************/
+  void erase ( key_type ) { }
+
+  TCluster ** slots;
+};
+
+template <typename TCluster, unsigned HighBits>
+struct TvEBTClusters<TCluster, HighBits, false>
+{
+  typedef typename TvEBKey<HighBits>::type key_type;
+
+  ~TvEBTClusters()
+  {
+    for ( typename std::unordered_map<key_type, TCluster *>::iterator it =
+            slots.begin(); it != slots.end(); ++it )
+    {
+      delete it->second;
+    }
+  }
+
+  TCluster * get ( key_type high ) const
+  {
+    typename std::unordered_map<key_type, TCluster *>::const_iterator it =
+      slots.find ( high );
+    return it == slots.end() ? NULL : it->second;
+  }
+
+  TCluster *& ref ( key_type high )
+  {
+    return slots[high];
+  }
+
+  void erase ( key_type high )
+  {
+    slots.erase ( high );
+  }
+
+  std::unordered_map<key_type, TCluster *> slots;
+};
+
+/***************************************************************************//**
+ * @brief      Struct template containing the Van Emde Boas tree over Bits-bit
+ *             keys.
+ *
+ * @details    Works as TvEB, but the universe is fixed to 2^Bits at compile
+ *             time, so the split of the key into cluster index and position
+ *             in the cluster, the fan-out and the recursion depth are all
+ *             constants. Every level is a distinct type: summary is a
+ *             TvEBT<ceil ( Bits / 2 )> and the clusters are
+ *             TvEBT<floor ( Bits / 2 )>, which ends in the bitmap leaf
+ *             specialization and lets the compiler inline the whole descent.
+ *             Keys are unsigned, an empty tree has min > max.
+ ******************************************************************************/
+template <unsigned Bits, bool Leaf = ( Bits <= VEB_LEAF_BITS )>
+struct TvEBT;
+
+template <unsigned Bits>
+struct TvEBT<Bits, false>
+{
+  typedef typename TvEBKey<Bits>::type key_type;
+
+  static const unsigned LOW_BITS = Bits / 2;
+  static const unsigned HIGH_BITS = Bits - Bits / 2;
+  static const key_type LOW_MASK = ( key_type ) ( ( ( key_type ) 1 << LOW_BITS ) - 1 );
+  static const key_type MAX_KEY = ( key_type ) ( ~ ( key_type ) 0 ) >> ( sizeof ( key_type ) * CHAR_BIT - Bits );
+
+  typedef TvEBT<HIGH_BITS> TSummary;
+  typedef TvEBT<LOW_BITS> TCluster;
+
+  /*************************************************************************//**
+   * @brief      Constructor of an empty tree.
+   ****************************************************************************/
+  TvEBT() : min ( ~ ( key_type ) 0 ), max ( 0 ), summary ( NULL ) { }
+
+  /*************************************************************************//**
+   * @brief      Destructor.
+   ****************************************************************************/
+  ~TvEBT() { if ( summary ) delete summary; }
+
+  /*************************************************************************//**
+   * @brief      Returns the index of the element's cluster.
+   ****************************************************************************/
+  static typename TSummary::key_type high ( key_type val )
+  {
+    return val >> LOW_BITS;
+  }
+
+  /*************************************************************************//**
+   * @brief      Returns the element's index in the cluster.
+   ****************************************************************************/
+  static typename TCluster::key_type low ( key_type val )
+  {
+    return val & LOW_MASK;
+  }
+
+  /*************************************************************************//**
+   * @brief      Returns the value on index low in the cluster high.
+   ****************************************************************************/
+  static key_type index ( key_type high, key_type low )
+  {
+    return ( high << LOW_BITS ) | low;
+  }
+
+  /*************************************************************************//**
+   * @brief      The minimal value in the tree.
+   ****************************************************************************/
+  key_type min;
+
+  /*************************************************************************//**
+   * @brief      The maximal value in the tree.
+   ****************************************************************************/
+  key_type max;
+
+  /*************************************************************************//**
+   * @brief      The pointer to the summary structure of the tree.
+   ****************************************************************************/
+  TSummary * summary;
+
+  /*************************************************************************//**
+   * @brief      The clusters of the tree.
+   ****************************************************************************/
+  TvEBTClusters<TCluster, HIGH_BITS> cluster;
+};
+
+/***************************************************************************//**
+ * @brief      The base case, a tree over at most 64 elements kept as bits of
+ *             one word. The minimum and maximum are in the bitmap too.
+ ******************************************************************************/
+template <unsigned Bits>
+struct TvEBT<Bits, true>
+{
+  typedef typename TvEBKey<Bits>::type key_type;
+
+  static const key_type MAX_KEY = ( key_type ) ( ( ( uint64_t ) 1 << Bits ) - 1 );
+
+  TvEBT() : min ( ~ ( key_type ) 0 ), max ( 0 ), bits ( 0 ) { }
+
+  key_type min;
+
+  key_type max;
+
+  /*************************************************************************//**
+   * @brief      The bitmap of the elements.
+   ****************************************************************************/
+  uint64_t bits;
+};
+
+/***************************************************************************//**
+ * @brief      Finds the lowest value stored in the given tree.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[out] res    The lowest element.
+ *
+ * @retval     true   Successfully found the minimum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+template <unsigned Bits, bool Leaf>
+bool vEB_min ( const TvEBT<Bits, Leaf> * tree,
+               typename TvEBT<Bits, Leaf>::key_type & res )
+{
+  if ( !tree || tree->min > tree->max ) return false;
+  res = tree->min;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Finds the highest value stored in the given tree.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[out] res    The highest element.
+ *
+ * @retval     true   Successfully found the maximum.
+ * @retval     false  The tree is empty.
+ ******************************************************************************/
+template <unsigned Bits, bool Leaf>
+bool vEB_max ( const TvEBT<Bits, Leaf> * tree,
+               typename TvEBT<Bits, Leaf>::key_type & res )
+{
+  if ( !tree || tree->min > tree->max ) return false;
+  res = tree->max;
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Inserts the given value into the given vEB tree, creating the
+ *             tree if the pointer is NULL.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  val    The value of the element to insert.
+ *
+ * @retval     true   Successfully inserted the value.
+ * @retval     false  The value is out of the universe or already present.
+ ******************************************************************************/
+template <unsigned Bits>
+bool vEB_insert ( TvEBT<Bits, false> *& tree,
+                  typename TvEBT<Bits, false>::key_type val );
+
+template <unsigned Bits>
+bool vEB_insert ( TvEBT<Bits, true> *& tree,
+                  typename TvEBT<Bits, true>::key_type val );
+
+/***************************************************************************//**
+ * @brief      Removes the given value from the given vEB tree. The emptied
+ *             tree is deleted and the pointer set to NULL.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  val    The value of the element to remove.
+ *
+ * @retval     true   Successfully removed the value.
+ * @retval     false  The value is not in the tree.
+ ******************************************************************************/
+template <unsigned Bits>
+bool vEB_delete ( TvEBT<Bits, false> *& tree,
+                  typename TvEBT<Bits, false>::key_type val );
+
+template <unsigned Bits>
+bool vEB_delete ( TvEBT<Bits, true> *& tree,
+                  typename TvEBT<Bits, true>::key_type val );
+
+/***************************************************************************//**
+ * @brief      Finds if the given value is in the given vEB tree.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  val    The value of the element to find.
+ *
+ * @retval     true   Successfully found the element.
+ * @retval     false  Failed to found the element.
+ ******************************************************************************/
+template <unsigned Bits>
+bool vEB_find ( const TvEBT<Bits, false> * tree,
+                typename TvEBT<Bits, false>::key_type val );
+
+template <unsigned Bits>
+bool vEB_find ( const TvEBT<Bits, true> * tree,
+                typename TvEBT<Bits, true>::key_type val );
+
+/***************************************************************************//**
+ * @brief      Finds the smallest value greater than the given value in the
+ *             given tree.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  val    The lower bound for the value of the sought element.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the successor.
+ * @retval     false  Failed to found the successor.
+ ******************************************************************************/
+template <unsigned Bits>
+bool vEB_succ ( const TvEBT<Bits, false> * tree,
+                typename TvEBT<Bits, false>::key_type val,
+                typename TvEBT<Bits, false>::key_type & res );
+
+template <unsigned Bits>
+bool vEB_succ ( const TvEBT<Bits, true> * tree,
+                typename TvEBT<Bits, true>::key_type val,
+                typename TvEBT<Bits, true>::key_type & res );
+
+/***************************************************************************//**
+ * @brief      Finds the largest value smaller than the given value in the
+ *             given tree.
+ *
+ * @param[in]  tree   The pointer to the van Emde Boas tree.
+ * @param[in]  val    The upper bound for the value of the sought element.
+ * @param[out] res    The found element.
+ *
+ * @retval     true   Successfully found the predecessor.
+ * @retval     false  Failed to found the predecessor.
+ ******************************************************************************/
+template <unsigned Bits>
+bool vEB_pred ( const TvEBT<Bits, false> * tree,
+                typename TvEBT<Bits, false>::key_type val,
+                typename TvEBT<Bits, false>::key_type & res );
+
+template <unsigned Bits>
+bool vEB_pred ( const TvEBT<Bits, true> * tree,
+                typename TvEBT<Bits, true>::key_type val,
+                typename TvEBT<Bits, true>::key_type & res );
+
+template <unsigned Bits>
+bool vEB_insert ( TvEBT<Bits, false> *& tree,
+                  typename TvEBT<Bits, false>::key_type val )
+{
+  typedef TvEBT<Bits, false> T;
+
+  if ( val > T::MAX_KEY ) return false;
+  if ( !tree ) tree = new T();
+
+  if ( tree->min > tree->max )
+  {
+    tree->min = tree->max = val;
+    return true;
+  }
+
+  if ( tree->min == val || tree->max == val ) return false;
+
+  if ( val < tree->min )
+  {
+    typename T::key_type tmp = val;
+    val = tree->min;
+    tree->min = tmp;
+  }
+
+  if ( val > tree->max )
+  {
+    tree->max = val;
+  }
+
+  typename T::TSummary::key_type highVal = T::high ( val );
+  typename T::TCluster *& cluster = tree->cluster.ref ( highVal );
+  if ( !cluster )
+  {
+    vEB_insert ( tree->summary, highVal );
+  }
+  return vEB_insert ( cluster, T::low ( val ) );
+}
+
+template <unsigned Bits>
+bool vEB_insert ( TvEBT<Bits, true> *& tree,
+                  typename TvEBT<Bits, true>::key_type val )
+{
+  if ( val > TvEBT<Bits, true>::MAX_KEY ) return false;
+  if ( !tree ) tree = new TvEBT<Bits, true>();
+
+  uint64_t bit = ( uint64_t ) 1 << val;
+  if ( tree->bits & bit ) return false;
+  if ( !tree->bits || val < tree->min ) tree->min = val;
+  if ( !tree->bits || val > tree->max ) tree->max = val;
+  tree->bits |= bit;
+  return true;
+}
+
+template <unsigned Bits>
+bool vEB_delete ( TvEBT<Bits, false> *& tree,
+                  typename TvEBT<Bits, false>::key_type val )
+{
+  typedef TvEBT<Bits, false> T;
+
+  if ( !tree ) return false;
+  if ( val < tree->min || val > tree->max ) return false;
+
+  if ( tree->min == tree->max )
+  {
+    delete tree;
+    tree = NULL;
+    return true;
+  }
+
+  if ( val == tree->min )
+  {
+    typename T::TSummary::key_type i = tree->summary->min;
+    val = tree->min = T::index ( i, tree->cluster.get ( i )->min );
+  }
+
+  typename T::TSummary::key_type highVal = T::high ( val );
+  typename T::TCluster * cluster = tree->cluster.get ( highVal );
+  if ( !cluster ) return false;
+  if ( !vEB_delete ( cluster, T::low ( val ) ) ) return false;
+  if ( !cluster )
+  {
+    tree->cluster.ref ( highVal ) = NULL;
+    tree->cluster.erase ( highVal );
+    vEB_delete ( tree->summary, highVal );
+  }
+
+  if ( val == tree->max )
+  {
+    if ( !tree->summary )
+    {
+      tree->max = tree->min;
+    }
+    else
+    {
+      typename T::TSummary::key_type i = tree->summary->max;
+      tree->max = T::index ( i, tree->cluster.get ( i )->max );
+    }
+  }
+  return true;
+}
+
+template <unsigned Bits>
+bool vEB_delete ( TvEBT<Bits, true> *& tree,
+                  typename TvEBT<Bits, true>::key_type val )
+{
+  if ( !tree || val > TvEBT<Bits, true>::MAX_KEY ) return false;
+
+  uint64_t bit = ( uint64_t ) 1 << val;
+  if ( !( tree->bits & bit ) ) return false;
+  tree->bits &= ~bit;
+  if ( !tree->bits )
+  {
+    delete tree;
+    tree = NULL;
+    return true;
+  }
+  tree->min = __builtin_ctzll ( tree->bits );
+  tree->max = 63 - __builtin_clzll ( tree->bits );
+  return true;
+}
+
+template <unsigned Bits>
+bool vEB_find ( const TvEBT<Bits, false> * tree,
+                typename TvEBT<Bits, false>::key_type val )
+{
+  typedef TvEBT<Bits, false> T;
+
+  if ( !tree ) return false;
+  if ( val < tree->min || val > tree->max ) return false;
+  if ( val == tree->min || val == tree->max ) return true;
+  return vEB_find ( tree->cluster.get ( T::high ( val ) ), T::low ( val ) );
+}
+
+template <unsigned Bits>
+bool vEB_find ( const TvEBT<Bits, true> * tree,
+                typename TvEBT<Bits, true>::key_type val )
+{
+  return tree && val <= TvEBT<Bits, true>::MAX_KEY && ( ( tree->bits >> val ) & 1 );
+}
+
+template <unsigned Bits>
+bool vEB_succ ( const TvEBT<Bits, false> * tree,
+                typename TvEBT<Bits, false>::key_type val,
+                typename TvEBT<Bits, false>::key_type & res )
+{
+  typedef TvEBT<Bits, false> T;
+
+  if ( !tree || tree->min > tree->max ) return false;
+
+  if ( val < tree->min )
+  {
+    res = tree->min;
+    return true;
+  }
+  if ( val >= tree->max ) return false;
+
+  typename T::TSummary::key_type highVal = T::high ( val );
+  typename T::TCluster::key_type lowVal = T::low ( val ), j;
+  const typename T::TCluster * cluster = tree->cluster.get ( highVal );
+  if ( cluster && lowVal < cluster->max )
+  {
+    vEB_succ ( cluster, lowVal, j );
+    res = T::index ( highVal, j );
+    return true;
+  }
+
+  typename T::TSummary::key_type i;
+  if ( !vEB_succ ( tree->summary, highVal, i ) ) return false;
+  res = T::index ( i, tree->cluster.get ( i )->min );
+  return true;
+}
+
+template <unsigned Bits>
+bool vEB_succ ( const TvEBT<Bits, true> * tree,
+                typename TvEBT<Bits, true>::key_type val,
+                typename TvEBT<Bits, true>::key_type & res )
+{
+  if ( !tree || !tree->bits || val >= tree->max ) return false;
+
+  res = __builtin_ctzll ( tree->bits & ( ~ ( uint64_t ) 1 << val ) );
+  return true;
+}
+
+template <unsigned Bits>
+bool vEB_pred ( const TvEBT<Bits, false> * tree,
+                typename TvEBT<Bits, false>::key_type val,
+                typename TvEBT<Bits, false>::key_type & res )
+{
+  typedef TvEBT<Bits, false> T;
+
+  if ( !tree || tree->min > tree->max ) return false;
+
+  if ( val > tree->max )
+  {
+    res = tree->max;
+    return true;
+  }
+  if ( val <= tree->min ) return false;
+
+  typename T::TSummary::key_type highVal = T::high ( val );
+  typename T::TCluster::key_type lowVal = T::low ( val ), j;
+  const typename T::TCluster * cluster = tree->cluster.get ( highVal );
+  if ( cluster && lowVal > cluster->min )
+  {
+    vEB_pred ( cluster, lowVal, j );
+    res = T::index ( highVal, j );
+    return true;
+  }
+
+  typename T::TSummary::key_type i;
+  if ( !vEB_pred ( tree->summary, highVal, i ) )
+  {
+    res = tree->min;
+    return true;
+  }
+  res = T::index ( i, tree->cluster.get ( i )->max );
+  return true;
+}
+
+template <unsigned Bits>
+bool vEB_pred ( const TvEBT<Bits, true> * tree,
+                typename TvEBT<Bits, true>::key_type val,
+                typename TvEBT<Bits, true>::key_type & res )
+{
+  if ( !tree || !tree->bits || val <= tree->min ) return false;
+
+  if ( val > tree->max ) res = tree->max;
+  else res = 63 - __builtin_clzll ( tree->bits & ( ( ( uint64_t ) 1 << val ) - 1 ) );
+  return true;
+}
+
+#endif /* __VEBT_H_783465873465873465983476598347659834765983476598347659834__ */
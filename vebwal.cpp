@@ -0,0 +1,408 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebwal.cpp
+ *
+ * @brief      File containing definitions of a durable Van Emde Boas tree
+ *             kept in a directory as a write-ahead log and checkpoint images.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include "vebwal.hpp"
+
+/***************************************************************************//**
+ * @brief      The first word of a manifest, "vEBmanif" read as a little endian
+ *             word.
+ ******************************************************************************/
+#define VEB_MANIFEST_MAGIC 0x66696e616d424576ULL
+
+/***************************************************************************//**
+ * @brief      Struct containing the manifest of a durable tree.
+ ******************************************************************************/
+struct TvEBManifest
+{
+  /*************************************************************************//**
+   * @brief      VEB_MANIFEST_MAGIC.
+   ****************************************************************************/
+  uint64_t magic;
+
+  /*************************************************************************//**
+   * @brief      The version of the format, VEB_IMAGE_VERSION.
+   ****************************************************************************/
+  uint32_t version;
+
+  /*************************************************************************//**
+   * @brief      The size of the universe.
+   ****************************************************************************/
+  uint32_t uni;
+
+  /*************************************************************************//**
+   * @brief      The number of low bits of a value inside its segment.
+   ****************************************************************************/
+  uint32_t segBits;
+
+  /*************************************************************************//**
+   * @brief      Reserved, 0.
+   ****************************************************************************/
+  uint32_t reserved;
+
+  /*************************************************************************//**
+   * @brief      The sequence number of the last change in the images.
+   ****************************************************************************/
+  uint64_t lsn;
+
+  /*************************************************************************//**
+   * @brief      The checksum of the other fields.
+   ****************************************************************************/
+  uint64_t check;
+};
+
+/***************************************************************************//**
+ * @brief      Mixes the given word into the given hash.
+ ******************************************************************************/
+static inline uint64_t mix ( uint64_t hash, uint64_t word )
+{
+  hash ^= word * 0x9e3779b97f4a7c15ULL;
+  hash ^= hash >> 29;
+  return hash * 0xbf58476d1ce4e5b9ULL;
+}
+
+/***************************************************************************//**
+ * @brief      Returns the checksum of the given log record.
+ ******************************************************************************/
+static inline uint16_t recordCheck ( const TvEBLogRecord & r )
+{
+  uint64_t hash = mix ( mix ( 1, r.lsn ), ( uint64_t ) ( uint32_t ) r.val << 1 | r.insert );
+  return ( uint16_t ) ( hash ^ hash >> 16 ^ hash >> 32 ^ hash >> 48 );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the checksum of the given manifest.
+ ******************************************************************************/
+static inline uint64_t manifestCheck ( const TvEBManifest & m )
+{
+  uint64_t hash = mix ( mix ( 1, m.magic ), m.version | ( uint64_t ) m.uni << 32 );
+  return mix ( mix ( hash, m.segBits ), m.lsn );
+}
+
+/***************************************************************************//**
+ * @brief      Returns the path of the given file of the tree.
+ ******************************************************************************/
+static std::string treePath ( const TvEBDurable * tree, const char * name, int seg = -1 )
+{
+  std::string path = std::string ( tree->dir ) + "/" + name;
+  if ( seg >= 0 )
+  {
+    char num[16];
+    snprintf ( num, sizeof ( num ), "%d.img", seg );
+    path += num;
+  }
+  return path;
+}
+
+/***************************************************************************//**
+ * @brief      Writes the whole buffer to the given file descriptor.
+ ******************************************************************************/
+static bool writeAll ( int fd, const void * buf, size_t bytes )
+{
+  const char * pos = ( const char * ) buf;
+  while ( bytes )
+  {
+    ssize_t done = write ( fd, pos, bytes );
+    if ( done < 0 && errno == EINTR ) continue;
+    if ( done <= 0 ) return false;
+    pos += done;
+    bytes -= done;
+  }
+  return true;
+}
+
+/***************************************************************************//**
+ * @brief      Flushes the directory of the tree, so that the renames in it
+ *             are durable.
+ ******************************************************************************/
+static bool syncDir ( const TvEBDurable * tree )
+{
+  int fd = open ( tree->dir, O_RDONLY );
+  if ( fd < 0 ) return false;
+  bool ok = !fsync ( fd );
+  close ( fd );
+  return ok;
+}
+
+/***************************************************************************//**
+ * @brief      Replaces the manifest of the tree by one with the given sequence
+ *             number.
+ ******************************************************************************/
+static bool writeManifest ( const TvEBDurable * tree, uint64_t lsn )
+{
+  TvEBManifest m;
+  std::memset ( &m, 0, sizeof ( m ) );
+  m.magic = VEB_MANIFEST_MAGIC;
+  m.version = VEB_IMAGE_VERSION;
+  m.uni = tree->segCnt << tree->segBits;
+  m.segBits = tree->segBits;
+  m.lsn = lsn;
+  m.check = manifestCheck ( m );
+
+  std::string path = treePath ( tree, "manifest" );
+  std::string tmp = path + ".tmp";
+  int fd = open ( tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+  if ( fd < 0 ) return false;
+  bool ok = writeAll ( fd, &m, sizeof ( m ) ) && !fsync ( fd );
+  ok = !close ( fd ) && ok;
+  return ok && !rename ( tmp.c_str(), path.c_str() ) && syncDir ( tree );
+}
+
+/***************************************************************************//**
+ * @brief      Applies the given change to the tree in memory and marks its
+ *             segment dirty.
+ ******************************************************************************/
+static bool applyChange ( TvEBDurable * tree, int val, bool insert )
+{
+  int uni = tree->segCnt << tree->segBits;
+  if ( val < 0 || val >= uni ) return false;
+  bool ok = insert ? vEB_insert ( tree->tree, val, uni, NULL, tree->flags ) : vEB_delete ( tree->tree, val );
+  if ( ok )
+  {
+    int seg = val >> tree->segBits;
+    tree->dirty[seg >> 6] |= ( uint64_t ) 1 << ( seg & 63 );
+  }
+  return ok;
+}
+
+TvEBDurable::~TvEBDurable()
+{
+  if ( logFd >= 0 ) close ( logFd );
+  delete tree;
+  delete [] dir;
+  delete [] dirty;
+  delete [] pending;
+}
+
+/***************************************************************************//**
+ * @brief      The callback of vEB_range collecting the elements of a segment.
+ ******************************************************************************/
+static bool collectValue ( int val, void * ctx )
+{
+  ( ( std::vector<int> * ) ctx )->push_back ( val );
+  return true;
+}
+
+TvEBDurable * vEB_durable_open ( const char * dir, int uniSize, int segCnt,
+                                 int groupSize, int flags )
+{
+  if ( !dir || uniSize <= 0 ) return NULL;
+
+  TvEBDurable * tree = new TvEBDurable;
+  tree->tree = NULL;
+  tree->flags = flags;
+  tree->dir = new char [strlen ( dir ) + 1];
+  strcpy ( tree->dir, dir );
+  tree->dirty = NULL;
+  tree->logFd = -1;
+  tree->pending = NULL;
+  tree->pendingCnt = 0;
+  tree->groupSize = groupSize > 0 ? groupSize : 1;
+  tree->syncCnt = 0;
+
+  // the manifest keeps the shape of an existing tree
+  TvEBManifest m;
+  uint64_t checkpointLsn = 0;
+  FILE * f = fopen ( treePath ( tree, "manifest" ).c_str(), "rb" );
+  if ( f )
+  {
+    bool ok = fread ( &m, sizeof ( m ), 1, f ) == 1 && m.magic == VEB_MANIFEST_MAGIC
+              && m.version == VEB_IMAGE_VERSION && m.check == manifestCheck ( m )
+              && m.uni && !( m.uni & ( m.uni - 1 ) ) && m.segBits <= ( uint32_t ) log2Int ( m.uni );
+    fclose ( f );
+    if ( !ok )
+    {
+      std::cerr << "manifest in " << dir << " is damaged" << std::endl;
+      delete tree;
+      return NULL;
+    }
+    tree->segBits = m.segBits;
+    tree->segCnt = m.uni >> m.segBits;
+    checkpointLsn = m.lsn;
+  }
+  else
+  {
+    int uni = powTwoRoundUp ( uniSize );
+    segCnt = powTwoRoundUp ( segCnt > 0 ? segCnt : 1 );
+    if ( segCnt > uni ) segCnt = uni;
+    tree->segCnt = segCnt;
+    tree->segBits = log2Int ( uni / segCnt );
+    if ( !writeManifest ( tree, 0 ) )
+    {
+      std::cerr << "failed to create a durable tree in " << dir << std::endl;
+      delete tree;
+      return NULL;
+    }
+  }
+
+  int uni = tree->segCnt << tree->segBits;
+  tree->dirty = new uint64_t [( tree->segCnt + 63 ) / 64]();
+  tree->pending = new TvEBLogRecord [tree->groupSize];
+
+  std::vector<int> vals;
+  for ( int seg = 0; seg < tree->segCnt; ++seg )
+  {
+    std::string path = treePath ( tree, "seg-", seg );
+    if ( access ( path.c_str(), F_OK ) ) continue;
+    TvEB * part = vEB_load ( path.c_str() );
+    if ( !part )
+    {
+      delete tree;
+      return NULL;
+    }
+    TvEBIterator it;
+    for ( bool valid = vEB_iter_succ ( part, it, -1 ); valid; valid = vEB_iter_next ( it ) )
+    {
+      vals.push_back ( ( seg << tree->segBits ) + it.val );
+    }
+    delete part;
+  }
+  tree->tree = vEB_build_from_sorted ( vals.data(), vals.size(), uni, NULL, flags );
+
+  // the records up to the checkpoint are already in the images, a torn tail
+  // is cut off
+  tree->logFd = open ( treePath ( tree, "wal" ).c_str(), O_RDWR | O_CREAT, 0644 );
+  if ( tree->logFd < 0 || !tree->tree )
+  {
+    delete tree;
+    return NULL;
+  }
+  tree->lsn = checkpointLsn + 1;
+  off_t valid = 0;
+  TvEBLogRecord r;
+  while ( read ( tree->logFd, &r, sizeof ( r ) ) == sizeof ( r ) && r.check == recordCheck ( r ) )
+  {
+    if ( r.lsn >= tree->lsn )
+    {
+      if ( r.lsn != tree->lsn ) break;
+      applyChange ( tree, r.val, r.insert );
+      tree->lsn++;
+    }
+    valid += sizeof ( r );
+  }
+  if ( ftruncate ( tree->logFd, valid ) || lseek ( tree->logFd, valid, SEEK_SET ) != valid )
+  {
+    delete tree;
+    return NULL;
+  }
+  return tree;
+}
+
+bool vEB_durable_commit ( TvEBDurable * tree )
+{
+  if ( !tree ) return false;
+  if ( !tree->pendingCnt ) return true;
+
+  // a failed write is cut off, so the next commit writes the group again
+  // right after the last committed record
+  off_t end = lseek ( tree->logFd, 0, SEEK_CUR );
+  if ( end < 0 || !writeAll ( tree->logFd, tree->pending, tree->pendingCnt * sizeof ( TvEBLogRecord ) )
+       || fdatasync ( tree->logFd ) )
+  {
+    std::cerr << "failed to write the log in " << tree->dir << std::endl;
+    if ( end >= 0 && !ftruncate ( tree->logFd, end ) ) lseek ( tree->logFd, end, SEEK_SET );
+    return false;
+  }
+  tree->pendingCnt = 0;
+  tree->syncCnt++;
+  return true;
+}
+
+bool vEB_durable_close ( TvEBDurable * tree )
+{
+  if ( !tree ) return false;
+  bool ok = vEB_durable_commit ( tree );
+  delete tree;
+  return ok;
+}
+
+int vEB_durable_checkpoint ( TvEBDurable * tree )
+{
+  if ( !tree || !vEB_durable_commit ( tree ) ) return -1;
+
+  int written = 0;
+  std::vector<int> vals;
+  for ( int seg = 0; seg < tree->segCnt; ++seg )
+  {
+    if ( !( tree->dirty[seg >> 6] >> ( seg & 63 ) & 1 ) ) continue;
+
+    int base = seg << tree->segBits;
+    vals.clear();
+    vEB_range ( tree->tree, base, base + ( 1 << tree->segBits ) - 1, collectValue, &vals );
+    std::string path = treePath ( tree, "seg-", seg );
+    if ( vals.empty() )
+    {
+      if ( remove ( path.c_str() ) && errno != ENOENT ) return -1;
+    }
+    else
+    {
+      for ( size_t i = 0; i < vals.size(); ++i ) vals[i] -= base;
+      TvEB * part = vEB_build_from_sorted ( vals.data(), vals.size(), 1 << tree->segBits );
+      bool ok = vEB_save ( part, path.c_str() );
+      delete part;
+      if ( !ok ) return -1;
+    }
+    written++;
+  }
+
+  // the log may be emptied only when the manifest covers all of it
+  if ( !syncDir ( tree ) || !writeManifest ( tree, tree->lsn - 1 ) ) return -1;
+  if ( ftruncate ( tree->logFd, 0 ) || lseek ( tree->logFd, 0, SEEK_SET ) ) return -1;
+  for ( int i = 0; i < ( tree->segCnt + 63 ) / 64; ++i ) tree->dirty[i] = 0;
+  return written;
+}
+
+/***************************************************************************//**
+ * @brief      Changes the tree and logs the change.
+ ******************************************************************************/
+static bool logChange ( TvEBDurable * tree, int val, bool insert )
+{
+  if ( !tree || !applyChange ( tree, val, insert ) ) return false;
+
+  TvEBLogRecord & r = tree->pending[tree->pendingCnt++];
+  r.lsn = tree->lsn++;
+  r.val = val;
+  r.insert = insert;
+  r.check = recordCheck ( r );
+  if ( tree->pendingCnt == tree->groupSize && !vEB_durable_commit ( tree ) )
+  {
+    // the change is taken back, which leaves room in the buffer, and the
+    // rest of the group waits for the next commit
+    tree->pendingCnt--;
+    tree->lsn--;
+    applyChange ( tree, val, !insert );
+    return false;
+  }
+  return true;
+}
+
+bool vEB_insert ( TvEBDurable * tree, int val )
+{
+  return logChange ( tree, val, true );
+}
+
+bool vEB_delete ( TvEBDurable * tree, int val )
+{
+  return logChange ( tree, val, false );
+}
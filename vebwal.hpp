@@ -0,0 +1,223 @@
+/*******************************************************************************
+* Copyright (C) 2016 Dominik Dragoun                                           *
+*                                                                              *
+* This file is part of my Van Emde Boas tree data structure implementation in  *
+* C/C++. It is released under MIT License, which should be distributed with    *
+* this file. It is also avaible at <https://opensource.org/licenses/MIT>.      *
+*******************************************************************************/
+
+/***************************************************************************//**
+ * @file vebwal.hpp
+ *
+ * @brief      File containing declarations of a durable Van Emde Boas tree
+ *             kept in a directory as a write-ahead log and checkpoint images.
+ * @author     Dominik Dragoun (dominik@dragoun.com)
+ * @date       June, 2016
+ * @copyright  Copyright (C) 2016 Dominik Dragoun.
+ * @license    This project is released undes the MIT License.
+ ******************************************************************************/
+
+#ifndef __VEBWAL_H_450918273645091827364509182736450918273645091827364509__
+#define __VEBWAL_H_450918273645091827364509182736450918273645091827364509__
+
+#include "vebfile.hpp"
+
+/***************************************************************************//**
+ * @brief      Struct containing one record of the write-ahead log.
+ ******************************************************************************/
+struct TvEBLogRecord
+{
+  /*************************************************************************//**
+   * @brief      The sequence number of the operation, one more than the one of
+   *             the previous record.
+   ****************************************************************************/
+  uint64_t lsn;
+
+  /*************************************************************************//**
+   * @brief      The value inserted or deleted.
+   ****************************************************************************/
+  int32_t val;
+
+  /*************************************************************************//**
+   * @brief      1 for an insert, 0 for a delete.
+   ****************************************************************************/
+  uint16_t insert;
+
+  /*************************************************************************//**
+   * @brief      The checksum of the other fields, a torn record at the end of
+   *             the log does not match it.
+   ****************************************************************************/
+  uint16_t check;
+};
+
+/***************************************************************************//**
+ * @brief      Struct containing a durable Van Emde Boas tree.
+ *
+ * @details    The tree lives in memory as an ordinary TvEB, which can be
+ *             searched by the TvEB functions, and in a directory holding
+ *             - the log "wal" of the changes since the last checkpoint,
+ *             - one image "seg-N.img" per non-empty segment, the universe
+ *               being split into segments by the top bits of the values,
+ *             - the manifest "manifest" with the universe, the segment size
+ *               and the sequence number the images are complete up to.
+ *
+ *             vEB_insert and vEB_delete change the tree and append a record
+ *             to a buffer, which vEB_durable_commit writes to the log with one
+ *             fdatasync, so a group of changes costs one flush. The buffer is
+ *             committed by itself when it holds groupSize records. A change
+ *             is durable once it is committed. When that commit fails, the
+ *             change which filled the buffer is taken back and refused, and
+ *             the rest of the group stays buffered for the next commit.
+ *
+ *             vEB_durable_checkpoint commits, rewrites the images of the
+ *             segments changed since the last checkpoint only, replaces the
+ *             manifest and empties the log. Every image and the manifest are
+ *             replaced by a rename, and the records only set the membership of
+ *             a value, so they can be replayed over newer images, which keeps
+ *             every moment of a checkpoint recoverable.
+ *
+ *             vEB_durable_open rebuilds the tree from the images and replays
+ *             the records of the log following the manifest, up to the first
+ *             torn or out of sequence one, which is cut off.
+ ******************************************************************************/
+struct TvEBDurable
+{
+  /*************************************************************************//**
+   * @brief      Destructor. Drops the uncommitted changes as a crash would,
+   *             vEB_durable_close commits them first.
+   ****************************************************************************/
+  ~TvEBDurable();
+
+  /*************************************************************************//**
+   * @brief      The tree.
+   ****************************************************************************/
+  TvEB * tree;
+
+  /*************************************************************************//**
+   * @brief      The directory of the tree.
+   ****************************************************************************/
+  char * dir;
+
+  /*************************************************************************//**
+   * @brief      The flags of the tree, kept to recreate it once it is emptied.
+   ****************************************************************************/
+  int flags;
+
+  /*************************************************************************//**
+   * @brief      The number of low bits of a value addressing it inside its
+   *             segment.
+   ****************************************************************************/
+  int segBits;
+
+  /*************************************************************************//**
+   * @brief      The number of the segments.
+   ****************************************************************************/
+  int segCnt;
+
+  /*************************************************************************//**
+   * @brief      The bitmap of the segments changed since the last checkpoint.
+   ****************************************************************************/
+  uint64_t * dirty;
+
+  /*************************************************************************//**
+   * @brief      The file descriptor of the log.
+   ****************************************************************************/
+  int logFd;
+
+  /*************************************************************************//**
+   * @brief      The sequence number of the next change.
+   ****************************************************************************/
+  uint64_t lsn;
+
+  /*************************************************************************//**
+   * @brief      The records not committed yet.
+   ****************************************************************************/
+  TvEBLogRecord * pending;
+
+  /*************************************************************************//**
+   * @brief      The number of the records not committed yet.
+   ****************************************************************************/
+  int pendingCnt;
+
+  /*************************************************************************//**
+   * @brief      The number of records committed by itself.
+   ****************************************************************************/
+  int groupSize;
+
+  /*************************************************************************//**
+   * @brief      The number of flushes of the log so far.
+   ****************************************************************************/
+  uint64_t syncCnt;
+};
+
+/***************************************************************************//**
+ * @brief      Opens the durable tree in the given directory, creating it when
+ *             the directory holds none, and recovers it.
+ *
+ * @param[in]  dir        The existing directory of the tree.
+ * @param[in]  uniSize    The size of the universe of a new tree.
+ * @param[in]  segCnt     The number of the segments of a new tree.
+ * @param[in]  groupSize  The number of records committed at once.
+ * @param[in]  flags      The flags of the tree in memory.
+ *
+ * @return     The pointer to the durable tree, or NULL when the directory can
+ *             not be used.
+ ******************************************************************************/
+TvEBDurable * vEB_durable_open ( const char * dir, int uniSize, int segCnt = 64,
+                                 int groupSize = 64, int flags = 0 );
+
+/***************************************************************************//**
+ * @brief      Commits the changes and frees the given durable tree.
+ *
+ * @param[in]  tree   The pointer to the durable tree.
+ *
+ * @retval     true   Successfully committed the changes.
+ * @retval     false  Failed to write the log.
+ ******************************************************************************/
+bool vEB_durable_close ( TvEBDurable * tree );
+
+/***************************************************************************//**
+ * @brief      Writes the changes made since the last commit to the log and
+ *             flushes it.
+ *
+ * @param[in]  tree   The pointer to the durable tree.
+ *
+ * @retval     true   Successfully committed the changes.
+ * @retval     false  Failed to write the log.
+ ******************************************************************************/
+bool vEB_durable_commit ( TvEBDurable * tree );
+
+/***************************************************************************//**
+ * @brief      Rewrites the images of the changed segments and empties the log.
+ *
+ * @param[in]  tree   The pointer to the durable tree.
+ *
+ * @return     The number of the rewritten segments, or -1 on failure.
+ ******************************************************************************/
+int vEB_durable_checkpoint ( TvEBDurable * tree );
+
+/***************************************************************************//**
+ * @brief      Inserts the given value into the given durable tree.
+ *
+ * @param[in]  tree   The pointer to the durable tree.
+ * @param[in]  val    The value of the element to insert.
+ *
+ * @retval     true   Successfully inserted the value.
+ * @retval     false  Failed to insert the value, or to commit the group it
+ *                    completed, and the tree is left unchanged.
+ ******************************************************************************/
+bool vEB_insert ( TvEBDurable * tree, int val );
+
+/***************************************************************************//**
+ * @brief      Removes the given value from the given durable tree.
+ *
+ * @param[in]  tree   The pointer to the durable tree.
+ * @param[in]  val    The value of the element to remove.
+ *
+ * @retval     true   Successfully removed the value.
+ * @retval     false  Failed to remove the value, or to commit the group it
+ *                    completed, and the tree is left unchanged.
+ ******************************************************************************/
+bool vEB_delete ( TvEBDurable * tree, int val );
+
+#endif /* __VEBWAL_H_450918273645091827364509182736450918273645091827364509__ */